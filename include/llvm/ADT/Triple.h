@@ -52,6 +52,7 @@ public:
     aarch64_be,     // AArch64 (big endian): aarch64_be
     avr,            // AVR: Atmel AVR microcontroller
     snes,           // Super Nintendo Entertainment System 65c816
+    spc700,         // SPC700: the S-SMP audio processor of the SNES
     bpfel,          // eBPF or extended BPF or 64-bit BPF (little endian)
     bpfeb,          // eBPF or extended BPF or 64-bit BPF (big endian)
     hexagon,        // Hexagon: hexagon
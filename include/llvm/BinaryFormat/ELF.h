@@ -313,6 +313,7 @@ enum {
   EM_LANAI = 244,         // Lanai 32-bit processor
   EM_BPF = 247,           // Linux kernel bpf virtual machine
   EM_SNES = 248,          // Super Nintendo Entertainment System 65c816
+  EM_SPC700 = 249,        // SPC700, the audio processor of the SNES
 
   // A request has been made to the maintainer of the official registry for
   // such numbers for an official value for WebAssembly. As soon as one is
@@ -627,6 +628,11 @@ enum {
 #include "ELFRelocs/SNES.def"
 };
 
+// ELF Relocation types for SPC700
+enum {
+#include "ELFRelocs/SPC700.def"
+};
+
 #undef ELF_RELOC
 
 // Section header.
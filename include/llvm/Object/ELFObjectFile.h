@@ -952,6 +952,8 @@ StringRef ELFObjectFile<ELFT>::getFileFormatName() const {
       return "ELF32-avr";
     case ELF::EM_SNES:
       return "ELF16-snes-65c816";
+    case ELF::EM_SPC700:
+      return "ELF16-spc700";
     case ELF::EM_HEXAGON:
       return "ELF32-hexagon";
     case ELF::EM_LANAI:
@@ -1024,6 +1026,8 @@ unsigned ELFObjectFile<ELFT>::getArch() const {
     return Triple::avr;
   case ELF::EM_SNES:
     return Triple::snes;
+  case ELF::EM_SPC700:
+    return Triple::spc700;
   case ELF::EM_HEXAGON:
     return Triple::hexagon;
   case ELF::EM_LANAI:
@@ -27,6 +27,7 @@ StringRef Triple::getArchTypeName(ArchType Kind) {
   case armeb:          return "armeb";
   case avr:            return "avr";
   case snes:           return "snes";
+  case spc700:         return "spc700";
   case bpfel:          return "bpfel";
   case bpfeb:          return "bpfeb";
   case hexagon:        return "hexagon";
@@ -93,6 +94,8 @@ StringRef Triple::getArchTypePrefix(ArchType Kind) {
 
   case snes:        return "snes";
 
+  case spc700:      return "spc700";
+
   case ppc64:
   case ppc64le:
   case ppc:         return "ppc";
@@ -264,6 +267,7 @@ Triple::ArchType Triple::getArchTypeForLLVMName(StringRef Name) {
     .Case("armeb", armeb)
     .Case("avr", avr)
     .Case("snes", snes)
+    .Case("spc700", spc700)
     .StartsWith("bpf", BPFArch)
     .Case("mips", mips)
     .Case("mipsel", mipsel)
@@ -389,6 +393,7 @@ static Triple::ArchType parseArch(StringRef ArchName) {
     .Case("thumbeb", Triple::thumbeb)
     .Case("avr", Triple::avr)
     .Case("snes", Triple::snes)
+    .Case("spc700", Triple::spc700)
     .Case("msp430", Triple::msp430)
     .Cases("mips", "mipseb", "mipsallegrex", Triple::mips)
     .Cases("mipsel", "mipsallegrexel", Triple::mipsel)
@@ -624,6 +629,7 @@ static Triple::ObjectFormatType getDefaultFormat(const Triple &T) {
   case Triple::armeb:
   case Triple::avr:
   case Triple::snes:
+  case Triple::spc700:
   case Triple::bpfeb:
   case Triple::bpfel:
   case Triple::hexagon:
@@ -1171,6 +1177,7 @@ static unsigned getArchPointerBitWidth(llvm::Triple::ArchType Arch) {
   case llvm::Triple::avr:
   case llvm::Triple::msp430:
   case llvm::Triple::snes:
+  case llvm::Triple::spc700:
     return 16;
 
   case llvm::Triple::arm:
@@ -1246,6 +1253,7 @@ Triple Triple::get32BitArchVariant() const {
   case Triple::amdgcn:
   case Triple::avr:
   case Triple::snes:
+  case Triple::spc700:
   case Triple::bpfel:
   case Triple::bpfeb:
   case Triple::msp430:
@@ -1309,6 +1317,7 @@ Triple Triple::get64BitArchVariant() const {
   case Triple::UnknownArch:
   case Triple::avr:
   case Triple::snes:
+  case Triple::spc700:
   case Triple::hexagon:
   case Triple::kalimba:
   case Triple::lanai:
@@ -1379,6 +1388,7 @@ Triple Triple::getBigEndianArchVariant() const {
   case Triple::amdil:
   case Triple::avr:
   case Triple::snes:
+  case Triple::spc700:
   case Triple::hexagon:
   case Triple::hsail64:
   case Triple::hsail:
@@ -1464,6 +1474,7 @@ bool Triple::isLittleEndian() const {
   case Triple::arm:
   case Triple::avr:
   case Triple::snes:
+  case Triple::spc700:
   case Triple::bpfel:
   case Triple::hexagon:
   case Triple::hsail64:
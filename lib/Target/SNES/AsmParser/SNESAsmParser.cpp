@@ -41,6 +41,15 @@ class SNESAsmParser : public MCTargetAsmParser {
   MCAsmParser &Parser;
   const MCRegisterInfo *MRI;
 
+  /// The mnemonic of the instruction being parsed, in upper case.
+  std::string Mnemonic;
+
+  /// Whether M and X are set, the width of the immediates of the accumulator
+  /// and index register instructions. Both are clear on entry to a function,
+  /// as the code generator expects, and follow the REP and SEP instructions.
+  bool ShortAccumulator = false;
+  bool ShortIndex = false;
+
 #define GET_ASSEMBLER_HEADER
 #include "SNESGenAsmMatcher.inc"
 
@@ -58,14 +67,14 @@ class SNESAsmParser : public MCTargetAsmParser {
 
   OperandMatchResultTy parseMemriOperand(OperandVector &Operands);
 
-  bool parseOperand(OperandVector &Operands);
+  bool parseOperand(OperandVector &Operands, bool AfterComma);
   int parseRegisterName(unsigned (*matchFn)(StringRef));
   int parseRegisterName();
   int parseRegister();
-  bool tryParseRegisterOperand(OperandVector &Operands);
   bool tryParseExpression(OperandVector &Operands);
   bool tryParseRelocExpression(OperandVector &Operands);
-  void eatComma();
+  bool eatComma();
+  void selectImmediateWidth(MCInst &Inst);
 
   unsigned validateTargetOperandClass(MCParsedAsmOperand &Op,
                                       unsigned Kind) override;
@@ -289,6 +298,55 @@ bool SNESAsmParser::emit(MCInst &Inst, SMLoc const &Loc, MCStreamer &Out) const
   return false;
 }
 
+/// The 8 and 16-bit forms of the immediate instructions. Both are written
+/// `LDA #k`, the width is the one of the register at run time.
+static const struct {
+  unsigned Long;
+  unsigned Short;
+  bool Index;
+} ImmediateForms[] = {
+    {SNES::ADCimm16, SNES::ADCimm8, false},
+    {SNES::SBCimm16, SNES::SBCimm8, false},
+    {SNES::ANDimm16, SNES::ANDimm8, false},
+    {SNES::ORAimm16, SNES::ORAimm8, false},
+    {SNES::EORimm16, SNES::EORimm8, false},
+    {SNES::BITimm16, SNES::BITimm8, false},
+    {SNES::CMPimm16, SNES::CMPimm8, false},
+    {SNES::LDAimm16, SNES::LDAimm8, false},
+    {SNES::CPXimm16, SNES::CPXimm8, true},
+    {SNES::CPYimm16, SNES::CPYimm8, true},
+    {SNES::LDXimm16, SNES::LDXimm8, true},
+    {SNES::LDYimm16, SNES::LDYimm8, true},
+};
+
+/// Picks the form of an immediate instruction from M and X, and keeps track
+/// of them through REP and SEP.
+void SNESAsmParser::selectImmediateWidth(MCInst &Inst) {
+  unsigned Opcode = Inst.getOpcode();
+
+  if (Opcode == SNES::REP || Opcode == SNES::SEP) {
+    if (!Inst.getOperand(0).isImm())
+      return;
+
+    int64_t Bits = Inst.getOperand(0).getImm();
+    bool Set = Opcode == SNES::SEP;
+    if (Bits & 0x20)
+      ShortAccumulator = Set;
+    if (Bits & 0x10)
+      ShortIndex = Set;
+    return;
+  }
+
+  for (const auto &Form : ImmediateForms) {
+    if (Opcode != Form.Long && Opcode != Form.Short)
+      continue;
+
+    bool Short = Form.Index ? ShortIndex : ShortAccumulator;
+    Inst.setOpcode(Short ? Form.Short : Form.Long);
+    return;
+  }
+}
+
 bool SNESAsmParser::MatchAndEmitInstruction(SMLoc Loc, unsigned &Opcode,
                                            OperandVector &Operands,
                                            MCStreamer &Out, uint64_t &ErrorInfo,
@@ -298,7 +356,9 @@ bool SNESAsmParser::MatchAndEmitInstruction(SMLoc Loc, unsigned &Opcode,
       MatchInstructionImpl(Operands, Inst, ErrorInfo, MatchingInlineAsm);
 
   switch (MatchResult) {
-  case Match_Success:        return emit(Inst, Loc, Out);
+  case Match_Success:
+    selectImmediateWidth(Inst);
+    return emit(Inst, Loc, Out);
   case Match_MissingFeature: return missingFeature(Loc, ErrorInfo);
   case Match_InvalidOperand: return invalidOperand(Loc, Operands, ErrorInfo);
   case Match_MnemonicFail:   return Error(Loc, "invalid instruction");
@@ -356,19 +416,6 @@ int SNESAsmParser::parseRegister() {
   return RegNum;
 }
 
-bool SNESAsmParser::tryParseRegisterOperand(OperandVector &Operands) {
-  int RegNo = parseRegister();
-
-  if (RegNo == SNES::NoRegister)
-    return true;
-
-  AsmToken const &T = Parser.getTok();
-  Operands.push_back(SNESOperand::CreateReg(RegNo, T.getLoc(), T.getEndLoc()));
-  Parser.Lex(); // Eat register token.
-
-  return false;
-}
-
 bool SNESAsmParser::tryParseExpression(OperandVector &Operands) {
   SMLoc S = Parser.getTok().getLoc();
 
@@ -453,21 +500,50 @@ bool SNESAsmParser::tryParseRelocExpression(OperandVector &Operands) {
   return false;
 }
 
-bool SNESAsmParser::parseOperand(OperandVector &Operands) {
+/// Gets the register an addressing mode names, `A` in `ASL A` and the index
+/// in `k,X`, or an empty string.
+static StringRef getModeRegister(StringRef Name) {
+  return StringSwitch<StringRef>(Name.upper())
+      .Case("A", "A")
+      .Case("X", "X")
+      .Case("Y", "Y")
+      .Case("S", "S")
+      .Default("");
+}
+
+bool SNESAsmParser::parseOperand(OperandVector &Operands, bool AfterComma) {
   DEBUG(dbgs() << "parseOperand\n");
 
+  AsmToken const &T = Parser.getTok();
+
   switch (getLexer().getKind()) {
   default:
-    return Error(Parser.getTok().getLoc(), "unexpected token in operand");
-
-  case AsmToken::Identifier:
-    // Try to parse a register, if it fails,
-    // fall through to the next case.
-    if (!tryParseRegisterOperand(Operands)) {
+    return Error(T.getLoc(), "unexpected token in operand");
+
+  case AsmToken::Identifier: {
+    // The registers of the addressing modes are tokens, they only come
+    // after a comma or alone, anything else is a symbol.
+    StringRef Register = getModeRegister(T.getString());
+    bool Alone = Operands.size() == 1 &&
+                 getLexer().peekTok().is(AsmToken::EndOfStatement);
+    if (!Register.empty() && (AfterComma || Alone)) {
+      Operands.push_back(SNESOperand::CreateToken(Register, T.getLoc()));
+      Parser.Lex(); // Eat the register.
       return false;
     }
-    LLVM_FALLTHROUGH;
+    return tryParseExpression(Operands);
+  }
+
+  // The immediate mark and the brackets of the indirect modes.
+  case AsmToken::Hash:
   case AsmToken::LParen:
+  case AsmToken::RParen:
+  case AsmToken::LBrac:
+  case AsmToken::RBrac:
+    Operands.push_back(SNESOperand::CreateToken(T.getString(), T.getLoc()));
+    Parser.Lex(); // Eat the token.
+    return false;
+
   case AsmToken::Integer:
   case AsmToken::Dot:
     return tryParseExpression(Operands);
@@ -538,22 +614,28 @@ bool SNESAsmParser::ParseRegister(unsigned &RegNo, SMLoc &StartLoc,
   return (RegNo == SNES::NoRegister);
 }
 
-void SNESAsmParser::eatComma() {
+bool SNESAsmParser::eatComma() {
   if (getLexer().is(AsmToken::Comma)) {
     Parser.Lex();
+    return true;
   } else {
     // GCC allows commas to be omitted.
+    return false;
   }
 }
 
 bool SNESAsmParser::ParseInstruction(ParseInstructionInfo &Info,
-                                    StringRef Mnemonic, SMLoc NameLoc,
+                                    StringRef Name, SMLoc NameLoc,
                                     OperandVector &Operands) {
+  // The generic parser hands the mnemonic over in lower case, the
+  // instructions are described in upper case.
+  Mnemonic = Name.upper();
   Operands.push_back(SNESOperand::CreateToken(Mnemonic, NameLoc));
 
   bool first = true;
   while (getLexer().isNot(AsmToken::EndOfStatement)) {
-    if (!first) eatComma();
+    bool AfterComma = false;
+    if (!first) AfterComma = eatComma();
 
     first = false;
 
@@ -570,7 +652,7 @@ bool SNESAsmParser::ParseInstruction(ParseInstructionInfo &Info,
       return Error(Loc, "failed to parse register and immediate pair");
     }
 
-    if (parseOperand(Operands)) {
+    if (parseOperand(Operands, AfterComma)) {
       SMLoc Loc = getLexer().getLoc();
       Parser.eatToEndOfStatement();
       return Error(Loc, "unexpected token in argument list");
@@ -45,6 +45,10 @@ public:
 };
 }
 
+namespace llvm {
+void registerSPC700Disassembler();
+}
+
 static MCDisassembler *createSNESDisassembler(const Target &T,
                                              const MCSubtargetInfo &STI,
                                              MCContext &Ctx) {
@@ -56,6 +60,7 @@ extern "C" void LLVMInitializeSNESDisassembler() {
   // Register the disassembler.
   TargetRegistry::RegisterMCDisassembler(getTheSNESTarget(),
                                          createSNESDisassembler);
+  registerSPC700Disassembler();
 }
 
 static DecodeStatus DecodeMainRegsRegisterClass(MCInst &Inst, unsigned RegNo,
@@ -68,6 +73,11 @@ static DecodeStatus DecodeMainLoRegsRegisterClass(MCInst &Inst, unsigned RegNo,
   return MCDisassembler::Success;
 }
 
+static DecodeStatus DecodeAccRegsRegisterClass(MCInst &Inst, unsigned RegNo,
+                                               uint64_t Address, const void *Decoder) {
+  return MCDisassembler::Success;
+}
+
 static DecodeStatus DecodeIndexRegsRegisterClass(MCInst &Inst, unsigned RegNo,
                                                  uint64_t Address, const void *Decoder) {
   return MCDisassembler::Success;
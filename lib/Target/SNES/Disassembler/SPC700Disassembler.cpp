@@ -0,0 +1,162 @@
+//===- SPC700Disassembler.cpp - Disassembler for SPC700 -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file is part of the SPC700 Disassembler. It is registered along with
+// the SNES one.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCFixedLenDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/TargetRegistry.h"
+
+#include <memory>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "spc700-disassembler"
+
+typedef MCDisassembler::DecodeStatus DecodeStatus;
+
+namespace {
+
+/// A disassembler class for SPC700.
+class SPC700Disassembler : public MCDisassembler {
+public:
+  SPC700Disassembler(const MCSubtargetInfo &STI, MCContext &Ctx,
+                     const MCInstrInfo *MII)
+      : MCDisassembler(STI, Ctx), MII(MII) {}
+  virtual ~SPC700Disassembler() {}
+
+  DecodeStatus getInstruction(MCInst &Instr, uint64_t &Size,
+                              ArrayRef<uint8_t> Bytes, uint64_t Address,
+                              raw_ostream &VStream,
+                              raw_ostream &CStream) const override;
+
+private:
+  void addImpliedOperands(MCInst &Instr) const;
+
+  std::unique_ptr<const MCInstrInfo> MII;
+};
+}
+
+static MCDisassembler *createSPC700Disassembler(const Target &T,
+                                                const MCSubtargetInfo &STI,
+                                                MCContext &Ctx) {
+  return new SPC700Disassembler(STI, Ctx, T.createMCInstrInfo());
+}
+
+namespace llvm {
+void registerSPC700Disassembler() {
+  TargetRegistry::RegisterMCDisassembler(getTheSPC700Target(),
+                                         createSPC700Disassembler);
+}
+}
+
+static const unsigned DPRegsTable[] = {
+  SPC700::R0,  SPC700::R1,  SPC700::R2,  SPC700::R3,
+  SPC700::R4,  SPC700::R5,  SPC700::R6,  SPC700::R7,
+  SPC700::R8,  SPC700::R9,  SPC700::R10, SPC700::R11,
+  SPC700::R12, SPC700::R13, SPC700::R14, SPC700::R15
+};
+
+static const unsigned DPWRegsTable[] = {
+  SPC700::RW0, SPC700::RW1, SPC700::RW2, SPC700::RW3,
+  SPC700::RW4, SPC700::RW5, SPC700::RW6, SPC700::RW7
+};
+
+/// The direct page registers are the first 16 bytes of the direct page, an
+/// instruction on any other address has no register form.
+static DecodeStatus DecodeDPRegsRegisterClass(MCInst &Inst, unsigned RegNo,
+                                              uint64_t Address,
+                                              const void *Decoder) {
+  if (RegNo >= array_lengthof(DPRegsTable))
+    return MCDisassembler::Fail;
+
+  Inst.addOperand(MCOperand::createReg(DPRegsTable[RegNo]));
+  return MCDisassembler::Success;
+}
+
+static DecodeStatus DecodeDPWRegsRegisterClass(MCInst &Inst, unsigned RegNo,
+                                               uint64_t Address,
+                                               const void *Decoder) {
+  if (RegNo % 2 != 0 || RegNo / 2 >= array_lengthof(DPWRegsTable))
+    return MCDisassembler::Fail;
+
+  Inst.addOperand(MCOperand::createReg(DPWRegsTable[RegNo / 2]));
+  return MCDisassembler::Success;
+}
+
+/// Branch displacements are signed, from the end of the instruction.
+static DecodeStatus decodeRelTarget8(MCInst &Inst, unsigned Field,
+                                     uint64_t Address, const void *Decoder) {
+  Inst.addOperand(MCOperand::createImm(SignExtend32<8>(Field)));
+  return MCDisassembler::Success;
+}
+
+#include "SPC700GenDisassemblerTables.inc"
+
+static const uint8_t *getDecoderTable(uint64_t Size) {
+  switch (Size) {
+    case 1: return DecoderTable8;
+    case 2: return DecoderTable16;
+    case 3: return DecoderTable24;
+    default: llvm_unreachable("instructions must be 1 to 3 bytes");
+  }
+}
+
+/// The A, X, Y and YA operands are implied by the opcode and have no bits in
+/// the encoding, so the generated decoder leaves them out. They are the only
+/// operands of a single register class.
+void SPC700Disassembler::addImpliedOperands(MCInst &Instr) const {
+  const MCInstrDesc &Desc = MII->get(Instr.getOpcode());
+  const MCRegisterInfo *MRI = getContext().getRegisterInfo();
+  MCInst Decoded = Instr;
+  unsigned NextDecoded = 0;
+
+  Instr.clear();
+  for (unsigned I = 0, E = Desc.getNumOperands(); I != E; ++I) {
+    int RegClass = Desc.OpInfo[I].RegClass;
+
+    if (RegClass >= 0 && MRI->getRegClass(RegClass).getNumRegs() == 1)
+      Instr.addOperand(
+          MCOperand::createReg(MRI->getRegClass(RegClass).getRegister(0)));
+    else if (NextDecoded < Decoded.getNumOperands())
+      Instr.addOperand(Decoded.getOperand(NextDecoded++));
+  }
+}
+
+DecodeStatus SPC700Disassembler::getInstruction(MCInst &Instr, uint64_t &Size,
+                                                ArrayRef<uint8_t> Bytes,
+                                                uint64_t Address,
+                                                raw_ostream &VStream,
+                                                raw_ostream &CStream) const {
+  // The opcode byte alone decides the length, try the shortest first.
+  uint32_t Insn = 0;
+  for (Size = 1; Size <= 3 && Size <= Bytes.size(); ++Size) {
+    Insn |= Bytes[Size - 1] << (8 * (Size - 1));
+
+    DecodeStatus Result = decodeInstruction(getDecoderTable(Size), Instr,
+                                            Insn, Address, this, STI);
+    if (Result != MCDisassembler::Fail) {
+      addImpliedOperands(Instr);
+      return Result;
+    }
+  }
+
+  Size = 1;
+  return MCDisassembler::Fail;
+}
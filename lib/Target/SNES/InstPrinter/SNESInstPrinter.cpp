@@ -168,5 +168,16 @@ void SNESInstPrinter::printMemri(const MCInst *MI, unsigned OpNo,
   }
 }
 
+void SNESInstPrinter::printMemsr(const MCInst *MI, unsigned OpNo,
+                                raw_ostream &O) {
+  assert(MI->getOperand(OpNo).isReg() && "Expected a register for the first operand");
+
+  const MCOperand &OffsetOp = MI->getOperand(OpNo + 1);
+
+  assert(OffsetOp.isImm() && "Expected an immediate offset");
+
+  O << OffsetOp.getImm() << ",S";
+}
+
 } // end of namespace llvm
 
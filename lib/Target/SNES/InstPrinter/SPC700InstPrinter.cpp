@@ -0,0 +1,121 @@
+//===-- SPC700InstPrinter.cpp - Convert SPC700 MCInst to assembly syntax --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This class prints an SPC700 MCInst to a .s file.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700InstPrinter.h"
+
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/MC/MCExpr.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrDesc.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormattedStream.h"
+
+#define DEBUG_TYPE "asm-printer"
+
+namespace llvm {
+
+// Include the auto-generated portion of the assembly writer.
+#define PRINT_ALIAS_INSTR
+#include "SPC700GenAsmWriter.inc"
+
+void SPC700InstPrinter::printInst(const MCInst *MI, raw_ostream &O,
+                                  StringRef Annot,
+                                  const MCSubtargetInfo &STI) {
+  if (!printAliasInstr(MI, O))
+    printInstruction(MI, O);
+
+  printAnnotation(O, Annot);
+}
+
+void SPC700InstPrinter::printOperand(const MCInst *MI, unsigned OpNo,
+                                     raw_ostream &O) {
+  const MCOperand &Op = MI->getOperand(OpNo);
+
+  if (Op.isReg()) {
+    O << getRegisterName(Op.getReg());
+  } else if (Op.isImm()) {
+    O << Op.getImm();
+  } else {
+    assert(Op.isExpr() && "Unknown operand kind in printOperand");
+    O << *Op.getExpr();
+  }
+}
+
+/// Prints an immediate operand, `#ii`.
+void SPC700InstPrinter::printImm(const MCInst *MI, unsigned OpNo,
+                                 raw_ostream &O) {
+  const MCOperand &Op = MI->getOperand(OpNo);
+
+  O << '#';
+  if (Op.isImm()) {
+    O << (Op.getImm() & 0xff);
+  } else {
+    assert(Op.isExpr() && "Unknown immediate operand");
+    O << *Op.getExpr();
+  }
+}
+
+/// Prints a direct page or absolute address, in hexadecimal as the
+/// assemblers for the chip do.
+void SPC700InstPrinter::printAddr(const MCInst *MI, unsigned OpNo,
+                                  raw_ostream &O) {
+  const MCOperand &Op = MI->getOperand(OpNo);
+
+  if (Op.isImm()) {
+    uint64_t Addr = Op.getImm() & 0xffff;
+    O << '$' << format_hex_no_prefix(Addr, Addr < 0x100 ? 2 : 4);
+  } else if (Op.isReg()) {
+    O << getRegisterName(Op.getReg());
+  } else {
+    assert(Op.isExpr() && "Unknown address operand");
+    O << *Op.getExpr();
+  }
+}
+
+/// This is used to print an immediate value that ends up
+/// being encoded as a pc-relative value.
+void SPC700InstPrinter::printPCRelImm(const MCInst *MI, unsigned OpNo,
+                                      raw_ostream &O) {
+  const MCOperand &Op = MI->getOperand(OpNo);
+
+  if (Op.isImm()) {
+    int64_t Imm = Op.getImm();
+    O << '.';
+
+    // Print a position sign if needed.
+    // Negative values have their sign printed automatically.
+    if (Imm >= 0)
+      O << '+';
+
+    O << Imm;
+  } else {
+    assert(Op.isExpr() && "Unknown pcrel immediate operand");
+    O << *Op.getExpr();
+  }
+}
+
+/// Stack slots only appear in pseudos, which are expanded before they get
+/// here. Printed for debug output.
+void SPC700InstPrinter::printMemfi(const MCInst *MI, unsigned OpNo,
+                                   raw_ostream &O) {
+  O << "fi#";
+  printOperand(MI, OpNo, O);
+  O << '+';
+  printOperand(MI, OpNo + 1, O);
+}
+
+} // end of namespace llvm
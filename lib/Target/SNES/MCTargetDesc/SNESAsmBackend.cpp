@@ -20,9 +20,12 @@
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCDirectives.h"
 #include "llvm/MC/MCELFObjectWriter.h"
+#include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCFixupKindInfo.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
@@ -126,6 +129,35 @@ void fixup_7_pcrel(unsigned Size, const MCFixup &Fixup, uint64_t &Value,
   Value &= 0x7f;
 }
 
+/// 8-bit PC-relative fixup of a 65816 branch.
+///
+/// Resolves to:
+/// kkkk kkkk
+/// The fixup is on the byte after the opcode, and the offset is counted from
+/// the next instruction.
+void fixup_8_pcrel(unsigned Size, const MCFixup &Fixup, uint64_t &Value,
+                   MCContext *Ctx = nullptr) {
+  Value -= 1;
+  signed_width(Size, Value, std::string("branch target"), Fixup, Ctx);
+
+  // Because the value may be negative, we must mask out the sign bits
+  Value &= 0xff;
+}
+
+/// 16-bit PC-relative fixup of a `PER` or `BRL`.
+///
+/// Resolves to:
+/// kkkk kkkk kkkk kkkk
+/// The fixup is on the two bytes after the opcode, and the offset is counted
+/// from the next instruction.
+void fixup_16_pcrel(unsigned Size, const MCFixup &Fixup, uint64_t &Value,
+                    MCContext *Ctx = nullptr) {
+  Value -= 2;
+  signed_width(Size, Value, std::string("relative address"), Fixup, Ctx);
+
+  Value &= 0xffff;
+}
+
 /// 12-bit PC-relative fixup.
 /// Yes, the fixup is 12 bits even though the name says otherwise.
 ///
@@ -243,9 +275,11 @@ void SNESAsmBackend::adjustFixupValue(const MCFixup &Fixup,
   // adjusted for instruction size, but normal labels aren't.
   //
   // To handle both cases, we simply un-adjust the temporary label
-  // case so it acts like all other labels.
+  // case so it acts like all other labels. The 65816 fixups take the
+  // label as it is.
   if (const MCSymbolRefExpr *A = Target.getSymA()) {
-    if (A->getSymbol().isTemporary())
+    if (A->getSymbol().isTemporary() &&
+        (Kind == SNES::fixup_7_pcrel || Kind == SNES::fixup_13_pcrel))
       Value += 2;
   }
 
@@ -258,6 +292,12 @@ void SNESAsmBackend::adjustFixupValue(const MCFixup &Fixup,
   case SNES::fixup_13_pcrel:
     adjust::fixup_13_pcrel(Size, Fixup, Value, Ctx);
     break;
+  case SNES::fixup_8_pcrel:
+    adjust::fixup_8_pcrel(Size, Fixup, Value, Ctx);
+    break;
+  case SNES::fixup_16_pcrel:
+    adjust::fixup_16_pcrel(Size, Fixup, Value, Ctx);
+    break;
   case SNES::fixup_call:
     adjust::fixup_call(Size, Fixup, Value, Ctx);
     break;
@@ -316,6 +356,16 @@ void SNESAsmBackend::adjustFixupValue(const MCFixup &Fixup,
 
     Value &= 0xffff;
     break;
+  case SNES::fixup_24:
+    adjust::unsigned_width(24, Value, std::string("long address"), Fixup, Ctx);
+
+    Value &= 0xffffff;
+    break;
+  case SNES::fixup_8:
+    adjust::unsigned_width(8, Value, std::string("byte"), Fixup, Ctx);
+
+    Value &= 0xff;
+    break;
   case SNES::fixup_6_adiw:
     adjust::fixup_6_adiw(Fixup, Value, Ctx);
     break;
@@ -428,6 +478,11 @@ MCFixupKindInfo const &SNESAsmBackend::getFixupKindInfo(MCFixupKind Kind) const
 
       {"fixup_port6", 0, 16, 0}, // non-contiguous
       {"fixup_port5", 3, 5, 0},
+
+      {"fixup_24", 0, 24, 0},
+
+      {"fixup_8_pcrel", 0, 8, MCFixupKindInfo::FKF_IsPCRel},
+      {"fixup_16_pcrel", 0, 16, MCFixupKindInfo::FKF_IsPCRel},
   };
 
   if (Kind < FirstTargetFixupKind)
@@ -440,12 +495,9 @@ MCFixupKindInfo const &SNESAsmBackend::getFixupKindInfo(MCFixupKind Kind) const
 }
 
 bool SNESAsmBackend::writeNopData(uint64_t Count, MCObjectWriter *OW) const {
-  // If the count is not 2-byte aligned, we must be writing data into the text
-  // section (otherwise we have unaligned instructions, and thus have far
-  // bigger problems), so just write zeros instead.
-  assert((Count % 2) == 0 && "NOP instructions must be 2 bytes");
-
-  OW->WriteZeros(Count);
+  // NOP is a single EA byte.
+  for (uint64_t i = 0; i != Count; ++i)
+    OW->write8(0xEA);
   return true;
 }
 
@@ -462,6 +514,38 @@ bool SNESAsmBackend::shouldForceRelocation(const MCAssembler &Asm,
   }
 }
 
+bool SNESAsmBackend::mayNeedRelaxation(const MCInst &Inst) const {
+  // Only calls to a function with a far entry carry it as a second operand.
+  return Inst.getOpcode() == SNES::JSRabs && Inst.getNumOperands() > 1;
+}
+
+bool SNESAsmBackend::fixupNeedsRelaxationAdvanced(
+    const MCFixup &Fixup, bool Resolved, uint64_t Value,
+    const MCRelaxableFragment *DF, const MCAsmLayout &Layout) const {
+  // A `JSR` only reaches callees in its own bank. Sections never straddle a
+  // bank boundary, so a callee defined in the same section is always near.
+  const auto *Ref = dyn_cast<MCSymbolRefExpr>(Fixup.getValue());
+  if (!Ref)
+    return true;
+
+  const MCSymbol &Sym = Ref->getSymbol();
+  return !Sym.isInSection() || &Sym.getSection() != DF->getParent();
+}
+
+void SNESAsmBackend::relaxInstruction(const MCInst &Inst,
+                                      const MCSubtargetInfo &STI,
+                                      MCInst &Res) const {
+  // Everything else goes through the callee's far entry, which returns to
+  // us with an `RTL`.
+  assert(Inst.getOpcode() == SNES::JSRabs && Inst.getNumOperands() > 1 &&
+         "unexpected instruction");
+
+  Res = MCInst();
+  Res.setOpcode(SNES::JSLlong);
+  Res.setLoc(Inst.getLoc());
+  Res.addOperand(Inst.getOperand(1));
+}
+
 MCAsmBackend *createSNESAsmBackend(const Target &T, const MCRegisterInfo &MRI,
                                   const Triple &TT, StringRef CPU,
                                   const llvm::MCTargetOptions &TO) {
@@ -127,6 +127,16 @@ enum Fixups {
   /// A 5-bit port address.
   fixup_port5,
 
+  /// A 24-bit long address, for the target of a `JSL` or `JML` instruction.
+  fixup_24,
+
+  /// An 8-bit PC-relative fixup for the 65816 branches (BEQ, BRA, etc), the
+  /// offset is from the instruction after the branch.
+  fixup_8_pcrel,
+  /// A 16-bit PC-relative fixup for the address `PER` pushes, the offset is
+  /// from the instruction after it.
+  fixup_16_pcrel,
+
   // Marker
   LastTargetFixupKind,
   NumTargetFixupKinds = LastTargetFixupKind - FirstTargetFixupKind
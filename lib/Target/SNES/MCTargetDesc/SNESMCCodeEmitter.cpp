@@ -95,8 +95,11 @@ SNESMCCodeEmitter::encodeRelCondBrTarget(const MCInst &MI, unsigned OpNo,
                                         const MCSubtargetInfo &STI) const {
   const MCOperand &MO = MI.getOperand(OpNo);
 
+  // The offset of a 65816 branch is in the byte after the opcode.
+  unsigned Offset = Fixup == SNES::fixup_8_pcrel ? 1 : 0;
+
   if (MO.isExpr()) {
-    Fixups.push_back(MCFixup::create(0, MO.getExpr(),
+    Fixups.push_back(MCFixup::create(Offset, MO.getExpr(),
                      MCFixupKind(Fixup), MI.getLoc()));
     return 0;
   }
@@ -106,6 +109,8 @@ SNESMCCodeEmitter::encodeRelCondBrTarget(const MCInst &MI, unsigned OpNo,
   // Take the size of the current instruction away.
   // With labels, this is implicitly done.
   auto target = MO.getImm();
+  if (Fixup == SNES::fixup_8_pcrel)
+    return target & 0xff;
   SNES::fixups::adjustBranchTarget(target);
   return target;
 }
@@ -167,6 +172,22 @@ unsigned SNESMCCodeEmitter::encodeMemri(const MCInst &MI, unsigned OpNo,
   return (RegBit << 6) | OffsetBits;
 }
 
+/// Encodes a `memsr` operand.
+/// The operand is the 8-bit offset from the stack pointer.
+unsigned SNESMCCodeEmitter::encodeMemsr(const MCInst &MI, unsigned OpNo,
+                                       SmallVectorImpl<MCFixup> &Fixups,
+                                       const MCSubtargetInfo &STI) const {
+  auto RegOp = MI.getOperand(OpNo);
+  auto OffsetOp = MI.getOperand(OpNo + 1);
+
+  assert(RegOp.isReg() && RegOp.getReg() == SNES::SP &&
+         "Expected the stack pointer");
+  assert(OffsetOp.isImm() && isUInt<8>(OffsetOp.getImm()) &&
+         "Stack relative offset is out of range");
+
+  return OffsetOp.getImm();
+}
+
 unsigned SNESMCCodeEmitter::encodeComplement(const MCInst &MI, unsigned OpNo,
                                             SmallVectorImpl<MCFixup> &Fixups,
                                             const MCSubtargetInfo &STI) const {
@@ -269,15 +290,11 @@ unsigned SNESMCCodeEmitter::getMachineOpValue(const MCInst &MI,
 void SNESMCCodeEmitter::emitInstruction(uint64_t Val, unsigned Size,
                                        const MCSubtargetInfo &STI,
                                        raw_ostream &OS) const {
-  const uint16_t *Words = reinterpret_cast<uint16_t const *>(&Val);
-  size_t WordCount = Size / 2;
-
-  for (int64_t i = WordCount - 1; i >= 0; --i) {
-    uint16_t Word = Words[i];
-
-    OS << (uint8_t) ((Word & 0x00ff) >> 0);
-    OS << (uint8_t) ((Word & 0xff00) >> 8);
-  }
+  // The opcode is in the highest byte and comes first, the operand follows
+  // it with its low byte first.
+  OS << static_cast<uint8_t>(Val >> ((Size - 1) * 8));
+  for (unsigned i = 0; i + 1 < Size; ++i)
+    OS << static_cast<uint8_t>(Val >> (i * 8));
 }
 
 void SNESMCCodeEmitter::encodeInstruction(const MCInst &MI, raw_ostream &OS,
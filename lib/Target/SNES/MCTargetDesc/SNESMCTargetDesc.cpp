@@ -15,6 +15,7 @@
 #include "SNESELFStreamer.h"
 #include "SNESMCAsmInfo.h"
 #include "SNESTargetStreamer.h"
+#include "SPC700MCTargetDesc.h"
 #include "InstPrinter/SNESInstPrinter.h"
 
 #include "llvm/MC/MCELFStreamer.h"
@@ -117,5 +118,7 @@ extern "C" void LLVMInitializeSNESTargetMC() {
 
   // Register the asm backend (as little endian).
   TargetRegistry::RegisterMCAsmBackend(getTheSNESTarget(), createSNESAsmBackend);
+
+  registerSPC700TargetMC();
 }
 
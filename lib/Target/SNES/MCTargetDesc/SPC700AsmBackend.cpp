@@ -0,0 +1,173 @@
+//===-- SPC700AsmBackend.cpp - SPC700 Asm Backend -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SPC700AsmBackend class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCTargetDesc/SPC700AsmBackend.h"
+#include "MCTargetDesc/SPC700FixupKinds.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAssembler.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCELFObjectWriter.h"
+#include "llvm/MC/MCExpr.h"
+#include "llvm/MC/MCFixupKindInfo.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCObjectWriter.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCValue.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+
+namespace llvm {
+
+void SPC700AsmBackend::adjustFixupValue(const MCFixup &Fixup, uint64_t &Value,
+                                        MCContext *Ctx) const {
+  switch ((unsigned) Fixup.getKind()) {
+  case SPC700::fixup_8_pcrel:
+    // The displacement is counted from the end of the instruction, which is
+    // where the displacement byte ends.
+    Value -= 1;
+
+    if (!isInt<8>(Value)) {
+      if (Ctx)
+        Ctx->reportFatalError(Fixup.getLoc(), "out of range branch target");
+      else
+        llvm_unreachable("out of range branch target");
+    }
+
+    Value &= 0xff;
+    break;
+
+  case SPC700::fixup_8:
+  case SPC700::fixup_lo8:
+  case FK_Data_1:
+    Value &= 0xff;
+    break;
+
+  case SPC700::fixup_hi8:
+    Value = (Value >> 8) & 0xff;
+    break;
+
+  case SPC700::fixup_16:
+  case FK_Data_2:
+    Value &= 0xffff;
+    break;
+
+  // Fixups which do not require adjustments.
+  case FK_Data_4:
+  case FK_Data_8:
+    break;
+
+  default:
+    llvm_unreachable("don't know how to adjust this fixup");
+  }
+}
+
+MCObjectWriter *
+SPC700AsmBackend::createObjectWriter(raw_pwrite_stream &OS) const {
+  return createSPC700ELFObjectWriter(OS,
+                                    MCELFObjectTargetWriter::getOSABI(OSType));
+}
+
+void SPC700AsmBackend::applyFixup(const MCAssembler &Asm,
+                                  const MCFixup &Fixup, const MCValue &Target,
+                                  MutableArrayRef<char> Data, uint64_t Value,
+                                  bool IsPCRel) const {
+  adjustFixupValue(Fixup, Value, &Asm.getContext());
+  if (Value == 0)
+    return; // Doesn't change encoding.
+
+  MCFixupKindInfo Info = getFixupKindInfo(Fixup.getKind());
+  unsigned NumBytes = Info.TargetSize / 8;
+
+  unsigned Offset = Fixup.getOffset();
+  assert(Offset + NumBytes <= Data.size() && "Invalid fixup offset!");
+
+  // Operands are little endian.
+  for (unsigned i = 0; i < NumBytes; ++i)
+    Data[Offset + i] |= static_cast<uint8_t>(Value >> (i * 8));
+}
+
+MCFixupKindInfo const &
+SPC700AsmBackend::getFixupKindInfo(MCFixupKind Kind) const {
+  const static MCFixupKindInfo Infos[SPC700::NumTargetFixupKinds] = {
+      // This table *must* be in same the order of fixup_* kinds in
+      // SPC700FixupKinds.h.
+      //
+      // name                    offset  bits  flags
+      {"fixup_8", 0, 8, 0},
+      {"fixup_16", 0, 16, 0},
+      {"fixup_8_pcrel", 0, 8, MCFixupKindInfo::FKF_IsPCRel},
+
+      {"fixup_lo8", 0, 8, 0},
+      {"fixup_hi8", 0, 8, 0},
+  };
+
+  if (Kind < FirstTargetFixupKind)
+    return MCAsmBackend::getFixupKindInfo(Kind);
+
+  assert(unsigned(Kind - FirstTargetFixupKind) < getNumFixupKinds() &&
+         "Invalid kind!");
+
+  return Infos[Kind - FirstTargetFixupKind];
+}
+
+bool SPC700AsmBackend::writeNopData(uint64_t Count, MCObjectWriter *OW) const {
+  // NOP is a single 00 byte.
+  OW->WriteZeros(Count);
+  return true;
+}
+
+/// Gets the long form of a relative branch, or 0 if there is none.
+static unsigned getRelaxedOpcode(unsigned Opcode) {
+  switch (Opcode) {
+  case SPC700::BEQ: return SPC700::BEQlong;
+  case SPC700::BNE: return SPC700::BNElong;
+  case SPC700::BCS: return SPC700::BCSlong;
+  case SPC700::BCC: return SPC700::BCClong;
+  case SPC700::BMI: return SPC700::BMIlong;
+  case SPC700::BPL: return SPC700::BPLlong;
+  case SPC700::BRA: return SPC700::JMP;
+  default:          return 0;
+  }
+}
+
+bool SPC700AsmBackend::mayNeedRelaxation(const MCInst &Inst) const {
+  return getRelaxedOpcode(Inst.getOpcode()) != 0;
+}
+
+bool SPC700AsmBackend::fixupNeedsRelaxation(const MCFixup &Fixup,
+                                            uint64_t Value,
+                                            const MCRelaxableFragment *DF,
+                                            const MCAsmLayout &Layout) const {
+  return !isInt<8>(static_cast<int64_t>(Value) - 1);
+}
+
+void SPC700AsmBackend::relaxInstruction(const MCInst &Inst,
+                                        const MCSubtargetInfo &STI,
+                                        MCInst &Res) const {
+  unsigned Opcode = getRelaxedOpcode(Inst.getOpcode());
+  assert(Opcode && "unexpected instruction");
+
+  Res = Inst;
+  Res.setOpcode(Opcode);
+}
+
+MCAsmBackend *createSPC700AsmBackend(const Target &T,
+                                     const MCRegisterInfo &MRI,
+                                     const Triple &TT, StringRef CPU,
+                                     const llvm::MCTargetOptions &TO) {
+  return new SPC700AsmBackend(TT.getOS());
+}
+
+} // end of namespace llvm
@@ -0,0 +1,68 @@
+//===-- SPC700ELFObjectWriter.cpp - SPC700 ELF Writer ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCTargetDesc/SPC700FixupKinds.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/MC/MCAssembler.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCELFObjectWriter.h"
+#include "llvm/MC/MCExpr.h"
+#include "llvm/MC/MCSection.h"
+#include "llvm/MC/MCValue.h"
+#include "llvm/Support/ErrorHandling.h"
+
+namespace llvm {
+
+/// Writes SPC700 machine code into an ELF32 object file.
+class SPC700ELFObjectWriter : public MCELFObjectTargetWriter {
+public:
+  SPC700ELFObjectWriter(uint8_t OSABI);
+
+  virtual ~SPC700ELFObjectWriter() {}
+
+  unsigned getRelocType(MCContext &Ctx,
+                        const MCValue &Target,
+                        const MCFixup &Fixup,
+                        bool IsPCRel) const override;
+};
+
+SPC700ELFObjectWriter::SPC700ELFObjectWriter(uint8_t OSABI)
+    : MCELFObjectTargetWriter(false, OSABI, ELF::EM_SPC700, true, false) {}
+
+unsigned SPC700ELFObjectWriter::getRelocType(MCContext &Ctx,
+                                             const MCValue &Target,
+                                             const MCFixup &Fixup,
+                                             bool IsPCRel) const {
+  switch ((unsigned) Fixup.getKind()) {
+  case FK_Data_1:
+  case SPC700::fixup_8:
+    return ELF::R_SPC700_8;
+  case FK_Data_2:
+  case SPC700::fixup_16:
+    return ELF::R_SPC700_16;
+  case SPC700::fixup_8_pcrel:
+    return ELF::R_SPC700_8_PCREL;
+  case SPC700::fixup_lo8:
+    return ELF::R_SPC700_LO8;
+  case SPC700::fixup_hi8:
+    return ELF::R_SPC700_HI8;
+  default:
+    Ctx.reportError(Fixup.getLoc(), "unsupported relocation type");
+    return ELF::R_SPC700_NONE;
+  }
+}
+
+MCObjectWriter *createSPC700ELFObjectWriter(raw_pwrite_stream &OS,
+                                            uint8_t OSABI) {
+  MCELFObjectTargetWriter *MOTW = new SPC700ELFObjectWriter(OSABI);
+  return createELFObjectWriter(MOTW, OS, true);
+}
+
+} // end of namespace llvm
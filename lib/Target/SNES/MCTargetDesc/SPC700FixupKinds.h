@@ -0,0 +1,45 @@
+//===-- SPC700FixupKinds.h - SPC700 Specific Fixup Entries ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_FIXUP_KINDS_H
+#define LLVM_SPC700_FIXUP_KINDS_H
+
+#include "llvm/MC/MCFixup.h"
+
+namespace llvm {
+namespace SPC700 {
+
+/// The set of supported fixups.
+///
+/// \note This table *must* be in the same order of
+///       MCFixupKindInfo Infos[SPC700::NumTargetFixupKinds]
+///       in `SPC700AsmBackend.cpp`.
+enum Fixups {
+  /// An 8-bit direct page address or immediate.
+  fixup_8 = FirstTargetFixupKind,
+  /// A 16-bit absolute address.
+  fixup_16,
+  /// The 8-bit displacement of a relative branch, counted from the end of
+  /// the instruction.
+  fixup_8_pcrel,
+
+  /// The lower 8 bits of a 16-bit value, `lo8()`.
+  fixup_lo8,
+  /// The upper 8 bits of a 16-bit value, `hi8()`.
+  fixup_hi8,
+
+  // Marker
+  LastTargetFixupKind,
+  NumTargetFixupKinds = LastTargetFixupKind - FirstTargetFixupKind
+};
+
+} // end of namespace SPC700
+} // end of namespace llvm
+
+#endif // LLVM_SPC700_FIXUP_KINDS_H
@@ -0,0 +1,29 @@
+//===-- SPC700MCAsmInfo.cpp - SPC700 asm properties -----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declarations of the SPC700MCAsmInfo properties.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700MCAsmInfo.h"
+
+#include "llvm/ADT/Triple.h"
+
+namespace llvm {
+
+SPC700MCAsmInfo::SPC700MCAsmInfo(const Triple &TT) {
+  CodePointerSize = 2;
+  CalleeSaveStackSlotSize = 1;
+  CommentString = ";";
+  PrivateGlobalPrefix = ".L";
+  UsesELFSectionDirectiveForBSS = true;
+  UseIntegratedAssembler = true;
+}
+
+} // end of namespace llvm
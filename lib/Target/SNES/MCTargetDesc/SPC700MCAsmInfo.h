@@ -0,0 +1,31 @@
+//===-- SPC700MCAsmInfo.h - SPC700 asm properties ---------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of the SPC700MCAsmInfo class.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_ASM_INFO_H
+#define LLVM_SPC700_ASM_INFO_H
+
+#include "llvm/MC/MCAsmInfo.h"
+
+namespace llvm {
+
+class Triple;
+
+/// Specifies the format of SPC700 assembly files.
+class SPC700MCAsmInfo : public MCAsmInfo {
+public:
+  explicit SPC700MCAsmInfo(const Triple &TT);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_ASM_INFO_H
@@ -0,0 +1,97 @@
+//===-- SPC700MCCodeEmitter.cpp - Convert SPC700 Code to Machine Code -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SPC700MCCodeEmitter class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700MCCodeEmitter.h"
+
+#include "MCTargetDesc/SPC700MCExpr.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCExpr.h"
+#include "llvm/MC/MCFixup.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "mccodeemitter"
+
+namespace llvm {
+
+template <SPC700::Fixups Fixup, unsigned Offset>
+unsigned SPC700MCCodeEmitter::encodeImm(const MCInst &MI, unsigned OpNo,
+                                        SmallVectorImpl<MCFixup> &Fixups,
+                                        const MCSubtargetInfo &STI) const {
+  const MCOperand &MO = MI.getOperand(OpNo);
+
+  if (MO.isImm())
+    return static_cast<unsigned>(MO.getImm());
+
+  if (MO.isReg())
+    return Ctx.getRegisterInfo()->getEncodingValue(MO.getReg());
+
+  assert(MO.isExpr());
+  const MCExpr *Expr = MO.getExpr();
+  MCFixupKind FixupKind = static_cast<MCFixupKind>(Fixup);
+
+  // A `lo8(sym)` or `hi8(sym)` brings its own fixup.
+  if (const auto *SPCExpr = dyn_cast<SPC700MCExpr>(Expr)) {
+    int64_t Result;
+    if (SPCExpr->evaluateAsConstant(Result))
+      return Result;
+
+    FixupKind = static_cast<MCFixupKind>(SPCExpr->getFixupKind());
+  }
+
+  Fixups.push_back(MCFixup::create(Offset, Expr, FixupKind, MI.getLoc()));
+  return 0;
+}
+
+unsigned
+SPC700MCCodeEmitter::getMachineOpValue(const MCInst &MI, const MCOperand &MO,
+                                       SmallVectorImpl<MCFixup> &Fixups,
+                                       const MCSubtargetInfo &STI) const {
+  if (MO.isReg()) return Ctx.getRegisterInfo()->getEncodingValue(MO.getReg());
+
+  assert(MO.isImm() && "expressions need an encoder method");
+  return static_cast<unsigned>(MO.getImm());
+}
+
+void SPC700MCCodeEmitter::encodeInstruction(const MCInst &MI, raw_ostream &OS,
+                                            SmallVectorImpl<MCFixup> &Fixups,
+                                            const MCSubtargetInfo &STI) const {
+  const MCInstrDesc &Desc = MCII.get(MI.getOpcode());
+
+  // Get byte count of instruction
+  unsigned Size = Desc.getSize();
+
+  assert(Size > 0 && "Instruction size cannot be zero");
+
+  // The opcode is in the lowest byte, the operands follow it.
+  uint64_t BinaryOpCode = getBinaryCodeForInstr(MI, Fixups, STI);
+  for (unsigned i = 0; i < Size; ++i)
+    OS << static_cast<uint8_t>(BinaryOpCode >> (i * 8));
+}
+
+MCCodeEmitter *createSPC700MCCodeEmitter(const MCInstrInfo &MCII,
+                                         const MCRegisterInfo &MRI,
+                                         MCContext &Ctx) {
+  return new SPC700MCCodeEmitter(MCII, Ctx);
+}
+
+#include "SPC700GenMCCodeEmitter.inc"
+
+} // end of namespace llvm
@@ -0,0 +1,121 @@
+//===-- SPC700MCExpr.cpp - SPC700 specific MC expression classes ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700MCExpr.h"
+
+#include "llvm/MC/MCAsmLayout.h"
+#include "llvm/MC/MCAssembler.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/MC/MCValue.h"
+
+namespace llvm {
+
+const SPC700MCExpr *SPC700MCExpr::create(VariantKind Kind, const MCExpr *Expr,
+                                         MCContext &Ctx) {
+  return new (Ctx) SPC700MCExpr(Kind, Expr);
+}
+
+void SPC700MCExpr::printImpl(raw_ostream &OS, const MCAsmInfo *MAI) const {
+  assert(Kind != VK_SPC700_None);
+
+  OS << getName() << '(';
+  getSubExpr()->print(OS, MAI);
+  OS << ')';
+}
+
+bool SPC700MCExpr::evaluateAsConstant(int64_t &Result) const {
+  MCValue Value;
+
+  bool isRelocatable =
+      getSubExpr()->evaluateAsRelocatable(Value, nullptr, nullptr);
+
+  if (!isRelocatable)
+    return false;
+
+  if (Value.isAbsolute()) {
+    Result = evaluateAsInt64(Value.getConstant());
+    return true;
+  }
+
+  return false;
+}
+
+bool SPC700MCExpr::evaluateAsRelocatableImpl(MCValue &Result,
+                                             const MCAsmLayout *Layout,
+                                             const MCFixup *Fixup) const {
+  MCValue Value;
+  bool isRelocatable = SubExpr->evaluateAsRelocatable(Value, Layout, Fixup);
+
+  if (!isRelocatable)
+    return false;
+
+  if (Value.isAbsolute()) {
+    Result = MCValue::get(evaluateAsInt64(Value.getConstant()));
+  } else {
+    if (!Layout) return false;
+
+    MCContext &Context = Layout->getAssembler().getContext();
+    const MCSymbolRefExpr *Sym = Value.getSymA();
+    MCSymbolRefExpr::VariantKind Modifier = Sym->getKind();
+    if (Modifier != MCSymbolRefExpr::VK_None)
+      return false;
+
+    Sym = MCSymbolRefExpr::create(&Sym->getSymbol(), Modifier, Context);
+    Result = MCValue::get(Sym, Value.getSymB(), Value.getConstant());
+  }
+
+  return true;
+}
+
+int64_t SPC700MCExpr::evaluateAsInt64(int64_t Value) const {
+  switch (Kind) {
+  case SPC700MCExpr::VK_SPC700_LO8:
+    break;
+  case SPC700MCExpr::VK_SPC700_HI8:
+    Value >>= 8;
+    break;
+
+  case SPC700MCExpr::VK_SPC700_None:
+    llvm_unreachable("Uninitialized expression.");
+  }
+  return static_cast<uint64_t>(Value) & 0xff;
+}
+
+SPC700::Fixups SPC700MCExpr::getFixupKind() const {
+  switch (getKind()) {
+  case VK_SPC700_LO8:
+    return SPC700::fixup_lo8;
+  case VK_SPC700_HI8:
+    return SPC700::fixup_hi8;
+
+  case VK_SPC700_None:
+    break;
+  }
+
+  llvm_unreachable("Uninitialized expression");
+}
+
+void SPC700MCExpr::visitUsedExpr(MCStreamer &Streamer) const {
+  Streamer.visitUsedExpr(*getSubExpr());
+}
+
+const char *SPC700MCExpr::getName() const {
+  switch (getKind()) {
+  case VK_SPC700_LO8:
+    return "lo8";
+  case VK_SPC700_HI8:
+    return "hi8";
+  case VK_SPC700_None:
+    break;
+  }
+  return nullptr;
+}
+
+} // end of namespace llvm
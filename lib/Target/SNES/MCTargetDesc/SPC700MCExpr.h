@@ -0,0 +1,75 @@
+//===-- SPC700MCExpr.h - SPC700 specific MC expression classes --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_MCEXPR_H
+#define LLVM_SPC700_MCEXPR_H
+
+#include "llvm/MC/MCExpr.h"
+
+#include "MCTargetDesc/SPC700FixupKinds.h"
+
+namespace llvm {
+
+/// A expression in SPC700 machine code.
+class SPC700MCExpr : public MCTargetExpr {
+public:
+  /// Specifies the type of an expression.
+  enum VariantKind {
+    VK_SPC700_None,
+
+    VK_SPC700_LO8, ///< Corresponds to `lo8()`.
+    VK_SPC700_HI8  ///< Corresponds to `hi8()`.
+  };
+
+public:
+  /// Creates an SPC700 machine code expression.
+  static const SPC700MCExpr *create(VariantKind Kind, const MCExpr *Expr,
+                                    MCContext &Ctx);
+
+  /// Gets the type of the expression.
+  VariantKind getKind() const { return Kind; }
+  /// Gets the name of the expression.
+  const char *getName() const;
+  const MCExpr *getSubExpr() const { return SubExpr; }
+  /// Gets the fixup which corresponds to the expression.
+  SPC700::Fixups getFixupKind() const;
+  /// Evaluates the fixup as a constant value.
+  bool evaluateAsConstant(int64_t &Result) const;
+
+  void printImpl(raw_ostream &OS, const MCAsmInfo *MAI) const override;
+  bool evaluateAsRelocatableImpl(MCValue &Res, const MCAsmLayout *Layout,
+                                 const MCFixup *Fixup) const override;
+
+  void visitUsedExpr(MCStreamer &streamer) const override;
+
+  MCFragment *findAssociatedFragment() const override {
+    return getSubExpr()->findAssociatedFragment();
+  }
+
+  void fixELFSymbolsInTLSFixups(MCAssembler &Asm) const override {}
+
+  static bool classof(const MCExpr *E) {
+    return E->getKind() == MCExpr::Target;
+  }
+
+private:
+  int64_t evaluateAsInt64(int64_t Value) const;
+
+  const VariantKind Kind;
+  const MCExpr *SubExpr;
+
+private:
+  explicit SPC700MCExpr(VariantKind Kind, const MCExpr *Expr)
+      : Kind(Kind), SubExpr(Expr) {}
+  ~SPC700MCExpr() {}
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_MCEXPR_H
@@ -0,0 +1,103 @@
+//===-- SPC700MCTargetDesc.cpp - SPC700 Target Descriptions ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides SPC700 specific target descriptions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700MCTargetDesc.h"
+#include "SPC700MCAsmInfo.h"
+#include "InstPrinter/SPC700InstPrinter.h"
+
+#include "llvm/MC/MCELFStreamer.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/TargetRegistry.h"
+
+#define GET_INSTRINFO_MC_DESC
+#include "SPC700GenInstrInfo.inc"
+
+#define GET_SUBTARGETINFO_MC_DESC
+#include "SPC700GenSubtargetInfo.inc"
+
+#define GET_REGINFO_MC_DESC
+#include "SPC700GenRegisterInfo.inc"
+
+using namespace llvm;
+
+static MCInstrInfo *createSPC700MCInstrInfo() {
+  MCInstrInfo *X = new MCInstrInfo();
+  InitSPC700MCInstrInfo(X);
+
+  return X;
+}
+
+static MCRegisterInfo *createSPC700MCRegisterInfo(const Triple &TT) {
+  MCRegisterInfo *X = new MCRegisterInfo();
+  InitSPC700MCRegisterInfo(X, 0);
+
+  return X;
+}
+
+static MCSubtargetInfo *createSPC700MCSubtargetInfo(const Triple &TT,
+                                                    StringRef CPU,
+                                                    StringRef FS) {
+  return createSPC700MCSubtargetInfoImpl(TT, CPU, FS);
+}
+
+static MCInstPrinter *createSPC700MCInstPrinter(const Triple &T,
+                                                unsigned SyntaxVariant,
+                                                const MCAsmInfo &MAI,
+                                                const MCInstrInfo &MII,
+                                                const MCRegisterInfo &MRI) {
+  if (SyntaxVariant == 0) {
+    return new SPC700InstPrinter(MAI, MII, MRI);
+  }
+
+  return nullptr;
+}
+
+static MCStreamer *createMCStreamer(const Triple &T, MCContext &Context,
+                                    MCAsmBackend &MAB, raw_pwrite_stream &OS,
+                                    MCCodeEmitter *Emitter, bool RelaxAll) {
+  return createELFStreamer(Context, MAB, OS, Emitter, RelaxAll);
+}
+
+void llvm::registerSPC700TargetMC() {
+  // Register the MC asm info.
+  RegisterMCAsmInfo<SPC700MCAsmInfo> X(getTheSPC700Target());
+
+  // Register the MC instruction info.
+  TargetRegistry::RegisterMCInstrInfo(getTheSPC700Target(),
+                                      createSPC700MCInstrInfo);
+
+  // Register the MC register info.
+  TargetRegistry::RegisterMCRegInfo(getTheSPC700Target(),
+                                    createSPC700MCRegisterInfo);
+
+  // Register the MC subtarget info.
+  TargetRegistry::RegisterMCSubtargetInfo(getTheSPC700Target(),
+                                          createSPC700MCSubtargetInfo);
+
+  // Register the MCInstPrinter.
+  TargetRegistry::RegisterMCInstPrinter(getTheSPC700Target(),
+                                        createSPC700MCInstPrinter);
+
+  // Register the MC Code Emitter
+  TargetRegistry::RegisterMCCodeEmitter(getTheSPC700Target(),
+                                        createSPC700MCCodeEmitter);
+
+  // Register the ELF streamer
+  TargetRegistry::RegisterELFStreamer(getTheSPC700Target(), createMCStreamer);
+
+  // Register the asm backend (as little endian).
+  TargetRegistry::RegisterMCAsmBackend(getTheSPC700Target(),
+                                       createSPC700AsmBackend);
+}
@@ -0,0 +1,64 @@
+//===-- SPC700MCTargetDesc.h - SPC700 Target Descriptions -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides SPC700 specific target descriptions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_MCTARGET_DESC_H
+#define LLVM_SPC700_MCTARGET_DESC_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+class MCAsmBackend;
+class MCCodeEmitter;
+class MCContext;
+class MCInstrInfo;
+class MCObjectWriter;
+class MCRegisterInfo;
+class MCTargetOptions;
+class StringRef;
+class Target;
+class Triple;
+class raw_pwrite_stream;
+
+Target &getTheSPC700Target();
+
+/// Creates a machine code emitter for SPC700.
+MCCodeEmitter *createSPC700MCCodeEmitter(const MCInstrInfo &MCII,
+                                         const MCRegisterInfo &MRI,
+                                         MCContext &Ctx);
+
+/// Creates an assembly backend for SPC700.
+MCAsmBackend *createSPC700AsmBackend(const Target &T,
+                                     const MCRegisterInfo &MRI,
+                                     const Triple &TT, StringRef CPU,
+                                     const llvm::MCTargetOptions &TO);
+
+/// Creates an ELF object writer for SPC700.
+MCObjectWriter *createSPC700ELFObjectWriter(raw_pwrite_stream &OS,
+                                            uint8_t OSABI);
+
+/// Registers the SPC700 MC layer, called along with the SNES one.
+void registerSPC700TargetMC();
+
+} // end namespace llvm
+
+#define GET_REGINFO_ENUM
+#include "SPC700GenRegisterInfo.inc"
+
+#define GET_INSTRINFO_ENUM
+#include "SPC700GenInstrInfo.inc"
+
+#define GET_SUBTARGETINFO_ENUM
+#include "SPC700GenSubtargetInfo.inc"
+
+#endif // LLVM_SPC700_MCTARGET_DESC_H
@@ -0,0 +1,248 @@
+;===-- crt0.s - Startup code for the SNES --------------------------------===;
+;
+;                     The LLVM Compiler Infrastructure
+;
+; This file is distributed under the University of Illinois Open Source
+; License. See LICENSE.TXT for details.
+;
+;===----------------------------------------------------------------------===;
+;
+; This file contains the code the S-CPU runs from reset up to main, and the
+; reset code of the SA-1.
+;
+; The emulation mode RESET vector of the ROM header points to __snes_reset.
+; It switches to native mode with M, X and D clear, which the code generator
+; expects everywhere, puts the stack at the top of low WRAM and the direct
+; page at $0000, and sets DB to bank $80, where both low WRAM and the I/O
+; registers are reached with absolute addresses.
+;
+; On a FastROM cartridge MEMSEL is set, so that the ROM in banks $80 and up,
+; where .text.fastrom is linked, runs at 3.58 MHz. The code itself carries
+; on in the bank $80 mirror of bank $00, which is as slow as bank $00 on a
+; SlowROM cartridge.
+;
+; The variables are in low WRAM, the only part of it absolute addresses can
+; reach. .data is copied from the ROM and .bss cleared with DMA to WMDATA,
+; which takes 8 master cycles a byte, about 3 ms for all of low WRAM, instead
+; of the tens of cycles a byte of a CPU loop. A program with an SA-1 side
+; has its variables in BW-RAM instead.
+;
+; The linker script provides:
+;
+;   __stack_top                the first byte of the stack, e.g. $1FFF.
+;   __data_start, __data_size  .directpage followed by .data, from $0000.
+;   __data_load                where their initial values are in the ROM,
+;   __data_load_bank           and its bank.
+;   __bss_start, __bss_size    .bss, after .data.
+;   __snes_fastrom             1 on a FastROM cartridge, MEMSEL is left
+;                              clear without it.
+;   __init_array_start,        the constructors, in the bank of this code.
+;   __init_array_end
+;
+; and for a program with an SA-1 side, the sizes rounded up to words:
+;
+;   __iram_start, __iram_size  .iram, the mailbox, in I-RAM.
+;   __sa1_stack_top            the top of the SA-1 stack in I-RAM.
+;   __sa1_direct_page          its direct page, 256 bytes of I-RAM.
+;   __bwram_bank               the BW-RAM bank, e.g. $40.
+;   __bwram_data_start,        .bwram.data,
+;   __bwram_data_size
+;   __bwram_data_load,         where its initial values are in the ROM,
+;   __bwram_data_load_bank     and its bank.
+;   __bwram_bss_start,         .bwram.bss.
+;   __bwram_bss_size
+;
+; The startup code has to be linked in bank $00, the SA-1 reset vector only
+; has 16 bits.
+;
+; The assembler takes M and X as clear, as the code generator does, and
+; follows the REP and SEP instructions to pick the width of an immediate.
+; M and X are still set when XCE leaves emulation mode, the SEP after it
+; only says so.
+;
+;===----------------------------------------------------------------------===;
+
+	.section	.text.startup,"ax",@progbits
+
+	.globl	__snes_reset
+__snes_reset:
+	SEI
+	CLC
+	XCE
+	SEP	#0x30
+	LDA	#__snes_fastrom
+	STA	0x420D
+	JML	0x800000 + .Lfast
+.Lfast:
+	REP	#0x38
+	LDX	#__stack_top
+	TXS
+	LDA	#0
+	TCD
+	PHK
+	PLB
+
+	; .data, with the direct page in front of it, from the ROM. DMAP0 takes
+	; one byte at a time from an incrementing address, BBAD0 is WMDATA.
+	LDA	#0x8000
+	STA	0x4300
+	SEP	#0x20
+	LDA	#__data_load_bank
+	STA	0x4304
+	REP	#0x20
+	LDA	#__data_size
+	BEQ	.Lclear_bss
+	LDX	#__data_load
+	LDY	#__data_start
+	JSR	.Lwram_dma
+
+	; .bss, from a zero byte in this bank, the source address is fixed.
+.Lclear_bss:
+	LDA	#0x8008
+	STA	0x4300
+	SEP	#0x20
+	PHK
+	PLA
+	STA	0x4304
+	REP	#0x20
+	LDA	#__bss_size
+	BEQ	.Lstart_sa1
+	LDX	#.Lzero
+	LDY	#__bss_start
+	JSR	.Lwram_dma
+
+	; A program with an SA-1 side, see Runtime/sa1.c, has its variables in
+	; BW-RAM and the mailbox in I-RAM, which DMA cannot write. Both are set up
+	; by the CPU before the SA-1 is let go, with the writes to them enabled in
+	; SBWE and SIWP first.
+.Lstart_sa1:
+	LDA	#__sa1_main
+	BEQ	.Lctors
+	SEP	#0x20
+	LDA	#0x80
+	STA	0x2226
+	LDA	#0xFF
+	STA	0x2229
+	REP	#0x20
+	LDX	#0
+.Lclear_iram:
+	CPX	#__iram_size
+	BCS	.Lcopy_bwram
+	STZ	__iram_start,X
+	INX
+	INX
+	BRA	.Lclear_iram
+
+	; MVN leaves the destination bank in DB, the BW-RAM bank is kept there
+	; until .bwram.bss is cleared.
+.Lcopy_bwram:
+	LDA	#__bwram_data_size
+	BEQ	.Lclear_bwram
+	DEC	A
+	LDX	#__bwram_data_load
+	LDY	#__bwram_data_start
+	MVN	__bwram_data_load_bank, __bwram_bank
+.Lclear_bwram:
+	SEP	#0x20
+	LDA	#__bwram_bank
+	PHA
+	PLB
+	REP	#0x20
+	LDX	#0
+.Lnext_bwram:
+	CPX	#__bwram_bss_size
+	BCS	.Lrelease_sa1
+	STZ	__bwram_bss_start,X
+	INX
+	INX
+	BRA	.Lnext_bwram
+
+	; The SA-1 starts at CRV once its reset bit in CCNT is cleared.
+.Lrelease_sa1:
+	PHK
+	PLB
+	LDA	#__sa1_reset
+	STA	0x2203
+	SEP	#0x20
+	STZ	0x2200
+	REP	#0x20
+
+	; The constructors, function pointers are in the bank they are used in.
+.Lctors:
+	LDX	#__init_array_start
+.Lnext_ctor:
+	CPX	#__init_array_end
+	BCS	.Lmain
+	PHX
+	JSR	(0,X)
+	PLX
+	INX
+	INX
+	BRA	.Lnext_ctor
+
+.Lmain:
+	CLI
+	JSL	main.far
+.Lhalt:
+	WAI
+	BRA	.Lhalt
+
+; Copies or clears A bytes at Y in low WRAM with DMA channel 0, from X in the
+; bank and with the mode set by the caller. A must not be zero.
+.Lwram_dma:
+	STA	0x4305
+	STX	0x4302
+	STY	0x2181
+	SEP	#0x20
+	STZ	0x2183
+	LDA	#1
+	STA	0x420B
+	REP	#0x20
+	RTS
+
+.Lzero:
+	.byte	0
+
+; The SA-1 comes out of reset in emulation mode too, with DB at bank $00.
+; Its stack and direct page are in I-RAM, away from the mailbox, so its own
+; writes to I-RAM and BW-RAM are enabled in CIWP and CBWE first.
+	.globl	__sa1_reset
+__sa1_reset:
+	SEI
+	CLC
+	XCE
+	SEP	#0x30
+	LDA	#0x80
+	STA	0x2227
+	LDA	#0xFF
+	STA	0x222A
+	REP	#0x38
+	LDX	#__sa1_stack_top
+	TXS
+	LDA	#__sa1_direct_page
+	TCD
+	JSL	__sa1_main.far
+.Lsa1_halt:
+	WAI
+	BRA	.Lsa1_halt
+
+	.weak	__snes_fastrom
+	.weak	__sa1_main
+	.weak	__sa1_main.far
+
+; Calls the function the S-CPU put in the mailbox, see Runtime/sa1.c, with
+; the arguments in A, X and Y left alone. It is called through its far entry
+; with the JSL pushed by hand: JML reads the long address from bank $00,
+; where I-RAM is mapped.
+	.globl	__sa1_invoke.far
+__sa1_invoke.far:
+	JSR	__sa1_invoke
+	RTL
+
+	.globl	__sa1_invoke
+__sa1_invoke:
+	PHK
+	PER	.Lsa1_return - 1
+	JML	[__sa1_mailbox_fn]
+.Lsa1_return:
+	RTS
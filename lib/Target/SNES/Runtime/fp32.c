@@ -0,0 +1,292 @@
+//===-- fp32.c - Single precision soft-float for the 65c816 -------*- C -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the IEEE-754 binary32 routines the SNES backend calls
+// for softened float operations. The names and return conventions follow
+// compiler-rt, so the generic libcall lowering works unchanged.
+//
+// The routines are built for speed on the 65c816 rather than strictness:
+// denormal inputs are treated as zero and denormal results are flushed to
+// zero, which keeps the normalization loops out of the common path. Rounding
+// is to nearest, ties to even.
+//
+// This file is meant to be compiled by llc for the SNES target, `int` is
+// 16 bits wide there.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdint.h>
+
+typedef union {
+  float f;
+  uint32_t u;
+} fp32;
+
+#define SIGN_BIT 0x80000000UL
+#define ABS_MASK 0x7fffffffUL
+#define FRAC_MASK 0x007fffffUL
+#define IMPLICIT_BIT 0x00800000UL
+#define QUIET_BIT 0x00400000UL
+#define INFINITY_REP 0x7f800000UL
+#define QNAN_REP 0x7fc00000UL
+#define EXP_MAX 0xff
+
+#define WRMPYA (*(volatile uint8_t *)0x4202)
+#define WRMPYB (*(volatile uint8_t *)0x4203)
+#define RDMPY (*(volatile uint16_t *)0x4216)
+
+static inline float fromRep(uint32_t U) {
+  fp32 V;
+  V.u = U;
+  return V.f;
+}
+
+static inline uint32_t toRep(float F) {
+  fp32 V;
+  V.f = F;
+  return V.u;
+}
+
+static inline int16_t exponentOf(uint32_t Rep) {
+  return (int16_t)((Rep >> 23) & EXP_MAX);
+}
+
+static inline int isNaN(uint32_t Rep) { return (Rep & ABS_MASK) > INFINITY_REP; }
+
+/// Unsigned 8x8 multiply on the CPU's hardware multiplier.
+static inline uint16_t umul8(uint8_t A, uint8_t B) {
+  WRMPYA = A;
+  WRMPYB = B;
+  // The product is ready 8 cycles after the write to WRMPYB.
+  __asm__ volatile("nop\n\tnop\n\tnop");
+  return RDMPY;
+}
+
+/// Rounds a significand with the implicit bit at bit 23 to nearest, ties to
+/// even, and packs the result. `Guard` is the first bit below the
+/// significand, `Sticky` is set if anything below it is.
+static float pack(uint32_t Sign, int16_t Exp, uint32_t Sig, int Guard,
+                  int Sticky) {
+  if (Guard && (Sticky || (Sig & 1))) {
+    if (++Sig & (IMPLICIT_BIT << 1)) {
+      Sig >>= 1;
+      ++Exp;
+    }
+  }
+
+  if (Exp >= EXP_MAX)
+    return fromRep(Sign | INFINITY_REP);
+  // Flush denormal results to zero.
+  if (Exp <= 0)
+    return fromRep(Sign);
+
+  return fromRep(Sign | ((uint32_t)Exp << 23) | (Sig & FRAC_MASK));
+}
+
+float __addsf3(float FA, float FB) {
+  uint32_t A = toRep(FA);
+  uint32_t B = toRep(FB);
+  int16_t ExpA = exponentOf(A);
+  int16_t ExpB = exponentOf(B);
+
+  if (ExpA == EXP_MAX || ExpB == EXP_MAX) {
+    if (isNaN(A))
+      return fromRep(A | QUIET_BIT);
+    if (isNaN(B))
+      return fromRep(B | QUIET_BIT);
+    // inf - inf.
+    if (ExpA == EXP_MAX && ExpB == EXP_MAX && ((A ^ B) & SIGN_BIT))
+      return fromRep(QNAN_REP);
+    return fromRep(ExpA == EXP_MAX ? A : B);
+  }
+
+  // Fast path: zeros and denormals.
+  if (ExpA == 0)
+    return ExpB == 0 ? fromRep(A & B & SIGN_BIT) : FB;
+  if (ExpB == 0)
+    return FA;
+
+  // Make A the larger magnitude.
+  if ((A & ABS_MASK) < (B & ABS_MASK)) {
+    uint32_t T = A;
+    A = B;
+    B = T;
+    ExpA = exponentOf(A);
+    ExpB = exponentOf(B);
+  }
+
+  // Three extra bits at the bottom: guard, round and sticky.
+  uint32_t SigA = ((A & FRAC_MASK) | IMPLICIT_BIT) << 3;
+  uint32_t SigB = ((B & FRAC_MASK) | IMPLICIT_BIT) << 3;
+
+  uint16_t Align = (uint16_t)(ExpA - ExpB);
+  if (Align >= 27) {
+    SigB = 1;
+  } else if (Align != 0) {
+    int Sticky = (SigB & ((1UL << Align) - 1)) != 0;
+    SigB = (SigB >> Align) | Sticky;
+  }
+
+  uint32_t Sign = A & SIGN_BIT;
+  uint32_t Sig;
+  if ((A ^ B) & SIGN_BIT) {
+    Sig = SigA - SigB;
+    if (Sig == 0)
+      return fromRep(0);
+    // Only cancellation with an alignment of at most one bit can shift
+    // by more than one here, and that case is exact.
+    while (!(Sig & (IMPLICIT_BIT << 3))) {
+      Sig <<= 1;
+      --ExpA;
+    }
+  } else {
+    Sig = SigA + SigB;
+    if (Sig & (IMPLICIT_BIT << 4)) {
+      Sig = (Sig >> 1) | (Sig & 1);
+      ++ExpA;
+    }
+  }
+
+  return pack(Sign, ExpA, Sig >> 3, (Sig & 4) != 0, (Sig & 3) != 0);
+}
+
+float __subsf3(float FA, float FB) {
+  return __addsf3(FA, fromRep(toRep(FB) ^ SIGN_BIT));
+}
+
+float __mulsf3(float FA, float FB) {
+  uint32_t A = toRep(FA);
+  uint32_t B = toRep(FB);
+  int16_t ExpA = exponentOf(A);
+  int16_t ExpB = exponentOf(B);
+  uint32_t Sign = (A ^ B) & SIGN_BIT;
+
+  if (ExpA == EXP_MAX || ExpB == EXP_MAX) {
+    if (isNaN(A))
+      return fromRep(A | QUIET_BIT);
+    if (isNaN(B))
+      return fromRep(B | QUIET_BIT);
+    // inf * 0.
+    if (ExpA == 0 || ExpB == 0)
+      return fromRep(QNAN_REP);
+    return fromRep(Sign | INFINITY_REP);
+  }
+
+  // Fast path: zeros and denormals.
+  if (ExpA == 0 || ExpB == 0)
+    return fromRep(Sign);
+
+  uint32_t SigA = (A & FRAC_MASK) | IMPLICIT_BIT;
+  uint32_t SigB = (B & FRAC_MASK) | IMPLICIT_BIT;
+  uint8_t A0 = (uint8_t)SigA, A1 = (uint8_t)(SigA >> 8);
+  uint8_t A2 = (uint8_t)(SigA >> 16);
+  uint8_t B0 = (uint8_t)SigB, B1 = (uint8_t)(SigB >> 8);
+  uint8_t B2 = (uint8_t)(SigB >> 16);
+
+  // The 48-bit product, one column of partial products at a time.
+  uint32_t Column = umul8(A0, B0);
+  uint8_t P0 = (uint8_t)Column;
+  Column = (Column >> 8) + umul8(A0, B1) + umul8(A1, B0);
+  uint8_t P1 = (uint8_t)Column;
+  Column = (Column >> 8) + umul8(A0, B2) + umul8(A1, B1) + umul8(A2, B0);
+  uint32_t Product = (uint8_t)Column;
+  Column = (Column >> 8) + umul8(A1, B2) + umul8(A2, B1);
+  Product |= (uint32_t)(uint8_t)Column << 8;
+  Column = (Column >> 8) + umul8(A2, B2);
+  Product |= Column << 16;
+
+  // Product holds bits 47..16, the top bit is at 46 or 47.
+  int16_t Exp = ExpA + ExpB - 127;
+  if (Product & SIGN_BIT)
+    ++Exp;
+  else
+    Product <<= 1;
+
+  return pack(Sign, Exp, Product >> 8, (Product & 0x80) != 0,
+              (Product & 0x7f) != 0 || P1 != 0 || P0 != 0);
+}
+
+float __divsf3(float FA, float FB) {
+  uint32_t A = toRep(FA);
+  uint32_t B = toRep(FB);
+  int16_t ExpA = exponentOf(A);
+  int16_t ExpB = exponentOf(B);
+  uint32_t Sign = (A ^ B) & SIGN_BIT;
+
+  if (ExpA == EXP_MAX || ExpB == EXP_MAX) {
+    if (isNaN(A))
+      return fromRep(A | QUIET_BIT);
+    if (isNaN(B))
+      return fromRep(B | QUIET_BIT);
+    // inf / inf.
+    if (ExpA == ExpB)
+      return fromRep(QNAN_REP);
+    return fromRep(ExpA == EXP_MAX ? Sign | INFINITY_REP : Sign);
+  }
+
+  // Fast path: zeros and denormals.
+  if (ExpB == 0)
+    return fromRep(ExpA == 0 ? QNAN_REP : Sign | INFINITY_REP);
+  if (ExpA == 0)
+    return fromRep(Sign);
+
+  uint32_t SigA = (A & FRAC_MASK) | IMPLICIT_BIT;
+  uint32_t SigB = (B & FRAC_MASK) | IMPLICIT_BIT;
+  int16_t Exp = ExpA - ExpB + 127;
+  if (SigA < SigB) {
+    SigA <<= 1;
+    --Exp;
+  }
+
+  // Restoring division, 24 quotient bits plus a guard bit.
+  uint32_t Quotient = 0;
+  for (uint8_t I = 0; I != 25; ++I) {
+    Quotient <<= 1;
+    if (SigA >= SigB) {
+      SigA -= SigB;
+      Quotient |= 1;
+    }
+    SigA <<= 1;
+  }
+
+  return pack(Sign, Exp, Quotient >> 1, Quotient & 1, SigA != 0);
+}
+
+/// Three-way comparison, returning `Unordered` if either side is a NaN.
+static int compare(float FA, float FB, int Unordered) {
+  uint32_t A = toRep(FA);
+  uint32_t B = toRep(FB);
+
+  if (isNaN(A) || isNaN(B))
+    return Unordered;
+
+  // Denormals compare like zero, and both zeros are equal.
+  if (exponentOf(A) == 0)
+    A = 0;
+  if (exponentOf(B) == 0)
+    B = 0;
+  if (A == B)
+    return 0;
+
+  // Both negative: the larger representation is the smaller number.
+  if (A & B & SIGN_BIT)
+    return A > B ? -1 : 1;
+  return (int32_t)A < (int32_t)B ? -1 : 1;
+}
+
+int __eqsf2(float A, float B) { return compare(A, B, 1); }
+int __nesf2(float A, float B) { return compare(A, B, 1); }
+int __ltsf2(float A, float B) { return compare(A, B, 1); }
+int __lesf2(float A, float B) { return compare(A, B, 1); }
+int __gtsf2(float A, float B) { return compare(A, B, -1); }
+int __gesf2(float A, float B) { return compare(A, B, -1); }
+
+int __unordsf2(float A, float B) {
+  return isNaN(toRep(A)) || isNaN(toRep(B));
+}
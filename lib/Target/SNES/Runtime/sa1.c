@@ -0,0 +1,69 @@
+//===-- sa1.c - S-CPU to SA-1 call mailbox ------------------------*- C -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the mailbox the S-CPU calls functions on the SA-1
+// through. SNESSA1Offload replaces every S-CPU call to a function with the
+// "snes-sa1" attribute with a stub which stores the long address of the
+// function's far entry to `__sa1_mailbox_fn` and calls `__sa1_call` with the
+// arguments, as words.
+//
+// The mailbox is in I-RAM, which the linker script maps at $3000 where both
+// CPUs see it. The S-CPU waits for the result: the calls are synchronous, and
+// only one may be in flight, so SA-1 functions must not be called from an
+// S-CPU interrupt handler.
+//
+// `__sa1_main` is the SA-1 side. Its reset code sets up the stack and the
+// direct page in I-RAM and jumps here, with the M and X flags clear. The
+// function may be in any bank, `__sa1_invoke` in crt0.s makes the long call.
+//
+// This file is meant to be compiled by llc for the SNES target with
+// -mcpu=sa1, `int` is 16 bits wide there.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdint.h>
+
+enum { SA1_IDLE, SA1_REQUEST, SA1_DONE };
+
+#define IRAM __attribute__((section(".iram")))
+
+// The long address of the function, the top byte is unused.
+volatile uint32_t __sa1_mailbox_fn IRAM;
+static volatile uint16_t MailboxArgs[3] IRAM;
+static volatile uint16_t MailboxResult IRAM;
+static volatile uint8_t MailboxState IRAM;
+
+// Calls the function at `__sa1_mailbox_fn` with the arguments in A, X and Y.
+uint16_t __sa1_invoke(uint16_t A, uint16_t X, uint16_t Y);
+
+uint16_t __sa1_call(uint16_t A, uint16_t X, uint16_t Y) {
+  MailboxArgs[0] = A;
+  MailboxArgs[1] = X;
+  MailboxArgs[2] = Y;
+  // The arguments and the function must be in place before the request.
+  MailboxState = SA1_REQUEST;
+
+  while (MailboxState != SA1_DONE)
+    ;
+
+  uint16_t Result = MailboxResult;
+  MailboxState = SA1_IDLE;
+  return Result;
+}
+
+void __sa1_main(void) {
+  for (;;) {
+    while (MailboxState != SA1_REQUEST)
+      ;
+
+    MailboxResult =
+        __sa1_invoke(MailboxArgs[0], MailboxArgs[1], MailboxArgs[2]);
+    MailboxState = SA1_DONE;
+  }
+}
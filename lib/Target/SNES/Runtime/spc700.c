@@ -0,0 +1,99 @@
+//===-- spc700.c - SPC700 integer runtime -------------------------*- C -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the routines the SPC700 backend calls for what the
+// S-SMP can't do in a few instructions. `MUL YA` and `DIV YA, X` only cover
+// unsigned bytes, wider and signed multiplications and divisions end up
+// here. The names follow libgcc.
+//
+// It also holds the trampoline indirect calls go through, the SPC700 has no
+// `CALL` through a pointer.
+//
+// This file is meant to be compiled by llc for the spc700 target, `int` is
+// 16 bits wide there. Nothing here may use the operation it implements.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdint.h>
+
+// `JMP !$0000`, SPC700ExpandPseudo stores the callee in the operand before
+// calling it. It has to be in the direct page for `MOV dp, dp`.
+__attribute__((section(".directpage")))
+uint8_t __spc700_icall[3] = {0x5f, 0x00, 0x00};
+
+uint16_t __mulhi3(uint16_t A, uint16_t B) {
+  uint16_t Result = 0;
+
+  while (B) {
+    if (B & 1)
+      Result += A;
+    A <<= 1;
+    B >>= 1;
+  }
+
+  return Result;
+}
+
+/// Restoring division, the remainder is left in \p Rem.
+static uint16_t udivmodhi4(uint16_t Num, uint16_t Den, uint16_t *Rem) {
+  uint16_t Quot = 0;
+  uint16_t R = 0;
+
+  for (uint8_t I = 0; I != 16; ++I) {
+    R = (R << 1) | (Num >> 15);
+    Num <<= 1;
+    Quot <<= 1;
+    if (R >= Den) {
+      R -= Den;
+      Quot |= 1;
+    }
+  }
+
+  *Rem = R;
+  return Quot;
+}
+
+uint16_t __udivhi3(uint16_t Num, uint16_t Den) {
+  uint16_t Rem;
+  return udivmodhi4(Num, Den, &Rem);
+}
+
+uint16_t __umodhi3(uint16_t Num, uint16_t Den) {
+  uint16_t Rem;
+  udivmodhi4(Num, Den, &Rem);
+  return Rem;
+}
+
+int16_t __divhi3(int16_t Num, int16_t Den) {
+  uint16_t Rem;
+  uint16_t Quot = udivmodhi4(Num < 0 ? -(uint16_t)Num : Num,
+                             Den < 0 ? -(uint16_t)Den : Den, &Rem);
+  return (Num < 0) != (Den < 0) ? -Quot : Quot;
+}
+
+int16_t __modhi3(int16_t Num, int16_t Den) {
+  uint16_t Rem;
+  udivmodhi4(Num < 0 ? -(uint16_t)Num : Num, Den < 0 ? -(uint16_t)Den : Den,
+             &Rem);
+  return Num < 0 ? -Rem : Rem;
+}
+
+// The unsigned byte division below is a single `DIV YA, X`.
+
+int8_t __divqi3(int8_t Num, int8_t Den) {
+  uint8_t Quot = (uint8_t)(Num < 0 ? -Num : Num) /
+                 (uint8_t)(Den < 0 ? -Den : Den);
+  return (Num < 0) != (Den < 0) ? -Quot : Quot;
+}
+
+int8_t __modqi3(int8_t Num, int8_t Den) {
+  uint8_t Rem = (uint8_t)(Num < 0 ? -Num : Num) %
+                (uint8_t)(Den < 0 ? -Den : Den);
+  return Num < 0 ? -Rem : Rem;
+}
@@ -0,0 +1,71 @@
+//===-- spc700_upload.c - Upload a program to the S-SMP -----------*- C -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the S-CPU side of the transfer protocol of the IPL
+// ROM of the S-SMP. Code built for the spc700 target is linked at $0200 into
+// a flat binary, which is put in the main ROM as data and sent through the
+// four ports at $2140-$2143 at boot:
+//
+//   extern const uint8_t driver[], driver_end[];
+//   __spc700_upload(driver, driver_end - driver, 0x0200, 0x0200);
+//
+// This file is meant to be compiled by llc for the SNES target, `int` is
+// 16 bits wide there.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdint.h>
+
+#define APUIO0 (*(volatile uint8_t *)0x2140)
+#define APUIO1 (*(volatile uint8_t *)0x2141)
+#define APUIO2 (*(volatile uint8_t *)0x2142)
+#define APUIO3 (*(volatile uint8_t *)0x2143)
+
+/// Copies \p Size bytes from \p Data to \p Dest in the audio RAM and starts
+/// executing at \p Entry. Must be called while the IPL ROM is waiting, i.e.
+/// after a reset of the S-SMP.
+void __spc700_upload(const uint8_t *Data, uint16_t Size, uint16_t Dest,
+                     uint16_t Entry) {
+  // The IPL ROM signals that it is ready with $AA, $BB.
+  while (APUIO0 != 0xaa || APUIO1 != 0xbb)
+    ;
+
+  // A non-zero command in port 1 starts a transfer to the address in ports
+  // 2 and 3. The first kick is $CC.
+  APUIO2 = Dest & 0xff;
+  APUIO3 = Dest >> 8;
+  APUIO1 = 1;
+  APUIO0 = 0xcc;
+  while (APUIO0 != 0xcc)
+    ;
+
+  // Each byte goes in port 1 with the low byte of its index in port 0, the
+  // IPL ROM echoes the index once it has stored the byte.
+  uint8_t Index = 0;
+  for (uint16_t I = 0; I != Size; ++I) {
+    APUIO1 = Data[I];
+    APUIO0 = Index;
+    while (APUIO0 != Index)
+      ;
+    ++Index;
+  }
+
+  // A zero command jumps to the address in ports 2 and 3. The kick has to
+  // differ from the last index by more than one, and must not be zero.
+  uint8_t Kick = Index + 1;
+  if (Kick == 0)
+    Kick = 1;
+
+  APUIO2 = Entry & 0xff;
+  APUIO3 = Entry >> 8;
+  APUIO1 = 0;
+  APUIO0 = Kick;
+  while (APUIO0 != Kick)
+    ;
+}
@@ -16,12 +16,18 @@
 #define LLVM_SNES_H
 
 #include "llvm/CodeGen/SelectionDAGNodes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Target/TargetMachine.h"
 
 namespace llvm {
 
 class SNESTargetMachine;
+class SNESSubtarget;
+class SNESRegisterBankInfo;
 class FunctionPass;
+class InstructionSelector;
+class ModulePass;
 
 FunctionPass *createSNESISelDag(SNESTargetMachine &TM,
                                CodeGenOpt::Level OptLevel);
@@ -31,15 +37,70 @@ FunctionPass *createSNESInstrumentFunctionsPass();
 FunctionPass *createSNESRelaxMemPass();
 FunctionPass *createSNESDynAllocaSRPass();
 FunctionPass *createSNESBranchSelectionPass();
+FunctionPass *createSNESDataBankOptPass();
+FunctionPass *createSNESAccumulatorWidthPass();
+FunctionPass *createSNESTransferOptPass();
+FunctionPass *createSNESPeepholePass();
+ModulePass *createSNESStaticFramesPass();
+ModulePass *createSNESCoroFramesPass();
+ModulePass *createSNESSA1OffloadPass();
+
+InstructionSelector *
+createSNESInstructionSelector(const SNESTargetMachine &TM,
+                              const SNESSubtarget &STI,
+                              const SNESRegisterBankInfo &RBI);
 
 void initializeSNESExpandPseudoPass(PassRegistry&);
 void initializeSNESInstrumentFunctionsPass(PassRegistry&);
 void initializeSNESRelaxMemPass(PassRegistry&);
+void initializeSNESDataBankOptPass(PassRegistry&);
+void initializeSNESAccumulatorWidthPass(PassRegistry&);
+void initializeSNESTransferOptPass(PassRegistry&);
+void initializeSNESPeepholePass(PassRegistry&);
+void initializeSNESStaticFramesPass(PassRegistry&);
+void initializeSNESCoroFramesPass(PassRegistry&);
+void initializeSNESSA1OffloadPass(PassRegistry&);
 
 /// Contains the SNES backend.
 namespace SNES {
 
-enum AddressSpace { DataMemory, ProgramMemory };
+enum AddressSpace { DataMemory, ProgramMemory, DirectPage };
+
+/// Checks if a function is an interrupt handler. Handlers return with RTI
+/// and may run in the middle of any other function.
+inline bool isInterruptHandler(const Function &F) {
+  return F.hasFnAttribute("interrupt") || F.hasFnAttribute("signal");
+}
+
+/// Checks if a function runs on the SA-1 core. The S-CPU reaches it through
+/// the stub SNESSA1Offload creates, and it cannot see WRAM or the S-CPU's
+/// I/O registers.
+inline bool isSA1Function(const Function &F) {
+  return F.hasFnAttribute("snes-sa1");
+}
+
+/// The bank of the "snes-data-bank" attribute of a function, or -1 when it
+/// has none. Direct calls to the function switch DB to this bank.
+inline int getDataBank(const Function &F) {
+  if (!F.hasFnAttribute("snes-data-bank"))
+    return -1;
+
+  unsigned Bank;
+  StringRef Value = F.getFnAttribute("snes-data-bank").getValueAsString();
+  if (Value.getAsInteger(0, Bank) || Bank > 0xFF)
+    report_fatal_error("SNES: invalid \"snes-data-bank\" attribute on '" +
+                       F.getName() + "'");
+  return Bank;
+}
+
+/// The bank DB holds on entry to a function, or -1 when it is not known.
+/// Only direct calls switch DB, so it is not known in a function which may
+/// be called through a pointer, or in an interrupt handler.
+inline int getEntryDataBank(const Function &F) {
+  if (isInterruptHandler(F) || F.hasAddressTaken())
+    return -1;
+  return getDataBank(F);
+}
 
 template <typename T> bool isProgramMemoryAddress(T *V) {
   return cast<PointerType>(V->getType())->getAddressSpace() == ProgramMemory;
@@ -51,6 +112,89 @@ inline bool isProgramMemoryAccess(MemSDNode const *N) {
   return (V != nullptr) ? isProgramMemoryAddress(V) : false;
 }
 
+/// Direct page objects can also be reached through a cast to a data
+/// pointer, as the frames placed by the static frame allocator are.
+template <typename T> bool isDirectPageAddress(T *V) {
+  return cast<PointerType>(V->stripPointerCasts()->getType())
+             ->getAddressSpace() == DirectPage;
+}
+
+/// Checks if an access can use the 8-bit direct page addressing modes.
+inline bool isDirectPageAccess(MemSDNode const *N) {
+  if (N->getAddressSpace() == DirectPage)
+    return true;
+
+  auto V = N->getMemOperand()->getValue();
+
+  return (V != nullptr) ? isDirectPageAddress(V) : false;
+}
+
+/// Memory mapped CPU registers.
+enum IORegister {
+  OAMADDL = 0x2102, ///< OAM address, low byte.
+  OAMADDH = 0x2103, ///< OAM address, high bit and priority rotation.
+  VMADDL = 0x2116,  ///< VRAM address, low byte.
+  VMADDH = 0x2117,  ///< VRAM address, high byte.
+  VMDATAL = 0x2118, ///< VRAM data write, low byte.
+  VMDATAH = 0x2119, ///< VRAM data write, high byte.
+  WRMPYA = 0x4202,  ///< Multiplicand, 8 bits.
+  WRMPYB = 0x4203,  ///< Multiplier, 8 bits, starts the multiplication.
+  WRDIVL = 0x4204,  ///< Dividend, low byte.
+  WRDIVH = 0x4205,  ///< Dividend, high byte.
+  HTIMEL = 0x4207,  ///< H-count timer, low byte.
+  VTIMEL = 0x4209,  ///< V-count timer, low byte.
+  RDMPYL = 0x4216,  ///< Product, low byte.
+  RDMPYH = 0x4217,  ///< Product, high byte.
+  DMAP0 = 0x4300,   ///< First DMA channel, each one takes 16 bytes.
+
+  // The SA-1 arithmetic unit, only mapped for the SA-1 core.
+  SA1MCNT = 0x2250, ///< Arithmetic control, 0 selects a signed multiply.
+  SA1MAL = 0x2251,  ///< Multiplicand, low byte.
+  SA1MAH = 0x2252,  ///< Multiplicand, high byte.
+  SA1MBL = 0x2253,  ///< Multiplier, low byte.
+  SA1MBH = 0x2254,  ///< Multiplier, high byte, starts the operation.
+  SA1MR = 0x2306    ///< Result, 40 bits, the product is in the low 32.
+};
+
+/// Checks if the hardware registers at \p Addr and \p Addr + 1 may be
+/// written with one 16-bit store, low byte first.
+///
+/// This holds for the PPU and CPU registers which take a 16-bit value in two
+/// halves, and for the pairs whose high register is the one with the side
+/// effect, such as WRMPYA/WRMPYB. Write-twice registers like the scroll
+/// registers take both bytes at the same address and are not in here.
+inline bool isWordWritableIORegister(uint64_t Addr) {
+  switch (Addr) {
+  case OAMADDL:
+  case VMADDL:
+  case VMDATAL:
+  case WRMPYA:
+  case WRDIVL:
+  case SA1MAL:
+  case SA1MBL:
+  case HTIMEL:
+  case VTIMEL:
+    return true;
+  default:
+    break;
+  }
+
+  // DMAPx/BBADx, A1TxL/H, DASxL/H and A2AxL/H of each DMA channel.
+  if (Addr >= DMAP0 && Addr < DMAP0 + 8 * 0x10) {
+    switch (Addr & 0xF) {
+    case 0x0:
+    case 0x2:
+    case 0x5:
+    case 0x8:
+      return true;
+    default:
+      break;
+    }
+  }
+
+  return false;
+}
+
 } // end of namespace SNES
 
 } // end namespace llvm
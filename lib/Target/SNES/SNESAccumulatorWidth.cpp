@@ -0,0 +1,238 @@
+//===-- SNESAccumulatorWidth.cpp - Switch the accumulator width -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which sets and clears the M flag around the
+// instructions which operate on bytes.
+//
+// The accumulator is 16 bits wide with M clear and 8 bits wide with M set.
+// Bytes are kept in AL and the instructions on them are the same as the ones
+// on words, so the width an instruction needs comes from its operands: AL
+// needs M set and A needs M clear. The read-modify-write instructions have no
+// register operand and are told apart by opcode.
+//
+// M is clear on entry to a function, around calls, on return and at the
+// start of most blocks, so nothing has to be known about the caller or the
+// predecessors. The pass only goes from one block to the next without a
+// REP when the next block has no other predecessor.
+//
+// X is always clear. Setting it would clear the high bytes of X and Y, which
+// may be holding words, so bytes in XL and YL are handled as words.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESTargetMachine.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+
+using namespace llvm;
+
+#define SNES_ACC_WIDTH_NAME "SNES accumulator width pass"
+
+namespace {
+
+/// The width an instruction needs the accumulator to be, or the width it is
+/// known to be.
+enum Width { AnyWidth, ByteWidth, WordWidth };
+
+class SNESAccumulatorWidth : public MachineFunctionPass {
+public:
+  static char ID;
+
+  SNESAccumulatorWidth() : MachineFunctionPass(ID) {
+    initializeSNESAccumulatorWidthPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return SNES_ACC_WIDTH_NAME; }
+
+private:
+  typedef MachineBasicBlock Block;
+  typedef Block::iterator BlockIt;
+
+  const SNESInstrInfo *TII;
+
+  /// The width at the end of each block which falls into its only
+  /// successor.
+  DenseMap<const Block *, Width> BlockOut;
+
+  static Width getWidth(const MachineInstr &MI);
+  static const Block *getOnlySuccessor(const Block &MBB);
+
+  Width getEntryWidth(const Block &MBB, const MachineFunction &MF) const;
+  void setWidth(Block &MBB, BlockIt MBBI, Width W, Width &Cur) const;
+  bool runOnBlock(Block &MBB, Width Cur);
+};
+
+char SNESAccumulatorWidth::ID = 0;
+
+Width SNESAccumulatorWidth::getWidth(const MachineInstr &MI) {
+  if (MI.isCall() || MI.isReturn() || MI.isInlineAsm())
+    return WordWidth;
+
+  switch (MI.getOpcode()) {
+  case SNES::INCdp8:
+  case SNES::INCabs8:
+  case SNES::DECdp8:
+  case SNES::DECabs8:
+  case SNES::ASLdp8:
+  case SNES::ASLabs8:
+  case SNES::LSRdp8:
+  case SNES::LSRabs8:
+  case SNES::ROLdp8:
+  case SNES::ROLabs8:
+  case SNES::RORdp8:
+  case SNES::RORabs8:
+    return ByteWidth;
+  case SNES::INCdp16:
+  case SNES::INCabs16:
+  case SNES::DECdp16:
+  case SNES::DECabs16:
+  case SNES::ASLdp16:
+  case SNES::ASLabs16:
+  case SNES::LSRdp16:
+  case SNES::LSRabs16:
+  case SNES::ROLdp16:
+  case SNES::ROLabs16:
+  case SNES::RORdp16:
+  case SNES::RORabs16:
+    return WordWidth;
+  case SNES::TXA:
+  case SNES::TYA:
+    // With M set only the low byte is copied, which is enough for a byte.
+    return MI.definesRegister(SNES::AL) ? AnyWidth : WordWidth;
+  case SNES::TAX:
+  case SNES::TAY:
+  case SNES::XBA:
+    return AnyWidth;
+  default:
+    break;
+  }
+
+  // An instruction with both, like the extension of a byte, works on words.
+  Width W = AnyWidth;
+  for (const MachineOperand &MO : MI.explicit_operands()) {
+    if (!MO.isReg())
+      continue;
+    if (MO.getReg() == SNES::A)
+      return WordWidth;
+    if (MO.getReg() == SNES::AL)
+      W = ByteWidth;
+  }
+
+  return W;
+}
+
+const MachineBasicBlock *
+SNESAccumulatorWidth::getOnlySuccessor(const Block &MBB) {
+  if (MBB.succ_size() != 1)
+    return nullptr;
+
+  const Block *Succ = *MBB.succ_begin();
+  if (Succ == &MBB || Succ->pred_size() != 1 || Succ->isEHPad() ||
+      Succ->hasAddressTaken())
+    return nullptr;
+  return Succ;
+}
+
+Width SNESAccumulatorWidth::getEntryWidth(const Block &MBB,
+                                          const MachineFunction &MF) const {
+  if (&MBB == &MF.front()) {
+    // An interrupt can come in with either width, RTI restores it.
+    return SNES::isInterruptHandler(*MF.getFunction()) ? AnyWidth : WordWidth;
+  }
+
+  if (MBB.pred_size() == 1) {
+    auto Out = BlockOut.find(*MBB.pred_begin());
+    if (Out != BlockOut.end())
+      return Out->second;
+  }
+
+  return WordWidth;
+}
+
+void SNESAccumulatorWidth::setWidth(Block &MBB, BlockIt MBBI, Width W,
+                                    Width &Cur) const {
+  if (W == AnyWidth || W == Cur)
+    return;
+
+  DebugLoc DL = MBBI != MBB.end() ? MBBI->getDebugLoc() : DebugLoc();
+  BuildMI(MBB, MBBI, DL, TII->get(W == ByteWidth ? SNES::SEP : SNES::REP))
+      .addImm(SNESII::MFlag);
+  Cur = W;
+}
+
+bool SNESAccumulatorWidth::runOnBlock(Block &MBB, Width Cur) {
+  bool Modified = false;
+
+  for (BlockIt MBBI = MBB.begin(), E = MBB.end(); MBBI != E; ++MBBI) {
+    switch (MBBI->getOpcode()) {
+    case SNES::SEP:
+      if (MBBI->getOperand(0).getImm() & SNESII::MFlag)
+        Cur = ByteWidth;
+      continue;
+    case SNES::REP:
+      if (MBBI->getOperand(0).getImm() & SNESII::MFlag)
+        Cur = WordWidth;
+      continue;
+    case SNES::PLP:
+      Cur = AnyWidth;
+      continue;
+    default:
+      break;
+    }
+
+    Width Prev = Cur;
+    setWidth(MBB, MBBI, getWidth(*MBBI), Cur);
+    Modified |= Cur != Prev;
+  }
+
+  // The branches do not depend on M and neither SEP nor REP touches the
+  // flags they test, so the width is put back right before them.
+  if (getOnlySuccessor(MBB)) {
+    BlockOut[&MBB] = Cur;
+  } else if (Cur != WordWidth) {
+    setWidth(MBB, MBB.getFirstTerminator(), WordWidth, Cur);
+    Modified = true;
+  }
+
+  return Modified;
+}
+
+bool SNESAccumulatorWidth::runOnMachineFunction(MachineFunction &MF) {
+  TII = MF.getSubtarget<SNESSubtarget>().getInstrInfo();
+  BlockOut.clear();
+
+  // A block which inherits the width is only reached from the block before
+  // it, which comes first in reverse post order.
+  bool Modified = false;
+  ReversePostOrderTraversal<MachineFunction *> RPOT(&MF);
+  for (Block *MBB : RPOT)
+    Modified |= runOnBlock(*MBB, getEntryWidth(*MBB, MF));
+
+  return Modified;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESAccumulatorWidth, "snes-acc-width", SNES_ACC_WIDTH_NAME,
+                false, false)
+
+namespace llvm {
+
+FunctionPass *createSNESAccumulatorWidthPass() {
+  return new SNESAccumulatorWidth();
+}
+
+} // end of namespace llvm
@@ -13,15 +13,25 @@
 //===----------------------------------------------------------------------===//
 
 #include "SNES.h"
+#include "SNESCostReport.h"
 #include "SNESMCInstLower.h"
+#include "SNESStackUsage.h"
 #include "SNESSubtarget.h"
+#include "SNESTargetObjectFile.h"
+#include "SPC700.h"
 #include "InstPrinter/SNESInstPrinter.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
 
 #include "llvm/CodeGen/AsmPrinter.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineBranchProbabilityInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Mangler.h"
+#include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstBuilder.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -56,8 +66,20 @@ public:
 
   void EmitInstruction(const MachineInstr *MI) override;
 
+  void EmitFunctionEntryLabel() override;
+
+  const MCExpr *lowerConstant(const Constant *CV) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  bool doFinalization(Module &M) override;
+
 private:
   const MCRegisterInfo &MRI;
+  SNESStackUsage StackUsage;
+  SNESCostReport CostReport;
 };
 
 void SNESAsmPrinter::printOperand(const MachineInstr *MI, unsigned OpNo,
@@ -181,9 +203,87 @@ void SNESAsmPrinter::EmitInstruction(const MachineInstr *MI) {
   EmitToStreamer(*OutStreamer, I);
 }
 
+void SNESAsmPrinter::EmitFunctionEntryLabel() {
+  const Function &F = *MF->getFunction();
+
+  // Every body returns with RTS, so callers from another bank JSL into a
+  // small trampoline in front of it instead.
+  if (SNESTargetObjectFile::needsFarEntry(F)) {
+    MCSymbol *FarSym =
+        OutContext.getOrCreateSymbol(CurrentFnSym->getName() + ".far");
+
+    if (F.hasExternalLinkage())
+      OutStreamer->EmitSymbolAttribute(FarSym, MCSA_Global);
+    else if (!F.hasLocalLinkage())
+      OutStreamer->EmitSymbolAttribute(FarSym, MCSA_Weak);
+    OutStreamer->EmitSymbolAttribute(FarSym, MCSA_ELF_TypeFunction);
+    OutStreamer->EmitLabel(FarSym);
+
+    EmitToStreamer(*OutStreamer,
+                   MCInstBuilder(SNES::JSRabs)
+                       .addExpr(MCSymbolRefExpr::create(CurrentFnSym,
+                                                        OutContext)));
+    EmitToStreamer(*OutStreamer, MCInstBuilder(SNES::RTL));
+  }
+
+  AsmPrinter::EmitFunctionEntryLabel();
+}
+
+const MCExpr *SNESAsmPrinter::lowerConstant(const Constant *CV) {
+  // A global in an integer wider than a pointer is its long address, with
+  // the bank. For a function it is the one of the far entry, which is what
+  // a JSL or a JML goes to.
+  const auto *CE = dyn_cast<ConstantExpr>(CV);
+  if (CE && CE->getOpcode() == Instruction::PtrToInt &&
+      getDataLayout().getTypeAllocSize(CE->getType()) >
+          getDataLayout().getPointerSize()) {
+    const auto *GV =
+        dyn_cast<GlobalValue>(CE->getOperand(0)->stripPointerCasts());
+    if (const auto *F = dyn_cast_or_null<Function>(GV)) {
+      assert(SNESTargetObjectFile::needsFarEntry(*F) &&
+             "Taking the address should give the function a far entry!");
+      return MCSymbolRefExpr::create(
+          OutContext.getOrCreateSymbol(getSymbol(F)->getName() + ".far"),
+          OutContext);
+    }
+    if (GV)
+      return MCSymbolRefExpr::create(getSymbol(GV), OutContext);
+  }
+
+  return AsmPrinter::lowerConstant(CV);
+}
+
+void SNESAsmPrinter::getAnalysisUsage(AnalysisUsage &AU) const {
+  AsmPrinter::getAnalysisUsage(AU);
+  if (SNESCostReport::isEnabled()) {
+    AU.addRequired<MachineBlockFrequencyInfo>();
+    AU.addRequired<MachineBranchProbabilityInfo>();
+  }
+}
+
+bool SNESAsmPrinter::runOnMachineFunction(MachineFunction &MF) {
+  if (SNESStackUsage::isEnabled())
+    StackUsage.addFunction(MF);
+  if (SNESCostReport::isEnabled())
+    CostReport.addFunction(MF, getAnalysis<MachineBlockFrequencyInfo>(),
+                           getAnalysis<MachineBranchProbabilityInfo>());
+
+  return AsmPrinter::runOnMachineFunction(MF);
+}
+
+bool SNESAsmPrinter::doFinalization(Module &M) {
+  if (SNESStackUsage::isEnabled())
+    StackUsage.finish(M, TM);
+  if (SNESCostReport::isEnabled())
+    CostReport.finish(M);
+
+  return AsmPrinter::doFinalization(M);
+}
+
 } // end of namespace llvm
 
 extern "C" void LLVMInitializeSNESAsmPrinter() {
   llvm::RegisterAsmPrinter<llvm::SNESAsmPrinter> X(llvm::getTheSNESTarget());
+  llvm::registerSPC700AsmPrinter();
 }
 
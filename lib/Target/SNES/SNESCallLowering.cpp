@@ -0,0 +1,388 @@
+//===-- SNESCallLowering.cpp - Call lowering ------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the lowering of LLVM calls to machine code calls for
+/// GlobalISel.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SNESCallLowering.h"
+
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+
+#include "SNES.h"
+#include "SNESISelLowering.h"
+#include "SNESInstrInfo.h"
+#include "SNESMachineFunctionInfo.h"
+#include "SNESTargetObjectFile.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "This shouldn't be built without GISel"
+#endif
+
+namespace llvm {
+
+SNESCallLowering::SNESCallLowering(const SNESTargetLowering &TLI)
+    : CallLowering(&TLI) {}
+
+/// Whether a value of type \p Ty is passed in a single register or stack
+/// slot.
+static bool isSupportedType(Type *Ty) {
+  if (Ty->isPointerTy())
+    return true;
+  if (!Ty->isIntegerTy())
+    return false;
+
+  unsigned Bits = Ty->getIntegerBitWidth();
+  return Bits == 1 || Bits == 8 || Bits == 16;
+}
+
+/// The type the calling convention sees for \p Ty. Pointers are words.
+static Type *getCCType(Type *Ty) {
+  if (Ty->isPointerTy())
+    return Type::getInt16Ty(Ty->getContext());
+  return Ty;
+}
+
+namespace {
+
+/// Moves values out through an ABI boundary, call arguments and return
+/// values.
+struct OutgoingValueHandler : public CallLowering::ValueHandler {
+  OutgoingValueHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                       MachineInstrBuilder &MIB, CCAssignFn *AssignFn)
+      : ValueHandler(MIRBuilder, MRI, AssignFn), MIB(MIB), StackSize(0) {}
+
+  unsigned getStackAddress(uint64_t Size, int64_t Offset,
+                           MachinePointerInfo &MPO) override {
+    LLT p0 = LLT::pointer(SNES::DataMemory, 16);
+    LLT s16 = LLT::scalar(16);
+
+    unsigned SPReg = MRI.createGenericVirtualRegister(p0);
+    MIRBuilder.buildCopy(SPReg, SNES::SP);
+
+    // SP points to the first free byte, one below the arguments.
+    unsigned OffsetReg = MRI.createGenericVirtualRegister(s16);
+    MIRBuilder.buildConstant(OffsetReg, Offset + 1);
+
+    unsigned AddrReg = MRI.createGenericVirtualRegister(p0);
+    MIRBuilder.buildGEP(AddrReg, SPReg, OffsetReg);
+
+    MPO = MachinePointerInfo::getStack(MIRBuilder.getMF(), Offset);
+    return AddrReg;
+  }
+
+  /// \p ValVReg widened to the location of \p VA.
+  unsigned extendToLoc(unsigned ValVReg, CCValAssign &VA) {
+    if (VA.getLocInfo() != CCValAssign::AExt)
+      return extendRegister(ValVReg, VA);
+
+    unsigned ExtReg = MRI.createGenericVirtualRegister(LLT{VA.getLocVT()});
+    MIRBuilder.buildAnyExt(ExtReg, ValVReg);
+    return ExtReg;
+  }
+
+  void assignValueToReg(unsigned ValVReg, unsigned PhysReg,
+                        CCValAssign &VA) override {
+    assert(VA.isRegLoc() && "Value shouldn't be assigned to reg");
+    assert(VA.getLocReg() == PhysReg && "Assigning to the wrong reg?");
+
+    MIRBuilder.buildCopy(PhysReg, extendToLoc(ValVReg, VA));
+    MIB.addUse(PhysReg, RegState::Implicit);
+  }
+
+  void assignValueToAddress(unsigned ValVReg, unsigned Addr, uint64_t Size,
+                            MachinePointerInfo &MPO, CCValAssign &VA) override {
+    auto MMO = MIRBuilder.getMF().getMachineMemOperand(
+        MPO, MachineMemOperand::MOStore, VA.getLocVT().getStoreSize(),
+        /* Alignment */ 1);
+    MIRBuilder.buildStore(extendToLoc(ValVReg, VA), Addr, *MMO);
+  }
+
+  bool assignArg(unsigned ValNo, MVT ValVT, MVT LocVT,
+                 CCValAssign::LocInfo LocInfo,
+                 const CallLowering::ArgInfo &Info, CCState &State) override {
+    if (AssignFn(ValNo, ValVT, LocVT, LocInfo, Info.Flags, State))
+      return true;
+
+    StackSize = std::max(StackSize, State.getNextStackOffset());
+    return false;
+  }
+
+  MachineInstrBuilder &MIB;
+  unsigned StackSize;
+};
+
+/// Moves values in through an ABI boundary, formal arguments and call
+/// results.
+struct IncomingValueHandler : public CallLowering::ValueHandler {
+  IncomingValueHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                       CCAssignFn *AssignFn)
+      : ValueHandler(MIRBuilder, MRI, AssignFn) {}
+
+  unsigned getStackAddress(uint64_t Size, int64_t Offset,
+                           MachinePointerInfo &MPO) override {
+    auto &MFI = MIRBuilder.getMF().getFrameInfo();
+
+    int FI = MFI.CreateFixedObject(Size, Offset, true);
+    MPO = MachinePointerInfo::getFixedStack(MIRBuilder.getMF(), FI);
+
+    unsigned AddrReg =
+        MRI.createGenericVirtualRegister(LLT::pointer(SNES::DataMemory, 16));
+    MIRBuilder.buildFrameIndex(AddrReg, FI);
+
+    return AddrReg;
+  }
+
+  void assignValueToAddress(unsigned ValVReg, unsigned Addr, uint64_t Size,
+                            MachinePointerInfo &MPO, CCValAssign &VA) override {
+    auto MMO = MIRBuilder.getMF().getMachineMemOperand(
+        MPO, MachineMemOperand::MOLoad, VA.getLocVT().getStoreSize(),
+        /* Alignment */ 1);
+
+    if (VA.getLocVT() == VA.getValVT()) {
+      MIRBuilder.buildLoad(ValVReg, Addr, *MMO);
+      return;
+    }
+
+    unsigned LoadVReg = MRI.createGenericVirtualRegister(LLT{VA.getLocVT()});
+    MIRBuilder.buildLoad(LoadVReg, Addr, *MMO);
+    MIRBuilder.buildTrunc(ValVReg, LoadVReg);
+  }
+
+  void assignValueToReg(unsigned ValVReg, unsigned PhysReg,
+                        CCValAssign &VA) override {
+    assert(VA.isRegLoc() && "Value shouldn't be assigned to reg");
+    assert(VA.getLocReg() == PhysReg && "Assigning to the wrong reg?");
+
+    markPhysRegUsed(PhysReg);
+    if (VA.getLocVT() == VA.getValVT()) {
+      MIRBuilder.buildCopy(ValVReg, PhysReg);
+      return;
+    }
+
+    unsigned LocVReg = MRI.createGenericVirtualRegister(LLT{VA.getLocVT()});
+    MIRBuilder.buildCopy(LocVReg, PhysReg);
+    MIRBuilder.buildTrunc(ValVReg, LocVReg);
+  }
+
+  /// Formal arguments are live into the entry block, call results are
+  /// defined by the call.
+  virtual void markPhysRegUsed(unsigned PhysReg) = 0;
+};
+
+struct FormalArgHandler : public IncomingValueHandler {
+  FormalArgHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                   CCAssignFn *AssignFn)
+      : IncomingValueHandler(MIRBuilder, MRI, AssignFn), StackSize(0) {}
+
+  void markPhysRegUsed(unsigned PhysReg) override {
+    MIRBuilder.getMBB().addLiveIn(PhysReg);
+  }
+
+  bool assignArg(unsigned ValNo, MVT ValVT, MVT LocVT,
+                 CCValAssign::LocInfo LocInfo,
+                 const CallLowering::ArgInfo &Info, CCState &State) override {
+    if (AssignFn(ValNo, ValVT, LocVT, LocInfo, Info.Flags, State))
+      return true;
+
+    StackSize = std::max(StackSize, State.getNextStackOffset());
+    return false;
+  }
+
+  unsigned StackSize;
+};
+
+struct CallReturnHandler : public IncomingValueHandler {
+  CallReturnHandler(MachineIRBuilder &MIRBuilder, MachineRegisterInfo &MRI,
+                    MachineInstrBuilder MIB, CCAssignFn *AssignFn)
+      : IncomingValueHandler(MIRBuilder, MRI, AssignFn), MIB(MIB) {}
+
+  void markPhysRegUsed(unsigned PhysReg) override {
+    MIB.addDef(PhysReg, RegState::Implicit);
+  }
+
+  MachineInstrBuilder MIB;
+};
+
+} // end of anonymous namespace
+
+bool SNESCallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
+                                   const Value *Val, unsigned VReg) const {
+  assert(!Val == !VReg && "Return value without a vreg");
+
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = *MF.getFunction();
+
+  // A naked function has no RTS, which is left to SelectionDAG.
+  if (F.hasFnAttribute(Attribute::Naked))
+    return false;
+
+  auto Ret = MIRBuilder.buildInstrNoInsert(SNES::RTS);
+
+  if (Val) {
+    if (!isSupportedType(Val->getType()))
+      return false;
+
+    const auto &TLI = *getTLI<SNESTargetLowering>();
+    const DataLayout &DL = MF.getDataLayout();
+
+    ArgInfo RetInfo(VReg, getCCType(Val->getType()));
+    setArgFlags(RetInfo, AttributeList::ReturnIndex, DL, F);
+
+    CCAssignFn *AssignFn = TLI.CCAssignFnForReturn(F.getCallingConv());
+    OutgoingValueHandler RetHandler(MIRBuilder, MF.getRegInfo(), Ret,
+                                    AssignFn);
+    if (!handleAssignments(MIRBuilder, RetInfo, RetHandler))
+      return false;
+  }
+
+  MIRBuilder.insertInstr(Ret);
+  return true;
+}
+
+bool SNESCallLowering::lowerFormalArguments(MachineIRBuilder &MIRBuilder,
+                                            const Function &F,
+                                            ArrayRef<unsigned> VRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  const DataLayout &DL = MF.getDataLayout();
+  const auto &TLI = *getTLI<SNESTargetLowering>();
+
+  // va_start needs the frame index SelectionDAG makes for the first variadic
+  // argument.
+  if (F.isVarArg())
+    return false;
+
+  SmallVector<ArgInfo, 8> ArgInfos;
+  unsigned Idx = 0;
+  for (auto &Arg : F.args()) {
+    if (!isSupportedType(Arg.getType()))
+      return false;
+
+    ArgInfo AInfo(VRegs[Idx], getCCType(Arg.getType()));
+    setArgFlags(AInfo, Idx + AttributeList::FirstArgIndex, DL, F);
+    ArgInfos.push_back(AInfo);
+    ++Idx;
+  }
+
+  if (!MBB.empty())
+    MIRBuilder.setInstr(*MBB.begin());
+
+  FormalArgHandler ArgHandler(MIRBuilder, MF.getRegInfo(),
+                              TLI.CCAssignFnForCall(F.getCallingConv(),
+                                                    /*IsVarArg=*/false));
+  if (!handleAssignments(MIRBuilder, ArgInfos, ArgHandler))
+    return false;
+
+  // Stack arguments past the return address of a far entry are left to
+  // SelectionDAG.
+  if (ArgHandler.StackSize && SNESTargetObjectFile::needsFarEntry(F))
+    return false;
+
+  // Tail calls check their stack arguments fit in ours.
+  MF.getInfo<SNESMachineFunctionInfo>()->setArgumentStackSize(
+      ArgHandler.StackSize);
+
+  return true;
+}
+
+bool SNESCallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
+                                 CallingConv::ID CallConv,
+                                 const MachineOperand &Callee,
+                                 const ArgInfo &OrigRet,
+                                 ArrayRef<ArgInfo> OrigArgs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const auto &TLI = *getTLI<SNESTargetLowering>();
+  const TargetRegisterInfo *TRI = MF.getSubtarget().getRegisterInfo();
+
+  // There is no JSR through a register, SelectionDAG goes through a
+  // trampoline for calls through a pointer.
+  if (Callee.isReg())
+    return false;
+
+  SmallVector<ArgInfo, 8> ArgInfos;
+  for (auto Arg : OrigArgs) {
+    if (!isSupportedType(Arg.Ty) || !Arg.IsFixed)
+      return false;
+
+    Arg.Ty = getCCType(Arg.Ty);
+    ArgInfos.push_back(Arg);
+  }
+
+  if (!OrigRet.Ty->isVoidTy() && !isSupportedType(OrigRet.Ty))
+    return false;
+
+  // SelectionDAG switches DB for a callee with another bank.
+  if (Callee.isGlobal())
+    if (const auto *CalleeF = dyn_cast<Function>(Callee.getGlobal())) {
+      int Bank = SNES::getDataBank(*CalleeF);
+      if (Bank != -1 && Bank != SNES::getEntryDataBank(*MF.getFunction()))
+        return false;
+    }
+
+  auto CallSeqStart = MIRBuilder.buildInstr(SNES::ADJCALLSTACKDOWN);
+
+  // Calls to functions placed in another bank go through their far entry.
+  unsigned CallOpc = SNES::JSRabs;
+  MachineOperand Target = Callee;
+  if (Callee.isGlobal() &&
+      SNESTargetObjectFile::isFarCall(*MF.getFunction(), Callee.getGlobal(),
+                                      /*HasStackArgs=*/false)) {
+    CallOpc = SNES::JSLlong;
+    Target.setTargetFlags(SNESII::MO_FAR);
+  }
+
+  // Create the call instruction so the argument registers can be added to it
+  // as implicit uses, but insert it after the copies into them.
+  auto MIB = MIRBuilder.buildInstrNoInsert(CallOpc).add(Target).addRegMask(
+      TRI->getCallPreservedMask(MF, CallConv));
+
+  OutgoingValueHandler ArgHandler(MIRBuilder, MRI, MIB,
+                                  TLI.CCAssignFnForCall(CallConv, false));
+  if (!handleAssignments(MIRBuilder, ArgInfos, ArgHandler))
+    return false;
+
+  // Stack arguments may have to go through the far entry of a callee in the
+  // same bank, which is left to SelectionDAG.
+  if (ArgHandler.StackSize && CallOpc == SNES::JSRabs) {
+    const auto *CalleeF =
+        Callee.isGlobal() ? dyn_cast<Function>(Callee.getGlobal()) : nullptr;
+    if (!CalleeF || SNESTargetObjectFile::needsFarEntry(*CalleeF))
+      return false;
+  }
+
+  MIRBuilder.insertInstr(MIB);
+
+  if (!OrigRet.Ty->isVoidTy()) {
+    ArgInfo RetInfo = OrigRet;
+    RetInfo.Ty = getCCType(RetInfo.Ty);
+
+    CallReturnHandler RetHandler(MIRBuilder, MRI, MIB,
+                                 TLI.CCAssignFnForReturn(CallConv));
+    if (!handleAssignments(MIRBuilder, RetInfo, RetHandler))
+      return false;
+  }
+
+  // The stack size is only known once the arguments are assigned.
+  CallSeqStart.addImm(ArgHandler.StackSize).addImm(0);
+
+  MIRBuilder.buildInstr(SNES::ADJCALLSTACKUP)
+      .addImm(ArgHandler.StackSize)
+      .addImm(0);
+
+  return true;
+}
+
+} // end of namespace llvm
@@ -0,0 +1,48 @@
+//===-- SNESCallLowering.h - Call lowering ----------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file describes how to lower LLVM calls to machine code calls for
+/// GlobalISel.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_CALL_LOWERING_H
+#define LLVM_SNES_CALL_LOWERING_H
+
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+
+namespace llvm {
+
+class SNESTargetLowering;
+class MachineInstrBuilder;
+
+/// Lowers calls, arguments and returns of at most a word each.
+///
+/// Values which SelectionDAG would split over several registers, and calls
+/// through a pointer, are not handled, and leave the function to
+/// SelectionDAG.
+class SNESCallLowering : public CallLowering {
+public:
+  SNESCallLowering(const SNESTargetLowering &TLI);
+
+  bool lowerReturn(MachineIRBuilder &MIRBuilder, const Value *Val,
+                   unsigned VReg) const override;
+
+  bool lowerFormalArguments(MachineIRBuilder &MIRBuilder, const Function &F,
+                            ArrayRef<unsigned> VRegs) const override;
+
+  bool lowerCall(MachineIRBuilder &MIRBuilder, CallingConv::ID CallConv,
+                 const MachineOperand &Callee, const ArgInfo &OrigRet,
+                 ArrayRef<ArgInfo> OrigArgs) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_CALL_LOWERING_H
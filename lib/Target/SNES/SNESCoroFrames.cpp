@@ -0,0 +1,542 @@
+//===-- SNESCoroFrames.cpp - Static frames for coroutines -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which takes the frames of coroutines from fixed
+// pools in WRAM instead of the heap, which the SNES does not have.
+//
+// The coroutine passes split a coroutine `f` into the ramp `f`, which
+// allocates the frame, and `f.resume`, `f.destroy` and `f.cleanup`, which
+// take the `%f.Frame` and switch on the suspend index kept in it. The frame
+// comes from whatever the frontend calls with llvm.coro.size, malloc or
+// operator new, and goes back through free or operator delete. Once the
+// coroutine is split its frame size is known, and each coroutine gets as
+// many frames as its "snes-coro-frames" attribute says, one by default:
+//
+//   * A single frame is a global. The frame pointer becomes a constant, so
+//     the frame is accessed with absolute addresses instead of (dp),Y, next
+//     to a byte in the direct page which says if the frame is taken.
+//   * A pool of frames has a byte per frame which says if it is taken.
+//
+// When all the frames are taken, the allocation gives null, like a failed
+// malloc.
+//
+// The suspend index moves out of the frame into the direct page, a byte for
+// each frame, unless something else than the coroutine may reach it. In a
+// pool, the byte of a frame is found by comparing the frame pointer with the
+// frames after the first. The switch on the suspend index has no default, so
+// it becomes a single `JMP (table,X)` on that byte.
+//
+// The size of the frames is given to the linker as the absolute symbol
+// `<coroutine>.frames.size`, so that a linker script can check what all the
+// coroutines take from WRAM.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstring>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "snes-coro-frames"
+
+STATISTIC(NumCoroutines, "Number of coroutines given static frames");
+STATISTIC(NumStatesInDP, "Number of suspend indexes moved to the direct page");
+
+#define SNES_CORO_FRAMES_NAME "SNES coroutine frame allocation pass"
+
+namespace {
+
+/// The fields the coroutine passes put first in a frame, see CoroFrame.cpp.
+enum { ResumeField, DestroyField, PromiseField, IndexField };
+
+/// A coroutine after it was split.
+struct Coroutine {
+  Function *Ramp;
+  /// The resume, destroy and cleanup functions, which take the frame.
+  SmallVector<Function *, 3> Clones;
+  StructType *FrameTy;
+  /// The calls which allocate the frame, and the values the allocation goes
+  /// through before it is cast to the frame type.
+  SmallVector<CallInst *, 2> Allocs;
+  SmallPtrSet<Value *, 8> Memory;
+  /// The frame pointers: the casts of the allocation in the ramp and the
+  /// argument of the clones.
+  SmallVector<Value *, 4> FramePtrs;
+  /// The calls which free the frame.
+  SmallVector<CallInst *, 4> Frees;
+};
+
+class SNESCoroFrames : public ModulePass {
+public:
+  static char ID;
+
+  SNESCoroFrames() : ModulePass(ID) {
+    initializeSNESCoroFramesPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  StringRef getPassName() const override { return SNES_CORO_FRAMES_NAME; }
+
+private:
+  bool findCoroutine(Function &Resume, Coroutine &C);
+  void findFrees(Function &F, Coroutine &C);
+  bool findStateAccesses(Coroutine &C,
+                         SmallVectorImpl<GetElementPtrInst *> &Accesses);
+  void moveStates(Coroutine &C, GlobalVariable *Pool, unsigned Count);
+  void useSingleFrame(Coroutine &C);
+  void usePool(Coroutine &C, unsigned Count);
+};
+
+char SNESCoroFrames::ID = 0;
+
+/// Checks if a call gives memory back to the heap.
+static bool isDeallocation(const CallInst &Call) {
+  const Function *Callee = Call.getCalledFunction();
+  return Callee && Call.getNumArgOperands() >= 1 &&
+         StringSwitch<bool>(Callee->getName())
+             .Cases("free", "_ZdlPv", "_ZdlPvj", "_ZdlPvm", true)
+             .Default(false);
+}
+
+/// The number of frames a coroutine gets.
+static unsigned getFrameCount(const Function &F) {
+  Attribute Attr = F.getFnAttribute("snes-coro-frames");
+  if (!Attr.isStringAttribute())
+    return 1;
+
+  unsigned Count;
+  if (Attr.getValueAsString().getAsInteger(0, Count) || Count == 0)
+    report_fatal_error("SNES: invalid \"snes-coro-frames\" attribute on '" +
+                       F.getName() + "'");
+  return Count;
+}
+
+bool SNESCoroFrames::findCoroutine(Function &Resume, Coroutine &C) {
+  StringRef Base = Resume.getName().drop_back(strlen(".resume"));
+  Module &M = *Resume.getParent();
+
+  C.Ramp = M.getFunction(Base);
+  if (!C.Ramp || C.Ramp->isDeclaration() || Resume.isDeclaration() ||
+      Resume.arg_size() != 1)
+    return false;
+
+  auto *FramePtrTy = dyn_cast<PointerType>(Resume.arg_begin()->getType());
+  C.FrameTy = FramePtrTy ? dyn_cast<StructType>(FramePtrTy->getElementType())
+                         : nullptr;
+  if (!C.FrameTy || !C.FrameTy->hasName() ||
+      !C.FrameTy->getName().startswith((Base + ".Frame").str()))
+    return false;
+
+  for (const char *Suffix : {".resume", ".destroy", ".cleanup"}) {
+    Function *Clone = M.getFunction((Base + Suffix).str());
+    if (Clone && !Clone->isDeclaration() && Clone->arg_size() == 1 &&
+        Clone->arg_begin()->getType() == FramePtrTy) {
+      C.Clones.push_back(Clone);
+      C.FramePtrs.push_back(&*Clone->arg_begin());
+    }
+  }
+
+  // The frame is the allocation cast to the frame type, through a phi with
+  // null when coro.alloc may say that it is already allocated.
+  for (Instruction &I : instructions(*C.Ramp))
+    if (auto *Cast = dyn_cast<BitCastInst>(&I))
+      if (Cast->getDestTy() == FramePtrTy)
+        C.FramePtrs.push_back(Cast);
+  if (C.FramePtrs.size() == C.Clones.size())
+    return false;
+
+  SmallVector<Value *, 4> Worklist;
+  for (Value *FramePtr : C.FramePtrs)
+    if (auto *Cast = dyn_cast<BitCastInst>(FramePtr))
+      Worklist.push_back(Cast->getOperand(0));
+
+  while (!Worklist.empty()) {
+    Value *V = Worklist.pop_back_val();
+    if (isa<ConstantPointerNull>(V) || !C.Memory.insert(V).second)
+      continue;
+
+    if (auto *Phi = dyn_cast<PHINode>(V)) {
+      for (Value *Incoming : Phi->incoming_values())
+        Worklist.push_back(Incoming);
+    } else if (auto *Call = dyn_cast<CallInst>(V)) {
+      if (!Call->getCalledFunction())
+        return false;
+      C.Allocs.push_back(Call);
+    } else {
+      return false;
+    }
+  }
+  if (C.Allocs.empty())
+    return false;
+
+  findFrees(*C.Ramp, C);
+  for (Function *Clone : C.Clones)
+    findFrees(*Clone, C);
+  return true;
+}
+
+/// Finds the calls which free the frame in a function of the coroutine.
+void SNESCoroFrames::findFrees(Function &F, Coroutine &C) {
+  for (Instruction &I : instructions(F)) {
+    auto *Call = dyn_cast<CallInst>(&I);
+    if (!Call || !isDeallocation(*Call))
+      continue;
+
+    Value *Freed = Call->getArgOperand(0)->stripPointerCasts();
+    if (C.Memory.count(Freed) || is_contained(C.FramePtrs, Freed))
+      C.Frees.push_back(Call);
+  }
+}
+
+static bool isOnlyHandle(const Value *V, const SmallPtrSetImpl<Value *> &Memory,
+                         unsigned Depth = 0);
+
+/// Checks if a use of a pointer to the frame only passes it on as a handle,
+/// whose users only read the resume and destroy fields.
+static bool isHandleUse(const Value *V, const User *U,
+                        const SmallPtrSetImpl<Value *> &Memory,
+                        unsigned Depth = 0) {
+  if (isa<ReturnInst>(U) || isa<CallInst>(U) || isa<ICmpInst>(U) ||
+      Memory.count(const_cast<User *>(U)))
+    return true;
+  if (auto *Store = dyn_cast<StoreInst>(U))
+    return Store->getValueOperand() == V;
+  return isa<BitCastInst>(U) && Depth < 4 && isOnlyHandle(U, Memory, Depth + 1);
+}
+
+static bool isOnlyHandle(const Value *V, const SmallPtrSetImpl<Value *> &Memory,
+                         unsigned Depth) {
+  for (const User *U : V->users())
+    if (!isHandleUse(V, U, Memory, Depth))
+      return false;
+  return true;
+}
+
+/// Collects the addresses of the suspend index, and checks that it is not
+/// reached in any other way.
+bool SNESCoroFrames::findStateAccesses(
+    Coroutine &C, SmallVectorImpl<GetElementPtrInst *> &Accesses) {
+  for (Value *FramePtr : C.FramePtrs) {
+    for (User *U : FramePtr->users()) {
+      auto *GEP = dyn_cast<GetElementPtrInst>(U);
+      if (!GEP) {
+        if (!isHandleUse(FramePtr, U, C.Memory))
+          return false;
+        continue;
+      }
+
+      if (GEP->getNumIndices() < 2 || !GEP->hasAllConstantIndices() ||
+          !cast<ConstantInt>(GEP->getOperand(1))->isZero())
+        return false;
+      if (cast<ConstantInt>(GEP->getOperand(2))->getZExtValue() != IndexField)
+        continue;
+
+      // Only loads and stores of the index itself.
+      if (GEP->getNumIndices() != 2)
+        return false;
+      for (User *Access : GEP->users()) {
+        if (isa<LoadInst>(Access))
+          continue;
+        auto *Store = dyn_cast<StoreInst>(Access);
+        if (!Store || Store->getValueOperand() == GEP)
+          return false;
+      }
+      Accesses.push_back(GEP);
+    }
+  }
+
+  // The allocation itself may only become a frame pointer or a handle.
+  for (Value *V : C.Memory)
+    for (User *U : V->users())
+      if (!is_contained(C.FramePtrs, U) && !isHandleUse(V, U, C.Memory))
+        return false;
+  return true;
+}
+
+/// Gives the frames of a coroutine the absolute symbol
+/// `<coroutine>.frames.size`, their size in bytes.
+static void emitSizeSymbol(const Coroutine &C, const GlobalVariable &Frames) {
+  Module &M = *C.Ramp->getParent();
+  const DataLayout &DL = M.getDataLayout();
+  uint64_t Size = DL.getTypeAllocSize(Frames.getValueType());
+
+  Type *SymbolTy = ArrayType::get(Type::getInt8Ty(M.getContext()), 0);
+  Constant *Value = ConstantExpr::getIntToPtr(
+      ConstantInt::get(DL.getIntPtrType(M.getContext()), Size),
+      SymbolTy->getPointerTo());
+  GlobalAlias::create(SymbolTy, 0,
+                      C.Ramp->hasLocalLinkage() ? GlobalValue::InternalLinkage
+                                                : GlobalValue::ExternalLinkage,
+                      C.Ramp->getName() + ".frames.size", Value, &M);
+}
+
+/// The number of the frame of a pool a frame pointer points to.
+static Value *getSlot(IRBuilder<> &B, Value *FramePtr, GlobalVariable *Pool,
+                      unsigned Count) {
+  Value *Slot = B.getInt16(0);
+  for (unsigned I = 1; I != Count; ++I) {
+    Constant *Frame = ConstantExpr::getInBoundsGetElementPtr(
+        Pool->getValueType(), Pool,
+        ArrayRef<Constant *>{B.getInt16(0), B.getInt16(I)});
+    Slot = B.CreateSelect(B.CreateICmpEQ(FramePtr, Frame), B.getInt16(I), Slot);
+  }
+  return Slot;
+}
+
+/// Moves the suspend index out of the frames into the direct page, before
+/// the frame pointers are replaced. Pool is null for a single frame.
+void SNESCoroFrames::moveStates(Coroutine &C, GlobalVariable *Pool,
+                                unsigned Count) {
+  SmallVector<GetElementPtrInst *, 8> StateAccesses;
+  if (!findStateAccesses(C, StateAccesses) || StateAccesses.empty())
+    return;
+
+  Module &M = *C.Ramp->getParent();
+  Type *StateTy = C.FrameTy->getElementType(IndexField);
+  Type *StatesTy = Pool ? ArrayType::get(StateTy, Count) : StateTy;
+  auto *States = new GlobalVariable(
+      M, StatesTy, false, GlobalValue::InternalLinkage,
+      Constant::getNullValue(StatesTy),
+      C.Ramp->getName() + (Pool ? ".states" : ".state"), nullptr,
+      GlobalVariable::NotThreadLocal, SNES::DirectPage);
+
+  // The slot of a frame pointer is found once, where it is defined. Only
+  // the stores to the state are behind the check of a failed allocation.
+  DenseMap<Value *, Value *> Slots;
+  for (GetElementPtrInst *GEP : StateAccesses) {
+    Value *State;
+    if (Pool) {
+      Value *FramePtr = GEP->getPointerOperand();
+      Value *&Slot = Slots[FramePtr];
+      if (!Slot) {
+        auto *Cast = dyn_cast<Instruction>(FramePtr);
+        IRBuilder<> B(Cast ? &*std::next(Cast->getIterator())
+                           : &*GEP->getFunction()->getEntryBlock()
+                                   .getFirstInsertionPt());
+        Slot = getSlot(B, FramePtr, Pool, Count);
+      }
+      IRBuilder<> B(GEP);
+      State = B.CreatePointerBitCastOrAddrSpaceCast(
+          B.CreateInBoundsGEP(StatesTy, States, {B.getInt16(0), Slot}),
+          GEP->getType());
+    } else {
+      State = ConstantExpr::getPointerBitCastOrAddrSpaceCast(States,
+                                                             GEP->getType());
+    }
+    GEP->replaceAllUsesWith(State);
+    GEP->eraseFromParent();
+  }
+  ++NumStatesInDP;
+}
+
+void SNESCoroFrames::useSingleFrame(Coroutine &C) {
+  Module &M = *C.Ramp->getParent();
+  LLVMContext &Ctx = M.getContext();
+
+  // Move the suspend index out first, while the frame pointers can still
+  // be told apart from the other constants.
+  moveStates(C, nullptr, 1);
+
+  auto *Frame = new GlobalVariable(
+      M, C.FrameTy, false, GlobalValue::InternalLinkage,
+      ConstantAggregateZero::get(C.FrameTy), C.Ramp->getName() + ".frame");
+  emitSizeSymbol(C, *Frame);
+  Type *Int8Ty = Type::getInt8Ty(Ctx);
+  auto *Taken = new GlobalVariable(
+      M, Int8Ty, false, GlobalValue::InternalLinkage,
+      ConstantInt::get(Int8Ty, 0), C.Ramp->getName() + ".frame.taken",
+      nullptr, GlobalVariable::NotThreadLocal, SNES::DirectPage);
+  Constant *FramePtr = ConstantExpr::getBitCast(Frame, Type::getInt8PtrTy(Ctx));
+
+  // The frame goes back only when it is the one freed, the ramp may free
+  // the null it got when the frame was taken.
+  for (CallInst *Call : C.Frees) {
+    IRBuilder<> B(Call);
+    Value *Freed = B.CreateBitCast(Call->getArgOperand(0), FramePtr->getType());
+    Value *IsFrame = B.CreateICmpEQ(Freed, FramePtr);
+    B.CreateStore(B.CreateSelect(IsFrame, B.getInt8(0), B.CreateLoad(Taken)),
+                  Taken);
+    Call->eraseFromParent();
+  }
+  for (CallInst *Call : C.Allocs) {
+    IRBuilder<> B(Call);
+    Value *IsTaken = B.CreateICmpNE(B.CreateLoad(Taken), B.getInt8(0));
+    B.CreateStore(B.getInt8(1), Taken);
+    auto *FramePtrTy = cast<PointerType>(FramePtr->getType());
+    Value *Alloc = B.CreateSelect(
+        IsTaken, ConstantPointerNull::get(FramePtrTy), FramePtr);
+    Call->replaceAllUsesWith(B.CreateBitCast(Alloc, Call->getType()));
+    Call->eraseFromParent();
+  }
+
+  // The clones only run on a frame which was given out.
+  for (Function *Clone : C.Clones)
+    Clone->arg_begin()->replaceAllUsesWith(Frame);
+}
+
+void SNESCoroFrames::usePool(Coroutine &C, unsigned Count) {
+  Module &M = *C.Ramp->getParent();
+  LLVMContext &Ctx = M.getContext();
+  Type *Int8PtrTy = Type::getInt8PtrTy(Ctx);
+  StringRef Base = C.Ramp->getName();
+
+  ArrayType *PoolTy = ArrayType::get(C.FrameTy, Count);
+  auto *Pool = new GlobalVariable(M, PoolTy, false,
+                                  GlobalValue::InternalLinkage,
+                                  ConstantAggregateZero::get(PoolTy),
+                                  Base + ".frames");
+  emitSizeSymbol(C, *Pool);
+  moveStates(C, Pool, Count);
+  ArrayType *TakenTy = ArrayType::get(Type::getInt8Ty(Ctx), Count);
+  auto *Taken = new GlobalVariable(M, TakenTy, false,
+                                   GlobalValue::InternalLinkage,
+                                   ConstantAggregateZero::get(TakenTy),
+                                   Base + ".frames.taken");
+
+  // i8* alloc(): the first frame which is not taken, or null.
+  auto *Alloc = Function::Create(FunctionType::get(Int8PtrTy, false),
+                                 GlobalValue::InternalLinkage,
+                                 Base + ".frame.alloc", &M);
+  {
+    auto *Entry = BasicBlock::Create(Ctx, "entry", Alloc);
+    auto *Loop = BasicBlock::Create(Ctx, "loop", Alloc);
+    auto *Take = BasicBlock::Create(Ctx, "take", Alloc);
+    auto *Next = BasicBlock::Create(Ctx, "next", Alloc);
+    auto *Fail = BasicBlock::Create(Ctx, "fail", Alloc);
+
+    IRBuilder<> B(Entry);
+    B.CreateBr(Loop);
+
+    B.SetInsertPoint(Loop);
+    PHINode *I = B.CreatePHI(B.getInt16Ty(), 2, "i");
+    I->addIncoming(B.getInt16(0), Entry);
+    Value *TakenAddr = B.CreateInBoundsGEP(TakenTy, Taken, {B.getInt16(0), I});
+    Value *IsTaken = B.CreateICmpNE(B.CreateLoad(TakenAddr), B.getInt8(0));
+    B.CreateCondBr(IsTaken, Next, Take);
+
+    B.SetInsertPoint(Take);
+    B.CreateStore(B.getInt8(1), TakenAddr);
+    Value *Frame = B.CreateInBoundsGEP(PoolTy, Pool, {B.getInt16(0), I});
+    B.CreateRet(B.CreateBitCast(Frame, Int8PtrTy));
+
+    B.SetInsertPoint(Next);
+    Value *NextI = B.CreateAdd(I, B.getInt16(1));
+    I->addIncoming(NextI, Next);
+    B.CreateCondBr(B.CreateICmpEQ(NextI, B.getInt16(Count)), Fail, Loop);
+
+    B.SetInsertPoint(Fail);
+    B.CreateRet(ConstantPointerNull::get(cast<PointerType>(Int8PtrTy)));
+  }
+
+  // void free(i8*): gives the frame back, does nothing for null.
+  auto *Free = Function::Create(
+      FunctionType::get(Type::getVoidTy(Ctx), Int8PtrTy, false),
+      GlobalValue::InternalLinkage, Base + ".frame.free", &M);
+  {
+    auto *Entry = BasicBlock::Create(Ctx, "entry", Free);
+    auto *Loop = BasicBlock::Create(Ctx, "loop", Free);
+    auto *Found = BasicBlock::Create(Ctx, "found", Free);
+    auto *Next = BasicBlock::Create(Ctx, "next", Free);
+    auto *Done = BasicBlock::Create(Ctx, "done", Free);
+
+    IRBuilder<> B(Entry);
+    B.CreateBr(Loop);
+
+    B.SetInsertPoint(Loop);
+    PHINode *I = B.CreatePHI(B.getInt16Ty(), 2, "i");
+    I->addIncoming(B.getInt16(0), Entry);
+    Value *Frame = B.CreateBitCast(
+        B.CreateInBoundsGEP(PoolTy, Pool, {B.getInt16(0), I}), Int8PtrTy);
+    B.CreateCondBr(B.CreateICmpEQ(Frame, &*Free->arg_begin()), Found, Next);
+
+    B.SetInsertPoint(Found);
+    B.CreateStore(B.getInt8(0),
+                  B.CreateInBoundsGEP(TakenTy, Taken, {B.getInt16(0), I}));
+    B.CreateRetVoid();
+
+    B.SetInsertPoint(Next);
+    Value *NextI = B.CreateAdd(I, B.getInt16(1));
+    I->addIncoming(NextI, Next);
+    B.CreateCondBr(B.CreateICmpEQ(NextI, B.getInt16(Count)), Done, Loop);
+
+    B.SetInsertPoint(Done);
+    B.CreateRetVoid();
+  }
+
+  for (CallInst *Call : C.Frees) {
+    IRBuilder<> B(Call);
+    B.CreateCall(Free, B.CreateBitCast(Call->getArgOperand(0), Int8PtrTy));
+    Call->eraseFromParent();
+  }
+  for (CallInst *Call : C.Allocs) {
+    IRBuilder<> B(Call);
+    Value *Frame = B.CreateCall(Alloc);
+    Call->replaceAllUsesWith(B.CreateBitCast(Frame, Call->getType()));
+    Call->eraseFromParent();
+  }
+}
+
+bool SNESCoroFrames::runOnModule(Module &M) {
+  SmallVector<Function *, 8> Resumes;
+  for (Function &F : M)
+    if (F.getName().endswith(".resume"))
+      Resumes.push_back(&F);
+
+  bool Modified = false;
+  for (Function *Resume : Resumes) {
+    Coroutine C;
+    if (!findCoroutine(*Resume, C))
+      continue;
+
+    unsigned Count = getFrameCount(*C.Ramp);
+    DEBUG(dbgs() << "Coroutine " << C.Ramp->getName() << ": " << Count
+                 << " static frame(s)\n");
+
+    if (Count == 1)
+      useSingleFrame(C);
+    else
+      usePool(C, Count);
+
+    ++NumCoroutines;
+    Modified = true;
+  }
+
+  return Modified;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESCoroFrames, "snes-coro-frames", SNES_CORO_FRAMES_NAME,
+                false, false)
+
+namespace llvm {
+
+ModulePass *createSNESCoroFramesPass() { return new SNESCoroFrames(); }
+
+} // end of namespace llvm
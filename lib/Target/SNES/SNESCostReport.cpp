@@ -0,0 +1,219 @@
+//===-- SNESCostReport.cpp - Code size and cycles of functions ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the report of the code size and the cycles of the
+// functions of a module.
+//
+// There is no 65c816 simulator in the tree, so the cycles are worked out from
+// the code: each instruction costs what the data sheet gives for its
+// addressing mode, and each block counts as often as the block frequencies
+// say it runs per call. The figures are meant to be compared with each other,
+// before and after a change to the backend, not with a real SNES.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNESCostReport.h"
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESSubtarget.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineBranchProbabilityInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> CostReport(
+    "snes-cost-report", cl::Hidden, cl::init(""),
+    cl::desc("Write the code size and the estimated cycles per call of each "
+             "function to this file, - for stdout"));
+
+/// Checks if an instruction works on 8 bits, with M or X set around it.
+static bool is8Bit(const MachineInstr &MI) {
+  for (const MachineOperand &MO : MI.operands())
+    if (MO.isReg() && (MO.getReg() == SNES::AL || MO.getReg() == SNES::XL ||
+                       MO.getReg() == SNES::YL))
+      return true;
+
+  if (MI.memoperands_empty())
+    return false;
+  for (const MachineMemOperand *MMO : MI.memoperands())
+    if (MMO->getSize() != 1)
+      return false;
+  return true;
+}
+
+/// The cycles an instruction takes, with a taken branch counted apart.
+static unsigned getCycles(const MachineInstr &MI, unsigned Size) {
+  switch (MI.getOpcode()) {
+  case SNES::PHB:
+  case SNES::PHP:
+  case SNES::SEP:
+  case SNES::REP:
+  case SNES::XBA:
+  case SNES::WAI:
+  case SNES::RJMPk:
+  case SNES::JMPabs:
+    return 3;
+  case SNES::PHAstk:
+  case SNES::PHX:
+  case SNES::PHY:
+  case SNES::PLB:
+  case SNES::PLP:
+    return 4;
+  case SNES::PEA:
+  case SNES::PLA:
+  case SNES::PLX:
+  case SNES::PLY:
+    return 5;
+  case SNES::JSRabs:
+  case SNES::JMPabsxind:
+  case SNES::RTS:
+  case SNES::RTL:
+    return 6;
+  case SNES::JSLlong:
+    return 8;
+  case SNES::LDAindy8:
+  case SNES::STAindy8:
+    return 6;
+  case SNES::LDAindy16:
+  case SNES::STAindy16:
+  case SNES::LDAsry8:
+  case SNES::STAsry8:
+    return 7;
+  case SNES::LDAsry16:
+  case SNES::STAsry16:
+    return 8;
+  case SNES::LDAsr8:
+  case SNES::STAsr8:
+  case SNES::ADCsr8:
+  case SNES::SBCsr8:
+  case SNES::ANDsr8:
+  case SNES::ORAsr8:
+  case SNES::EORsr8:
+    return 4;
+  case SNES::LDAsr16:
+  case SNES::STAsr16:
+  case SNES::ADCsr16:
+  case SNES::SBCsr16:
+  case SNES::ANDsr16:
+  case SNES::ORAsr16:
+  case SNES::EORsr16:
+    return 5;
+  default:
+    break;
+  }
+
+  if (MI.isConditionalBranch())
+    return 2;
+
+  // The rest by addressing mode, from the size: implied, immediate or direct
+  // page, immediate or absolute, and long. An 8-bit access takes one cycle
+  // less, two for a read-modify-write, and indexing adds one.
+  bool IsMemory = MI.mayLoad() || MI.mayStore();
+  bool IsRMW = MI.mayLoad() && MI.mayStore();
+  unsigned Cycles;
+  switch (Size) {
+  case 1:
+    return 2;
+  case 2:
+    Cycles = IsRMW ? 7 : IsMemory ? 4 : 3;
+    break;
+  case 3:
+    Cycles = IsRMW ? 8 : IsMemory ? 5 : 3;
+    break;
+  default:
+    Cycles = 6;
+    break;
+  }
+
+  if (IsMemory && (MI.readsRegister(SNES::X) || MI.readsRegister(SNES::Y)))
+    ++Cycles;
+  if (is8Bit(MI))
+    Cycles -= IsRMW ? 2 : 1;
+  return Cycles;
+}
+
+bool SNESCostReport::isEnabled() { return !CostReport.empty(); }
+
+void SNESCostReport::addFunction(const MachineFunction &MF,
+                                 const MachineBlockFrequencyInfo &MBFI,
+                                 const MachineBranchProbabilityInfo &MBPI) {
+  const SNESInstrInfo &TII = *MF.getSubtarget<SNESSubtarget>().getInstrInfo();
+  double EntryFreq = MBFI.getEntryFreq();
+
+  uint64_t Size = 0;
+  double Cycles = 0;
+  for (const MachineBasicBlock &MBB : MF) {
+    double Runs = MBFI.getBlockFreq(&MBB).getFrequency() / EntryFreq;
+
+    double BlockCycles = 0;
+    for (const MachineInstr &MI : MBB) {
+      unsigned InstSize = TII.getInstSizeInBytes(MI);
+      if (MI.isMetaInstruction() || InstSize == 0)
+        continue;
+
+      Size += InstSize;
+      BlockCycles += getCycles(MI, InstSize);
+
+      // A taken branch takes one more cycle.
+      if (MI.isConditionalBranch())
+        for (const MachineOperand &MO : MI.operands())
+          if (MO.isMBB()) {
+            BranchProbability Taken =
+                MBPI.getEdgeProbability(&MBB, MO.getMBB());
+            BlockCycles +=
+                double(Taken.getNumerator()) / Taken.getDenominator();
+          }
+    }
+    Cycles += Runs * BlockCycles;
+  }
+
+  FunctionCost &Cost = Functions[MF.getName()];
+  Cost.Size = Size;
+  Cost.Cycles = uint64_t(Cycles + 0.5);
+}
+
+void SNESCostReport::finish(const Module &M) {
+  std::error_code EC;
+  raw_fd_ostream File(CostReport, EC, sys::fs::F_Text);
+  if (EC)
+    report_fatal_error("SNES: cannot open the cost report '" + CostReport +
+                       "': " + EC.message());
+
+  std::vector<StringRef> Names;
+  for (auto &Entry : Functions)
+    Names.push_back(Entry.first());
+  std::sort(Names.begin(), Names.end());
+
+  uint64_t TotalSize = 0;
+  File << "Cost of " << M.getModuleIdentifier()
+      << ", in bytes and estimated cycles per call:\n";
+  for (StringRef Name : Names) {
+    const FunctionCost &Cost = Functions[Name];
+    File << format("  %-32s size %6llu, cycles %8llu\n", Name.str().c_str(),
+                  (unsigned long long)Cost.Size,
+                  (unsigned long long)Cost.Cycles);
+    TotalSize += Cost.Size;
+  }
+  File << format("\nTotal size: %llu bytes\n", (unsigned long long)TotalSize);
+}
@@ -0,0 +1,64 @@
+//===-- SNESCostReport.h - Code size and cycles of functions ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the report of the code size and the cycles of the
+// functions of a module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_COST_REPORT_H
+#define LLVM_SNES_COST_REPORT_H
+
+#include "llvm/ADT/StringMap.h"
+
+#include <cstdint>
+
+namespace llvm {
+
+class MachineBlockFrequencyInfo;
+class MachineBranchProbabilityInfo;
+class MachineFunction;
+class Module;
+
+/// Measures the code the asm printer emits, for the benchmarks in
+/// test/CodeGen/SNES/Bench and utils/snes-bench.py.
+///
+/// The size is the bytes of the instructions. The cycles are an estimate of
+/// one call: the cycles of each block from the instruction timings, with M
+/// and X clear, the direct page aligned and no page crossed, weighted by how
+/// often the block runs per entry. The block frequencies come from the
+/// branch weights, so a benchmark gives its loops their trip counts with
+/// !prof metadata.
+///
+/// Only done when asked for with -snes-cost-report.
+class SNESCostReport {
+public:
+  /// Checks if the report was asked for.
+  static bool isEnabled();
+
+  /// Measures a function.
+  void addFunction(const MachineFunction &MF,
+                   const MachineBlockFrequencyInfo &MBFI,
+                   const MachineBranchProbabilityInfo &MBPI);
+
+  /// Writes the report.
+  void finish(const Module &M);
+
+private:
+  struct FunctionCost {
+    uint64_t Size;
+    uint64_t Cycles;
+  };
+
+  StringMap<FunctionCost> Functions;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_COST_REPORT_H
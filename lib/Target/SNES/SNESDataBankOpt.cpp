@@ -0,0 +1,410 @@
+//===-- SNESDataBankOpt.cpp - Track the data bank register ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which follows the value of the data bank register
+// (DB) through a function and removes the bank switches that do not change
+// it.
+//
+// DB is preserved across calls. A function with the "snes-data-bank"
+// attribute is only called with DB holding that bank, and otherwise DB is
+// unknown on entry. The calls to such a function switch DB around the call:
+//
+//   PHB; PEA #$nnnn; PLB; PLB; JSR f; PLB     from a function whose bank is
+//                                            not known
+//   PEA #$nnnn; PLB; PLB; JSR f; PEA #$mmmm; PLB; PLB
+//                                            from a function in bank $mm
+//
+// The pass:
+//
+//   * removes a switch when nothing uses DB before the next one,
+//   * removes a PLB which restores DB only for a PHB to save it again before
+//     the next switch,
+//   * removes switches to the bank DB already holds,
+//   * removes a PHB/PLB pair which restores the value DB has anyway,
+//   * turns long loads and stores of data in the bank DB holds into absolute
+//     ones, which are a byte shorter and a cycle faster.
+//
+// so that calls in a row to functions of the same bank switch only once.
+//
+// The bank of a symbol is only known when it is placed in a `.bank<nn>`
+// section.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESTargetMachine.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/IR/GlobalObject.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+#define SNES_DATA_BANK_OPT_NAME "SNES data bank optimization pass"
+
+namespace {
+
+/// A value of DB, or of a byte on the stack.
+enum : int { UnknownBank = -1 };
+
+class SNESDataBankOpt : public MachineFunctionPass {
+public:
+  static char ID;
+
+  SNESDataBankOpt() : MachineFunctionPass(ID) {
+    initializeSNESDataBankOptPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return SNES_DATA_BANK_OPT_NAME; }
+
+private:
+  typedef MachineBasicBlock Block;
+  typedef Block::iterator BlockIt;
+
+  /// What is known within a block: DB and the bytes pushed so far.
+  struct State {
+    int DB;
+    SmallVector<int, 4> Stack;
+    /// Something else was pushed or popped, the stack is unknown.
+    bool StackKnown;
+
+    explicit State(int DB) : DB(DB), StackKnown(true) {}
+  };
+
+  const SNESInstrInfo *TII;
+  const TargetRegisterInfo *TRI;
+
+  /// The value of DB on entry to each block.
+  DenseMap<const Block *, int> BlockIn;
+
+  void computeBlockIn(MachineFunction &MF);
+  void step(const MachineInstr &MI, State &S) const;
+  bool optimizeBlock(Block &MBB);
+
+  bool isBankSwitch(BlockIt I, BlockIt E, int &Bank) const;
+  bool mayReadBank(const MachineInstr &MI) const;
+  bool isDeadSwitch(BlockIt I, BlockIt E) const;
+  bool removeRestoreAndSave(BlockIt PLB, BlockIt E);
+  bool removeRedundantSave(BlockIt PHB, BlockIt E, int DB);
+  bool rewriteLong(MachineInstr &MI, int DB) const;
+};
+
+char SNESDataBankOpt::ID = 0;
+
+/// Parses the bank out of a `.bank<nn>` section name.
+static int getSectionBank(StringRef Section) {
+  if (!Section.consume_front(".bank"))
+    return UnknownBank;
+
+  unsigned Bank;
+  if (Section.substr(0, 2).getAsInteger(16, Bank) || Bank > 0xFF)
+    return UnknownBank;
+  return Bank;
+}
+
+/// The bank of the data a long access refers to.
+static int getOperandBank(const MachineOperand &MO) {
+  if (!MO.isGlobal())
+    return UnknownBank;
+
+  const auto *GO = dyn_cast<GlobalObject>(MO.getGlobal());
+  if (!GO || !GO->hasSection())
+    return UnknownBank;
+  return getSectionBank(GO->getSection());
+}
+
+static int meet(int A, int B) { return A == B ? A : UnknownBank; }
+
+void SNESDataBankOpt::step(const MachineInstr &MI, State &S) const {
+  switch (MI.getOpcode()) {
+  case SNES::PHB:
+    S.Stack.push_back(S.DB);
+    return;
+  case SNES::PEA:
+    if (MI.getOperand(0).isImm()) {
+      int64_t Imm = MI.getOperand(0).getImm();
+      S.Stack.push_back((Imm >> 8) & 0xFF);
+      S.Stack.push_back(Imm & 0xFF);
+    } else {
+      S.Stack.push_back(UnknownBank);
+      S.Stack.push_back(UnknownBank);
+    }
+    return;
+  case SNES::PLB:
+    if (S.StackKnown && !S.Stack.empty()) {
+      S.DB = S.Stack.pop_back_val();
+    } else {
+      S.DB = UnknownBank;
+      S.StackKnown = false;
+    }
+    return;
+  default:
+    break;
+  }
+
+  // Calls preserve DB and leave the stack as it was.
+  if (MI.isCall())
+    return;
+
+  if (MI.isInlineAsm() || MI.modifiesRegister(SNES::DB, TRI))
+    S.DB = UnknownBank;
+
+  if (MI.modifiesRegister(SNES::SP, TRI)) {
+    S.Stack.clear();
+    S.StackKnown = false;
+  }
+}
+
+void SNESDataBankOpt::computeBlockIn(MachineFunction &MF) {
+  BlockIn.clear();
+
+  // Blocks not reached yet are left out of the meet.
+  DenseMap<const Block *, int> BlockOut;
+  ReversePostOrderTraversal<MachineFunction *> RPOT(&MF);
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (Block *MBB : RPOT) {
+      int In;
+      if (MBB == &MF.front()) {
+        In = SNES::getEntryDataBank(*MF.getFunction());
+      } else {
+        bool Seen = false;
+        In = UnknownBank;
+        for (const Block *Pred : MBB->predecessors()) {
+          auto Out = BlockOut.find(Pred);
+          if (Out == BlockOut.end())
+            continue;
+          In = Seen ? meet(In, Out->second) : Out->second;
+          Seen = true;
+        }
+      }
+
+      State S(In);
+      for (const MachineInstr &MI : *MBB)
+        step(MI, S);
+
+      auto It = BlockIn.find(MBB);
+      if (It != BlockIn.end() && It->second == In &&
+          BlockOut.lookup(MBB) == S.DB)
+        continue;
+
+      BlockIn[MBB] = In;
+      BlockOut[MBB] = S.DB;
+      Changed = true;
+    }
+  }
+}
+
+/// Matches `PEA #$nnnn; PLB; PLB` with both bytes the same bank.
+bool SNESDataBankOpt::isBankSwitch(BlockIt I, BlockIt E, int &Bank) const {
+  if (I->getOpcode() != SNES::PEA || !I->getOperand(0).isImm())
+    return false;
+
+  int64_t Imm = I->getOperand(0).getImm();
+  if (((Imm >> 8) & 0xFF) != (Imm & 0xFF))
+    return false;
+
+  for (unsigned N = 0; N != 2; ++N)
+    if (++I == E || I->getOpcode() != SNES::PLB)
+      return false;
+
+  Bank = Imm & 0xFF;
+  return true;
+}
+
+/// Checks if an instruction may access memory through DB, or see its value.
+bool SNESDataBankOpt::mayReadBank(const MachineInstr &MI) const {
+  if (SNESInstrInfo::isStackRelative(MI))
+    return false;
+  return MI.isCall() || MI.isInlineAsm() || MI.mayLoadOrStore() ||
+         MI.readsRegister(SNES::DB, TRI) || MI.modifiesRegister(SNES::DB, TRI);
+}
+
+/// Checks if the bank switch which ends before \p I is switched again before
+/// DB is used.
+bool SNESDataBankOpt::isDeadSwitch(BlockIt I, BlockIt E) const {
+  int Bank;
+  for (; I != E; ++I) {
+    if (isBankSwitch(I, E, Bank))
+      return true;
+    if (mayReadBank(*I))
+      return false;
+  }
+  return false;
+}
+
+/// Removes a PLB and the PHB which saves the restored DB again, when a bank
+/// switch follows and nothing in between uses DB or the stack. The saved
+/// value then stays on the stack for the next PLB.
+bool SNESDataBankOpt::removeRestoreAndSave(BlockIt PLB, BlockIt E) {
+  for (BlockIt I = std::next(PLB); I != E; ++I) {
+    int Bank;
+    if (I->getOpcode() == SNES::PHB) {
+      if (!isBankSwitch(std::next(I), E, Bank))
+        return false;
+
+      I->eraseFromParent();
+      PLB->eraseFromParent();
+      return true;
+    }
+
+    if (mayReadBank(*I) || SNESInstrInfo::isStackRelative(*I) ||
+        I->readsRegister(SNES::SP, TRI) || I->modifiesRegister(SNES::SP, TRI))
+      return false;
+  }
+
+  return false;
+}
+
+/// Removes a PHB and its PLB when DB holds the saved value by the time of the
+/// PLB. Other uses of the stack in between would see it move, so only bank
+/// switches and calls may sit there.
+bool SNESDataBankOpt::removeRedundantSave(BlockIt PHB, BlockIt E, int DB) {
+  State S(DB);
+  unsigned Depth = 0;
+
+  for (BlockIt I = std::next(PHB); I != E; ++I) {
+    unsigned Opc = I->getOpcode();
+    if (Opc == SNES::PLB && Depth == 0) {
+      if (S.DB == UnknownBank || S.DB != DB)
+        return false;
+
+      I->eraseFromParent();
+      PHB->eraseFromParent();
+      return true;
+    }
+
+    if (Opc == SNES::PHB)
+      Depth += 1;
+    else if (Opc == SNES::PEA)
+      Depth += 2;
+    else if (Opc == SNES::PLB)
+      Depth -= 1;
+    else if (!I->isCall() &&
+             (I->readsRegister(SNES::SP, TRI) ||
+              I->modifiesRegister(SNES::SP, TRI) ||
+              SNESInstrInfo::isStackRelative(*I)))
+      return false;
+
+    step(*I, S);
+  }
+
+  return false;
+}
+
+bool SNESDataBankOpt::rewriteLong(MachineInstr &MI, int DB) const {
+  unsigned Opc;
+  switch (MI.getOpcode()) {
+  case SNES::LDAlong8:
+    Opc = SNES::LDAabs8;
+    break;
+  case SNES::LDAlong16:
+    Opc = SNES::LDAabs16;
+    break;
+  case SNES::STAlong8:
+    Opc = SNES::STAabs8;
+    break;
+  case SNES::STAlong16:
+    Opc = SNES::STAabs16;
+    break;
+  default:
+    return false;
+  }
+
+  // The address is the first operand after the definitions.
+  const MachineOperand &Addr = MI.getOperand(MI.getDesc().getNumDefs());
+  if (DB == UnknownBank || getOperandBank(Addr) != DB)
+    return false;
+
+  MI.setDesc(TII->get(Opc));
+  return true;
+}
+
+bool SNESDataBankOpt::optimizeBlock(Block &MBB) {
+  bool Modified = false;
+  State S(BlockIn.lookup(&MBB));
+
+  BlockIt MBBI = MBB.begin(), E = MBB.end();
+  while (MBBI != E) {
+    int Bank;
+    if (isBankSwitch(MBBI, E, Bank) &&
+        ((S.DB != UnknownBank && Bank == S.DB) ||
+         isDeadSwitch(std::next(MBBI, 3), E))) {
+      // PEA; PLB; PLB
+      MBBI = std::next(MBBI, 3);
+      MBB.erase(std::prev(MBBI, 3), MBBI);
+      Modified = true;
+      continue;
+    }
+
+    if (MBBI->getOpcode() == SNES::PLB && removeRestoreAndSave(MBBI, E)) {
+      MBBI = MBB.begin();
+      S = State(BlockIn.lookup(&MBB));
+      Modified = true;
+      continue;
+    }
+
+    if (MBBI->getOpcode() == SNES::PHB && S.DB != UnknownBank &&
+        removeRedundantSave(MBBI, E, S.DB)) {
+      // Start over, the stack model must see the block as it now is.
+      MBBI = MBB.begin();
+      S = State(BlockIn.lookup(&MBB));
+      Modified = true;
+      continue;
+    }
+
+    Modified |= rewriteLong(*MBBI, S.DB);
+    step(*MBBI, S);
+    ++MBBI;
+  }
+
+  return Modified;
+}
+
+bool SNESDataBankOpt::runOnMachineFunction(MachineFunction &MF) {
+  const SNESSubtarget &STI = MF.getSubtarget<SNESSubtarget>();
+  TII = STI.getInstrInfo();
+  TRI = STI.getRegisterInfo();
+
+  // Removing a switch can make DB known further down, go again until
+  // nothing changes.
+  bool Modified = false;
+  while (true) {
+    computeBlockIn(MF);
+
+    bool Changed = false;
+    for (Block &MBB : MF)
+      Changed |= optimizeBlock(MBB);
+
+    if (!Changed)
+      break;
+    Modified = true;
+  }
+
+  return Modified;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESDataBankOpt, "snes-data-bank-opt",
+                SNES_DATA_BANK_OPT_NAME, false, false)
+
+namespace llvm {
+
+FunctionPass *createSNESDataBankOptPass() { return new SNESDataBankOpt(); }
+
+} // end of namespace llvm
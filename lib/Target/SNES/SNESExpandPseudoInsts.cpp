@@ -18,6 +18,7 @@
 #include "SNESTargetMachine.h"
 #include "MCTargetDesc/SNESMCTargetDesc.h"
 
+#include "llvm/CodeGen/LivePhysRegs.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
@@ -53,8 +54,6 @@ private:
 
   /// The register to be used for temporary storage.
   const unsigned SCRATCH_REGISTER = SNES::A;
-  /// The IO address of the status register.
-  const unsigned P_ADDR = 0x3f;
 
   bool expandMBB(Block &MBB);
   bool expandMI(Block &MBB, BlockIt MBBI);
@@ -74,17 +73,19 @@ private:
   bool expandArith(unsigned OpLo, unsigned OpHi, Block &MBB, BlockIt MBBI);
   bool expandLogic(unsigned Op, Block &MBB, BlockIt MBBI);
   bool expandLogicImm(unsigned Op, Block &MBB, BlockIt MBBI);
+  bool expandByteArith(unsigned CarryOp, unsigned Op, Block &MBB,
+                       BlockIt MBBI);
+  bool expandExtension(bool IsSigned, Block &MBB, BlockIt MBBI);
+  bool expandArithShift(bool IsByte, Block &MBB, BlockIt MBBI);
+  bool expandBranchX(unsigned Opcode, Block &MBB, BlockIt MBBI);
+  bool expandStackSlot(bool IsLoad, bool IsByte, Block &MBB, BlockIt MBBI);
+  bool expandDecimalArith(bool IsSub, Block &MBB, BlockIt MBBI);
   bool isLogicImmOpRedundant(unsigned Op, unsigned ImmVal) const;
 
   template<typename Func>
   bool expandAtomic(Block &MBB, BlockIt MBBI, Func f);
 
-  template<typename Func>
-  bool expandAtomicBinaryOp(unsigned Opcode, Block &MBB, BlockIt MBBI, Func f);
-
-  bool expandAtomicBinaryOp(unsigned Opcode, Block &MBB, BlockIt MBBI);
-
-  bool expandAtomicArithmeticOp(unsigned MemOpcode,
+  bool expandAtomicArithmeticOp(unsigned Width,
                                 unsigned ArithOpcode,
                                 Block &MBB,
                                 BlockIt MBBI);
@@ -254,6 +255,358 @@ expandLogicImm(unsigned Op, Block &MBB, BlockIt MBBI) {
   return true;
 }
 
+/// Expands an operation between AL and the low byte of an index register.
+/// The index register is pushed, as a word since X is clear, so its low
+/// byte is at 1,S:
+///
+///   PHX
+///   CLC               ; CarryOp, if any
+///   ADC 1,S
+///   PLX
+bool SNESExpandPseudo::
+expandByteArith(unsigned CarryOp, unsigned Op, Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(2).getReg();
+  bool DstIsDead = MI.getOperand(0).isDead();
+  bool DstIsKill = MI.getOperand(1).isKill();
+  bool SrcIsKill = MI.getOperand(2).isKill();
+  bool IsX = SrcReg == SNES::XL;
+
+  buildMI(MBB, MBBI, IsX ? SNES::PHX : SNES::PHY)
+    .addReg(IsX ? SNES::X : SNES::Y);
+
+  if (CarryOp)
+    buildMI(MBB, MBBI, CarryOp);
+
+  buildMI(MBB, MBBI, Op)
+    .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+    .addReg(DstReg, getKillRegState(DstIsKill))
+    .addReg(SNES::SP)
+    .addImm(1);
+
+  // The pull is only there to drop the byte, when the index register was
+  // killed the value it gets back is dead.
+  buildMI(MBB, MBBI, IsX ? SNES::PLX : SNES::PLY)
+    .addReg(IsX ? SNES::X : SNES::Y,
+            RegState::Define | getDeadRegState(SrcIsKill));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+/// Expands a BCD add or subtract in decimal mode, with an immediate or an
+/// index register, which is pushed as in expandByteArith:
+///
+///   PHX               ; index register only
+///   SED
+///   CLC               ; SEC for a subtract
+///   ADC 1,S           ; or ADC #k
+///   CLD
+///   PLX
+///
+/// D is set for these instructions only. It is clear everywhere else, and an
+/// interrupt clears it on entry and RTI restores it, so no other code ever
+/// runs in decimal mode.
+bool SNESExpandPseudo::
+expandDecimalArith(bool IsSub, Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  bool DstIsDead = MI.getOperand(0).isDead();
+  bool DstIsKill = MI.getOperand(1).isKill();
+  const MachineOperand &Src = MI.getOperand(2);
+  bool IsX = Src.isReg() && Src.getReg() == SNES::X;
+
+  if (Src.isReg())
+    buildMI(MBB, MBBI, IsX ? SNES::PHX : SNES::PHY).addReg(Src.getReg());
+
+  buildMI(MBB, MBBI, SNES::SED);
+  buildMI(MBB, MBBI, IsSub ? SNES::SEC : SNES::CLC);
+
+  if (Src.isReg()) {
+    buildMI(MBB, MBBI, IsSub ? SNES::SBCsr16 : SNES::ADCsr16)
+      .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+      .addReg(DstReg, getKillRegState(DstIsKill))
+      .addReg(SNES::SP)
+      .addImm(1);
+  } else {
+    buildMI(MBB, MBBI, IsSub ? SNES::SBCimm16 : SNES::ADCimm16)
+      .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+      .addReg(DstReg, getKillRegState(DstIsKill))
+      .addImm(Src.getImm());
+  }
+
+  buildMI(MBB, MBBI, SNES::CLD);
+
+  if (Src.isReg())
+    buildMI(MBB, MBBI, IsX ? SNES::PLX : SNES::PLY)
+      .addReg(Src.getReg(),
+              RegState::Define | getDeadRegState(Src.isKill()));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+/// Expands the extension of a byte to a word in A, with M clear:
+///
+///   TXA               ; when the byte is not in AL already
+///   AND #$00FF
+///   EOR #$0080        ; sign extension only
+///   SEC
+///   SBC #$0080
+bool SNESExpandPseudo::
+expandExtension(bool IsSigned, Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(1).getReg();
+  bool DstIsDead = MI.getOperand(0).isDead();
+  bool SrcIsKill = MI.getOperand(1).isKill();
+
+  if (SrcReg != SNES::AL) {
+    buildMI(MBB, MBBI, SrcReg == SNES::XL ? SNES::TXA : SNES::TYA)
+      .addReg(DstReg, RegState::Define | RegState::Implicit)
+      .addReg(SrcReg, RegState::Implicit | getKillRegState(SrcIsKill));
+  }
+
+  auto Last = buildMI(MBB, MBBI, SNES::ANDimm16)
+    .addReg(DstReg,
+            RegState::Define | getDeadRegState(DstIsDead && !IsSigned))
+    .addReg(DstReg, RegState::Kill)
+    .addImm(0xFF);
+
+  if (IsSigned) {
+    buildMI(MBB, MBBI, SNES::EORimm16)
+      .addReg(DstReg, RegState::Define)
+      .addReg(DstReg, RegState::Kill)
+      .addImm(0x80);
+    buildMI(MBB, MBBI, SNES::SEC);
+    Last = buildMI(MBB, MBBI, SNES::SBCimm16)
+      .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+      .addReg(DstReg, RegState::Kill)
+      .addImm(0x80);
+  }
+
+  if (MI.getOperand(2).isDead())
+    Last->getOperand(3).setIsDead();
+
+  MI.eraseFromParent();
+  return true;
+}
+
+/// Expands a spill or a reload, `STA k,S` or `LDA k,S`. X and Y go through
+/// A, which is pushed around the access when it is live, so the slot is two
+/// bytes further:
+///
+///   PHA
+///   TXA
+///   STA k+2,S
+///   PLA
+bool SNESExpandPseudo::
+expandStackSlot(bool IsLoad, bool IsByte, Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  const MachineOperand &RegOp = MI.getOperand(IsLoad ? 0 : 2);
+  unsigned Reg = RegOp.getReg();
+  int64_t Offset = MI.getOperand(IsLoad ? 2 : 1).getImm();
+  unsigned AccReg = IsByte ? SNES::AL : SNES::A;
+  unsigned Op = IsLoad ? (IsByte ? SNES::LDAsr8 : SNES::LDAsr16)
+                       : (IsByte ? SNES::STAsr8 : SNES::STAsr16);
+
+  bool PushA = false;
+  if (Reg != AccReg) {
+    LivePhysRegs LiveRegs(*TRI);
+    LiveRegs.addLiveOuts(MBB);
+    for (auto I = MBB.rbegin(); &*I != &MI; ++I)
+      LiveRegs.stepBackward(*I);
+    PushA = !LiveRegs.available(getRegInfo(MBB), SNES::A);
+  }
+
+  if (PushA) {
+    buildMI(MBB, MBBI, SNES::PHAstk).addReg(SNES::A, RegState::Kill);
+    Offset += 2;
+  }
+
+  bool IsX = Reg == SNES::X || Reg == SNES::XL;
+  if (!IsLoad && Reg != AccReg) {
+    buildMI(MBB, MBBI, IsX ? SNES::TXA : SNES::TYA)
+      .addReg(AccReg, RegState::Define | RegState::Implicit)
+      .addReg(Reg, RegState::Implicit | getKillRegState(RegOp.isKill()));
+  }
+
+  auto MIB = IsLoad ? buildMI(MBB, MBBI, Op, AccReg) : buildMI(MBB, MBBI, Op);
+  MIB.addReg(SNES::SP).addImm(Offset);
+  if (!IsLoad)
+    MIB.addReg(AccReg, RegState::Kill);
+  MIB.setMemRefs(MI.memoperands_begin(), MI.memoperands_end());
+
+  if (IsLoad && Reg != AccReg) {
+    buildMI(MBB, MBBI, IsX ? SNES::TAX : SNES::TAY)
+      .addReg(Reg, RegState::Define | RegState::Implicit |
+                   getDeadRegState(RegOp.isDead()))
+      .addReg(AccReg, RegState::Implicit | RegState::Kill);
+  } else if (IsLoad && RegOp.isDead()) {
+    MIB->getOperand(0).setIsDead();
+  }
+
+  if (PushA)
+    buildMI(MBB, MBBI, SNES::PLA, SNES::A);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::STsr8>(Block &MBB, BlockIt MBBI) {
+  return expandStackSlot(false, true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::STsr16>(Block &MBB, BlockIt MBBI) {
+  return expandStackSlot(false, false, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::LDsr8>(Block &MBB, BlockIt MBBI) {
+  return expandStackSlot(true, true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::LDsr16>(Block &MBB, BlockIt MBBI) {
+  return expandStackSlot(true, false, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ADDRr8>(Block &MBB, BlockIt MBBI) {
+  return expandByteArith(SNES::CLC, SNES::ADCsr8, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::SUBRr8>(Block &MBB, BlockIt MBBI) {
+  return expandByteArith(SNES::SEC, SNES::SBCsr8, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ANDRr8>(Block &MBB, BlockIt MBBI) {
+  return expandByteArith(0, SNES::ANDsr8, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ORARr8>(Block &MBB, BlockIt MBBI) {
+  return expandByteArith(0, SNES::ORAsr8, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::EORRr8>(Block &MBB, BlockIt MBBI) {
+  return expandByteArith(0, SNES::EORsr8, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BCDADDimm16>(Block &MBB, BlockIt MBBI) {
+  return expandDecimalArith(false, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BCDSUBimm16>(Block &MBB, BlockIt MBBI) {
+  return expandDecimalArith(true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BCDADDRr16>(Block &MBB, BlockIt MBBI) {
+  return expandDecimalArith(false, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BCDSUBRr16>(Block &MBB, BlockIt MBBI) {
+  return expandDecimalArith(true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::SEXT>(Block &MBB, BlockIt MBBI) {
+  return expandExtension(true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ZEXT>(Block &MBB, BlockIt MBBI) {
+  return expandExtension(false, MBB, MBBI);
+}
+
+/// `CMP #$80` copies the sign into the carry, which ROR shifts back in.
+bool SNESExpandPseudo::expandArithShift(bool IsByte, Block &MBB,
+                                        BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  bool DstIsDead = MI.getOperand(0).isDead();
+  bool SrcIsKill = MI.getOperand(1).isKill();
+
+  buildMI(MBB, MBBI, IsByte ? SNES::CMPimm8 : SNES::CMPimm16)
+    .addReg(DstReg)
+    .addImm(IsByte ? 0x80 : 0x8000);
+
+  buildMI(MBB, MBBI, IsByte ? SNES::RORA8 : SNES::RORA16)
+    .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+    .addReg(DstReg, getKillRegState(SrcIsKill));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ASRA8>(Block &MBB, BlockIt MBBI) {
+  return expandArithShift(true, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::ASRA16>(Block &MBB, BlockIt MBBI) {
+  return expandArithShift(false, MBB, MBBI);
+}
+
+bool SNESExpandPseudo::expandBranchX(unsigned Opcode, Block &MBB,
+                                     BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned SrcReg = MI.getOperand(0).getReg();
+  bool SrcIsKill = MI.getOperand(0).isKill();
+
+  // An instruction right before the branch that wrote X has already set Z
+  // from it.
+  BlockIt Prev = MBBI;
+  do {
+    if (Prev == MBB.begin())
+      break;
+    --Prev;
+  } while (Prev->isDebugValue());
+
+  bool SetsZ = false;
+  if (Prev != MBBI) {
+    switch (Prev->getOpcode()) {
+    case SNES::DEXr:
+    case SNES::TAX:
+    case SNES::TYX:
+      SetsZ = Prev->definesRegister(SrcReg);
+      break;
+    }
+  }
+
+  if (!SetsZ) {
+    buildMI(MBB, MBBI, SNES::CPXimm16)
+      .addReg(SrcReg, getKillRegState(SrcIsKill))
+      .addImm(0);
+  }
+
+  buildMI(MBB, MBBI, Opcode).addMBB(MI.getOperand(1).getMBB());
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BREQXk>(Block &MBB, BlockIt MBBI) {
+  return expandBranchX(SNES::BREQk, MBB, MBBI);
+}
+
+template <>
+bool SNESExpandPseudo::expand<SNES::BRNEXk>(Block &MBB, BlockIt MBBI) {
+  return expandBranchX(SNES::BRNEk, MBB, MBBI);
+}
+
 template <>
 bool SNESExpandPseudo::expand<SNES::ADDWRdRr>(Block &MBB, BlockIt MBBI) {
   return expandArith(SNES::ADDRdRr, SNES::ADCRdRr, MBB, MBBI);
@@ -485,48 +838,59 @@ bool SNESExpandPseudo::expand<SNES::CPCWRdRr>(Block &MBB, BlockIt MBBI) {
 template <>
 bool SNESExpandPseudo::expand<SNES::LDIWRdK>(Block &MBB, BlockIt MBBI) {
   MachineInstr &MI = *MBBI;
-  unsigned OpLo, OpHi, DstLoReg, DstHiReg;
   unsigned DstReg = MI.getOperand(0).getReg();
   bool DstIsDead = MI.getOperand(0).isDead();
-  OpLo = SNES::LDIRdK;
-  OpHi = SNES::LDIRdK;
-  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
 
-  auto MIBLO = buildMI(MBB, MBBI, OpLo)
-    .addReg(DstLoReg, RegState::Define | getDeadRegState(DstIsDead));
+  // The whole 16 bits go in one LDA, LDX or LDY, the fixups of global and
+  // block addresses take the full address.
+  unsigned Op;
+  switch (DstReg) {
+  default:
+    llvm_unreachable("Unexpected register for a constant!");
+  case SNES::A:
+    Op = SNES::LDAimm16;
+    break;
+  case SNES::X:
+    Op = SNES::LDXimm16;
+    break;
+  case SNES::Y:
+    Op = SNES::LDYimm16;
+    break;
+  }
 
-  auto MIBHI = buildMI(MBB, MBBI, OpHi)
-    .addReg(DstHiReg, RegState::Define | getDeadRegState(DstIsDead));
+  buildMI(MBB, MBBI, Op)
+    .addReg(DstReg, RegState::Define | getDeadRegState(DstIsDead))
+    .add(MI.getOperand(1));
 
-  switch (MI.getOperand(1).getType()) {
-  case MachineOperand::MO_GlobalAddress: {
-    const GlobalValue *GV = MI.getOperand(1).getGlobal();
-    int64_t Offs = MI.getOperand(1).getOffset();
-    unsigned TF = MI.getOperand(1).getTargetFlags();
+  MI.eraseFromParent();
+  return true;
+}
 
-    MIBLO.addGlobalAddress(GV, Offs, TF | SNESII::MO_LO);
-    MIBHI.addGlobalAddress(GV, Offs, TF | SNESII::MO_HI);
-    break;
-  }
-  case MachineOperand::MO_BlockAddress: {
-    const BlockAddress *BA = MI.getOperand(1).getBlockAddress();
-    unsigned TF = MI.getOperand(1).getTargetFlags();
+template <>
+bool SNESExpandPseudo::expand<SNES::CPIWRdK>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned SrcReg = MI.getOperand(0).getReg();
+  bool SrcIsKill = MI.getOperand(0).isKill();
 
-    MIBLO.add(MachineOperand::CreateBA(BA, TF | SNESII::MO_LO));
-    MIBHI.add(MachineOperand::CreateBA(BA, TF | SNESII::MO_HI));
+  unsigned Op;
+  switch (SrcReg) {
+  default:
+    llvm_unreachable("Unexpected register for a compare!");
+  case SNES::A:
+    Op = SNES::CMPimm16;
     break;
-  }
-  case MachineOperand::MO_Immediate: {
-    unsigned Imm = MI.getOperand(1).getImm();
-
-    MIBLO.addImm(Imm & 0xff);
-    MIBHI.addImm((Imm >> 8) & 0xff);
+  case SNES::X:
+    Op = SNES::CPXimm16;
+    break;
+  case SNES::Y:
+    Op = SNES::CPYimm16;
     break;
-  }
-  default:
-    llvm_unreachable("Unknown operand type!");
   }
 
+  buildMI(MBB, MBBI, Op)
+    .addReg(SrcReg, getKillRegState(SrcIsKill))
+    .add(MI.getOperand(1));
+
   MI.eraseFromParent();
   return true;
 }
@@ -754,65 +1118,76 @@ bool SNESExpandPseudo::expandAtomic(Block &MBB, BlockIt MBBI, Func f) {
   // Remove the pseudo instruction.
   MachineInstr &MI = *MBBI;
 
-  // Store the P.
-  buildMI(MBB, MBBI, SNES::INRdA)
-    .addReg(SCRATCH_REGISTER, RegState::Define)
-    .addImm(P_ADDR);
-
-  // Disable exceptions.
-  buildMI(MBB, MBBI, SNES::BCLRs).addImm(7); // CLI
+  // Save the interrupt disable flag and keep interrupts out for as few
+  // instructions as possible. PLP puts the flag back the way it was, so this
+  // also works with interrupts already disabled. PHP moves S, which is why
+  // this is only done after the frame indices are gone.
+  buildMI(MBB, MBBI, SNES::PHP);
+  buildMI(MBB, MBBI, SNES::SEI);
 
   f(MI);
 
   // Restore the status reg.
-  buildMI(MBB, MBBI, SNES::OUTARr)
-    .addImm(P_ADDR)
-    .addReg(SCRATCH_REGISTER);
+  buildMI(MBB, MBBI, SNES::PLP);
 
   MI.eraseFromParent();
   return true;
 }
 
-template<typename Func>
-bool SNESExpandPseudo::expandAtomicBinaryOp(unsigned Opcode,
-                                           Block &MBB,
-                                           BlockIt MBBI,
-                                           Func f) {
-  return expandAtomic(MBB, MBBI, [&](MachineInstr &MI) {
-      auto Op1 = MI.getOperand(0);
-      auto Op2 = MI.getOperand(1);
-
-      MachineInstr &NewInst =
-          *buildMI(MBB, MBBI, Opcode).add(Op1).add(Op2).getInstr();
-      f(NewInst);
-  });
-}
-
-bool SNESExpandPseudo::expandAtomicBinaryOp(unsigned Opcode,
-                                           Block &MBB,
-                                           BlockIt MBBI) {
-  return expandAtomicBinaryOp(Opcode, MBB, MBBI, [](MachineInstr &MI) {});
-}
-
+/// Expands an AtomicLoadOp pseudo to
+///
+///   PHP
+///   SEI
+///   LDY $0000,X       ; the old value, left out when it is not used
+///   <op> $0000,X      ; A = A op mem
+///   STA $0000,X
+///   PLP
+///
+/// ArithOpcode is the abs,X form of the operation, or 0 for a swap.
 bool SNESExpandPseudo::expandAtomicArithmeticOp(unsigned Width,
                                                unsigned ArithOpcode,
                                                Block &MBB,
                                                BlockIt MBBI) {
   return expandAtomic(MBB, MBBI, [&](MachineInstr &MI) {
-      auto Op1 = MI.getOperand(0);
-      auto Op2 = MI.getOperand(1);
-
-      unsigned LoadOpcode = (Width == 8) ? SNES::LDRdPtr : SNES::LDWRdPtr;
-      unsigned StoreOpcode = (Width == 8) ? SNES::STPtrRr : SNES::STWPtrRr;
-
-      // Create the load
-      buildMI(MBB, MBBI, LoadOpcode).add(Op1).add(Op2);
-
-      // Create the arithmetic op
-      buildMI(MBB, MBBI, ArithOpcode).add(Op1).add(Op1).add(Op2);
-
-      // Create the store
-      buildMI(MBB, MBBI, StoreOpcode).add(Op2).add(Op1);
+      bool Is8Bit = Width == 8;
+      unsigned DstReg = MI.getOperand(0).getReg();
+      unsigned PtrReg = MI.getOperand(1).getReg();
+      unsigned AccReg = MI.getOperand(2).getReg();
+      unsigned Opc = MI.getOpcode();
+      int64_t Ones = Is8Bit ? 0xFF : 0xFFFF;
+
+      if (!MI.getOperand(0).isDead())
+        buildMI(MBB, MBBI, Is8Bit ? SNES::LDYabsx8 : SNES::LDYabsx16, DstReg)
+          .addImm(0)
+          .addReg(PtrReg);
+
+      // mem - A is mem + ~A + 1.
+      if (Opc == SNES::AtomicLoadSub8 || Opc == SNES::AtomicLoadSub16)
+        buildMI(MBB, MBBI, Is8Bit ? SNES::EORimm8 : SNES::EORimm16, AccReg)
+          .addReg(AccReg)
+          .addImm(Ones);
+
+      if (ArithOpcode == SNES::ADCabsx8 || ArithOpcode == SNES::ADCabsx16) {
+        bool IsSub = Opc == SNES::AtomicLoadSub8 ||
+                     Opc == SNES::AtomicLoadSub16;
+        buildMI(MBB, MBBI, IsSub ? SNES::SEC : SNES::CLC);
+      }
+
+      if (ArithOpcode)
+        buildMI(MBB, MBBI, ArithOpcode, AccReg)
+          .addReg(AccReg)
+          .addImm(0)
+          .addReg(PtrReg);
+
+      if (Opc == SNES::AtomicLoadNand8 || Opc == SNES::AtomicLoadNand16)
+        buildMI(MBB, MBBI, Is8Bit ? SNES::EORimm8 : SNES::EORimm16, AccReg)
+          .addReg(AccReg)
+          .addImm(Ones);
+
+      buildMI(MBB, MBBI, Is8Bit ? SNES::STAabsx8 : SNES::STAabsx16)
+        .addImm(0)
+        .addReg(PtrReg)
+        .addReg(AccReg, RegState::Kill);
   });
 }
 
@@ -843,73 +1218,73 @@ unsigned SNESExpandPseudo::scavengeMainRegs(MachineInstr &MI) {
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoad8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicBinaryOp(SNES::LDRdPtr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadAdd8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::ADCabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoad16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicBinaryOp(SNES::LDWRdPtr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadAdd16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::ADCabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicStore8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicBinaryOp(SNES::STPtrRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadSub8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::ADCabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicStore16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicBinaryOp(SNES::STWPtrRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadSub16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::ADCabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadAdd8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(8, SNES::ADDRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadAnd8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::ANDabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadAdd16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(16, SNES::ADDWRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadAnd16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::ANDabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadSub8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(8, SNES::SUBRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadOr8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::ORAabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadSub16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(16, SNES::SUBWRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadOr16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::ORAabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadAnd8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(8, SNES::ANDRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadXor8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::EORabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadAnd16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(16, SNES::ANDWRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadXor16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::EORabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadOr8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(8, SNES::ORRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadNand8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, SNES::ANDabsx8, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadOr16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(16, SNES::ORWRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicLoadNand16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, SNES::ANDabsx16, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadXor8>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(8, SNES::EORRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicSwap8>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(8, 0, MBB, MBBI);
 }
 
 template<>
-bool SNESExpandPseudo::expand<SNES::AtomicLoadXor16>(Block &MBB, BlockIt MBBI) {
-  return expandAtomicArithmeticOp(16, SNES::EORWRdRr, MBB, MBBI);
+bool SNESExpandPseudo::expand<SNES::AtomicSwap16>(Block &MBB, BlockIt MBBI) {
+  return expandAtomicArithmeticOp(16, 0, MBB, MBBI);
 }
 
 template<>
@@ -1193,68 +1568,6 @@ bool SNESExpandPseudo::expand<SNES::POPWRd>(Block &MBB, BlockIt MBBI) {
   return true;
 }
 
-template <>
-bool SNESExpandPseudo::expand<SNES::LSLWRd>(Block &MBB, BlockIt MBBI) {
-  MachineInstr &MI = *MBBI;
-  unsigned OpLo, OpHi, DstLoReg, DstHiReg;
-  unsigned DstReg = MI.getOperand(0).getReg();
-  bool DstIsDead = MI.getOperand(0).isDead();
-  bool DstIsKill = MI.getOperand(1).isKill();
-  bool ImpIsDead = MI.getOperand(2).isDead();
-  OpLo = SNES::LSLRd;
-  OpHi = SNES::ROLRd;
-  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
-
-  // Low part
-  buildMI(MBB, MBBI, OpLo)
-    .addReg(DstLoReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstLoReg, getKillRegState(DstIsKill));
-
-  auto MIBHI = buildMI(MBB, MBBI, OpHi)
-    .addReg(DstHiReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstHiReg, getKillRegState(DstIsKill));
-
-  if (ImpIsDead)
-    MIBHI->getOperand(2).setIsDead();
-
-  // P is always implicitly killed
-  MIBHI->getOperand(3).setIsKill();
-
-  MI.eraseFromParent();
-  return true;
-}
-
-template <>
-bool SNESExpandPseudo::expand<SNES::LSRWRd>(Block &MBB, BlockIt MBBI) {
-  MachineInstr &MI = *MBBI;
-  unsigned OpLo, OpHi, DstLoReg, DstHiReg;
-  unsigned DstReg = MI.getOperand(0).getReg();
-  bool DstIsDead = MI.getOperand(0).isDead();
-  bool DstIsKill = MI.getOperand(1).isKill();
-  bool ImpIsDead = MI.getOperand(2).isDead();
-  OpLo = SNES::RORRd;
-  OpHi = SNES::LSRRd;
-  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
-
-  // High part
-  buildMI(MBB, MBBI, OpHi)
-    .addReg(DstHiReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstHiReg, getKillRegState(DstIsKill));
-
-  auto MIBLO = buildMI(MBB, MBBI, OpLo)
-    .addReg(DstLoReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstLoReg, getKillRegState(DstIsKill));
-
-  if (ImpIsDead)
-    MIBLO->getOperand(2).setIsDead();
-
-  // P is always implicitly killed
-  MIBLO->getOperand(3).setIsKill();
-
-  MI.eraseFromParent();
-  return true;
-}
-
 template <>
 bool SNESExpandPseudo::expand<SNES::RORWRd>(Block &MBB, BlockIt MBBI) {
   llvm_unreachable("RORW unimplemented");
@@ -1267,37 +1580,6 @@ bool SNESExpandPseudo::expand<SNES::ROLWRd>(Block &MBB, BlockIt MBBI) {
   return false;
 }
 
-template <>
-bool SNESExpandPseudo::expand<SNES::ASRWRd>(Block &MBB, BlockIt MBBI) {
-  MachineInstr &MI = *MBBI;
-  unsigned OpLo, OpHi, DstLoReg, DstHiReg;
-  unsigned DstReg = MI.getOperand(0).getReg();
-  bool DstIsDead = MI.getOperand(0).isDead();
-  bool DstIsKill = MI.getOperand(1).isKill();
-  bool ImpIsDead = MI.getOperand(2).isDead();
-  OpLo = SNES::RORRd;
-  OpHi = SNES::ASRRd;
-  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
-
-  // High part
-  buildMI(MBB, MBBI, OpHi)
-    .addReg(DstHiReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstHiReg, getKillRegState(DstIsKill));
-
-  auto MIBLO = buildMI(MBB, MBBI, OpLo)
-    .addReg(DstLoReg, RegState::Define | getDeadRegState(DstIsDead))
-    .addReg(DstLoReg, getKillRegState(DstIsKill));
-
-  if (ImpIsDead)
-    MIBLO->getOperand(2).setIsDead();
-
-  // P is always implicitly killed
-  MIBLO->getOperand(3).setIsKill();
-
-  MI.eraseFromParent();
-  return true;
-}
-
 // template <> bool SNESExpandPseudo::expand<SNES::SEXT>(Block &MBB, BlockIt MBBI) {
 //   MachineInstr &MI = *MBBI;
 //   unsigned DstLoReg, DstHiReg;
@@ -1392,63 +1674,34 @@ bool SNESExpandPseudo::expand<SNES::ASRWRd>(Block &MBB, BlockIt MBBI) {
 //   return true;
 // }
 
-// template <>
-// bool SNESExpandPseudo::expand<SNES::SPREAD>(Block &MBB, BlockIt MBBI) {
-//   MachineInstr &MI = *MBBI;
-//   unsigned OpLo, OpHi, DstLoReg, DstHiReg;
-//   unsigned DstReg = MI.getOperand(0).getReg();
-//   bool DstIsDead = MI.getOperand(0).isDead();
-//   unsigned Flags = MI.getFlags();
-//   OpLo = SNES::INRdA;
-//   OpHi = SNES::INRdA;
-//   TRI->splitReg(DstReg, DstLoReg, DstHiReg);
-
-//   // Low part
-//   buildMI(MBB, MBBI, OpLo)
-//     .addReg(DstLoReg, RegState::Define | getDeadRegState(DstIsDead))
-//     .addImm(0x3d)
-//     .setMIFlags(Flags);
+/// S is only copied to and from A and X, with TSC/TCS and TSX/TXS.
+template <>
+bool SNESExpandPseudo::expand<SNES::SPREAD>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  bool DstIsDead = MI.getOperand(0).isDead();
+  assert((DstReg == SNES::A || DstReg == SNES::X) &&
+         "S is only read into A or X");
 
-//   // High part
-//   buildMI(MBB, MBBI, OpHi)
-//     .addReg(DstHiReg, RegState::Define | getDeadRegState(DstIsDead))
-//     .addImm(0x3e)
-//     .setMIFlags(Flags);
+  auto MIB = buildMI(MBB, MBBI, DstReg == SNES::A ? SNES::TSC : SNES::TSX)
+    .setMIFlags(MI.getFlags());
+  MIB->findRegisterDefOperand(DstReg)->setIsDead(DstIsDead);
 
-//   MI.eraseFromParent();
-//   return true;
-// }
+  MI.eraseFromParent();
+  return true;
+}
 
 template <>
 bool SNESExpandPseudo::expand<SNES::SPWRITE>(Block &MBB, BlockIt MBBI) {
   MachineInstr &MI = *MBBI;
-  unsigned SrcLoReg, SrcHiReg;
   unsigned SrcReg = MI.getOperand(1).getReg();
   bool SrcIsKill = MI.getOperand(1).isKill();
-  unsigned Flags = MI.getFlags();
-  TRI->splitReg(SrcReg, SrcLoReg, SrcHiReg);
+  assert((SrcReg == SNES::A || SrcReg == SNES::X) &&
+         "S is only written from A or X");
 
-  buildMI(MBB, MBBI, SNES::INRdA)
-    .addReg(SNES::A, RegState::Define)
-    .addImm(P_ADDR)
-    .setMIFlags(Flags);
-
-  buildMI(MBB, MBBI, SNES::BCLRs).addImm(0x07).setMIFlags(Flags);
-
-  buildMI(MBB, MBBI, SNES::OUTARr)
-    .addImm(0x3e)
-    .addReg(SrcHiReg, getKillRegState(SrcIsKill))
-    .setMIFlags(Flags);
-
-  buildMI(MBB, MBBI, SNES::OUTARr)
-    .addImm(P_ADDR)
-    .addReg(SNES::A, RegState::Kill)
-    .setMIFlags(Flags);
-
-  buildMI(MBB, MBBI, SNES::OUTARr)
-    .addImm(0x3d)
-    .addReg(SrcLoReg, getKillRegState(SrcIsKill))
-    .setMIFlags(Flags);
+  auto MIB = buildMI(MBB, MBBI, SrcReg == SNES::A ? SNES::TCS : SNES::TXS)
+    .setMIFlags(MI.getFlags());
+  MIB->findRegisterUseOperand(SrcReg)->setIsKill(SrcIsKill);
 
   MI.eraseFromParent();
   return true;
@@ -1463,6 +1716,25 @@ bool SNESExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
     return expand<Op>(MBB, MI)
 
   switch (Opcode) {
+    EXPAND(SNES::ADDRr8);
+    EXPAND(SNES::SUBRr8);
+    EXPAND(SNES::ANDRr8);
+    EXPAND(SNES::ORARr8);
+    EXPAND(SNES::EORRr8);
+    EXPAND(SNES::BCDADDimm16);
+    EXPAND(SNES::BCDSUBimm16);
+    EXPAND(SNES::BCDADDRr16);
+    EXPAND(SNES::BCDSUBRr16);
+    EXPAND(SNES::SEXT);
+    EXPAND(SNES::ZEXT);
+    EXPAND(SNES::ASRA8);
+    EXPAND(SNES::ASRA16);
+    EXPAND(SNES::BREQXk);
+    EXPAND(SNES::BRNEXk);
+    EXPAND(SNES::STsr8);
+    EXPAND(SNES::STsr16);
+    EXPAND(SNES::LDsr8);
+    EXPAND(SNES::LDsr16);
     EXPAND(SNES::ADDWRdRr);
     EXPAND(SNES::ADCWRdRr);
     EXPAND(SNES::SUBWRdRr);
@@ -1478,6 +1750,7 @@ bool SNESExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
     EXPAND(SNES::CPWRdRr);
     EXPAND(SNES::CPCWRdRr);
     EXPAND(SNES::LDIWRdK);
+    EXPAND(SNES::CPIWRdK);
     EXPAND(SNES::LDSWRdK);
     EXPAND(SNES::LDWRdPtr);
     EXPAND(SNES::LDWRdPtrPi);
@@ -1486,10 +1759,6 @@ bool SNESExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
     EXPAND(SNES::LDDWRdPtrQ);
     EXPAND(SNES::LPMWRdZ);
     EXPAND(SNES::LPMWRdZPi);
-    EXPAND(SNES::AtomicLoad8);
-    EXPAND(SNES::AtomicLoad16);
-    EXPAND(SNES::AtomicStore8);
-    EXPAND(SNES::AtomicStore16);
     EXPAND(SNES::AtomicLoadAdd8);
     EXPAND(SNES::AtomicLoadAdd16);
     EXPAND(SNES::AtomicLoadSub8);
@@ -1500,6 +1769,10 @@ bool SNESExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
     EXPAND(SNES::AtomicLoadOr16);
     EXPAND(SNES::AtomicLoadXor8);
     EXPAND(SNES::AtomicLoadXor16);
+    EXPAND(SNES::AtomicLoadNand8);
+    EXPAND(SNES::AtomicLoadNand16);
+    EXPAND(SNES::AtomicSwap8);
+    EXPAND(SNES::AtomicSwap16);
     EXPAND(SNES::AtomicFence);
     EXPAND(SNES::STSWKRr);
     EXPAND(SNES::STWPtrRr);
@@ -1510,11 +1783,8 @@ bool SNESExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
     EXPAND(SNES::OUTWARr);
     EXPAND(SNES::PUSHWRr);
     EXPAND(SNES::POPWRd);
-    EXPAND(SNES::LSLWRd);
-    EXPAND(SNES::LSRWRd);
     EXPAND(SNES::RORWRd);
     EXPAND(SNES::ROLWRd);
-    EXPAND(SNES::ASRWRd);
     EXPAND(SNES::SPREAD);
     EXPAND(SNES::SPWRITE);
   }
@@ -50,114 +50,96 @@ bool SNESFrameLowering::hasReservedCallFrame(const MachineFunction &MF) const {
   return hasFP(MF) && !MFI.hasVarSizedObjects();
 }
 
+/// The largest frame pushed or pulled a word at a time, above it S is moved
+/// through A.
+static const unsigned MaxPushedFrame = 8;
+
+static bool isCalleeSavedPush(const MachineInstr &MI) {
+  unsigned Opc = MI.getOpcode();
+  return MI.getFlag(MachineInstr::FrameSetup) &&
+         (Opc == SNES::PHAstk || Opc == SNES::PHX || Opc == SNES::PHY);
+}
+
+static bool isCalleeSavedPull(const MachineInstr &MI) {
+  unsigned Opc = MI.getOpcode();
+  return Opc == SNES::PLA || Opc == SNES::PLX || Opc == SNES::PLY;
+}
+
+/// Adds A as an operand of a push or a store which keeps its value. When only
+/// AL holds a value the high byte is undefined, and AL is what is read.
+static void addAccumulator(MachineInstrBuilder &MIB, bool OnlyAL) {
+  MIB.addReg(SNES::A, getUndefRegState(OnlyAL));
+  if (OnlyAL)
+    MIB.addReg(SNES::AL, RegState::Implicit);
+}
+
 void SNESFrameLowering::emitPrologue(MachineFunction &MF,
                                     MachineBasicBlock &MBB) const {
-// TODO: check what we will use on the code below
-/*
   MachineBasicBlock::iterator MBBI = MBB.begin();
-  CallingConv::ID CallConv = MF.getFunction()->getCallingConv();
   DebugLoc DL = (MBBI != MBB.end()) ? MBBI->getDebugLoc() : DebugLoc();
   const SNESSubtarget &STI = MF.getSubtarget<SNESSubtarget>();
   const SNESInstrInfo &TII = *STI.getInstrInfo();
-  bool HasFP = hasFP(MF);
+  MachineFrameInfo &MFI = MF.getFrameInfo();
+  const SNESMachineFunctionInfo *AFI = MF.getInfo<SNESMachineFunctionInfo>();
+  unsigned CalleeFrameSize = AFI->getCalleeSavedFrameSize();
 
-  // Interrupt handlers re-enable interrupts in function entry.
-  if (CallConv == CallingConv::SNES_INTR) {
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::BSETs))
-        .addImm(0x07)
-        .setMIFlag(MachineInstr::FrameSetup);
-  }
+  // The frame is a whole number of words, the spare byte is at the bottom
+  // so nothing moves relative to the incoming S.
+  unsigned FrameSize = alignTo(MFI.getStackSize() - CalleeFrameSize, 2);
+  MFI.setStackSize(CalleeFrameSize + FrameSize);
 
-  // Save the frame pointer if we have one.
-  if (HasFP) {
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::PUSHWRr))
-        .addReg(SNES::R29R28, RegState::Kill)
-        .setMIFlag(MachineInstr::FrameSetup);
+  // Skip the callee-saved push instructions.
+  while (MBBI != MBB.end() && isCalleeSavedPush(*MBBI)) {
+    ++MBBI;
   }
 
-  // Emit special prologue code to save R1, A and P in interrupt/signal
-  // handlers before saving any other registers.
-  if (CallConv == CallingConv::SNES_INTR ||
-      CallConv == CallingConv::SNES_SIGNAL) {
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::PUSHWRr))
-        .addReg(SNES::AA, RegState::Kill)
-        .setMIFlag(MachineInstr::FrameSetup);
-
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::INRdA), SNES::A)
-        .addImm(0x3f)
-        .setMIFlag(MachineInstr::FrameSetup);
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::PUSHRr))
-        .addReg(SNES::A, RegState::Kill)
-        .setMIFlag(MachineInstr::FrameSetup);
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::EORRdRr))
-        .addReg(SNES::A, RegState::Define)
-        .addReg(SNES::A, RegState::Kill)
-        .addReg(SNES::A, RegState::Kill)
-        .setMIFlag(MachineInstr::FrameSetup);
+  if (!FrameSize) {
+    return;
   }
 
-  // Early exit if the frame pointer is not needed in this function.
-  if (!HasFP) {
+  // A small frame is pushed, whatever A holds.
+  if (FrameSize <= MaxPushedFrame) {
+    for (unsigned i = 0; i != FrameSize; i += 2) {
+      BuildMI(MBB, MBBI, DL, TII.get(SNES::PHAstk))
+          .addReg(SNES::A, RegState::Undef)
+          .setMIFlag(MachineInstr::FrameSetup);
+    }
     return;
   }
 
-  const MachineFrameInfo &MFI = MF.getFrameInfo();
-  const SNESMachineFunctionInfo *AFI = MF.getInfo<SNESMachineFunctionInfo>();
-  unsigned FrameSize = MFI.getStackSize() - AFI->getCalleeSavedFrameSize();
+  // Otherwise S is moved down through A, `TSC; SEC; SBC #n; TCS`. An argument
+  // in A is pushed first, to the top of the frame, and loaded back from there.
+  bool SaveA = MBB.isLiveIn(SNES::A) || MBB.isLiveIn(SNES::AL);
+  unsigned Size = SaveA ? FrameSize - 2 : FrameSize;
 
-  // Skip the callee-saved push instructions.
-  while (
-      (MBBI != MBB.end()) && MBBI->getFlag(MachineInstr::FrameSetup) &&
-      (MBBI->getOpcode() == SNES::PUSHRr || MBBI->getOpcode() == SNES::PUSHWRr)) {
-    ++MBBI;
+  if (SaveA) {
+    MachineInstrBuilder MIB =
+        BuildMI(MBB, MBBI, DL, TII.get(SNES::PHAstk))
+            .setMIFlag(MachineInstr::FrameSetup);
+    addAccumulator(MIB, !MBB.isLiveIn(SNES::A));
   }
 
-  // Update Y with the new base value.
-  BuildMI(MBB, MBBI, DL, TII.get(SNES::SPREAD), SNES::R29R28)
-      .addReg(SNES::SP)
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::TSC))
+      .setMIFlag(MachineInstr::FrameSetup);
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::SEC))
+      .setMIFlag(MachineInstr::FrameSetup);
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::SBCimm16), SNES::A)
+      .addReg(SNES::A, RegState::Kill)
+      .addImm(Size)
+      .setMIFlag(MachineInstr::FrameSetup);
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::TCS))
       .setMIFlag(MachineInstr::FrameSetup);
 
-  // Mark the FramePtr as live-in in every block except the entry.
-  for (MachineFunction::iterator I = std::next(MF.begin()), E = MF.end();
-       I != E; ++I) {
-    I->addLiveIn(SNES::R29R28);
-  }
-
-  if (!FrameSize) {
-    return;
+  if (SaveA) {
+    BuildMI(MBB, MBBI, DL, TII.get(SNES::LDAsr16), SNES::A)
+        .addReg(SNES::SP)
+        .addImm(Size + 1)
+        .setMIFlag(MachineInstr::FrameSetup);
   }
-
-  // Reserve the necessary frame memory by doing FP -= <size>.
-  unsigned Opcode = (isUInt<6>(FrameSize)) ? SNES::SBIWRdK : SNES::SUBIWRdK;
-
-  MachineInstr *MI = BuildMI(MBB, MBBI, DL, TII.get(Opcode), SNES::R29R28)
-                         .addReg(SNES::R29R28, RegState::Kill)
-                         .addImm(FrameSize)
-                         .setMIFlag(MachineInstr::FrameSetup);
-  // The P implicit def is dead.
-  MI->getOperand(3).setIsDead();
-
-  // Write back R29R28 to SP and temporarily disable interrupts.
-  BuildMI(MBB, MBBI, DL, TII.get(SNES::SPWRITE), SNES::SP)
-      .addReg(SNES::R29R28)
-      .setMIFlag(MachineInstr::FrameSetup);
-*/
 }
 
 void SNESFrameLowering::emitEpilogue(MachineFunction &MF,
                                     MachineBasicBlock &MBB) const {
-// TODO: check what will be used on the code below
-/*
-  CallingConv::ID CallConv = MF.getFunction()->getCallingConv();
-  bool isHandler = (CallConv == CallingConv::SNES_INTR ||
-                    CallConv == CallingConv::SNES_SIGNAL);
-
-  // Early exit if the frame pointer is not needed in this function except for
-  // signal/interrupt handlers where special code generation is required.
-  if (!hasFP(MF) && !isHandler) {
-    return;
-  }
-
   MachineBasicBlock::iterator MBBI = MBB.getLastNonDebugInstr();
   assert(MBBI->getDesc().isReturn() &&
          "Can only insert epilog into returning blocks");
@@ -169,57 +151,55 @@ void SNESFrameLowering::emitEpilogue(MachineFunction &MF,
   const SNESSubtarget &STI = MF.getSubtarget<SNESSubtarget>();
   const SNESInstrInfo &TII = *STI.getInstrInfo();
 
-  // Emit special epilogue code to restore R1, A and P in interrupt/signal
-  // handlers at the very end of the function, just before reti.
-  if (isHandler) {
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::POPRd), SNES::A);
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::OUTARr))
-        .addImm(0x3f)
-        .addReg(SNES::A, RegState::Kill);
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::POPWRd), SNES::AA);
-  }
-
-  if (hasFP(MF))
-    BuildMI(MBB, MBBI, DL, TII.get(SNES::POPWRd), SNES::R29R28);
-
-  // Early exit if there is no need to restore the frame pointer.
   if (!FrameSize) {
     return;
   }
 
-  // Skip the callee-saved pop instructions.
-  while (MBBI != MBB.begin()) {
-    MachineBasicBlock::iterator PI = std::prev(MBBI);
-    int Opc = PI->getOpcode();
-
-    if (Opc != SNES::POPRd && Opc != SNES::POPWRd && !PI->isTerminator()) {
-      break;
-    }
+  // The return value, or the arguments of a tail call, must be kept.
+  const MachineInstr &Ret = *MBBI;
+  bool KeepA = Ret.readsRegister(SNES::A) || Ret.readsRegister(SNES::AL);
+  unsigned PullReg = !Ret.readsRegister(SNES::X)
+                         ? SNES::X
+                         : !Ret.readsRegister(SNES::Y) ? SNES::Y : 0;
 
+  // Skip the callee-saved pull instructions.
+  while (MBBI != MBB.begin() && isCalleeSavedPull(*std::prev(MBBI))) {
     --MBBI;
   }
 
-  unsigned Opcode;
+  // A small frame is pulled into an index register the return doesn't read.
+  // In an interrupt handler that is one it pulls back after.
+  if (FrameSize <= MaxPushedFrame && PullReg) {
+    for (unsigned i = 0; i != FrameSize; i += 2) {
+      BuildMI(MBB, MBBI, DL,
+              TII.get(PullReg == SNES::X ? SNES::PLX : SNES::PLY), PullReg)
+          ->getOperand(0)
+          .setIsDead();
+    }
+    return;
+  }
 
-  // Select the optimal opcode depending on how big it is.
-  if (isUInt<6>(FrameSize)) {
-    Opcode = SNES::ADIWRdK;
-  } else {
-    Opcode = SNES::SUBIWRdK;
-    FrameSize = -FrameSize;
+  // Otherwise S is moved up through A, `TSC; CLC; ADC #n; TCS`. A value in A
+  // is stored to the top of the frame first and pulled from there.
+  unsigned Size = KeepA ? FrameSize - 2 : FrameSize;
+
+  if (KeepA) {
+    MachineInstrBuilder MIB = BuildMI(MBB, MBBI, DL, TII.get(SNES::STAsr16))
+                                  .addReg(SNES::SP)
+                                  .addImm(Size + 1);
+    addAccumulator(MIB, !Ret.readsRegister(SNES::A));
   }
 
-  // Restore the frame pointer by doing FP += <size>.
-  MachineInstr *MI = BuildMI(MBB, MBBI, DL, TII.get(Opcode), SNES::R29R28)
-                         .addReg(SNES::R29R28, RegState::Kill)
-                         .addImm(FrameSize);
-  // The P implicit def is dead.
-  MI->getOperand(3).setIsDead();
-
-  // Write back R29R28 to SP and temporarily disable interrupts.
-  BuildMI(MBB, MBBI, DL, TII.get(SNES::SPWRITE), SNES::SP)
-      .addReg(SNES::R29R28, RegState::Kill);
-*/
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::TSC));
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::CLC));
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::ADCimm16), SNES::A)
+      .addReg(SNES::A, RegState::Kill)
+      .addImm(Size);
+  BuildMI(MBB, MBBI, DL, TII.get(SNES::TCS));
+
+  if (KeepA) {
+    BuildMI(MBB, MBBI, DL, TII.get(SNES::PLA), SNES::A);
+  }
 }
 
 // Return true if the specified function should have a dedicated frame
@@ -268,10 +248,12 @@ bool SNESFrameLowering::spillCalleeSavedRegisters(
     }
 
     // Do not kill the register when it is an input argument.
-    BuildMI(MBB, MI, DL, TII.get(SNES::PHAstk))
+    unsigned Opc = Reg == SNES::A ? SNES::PHAstk
+                                  : Reg == SNES::X ? SNES::PHX : SNES::PHY;
+    BuildMI(MBB, MI, DL, TII.get(Opc))
         .addReg(Reg, getKillRegState(IsNotLiveIn))
         .setMIFlag(MachineInstr::FrameSetup);
-    ++CalleeFrameSize;
+    CalleeFrameSize += 2;
   }
 
   SNESFI->setCalleeSavedFrameSize(CalleeFrameSize);
@@ -298,7 +280,9 @@ bool SNESFrameLowering::restoreCalleeSavedRegisters(
     assert(TRI->getRegSizeInBits(*TRI->getMinimalPhysRegClass(Reg)) == 16 &&
            "Invalid register size");
 
-    BuildMI(MBB, MI, DL, TII.get(SNES::POPRd), Reg);
+    unsigned Opc = Reg == SNES::A ? SNES::PLA
+                                  : Reg == SNES::X ? SNES::PLX : SNES::PLY;
+    BuildMI(MBB, MI, DL, TII.get(Opc), Reg);
   }
 
   return true;
@@ -367,14 +367,32 @@ template <> bool SNESDAGToDAGISel::select<ISD::LOAD>(SDNode *N) {
     return selectIndexedLoad(N);
   }
 
-  // This is a flash memory load, move the pointer into A and emit
-  // the lpm instruction.
   MVT VT = LD->getMemoryVT().getSimpleVT();
   SDValue Chain = LD->getChain();
   SDValue Ptr = LD->getBasePtr();
   SDNode *ResNode;
   SDLoc DL(N);
 
+  // ROM data may be in any bank, a symbol is read with a long address.
+  if (Ptr.getOpcode() == SNESISD::WRAPPER &&
+      Ptr.getOperand(0).getOpcode() == ISD::TargetGlobalAddress &&
+      (VT == MVT::i8 || VT == MVT::i16)) {
+    unsigned Opc = VT == MVT::i8 ? SNES::LDAlong8 : SNES::LDAlong16;
+    ResNode = CurDAG->getMachineNode(Opc, DL, VT, MVT::Other,
+                                     Ptr.getOperand(0), Chain);
+
+    MachineSDNode::mmo_iterator MemOp = MF->allocateMemRefsArray(1);
+    MemOp[0] = LD->getMemOperand();
+    cast<MachineSDNode>(ResNode)->setMemRefs(MemOp, MemOp + 1);
+
+    ReplaceUses(SDValue(N, 0), SDValue(ResNode, 0));
+    ReplaceUses(SDValue(N, 1), SDValue(ResNode, 1));
+    CurDAG->RemoveDeadNode(N);
+    return true;
+  }
+
+  // Otherwise, move the pointer into A and emit the lpm instruction.
+
   Chain = CurDAG->getCopyToReg(Chain, DL, SNES::A, Ptr, SDValue());
   Ptr = CurDAG->getCopyFromReg(Chain, DL, SNES::A, MVT::i16,
                                Chain.getValue(1));
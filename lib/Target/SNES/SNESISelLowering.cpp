@@ -18,15 +18,19 @@
 #include "llvm/CodeGen/CallingConvLower.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineJumpTableInfo.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/CodeGen/TargetLoweringObjectFileImpl.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/Support/ErrorHandling.h"
 
 #include "SNES.h"
 #include "SNESMachineFunctionInfo.h"
 #include "SNESTargetMachine.h"
+#include "SNESTargetObjectFile.h"
 #include "MCTargetDesc/SNESMCTargetDesc.h"
 
 namespace llvm {
@@ -34,7 +38,9 @@ namespace llvm {
 SNESTargetLowering::SNESTargetLowering(SNESTargetMachine &tm)
     : TargetLowering(tm) {
   // Set up the register classes.
-  addRegisterClass(MVT::i8, &SNES::MainRegsRegClass);
+  // Bytes are kept in the low halves and operated on with M set, see
+  // SNESAccumulatorWidth.cpp.
+  addRegisterClass(MVT::i8, &SNES::MainLoRegsRegClass);
   addRegisterClass(MVT::i16, &SNES::MainRegsRegClass);
 
   // Compute derived properties from the register classes.
@@ -101,30 +107,39 @@ SNESTargetLowering::SNESTargetLowering(SNESTargetMachine &tm)
   setOperationAction(ISD::SELECT, MVT::i8, Expand);
   setOperationAction(ISD::SELECT, MVT::i16, Expand);
 
+  // `BPL +; EOR #$FFFF; INC A`, the DAG combiner forms it out of the selects
+  // and shifts of the usual absolute value idioms.
+  setOperationAction(ISD::ABS, MVT::i16, Legal);
+
   setOperationAction(ISD::BSWAP, MVT::i16, Expand);
 
-  // Add support for postincrement and predecrement load/stores.
-  setIndexedLoadAction(ISD::POST_INC, MVT::i8, Legal);
-  setIndexedLoadAction(ISD::POST_INC, MVT::i16, Legal);
-  setIndexedLoadAction(ISD::PRE_DEC, MVT::i8, Legal);
-  setIndexedLoadAction(ISD::PRE_DEC, MVT::i16, Legal);
-  setIndexedStoreAction(ISD::POST_INC, MVT::i8, Legal);
-  setIndexedStoreAction(ISD::POST_INC, MVT::i16, Legal);
-  setIndexedStoreAction(ISD::PRE_DEC, MVT::i8, Legal);
-  setIndexedStoreAction(ISD::PRE_DEC, MVT::i16, Legal);
+  // There are no post increment or pre decrement addressing modes, arrays
+  // are walked with an index register instead (abs,X and (dp),Y).
 
-  setOperationAction(ISD::BR_JT, MVT::Other, Expand);
+  // Switches become `JMP (table,X)`, with X the case times two.
+  setOperationAction(ISD::BR_JT, MVT::Other, Custom);
 
   setOperationAction(ISD::VASTART, MVT::Other, Custom);
   setOperationAction(ISD::VAEND, MVT::Other, Expand);
   setOperationAction(ISD::VAARG, MVT::Other, Expand);
   setOperationAction(ISD::VACOPY, MVT::Other, Expand);
 
+  // There is a single core, an operation is atomic when no interrupt can come
+  // in the middle of it. Loads and stores of a byte or a word are a single
+  // instruction, `x |= m` and `x &= ~m` on a fixed address are TSB and TRB,
+  // and the other read-modify-writes run with interrupts disabled, see
+  // SNESExpandPseudo::expandAtomic. Wider atomics are rtlib calls.
+  setMaxAtomicSizeInBitsSupported(16);
+  for (MVT VT : {MVT::i8, MVT::i16}) {
+    setOperationAction(ISD::ATOMIC_LOAD, VT, Custom);
+    setOperationAction(ISD::ATOMIC_STORE, VT, Custom);
+    setOperationAction(ISD::ATOMIC_LOAD_OR, VT, Custom);
+    setOperationAction(ISD::ATOMIC_LOAD_AND, VT, Custom);
+  }
+
   // Atomic operations which must be lowered to rtlib calls
   for (MVT VT : MVT::integer_valuetypes()) {
-    setOperationAction(ISD::ATOMIC_SWAP, VT, Expand);
     setOperationAction(ISD::ATOMIC_CMP_SWAP, VT, Expand);
-    setOperationAction(ISD::ATOMIC_LOAD_NAND, VT, Expand);
     setOperationAction(ISD::ATOMIC_LOAD_MAX, VT, Expand);
     setOperationAction(ISD::ATOMIC_LOAD_MIN, VT, Expand);
     setOperationAction(ISD::ATOMIC_LOAD_UMAX, VT, Expand);
@@ -147,13 +162,17 @@ SNESTargetLowering::SNESTargetLowering(SNESTargetMachine &tm)
     setOperationAction(ISD::SDIVREM, VT, Custom);
   }
 
-  // Do not use MUL. The SNES instructions are closer to SMUL_LOHI &co.
-  setOperationAction(ISD::MUL, MVT::i8, Expand);
-  setOperationAction(ISD::MUL, MVT::i16, Expand);
+  // Bytes are multiplied on the hardware multiplier. Functions on the SA-1
+  // core multiply words on its arithmetic unit, the others fall back to the
+  // libcall, see LowerMUL.
+  setOperationAction(ISD::MUL, MVT::i8, Custom);
+  setOperationAction(ISD::MUL, MVT::i16, Custom);
 
-  // Expand 16 bit multiplications.
-  setOperationAction(ISD::SMUL_LOHI, MVT::i16, Expand);
-  setOperationAction(ISD::UMUL_LOHI, MVT::i16, Expand);
+  // There is no multiply instruction to split a word multiply into.
+  for (MVT VT : {MVT::i8, MVT::i16}) {
+    setOperationAction(ISD::SMUL_LOHI, VT, Expand);
+    setOperationAction(ISD::UMUL_LOHI, VT, Expand);
+  }
 
   for (MVT VT : MVT::integer_valuetypes()) {
     setOperationAction(ISD::MULHS, VT, Expand);
@@ -223,8 +242,15 @@ SNESTargetLowering::SNESTargetLowering(SNESTargetMachine &tm)
   setLibcallName(RTLIB::SIN_F32, "sin");
   setLibcallName(RTLIB::COS_F32, "cos");
 
+  // There are no floating point registers, f32 operations are softened into
+  // calls to the runtime, which keeps the compiler-rt names (__addsf3 &co).
+  // The fixed-point intrinsics are expanded before type legalization.
+  setTargetDAGCombine(ISD::INTRINSIC_WO_CHAIN);
+
+  // Byte writes to hardware register pairs are merged into word writes.
+  setTargetDAGCombine(ISD::STORE);
+
   setMinFunctionAlignment(1);
-  setMinimumJumpTableEntries(INT_MAX);
 }
 
 const char *SNESTargetLowering::getTargetNodeName(unsigned Opcode) const {
@@ -238,7 +264,18 @@ const char *SNESTargetLowering::getTargetNodeName(unsigned Opcode) const {
     NODE(RET_FLAG);
     NODE(RETI_FLAG);
     NODE(CALL);
+    NODE(FAR_CALL);
+    NODE(TAIL_CALL);
+    NODE(SAVE_BANK);
+    NODE(SET_BANK);
+    NODE(RESTORE_BANK);
     NODE(WRAPPER);
+    NODE(HWMUL);
+    NODE(SA1MUL);
+    NODE(BR_JT);
+    NODE(BCDADD);
+    NODE(BCDSUB);
+    NODE(DEC);
     NODE(LSL);
     NODE(LSR);
     NODE(ROL);
@@ -252,6 +289,10 @@ const char *SNESTargetLowering::getTargetNodeName(unsigned Opcode) const {
     NODE(CMPC);
     NODE(TST);
     NODE(SELECT_CC);
+    NODE(CARRY_BIT);
+    NODE(CARRY_MASK);
+    NODE(TSB);
+    NODE(TRB);
 #undef NODE
   }
 }
@@ -262,6 +303,62 @@ EVT SNESTargetLowering::getSetCCResultType(const DataLayout &DL, LLVMContext &,
   return MVT::i8;
 }
 
+/// A byte operation needs M set, a SEP and a REP around it are 4 bytes and
+/// 6 cycles, while an `AND #$00FF` to get a word back to a byte is 3 bytes
+/// and 3 cycles. The operations a word does as well are left to
+/// IsDesirableToPromoteOp.
+bool SNESTargetLowering::isTypeDesirableForOp(unsigned Opc, EVT VT) const {
+  if (!isTypeLegal(VT))
+    return false;
+  if (VT != MVT::i8)
+    return true;
+
+  switch (Opc) {
+  case ISD::ADD:
+  case ISD::SUB:
+  case ISD::AND:
+  case ISD::OR:
+  case ISD::XOR:
+  case ISD::SHL:
+  case ISD::SRL:
+    return false;
+  default:
+    return true;
+  }
+}
+
+/// Checks if a byte is the low half of a word anyway.
+static bool isWordByte(SDValue V) {
+  return V.getOpcode() == ISD::TRUNCATE || isa<ConstantSDNode>(V);
+}
+
+/// Promotes a byte operation to a word one when the bytes come from words
+/// and the result goes back to a word, so that the byte operation would be
+/// the only reason to switch the accumulator to 8 bits. Byte operations
+/// between loads and stores of bytes stay, M is set for those anyway.
+bool SNESTargetLowering::IsDesirableToPromoteOp(SDValue Op, EVT &PVT) const {
+  if (Op.getValueType() != MVT::i8)
+    return false;
+
+  for (SDValue Operand : Op->op_values())
+    if (!isWordByte(Operand))
+      return false;
+
+  for (SDNode *User : Op->uses()) {
+    switch (User->getOpcode()) {
+    case ISD::ZERO_EXTEND:
+    case ISD::ANY_EXTEND:
+    case ISD::SIGN_EXTEND:
+      break;
+    default:
+      return false;
+    }
+  }
+
+  PVT = MVT::i16;
+  return true;
+}
+
 SDValue SNESTargetLowering::LowerShifts(SDValue Op, SelectionDAG &DAG) const {
   //:TODO: this function has to be completely rewritten to produce optimal
   // code, for now it's producing very long but correct code.
@@ -270,26 +367,24 @@ SDValue SNESTargetLowering::LowerShifts(SDValue Op, SelectionDAG &DAG) const {
   EVT VT = Op.getValueType();
   SDLoc dl(N);
 
-  // Expand non-constant shifts to loops.
+  // Expand non-constant shifts to loops. The loop counts down a word, the
+  // index registers are never switched to bytes, so the count of a byte
+  // shift is zero extended first.
   if (!isa<ConstantSDNode>(N->getOperand(1))) {
+    SDValue Count = DAG.getZExtOrTrunc(N->getOperand(1), dl, MVT::i16);
     switch (Op.getOpcode()) {
     default:
       llvm_unreachable("Invalid shift opcode!");
     case ISD::SHL:
-      return DAG.getNode(SNESISD::LSLLOOP, dl, VT, N->getOperand(0),
-                         N->getOperand(1));
+      return DAG.getNode(SNESISD::LSLLOOP, dl, VT, N->getOperand(0), Count);
     case ISD::SRL:
-      return DAG.getNode(SNESISD::LSRLOOP, dl, VT, N->getOperand(0),
-                         N->getOperand(1));
+      return DAG.getNode(SNESISD::LSRLOOP, dl, VT, N->getOperand(0), Count);
     case ISD::ROTL:
-      return DAG.getNode(SNESISD::ROLLOOP, dl, VT, N->getOperand(0),
-                         N->getOperand(1));
+      return DAG.getNode(SNESISD::ROLLOOP, dl, VT, N->getOperand(0), Count);
     case ISD::ROTR:
-      return DAG.getNode(SNESISD::RORLOOP, dl, VT, N->getOperand(0),
-                         N->getOperand(1));
+      return DAG.getNode(SNESISD::RORLOOP, dl, VT, N->getOperand(0), Count);
     case ISD::SRA:
-      return DAG.getNode(SNESISD::ASRLOOP, dl, VT, N->getOperand(0),
-                         N->getOperand(1));
+      return DAG.getNode(SNESISD::ASRLOOP, dl, VT, N->getOperand(0), Count);
     }
   }
 
@@ -402,6 +497,24 @@ SDValue SNESTargetLowering::LowerBlockAddress(SDValue Op,
   return DAG.getNode(SNESISD::WRAPPER, SDLoc(Op), getPointerTy(DL), Result);
 }
 
+SDValue SNESTargetLowering::LowerBR_JT(SDValue Op, SelectionDAG &DAG) const {
+  SDLoc DL(Op);
+  SDValue Chain = Op.getOperand(0);
+  auto *JT = cast<JumpTableSDNode>(Op.getOperand(1));
+  SDValue Index = Op.getOperand(2);
+
+  // The entries are 2 byte addresses in the bank of the code.
+  SDValue Table = DAG.getTargetJumpTable(JT->getIndex(), MVT::i16);
+  Index = DAG.getNode(ISD::SHL, DL, MVT::i16, Index,
+                      DAG.getConstant(1, DL, MVT::i8));
+  return DAG.getNode(SNESISD::BR_JT, DL, MVT::Other, Chain, Table, Index);
+}
+
+unsigned SNESTargetLowering::getJumpTableEncoding() const {
+  // JMP (table,X) needs the addresses themselves, even in PIC.
+  return MachineJumpTableInfo::EK_BlockAddress;
+}
+
 /// IntCCToSNESCC - Convert a DAG integer condition code to an SNES CC.
 static SNESCC::CondCodes intCCToSNESCC(ISD::CondCode CC) {
   switch (CC) {
@@ -586,6 +699,17 @@ SDValue SNESTargetLowering::getSNESCmp(SDValue LHS, SDValue RHS, ISD::CondCode C
                             : DAG.getNode(ISD::EXTRACT_ELEMENT, DL, MVT::i8,
                                           LHS, DAG.getIntPtrConstant(1, DL)));
     } else {
+      // CMP only takes a byte from an immediate or from memory. Two bytes in
+      // registers are compared as words, extended as the condition reads
+      // them.
+      bool RHSInMemory = ISD::isNormalLoad(RHS.getNode()) &&
+                         RHS.getOperand(1).getOpcode() == SNESISD::WRAPPER;
+      if (VT == MVT::i8 && !isa<ConstantSDNode>(RHS) && !RHSInMemory) {
+        unsigned Ext =
+            ISD::isSignedIntSetCC(CC) ? ISD::SIGN_EXTEND : ISD::ZERO_EXTEND;
+        LHS = DAG.getNode(Ext, DL, MVT::i16, LHS);
+        RHS = DAG.getNode(Ext, DL, MVT::i16, RHS);
+      }
       Cmp = DAG.getNode(SNESISD::CMP, DL, MVT::Glue, LHS, RHS);
     }
   } else {
@@ -608,6 +732,22 @@ SDValue SNESTargetLowering::LowerBR_CC(SDValue Op, SelectionDAG &DAG) const {
   SDValue Dest = Op.getOperand(4);
   SDLoc dl(Op);
 
+  // A counter decremented down to zero. The decrement sets Z, so the branch
+  // doesn't need a compare, `DEX; BNE loop`. The flags are glued to the
+  // branch, so this is only done when nothing else uses the decrement.
+  if ((CC == ISD::SETNE || CC == ISD::SETEQ) && isNullConstant(RHS) &&
+      LHS.getValueType() == MVT::i16 && LHS.getOpcode() == ISD::ADD &&
+      isAllOnesConstant(LHS.getOperand(1)) && LHS.hasOneUse()) {
+    SDValue Dec = DAG.getNode(SNESISD::DEC, dl,
+                              DAG.getVTList(MVT::i16, MVT::Glue),
+                              LHS.getOperand(0));
+
+    SDValue TargetCC = DAG.getConstant(
+        CC == ISD::SETNE ? SNESCC::COND_NE : SNESCC::COND_EQ, dl, MVT::i8);
+    return DAG.getNode(SNESISD::BRCOND, dl, MVT::Other, Chain, Dest, TargetCC,
+                       Dec.getValue(1));
+  }
+
   SDValue TargetCC;
   SDValue Cmp = getSNESCmp(LHS, RHS, CC, TargetCC, DAG, dl);
 
@@ -615,6 +755,92 @@ SDValue SNESTargetLowering::LowerBR_CC(SDValue Op, SelectionDAG &DAG) const {
                      Cmp);
 }
 
+/// Cycles of a select done with a branch: the load of the first value, the
+/// branch, taken about half of the time, and the load of the other value.
+static const unsigned BranchSelectCycles = 9;
+
+/// Rewrites a test of the sign of \p LHS into an unsigned compare, which
+/// leaves the sign in the carry, `CMP #$8000`.
+static void getSignTestAsCarry(SDValue &LHS, SDValue &RHS, ISD::CondCode &CC,
+                               const SDLoc &DL, SelectionDAG &DAG) {
+  EVT VT = LHS.getValueType();
+  if (VT != MVT::i8 && VT != MVT::i16)
+    return;
+
+  if (CC == ISD::SETLT && isNullConstant(RHS))
+    CC = ISD::SETUGE;
+  else if (CC == ISD::SETGT && isAllOnesConstant(RHS))
+    CC = ISD::SETULT;
+  else
+    return;
+
+  RHS = DAG.getConstant(APInt::getSignMask(VT.getSizeInBits()), DL, VT);
+}
+
+/// Lowers a select between two constants on an unsigned compare without a
+/// branch, when the carry it leaves gives the result in no more cycles than
+/// a branch would take:
+///
+///   LDA #0; ROL A                         carry ? 1 : 0
+///   LDA #0; SBC #0                        carry ? 0 : $FFFF
+///   LDA #0; SBC #0; AND #(T^F); EOR #T    carry ? T : F
+///
+/// Anything else is left to the Select pseudos. Min, max and clamp are a
+/// compare and a branch around one copy there, and the absolute value is
+/// the Abs16 pseudo.
+SDValue SNESTargetLowering::lowerSelect(SDValue TrueV, SDValue FalseV,
+                                        SDValue TargetCC, SDValue Cmp,
+                                        const SDLoc &DL,
+                                        SelectionDAG &DAG) const {
+  EVT VT = TrueV.getValueType();
+  auto *TrueC = dyn_cast<ConstantSDNode>(TrueV);
+  auto *FalseC = dyn_cast<ConstantSDNode>(FalseV);
+  SNESCC::CondCodes CC =
+      (SNESCC::CondCodes)cast<ConstantSDNode>(TargetCC)->getZExtValue();
+
+  if ((VT != MVT::i8 && VT != MVT::i16) || !TrueC || !FalseC ||
+      (CC != SNESCC::COND_SH && CC != SNESCC::COND_LO))
+    return SDValue();
+
+  // The values with the carry set and clear, computed in 16 bits.
+  APInt Set = TrueC->getAPIntValue().zext(16);
+  APInt Clear = FalseC->getAPIntValue().zext(16);
+  if (CC == SNESCC::COND_LO)
+    std::swap(Set, Clear);
+
+  // The carry itself, and flipped with `EOR #1`.
+  unsigned BitCycles = ~0U;
+  if (Set == 1 && Clear == 0)
+    BitCycles = 5;
+  else if (Set == 0 && Clear == 1)
+    BitCycles = 8;
+
+  APInt Diff = Set ^ Clear;
+  unsigned MaskCycles =
+      6 + (Diff.isAllOnesValue() ? 0 : 3) + (Set.isNullValue() ? 0 : 3);
+
+  if (std::min(BitCycles, MaskCycles) > BranchSelectCycles)
+    return SDValue();
+
+  SDValue Result;
+  if (BitCycles <= MaskCycles) {
+    Result = DAG.getNode(SNESISD::CARRY_BIT, DL, MVT::i16, Cmp);
+    if (Set == 0)
+      Result = DAG.getNode(ISD::XOR, DL, MVT::i16, Result,
+                           DAG.getConstant(1, DL, MVT::i16));
+  } else {
+    Result = DAG.getNode(SNESISD::CARRY_MASK, DL, MVT::i16, Cmp);
+    Result = DAG.getNode(ISD::AND, DL, MVT::i16, Result,
+                         DAG.getConstant(Diff, DL, MVT::i16));
+    Result = DAG.getNode(ISD::XOR, DL, MVT::i16, Result,
+                         DAG.getConstant(Set, DL, MVT::i16));
+  }
+
+  if (VT == MVT::i8)
+    Result = DAG.getNode(ISD::TRUNCATE, DL, VT, Result);
+  return Result;
+}
+
 SDValue SNESTargetLowering::LowerSELECT_CC(SDValue Op, SelectionDAG &DAG) const {
   SDValue LHS = Op.getOperand(0);
   SDValue RHS = Op.getOperand(1);
@@ -623,9 +849,15 @@ SDValue SNESTargetLowering::LowerSELECT_CC(SDValue Op, SelectionDAG &DAG) const
   ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(4))->get();
   SDLoc dl(Op);
 
+  if (isa<ConstantSDNode>(TrueV) && isa<ConstantSDNode>(FalseV))
+    getSignTestAsCarry(LHS, RHS, CC, dl, DAG);
+
   SDValue TargetCC;
   SDValue Cmp = getSNESCmp(LHS, RHS, CC, TargetCC, DAG, dl);
 
+  if (SDValue Select = lowerSelect(TrueV, FalseV, TargetCC, Cmp, dl, DAG))
+    return Select;
+
   SDVTList VTs = DAG.getVTList(Op.getValueType(), MVT::Glue);
   SDValue Ops[] = {TrueV, FalseV, TargetCC, Cmp};
 
@@ -638,11 +870,16 @@ SDValue SNESTargetLowering::LowerSETCC(SDValue Op, SelectionDAG &DAG) const {
   ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(2))->get();
   SDLoc DL(Op);
 
+  getSignTestAsCarry(LHS, RHS, CC, DL, DAG);
+
   SDValue TargetCC;
   SDValue Cmp = getSNESCmp(LHS, RHS, CC, TargetCC, DAG, DL);
 
   SDValue TrueV = DAG.getConstant(1, DL, Op.getValueType());
   SDValue FalseV = DAG.getConstant(0, DL, Op.getValueType());
+  if (SDValue Select = lowerSelect(TrueV, FalseV, TargetCC, Cmp, DL, DAG))
+    return Select;
+
   SDVTList VTs = DAG.getVTList(Op.getValueType(), MVT::Glue);
   SDValue Ops[] = {TrueV, FalseV, TargetCC, Cmp};
 
@@ -664,6 +901,53 @@ SDValue SNESTargetLowering::LowerVASTART(SDValue Op, SelectionDAG &DAG) const {
                       MachinePointerInfo(SV), 0);
 }
 
+/// An atomic load of a byte or a word is a single `LDA`.
+SDValue SNESTargetLowering::LowerATOMIC_LOAD(SDValue Op,
+                                             SelectionDAG &DAG) const {
+  auto *AN = cast<AtomicSDNode>(Op);
+  return DAG.getLoad(Op.getValueType(), SDLoc(Op), AN->getChain(),
+                     AN->getBasePtr(), AN->getPointerInfo(),
+                     AN->getAlignment(), MachineMemOperand::MOVolatile);
+}
+
+/// An atomic store of a byte or a word is a single `STA`.
+SDValue SNESTargetLowering::LowerATOMIC_STORE(SDValue Op,
+                                              SelectionDAG &DAG) const {
+  auto *AN = cast<AtomicSDNode>(Op);
+  return DAG.getStore(AN->getChain(), SDLoc(Op), AN->getVal(),
+                      AN->getBasePtr(), AN->getPointerInfo(),
+                      AN->getAlignment(), MachineMemOperand::MOVolatile);
+}
+
+/// Lowers an `atomicrmw or` or `and` on a fixed address whose old value is
+/// not used to TSB or TRB, which do the whole read-modify-write in one
+/// instruction. Anything else is left to the AtomicLoadOp pseudos.
+SDValue SNESTargetLowering::LowerATOMIC_LOAD_OP(SDValue Op,
+                                                SelectionDAG &DAG) const {
+  auto *AN = cast<AtomicSDNode>(Op);
+  if (Op.getNode()->hasAnyUseOfValue(0))
+    return Op;
+
+  SDValue Ptr = AN->getBasePtr();
+  if (Ptr.getOpcode() != SNESISD::WRAPPER && !isa<ConstantSDNode>(Ptr))
+    return Op;
+
+  SDLoc DL(Op);
+  EVT VT = AN->getMemoryVT();
+  SDValue Mask = AN->getVal();
+  unsigned Opc = SNESISD::TSB;
+  if (Op.getOpcode() == ISD::ATOMIC_LOAD_AND) {
+    // TRB clears the bits set in A.
+    Mask = DAG.getNOT(DL, Mask, VT);
+    Opc = SNESISD::TRB;
+  }
+
+  SDValue Ops[] = {AN->getChain(), Ptr, Mask};
+  SDValue Chain = DAG.getMemIntrinsicNode(Opc, DL, DAG.getVTList(MVT::Other),
+                                          Ops, VT, AN->getMemOperand());
+  return DAG.getMergeValues({DAG.getUNDEF(Op.getValueType()), Chain}, DL);
+}
+
 SDValue SNESTargetLowering::LowerOperation(SDValue Op, SelectionDAG &DAG) const {
   switch (Op.getOpcode()) {
   default:
@@ -680,15 +964,197 @@ SDValue SNESTargetLowering::LowerOperation(SDValue Op, SelectionDAG &DAG) const
     return LowerBlockAddress(Op, DAG);
   case ISD::BR_CC:
     return LowerBR_CC(Op, DAG);
+  case ISD::BR_JT:
+    return LowerBR_JT(Op, DAG);
   case ISD::SELECT_CC:
     return LowerSELECT_CC(Op, DAG);
   case ISD::SETCC:
     return LowerSETCC(Op, DAG);
   case ISD::VASTART:
     return LowerVASTART(Op, DAG);
+  case ISD::ATOMIC_LOAD:
+    return LowerATOMIC_LOAD(Op, DAG);
+  case ISD::ATOMIC_STORE:
+    return LowerATOMIC_STORE(Op, DAG);
+  case ISD::ATOMIC_LOAD_OR:
+  case ISD::ATOMIC_LOAD_AND:
+    return LowerATOMIC_LOAD_OP(Op, DAG);
   case ISD::SDIVREM:
   case ISD::UDIVREM:
     return LowerDivRem(Op, DAG);
+  case ISD::MUL:
+    return LowerMUL(Op, DAG);
+  }
+
+  return SDValue();
+}
+
+/// Checks if the function being lowered runs on the SA-1 core.
+static bool isSA1Code(const SelectionDAG &DAG) {
+  const MachineFunction &MF = DAG.getMachineFunction();
+  return MF.getSubtarget<SNESSubtarget>().hasSA1() &&
+         SNES::isSA1Function(*MF.getFunction());
+}
+
+SDValue SNESTargetLowering::LowerMUL(SDValue Op, SelectionDAG &DAG) const {
+  SDLoc DL(Op);
+
+  // The low byte of the product is the same signed or unsigned.
+  if (Op.getValueType() == MVT::i8)
+    return DAG.getNode(ISD::TRUNCATE, DL, MVT::i8,
+                       getByteMul(Op.getOperand(0), Op.getOperand(1), DL, DAG));
+
+  // An empty value makes the legalizer expand the node into __mulhi3.
+  if (!isSA1Code(DAG))
+    return SDValue();
+
+  return DAG.getNode(SNESISD::SA1MUL, DL, MVT::i16, Op.getOperand(0),
+                     Op.getOperand(1));
+}
+
+/// Multiplies two unsigned bytes into a word.
+///
+/// The S-CPU's multiplier at WRMPYA is not mapped for the SA-1 core, which
+/// uses its own unit with the bytes zero extended instead. Its multiply is
+/// signed, but the product of two positive words below 256 is the same.
+SDValue SNESTargetLowering::getByteMul(SDValue LHS, SDValue RHS,
+                                       const SDLoc &DL,
+                                       SelectionDAG &DAG) const {
+  if (!isSA1Code(DAG))
+    return DAG.getNode(SNESISD::HWMUL, DL, MVT::i16, LHS, RHS);
+
+  return DAG.getNode(SNESISD::SA1MUL, DL, MVT::i16,
+                     DAG.getNode(ISD::ZERO_EXTEND, DL, MVT::i16, LHS),
+                     DAG.getNode(ISD::ZERO_EXTEND, DL, MVT::i16, RHS));
+}
+
+/// Multiplies two signed fixed-point numbers with `FracBits` fractional bits.
+///
+/// The hardware multiplier only does unsigned 8x8 multiplies, so the full
+/// product is summed out of the byte partial products at their offsets and
+/// then corrected for negative operands.
+SDValue SNESTargetLowering::lowerFixedMul(SDValue LHS, SDValue RHS,
+                                          unsigned FracBits, const SDLoc &DL,
+                                          SelectionDAG &DAG) const {
+  EVT VT = LHS.getValueType();
+  unsigned Bits = VT.getSizeInBits();
+  EVT WideVT = EVT::getIntegerVT(*DAG.getContext(), Bits * 2);
+  EVT ShiftVT = getShiftAmountTy(WideVT, DAG.getDataLayout());
+
+  auto getByte = [&](SDValue V, unsigned I) {
+    if (I != 0)
+      V = DAG.getNode(ISD::SRL, DL, VT, V,
+                      DAG.getConstant(I * 8, DL, getShiftAmountTy(
+                                                     VT, DAG.getDataLayout())));
+    return DAG.getNode(ISD::TRUNCATE, DL, MVT::i8, V);
+  };
+
+  SDValue Product = DAG.getConstant(0, DL, WideVT);
+  for (unsigned I = 0; I != Bits / 8; ++I) {
+    for (unsigned J = 0; J != Bits / 8; ++J) {
+      SDValue Partial = DAG.getNode(
+          ISD::ZERO_EXTEND, DL, WideVT,
+          getByteMul(getByte(LHS, I), getByte(RHS, J), DL, DAG));
+      if (I + J != 0)
+        Partial = DAG.getNode(ISD::SHL, DL, WideVT, Partial,
+                              DAG.getConstant((I + J) * 8, DL, ShiftVT));
+      Product = DAG.getNode(ISD::ADD, DL, WideVT, Product, Partial);
+    }
+  }
+
+  // The unsigned product of a negative number is off by the other operand
+  // shifted up by the width of the operands.
+  SDValue Zero = DAG.getConstant(0, DL, VT);
+  for (auto Ops : {std::make_pair(LHS, RHS), std::make_pair(RHS, LHS)}) {
+    SDValue Fixup = DAG.getSelectCC(DL, Ops.first, Zero, Ops.second, Zero,
+                                    ISD::SETLT);
+    Fixup = DAG.getNode(ISD::SHL, DL, WideVT,
+                        DAG.getNode(ISD::ZERO_EXTEND, DL, WideVT, Fixup),
+                        DAG.getConstant(Bits, DL, ShiftVT));
+    Product = DAG.getNode(ISD::SUB, DL, WideVT, Product, Fixup);
+  }
+
+  Product = DAG.getNode(ISD::SRL, DL, WideVT, Product,
+                        DAG.getConstant(FracBits, DL, ShiftVT));
+  return DAG.getNode(ISD::TRUNCATE, DL, VT, Product);
+}
+
+/// Merges a volatile byte store to the low register of a hardware register
+/// pair with the store to the high register right after it into a single
+/// 16-bit STA, e.g. for VMADDL/VMADDH.
+SDValue SNESTargetLowering::combineSTORE(SDNode *N, SelectionDAG &DAG) const {
+  auto *Hi = cast<StoreSDNode>(N);
+  if (!Hi->isVolatile() || Hi->isIndexed() || Hi->getMemoryVT() != MVT::i8)
+    return SDValue();
+
+  // The low byte must be written first, by the store this one is chained to
+  // and nothing else depends on.
+  auto *Lo = dyn_cast<StoreSDNode>(Hi->getChain());
+  if (!Lo || !Lo->hasOneUse() || !Lo->isVolatile() || Lo->isIndexed() ||
+      Lo->getMemoryVT() != MVT::i8 ||
+      Lo->getAddressSpace() != Hi->getAddressSpace())
+    return SDValue();
+
+  auto *LoAddr = dyn_cast<ConstantSDNode>(Lo->getBasePtr());
+  auto *HiAddr = dyn_cast<ConstantSDNode>(Hi->getBasePtr());
+  if (!LoAddr || !HiAddr ||
+      HiAddr->getZExtValue() != LoAddr->getZExtValue() + 1 ||
+      !SNES::isWordWritableIORegister(LoAddr->getZExtValue()))
+    return SDValue();
+
+  SDLoc DL(N);
+  EVT ShiftTy = getScalarShiftAmountTy(DAG.getDataLayout(), MVT::i16);
+  // Truncating stores may have anything in the upper bits of the value.
+  SDValue LoVal = DAG.getZeroExtendInReg(
+      DAG.getAnyExtOrTrunc(Lo->getValue(), DL, MVT::i16), DL, MVT::i8);
+  SDValue HiVal = DAG.getAnyExtOrTrunc(Hi->getValue(), DL, MVT::i16);
+  HiVal = DAG.getNode(ISD::SHL, DL, MVT::i16, HiVal,
+                      DAG.getConstant(8, DL, ShiftTy));
+  SDValue Val = DAG.getNode(ISD::OR, DL, MVT::i16, LoVal, HiVal);
+
+  MachineFunction &MF = DAG.getMachineFunction();
+  MachineMemOperand *MMO = MF.getMachineMemOperand(
+      Lo->getPointerInfo(),
+      MachineMemOperand::MOStore | MachineMemOperand::MOVolatile, 2, 1);
+
+  return DAG.getStore(Lo->getChain(), DL, Val, Lo->getBasePtr(), MMO);
+}
+
+SDValue SNESTargetLowering::combineINTRINSIC_WO_CHAIN(SDNode *N,
+                                                      SelectionDAG &DAG) const {
+  SDLoc DL(N);
+  unsigned IntNo = cast<ConstantSDNode>(N->getOperand(0))->getZExtValue();
+
+  switch (IntNo) {
+  case Intrinsic::snes_umul8:
+    return getByteMul(N->getOperand(1), N->getOperand(2), DL, DAG);
+  case Intrinsic::snes_fixed16_mul8_8:
+    return lowerFixedMul(N->getOperand(1), N->getOperand(2), 8, DL, DAG);
+  case Intrinsic::snes_fixed16_mul16_16:
+    return lowerFixedMul(N->getOperand(1), N->getOperand(2), 16, DL, DAG);
+  case Intrinsic::snes_bcd_add:
+    return DAG.getNode(SNESISD::BCDADD, DL, MVT::i16, N->getOperand(1),
+                       N->getOperand(2));
+  case Intrinsic::snes_bcd_sub:
+    return DAG.getNode(SNESISD::BCDSUB, DL, MVT::i16, N->getOperand(1),
+                       N->getOperand(2));
+  default:
+    return SDValue();
+  }
+}
+
+SDValue SNESTargetLowering::PerformDAGCombine(SDNode *N,
+                                              DAGCombinerInfo &DCI) const {
+  switch (N->getOpcode()) {
+  case ISD::INTRINSIC_WO_CHAIN:
+    // The expansions use types which only exist before legalization.
+    if (DCI.isBeforeLegalize())
+      return combineINTRINSIC_WO_CHAIN(N, DCI.DAG);
+    break;
+  case ISD::STORE:
+    return combineSTORE(N, DCI.DAG);
+  default:
+    break;
   }
 
   return SDValue();
@@ -725,135 +1191,42 @@ void SNESTargetLowering::ReplaceNodeResults(SDNode *N,
 
 /// Return true if the addressing mode represented
 /// by AM is legal for this target, for a load/store of the specified type.
+///
+/// The 65816 modes are an absolute address (`abs`, `long`), an absolute
+/// address plus an index register (`abs,X`, `abs,Y`) and a pointer plus an
+/// index register (`(dp),Y`). There is no scaled index.
 bool SNESTargetLowering::isLegalAddressingMode(const DataLayout &DL,
                                               const AddrMode &AM, Type *Ty,
                                               unsigned AS) const {
   int64_t Offs = AM.BaseOffs;
 
-  // Allow absolute addresses.
-  if (AM.BaseGV && !AM.HasBaseReg && AM.Scale == 0 && Offs == 0) {
-    return true;
+  if (AM.Scale != 0 && AM.Scale != 1) {
+    return false;
   }
 
   // Flash memory instructions only allow zero offsets.
   if (isa<PointerType>(Ty) && AS == SNES::ProgramMemory) {
-    return false;
-  }
-
-  // Allow reg+<6bit> offset.
-  if (Offs < 0)
-    Offs = -Offs;
-  if (AM.BaseGV == 0 && AM.HasBaseReg && AM.Scale == 0 && isUInt<6>(Offs)) {
-    return true;
-  }
-
-  return false;
-}
-
-/// Returns true by value, base pointer and
-/// offset pointer and addressing mode by reference if the node's address
-/// can be legally represented as pre-indexed load / store address.
-bool SNESTargetLowering::getPreIndexedAddressParts(SDNode *N, SDValue &Base,
-                                                  SDValue &Offset,
-                                                  ISD::MemIndexedMode &AM,
-                                                  SelectionDAG &DAG) const {
-  EVT VT;
-  const SDNode *Op;
-  SDLoc DL(N);
-
-  if (const LoadSDNode *LD = dyn_cast<LoadSDNode>(N)) {
-    VT = LD->getMemoryVT();
-    Op = LD->getBasePtr().getNode();
-    if (LD->getExtensionType() != ISD::NON_EXTLOAD)
-      return false;
-    if (SNES::isProgramMemoryAccess(LD)) {
-      return false;
-    }
-  } else if (const StoreSDNode *ST = dyn_cast<StoreSDNode>(N)) {
-    VT = ST->getMemoryVT();
-    Op = ST->getBasePtr().getNode();
-    if (SNES::isProgramMemoryAccess(ST)) {
-      return false;
-    }
-  } else {
-    return false;
+    return AM.BaseGV == nullptr && Offs == 0 && AM.Scale == 0;
   }
 
-  if (VT != MVT::i8 && VT != MVT::i16) {
+  // The index register counts as the base register when there is no scaled
+  // one.
+  unsigned NumRegs = AM.HasBaseReg + AM.Scale;
+  if (NumRegs > (AM.BaseGV ? 1U : 2U)) {
     return false;
   }
 
-  if (Op->getOpcode() != ISD::ADD && Op->getOpcode() != ISD::SUB) {
-    return false;
+  // abs, abs,X and abs,Y, the offset is folded into the symbol.
+  if (AM.BaseGV) {
+    return isInt<16>(Offs);
   }
 
-  if (const ConstantSDNode *RHS = dyn_cast<ConstantSDNode>(Op->getOperand(1))) {
-    int RHSC = RHS->getSExtValue();
-    if (Op->getOpcode() == ISD::SUB)
-      RHSC = -RHSC;
-
-    if ((VT == MVT::i16 && RHSC != -2) || (VT == MVT::i8 && RHSC != -1)) {
-      return false;
-    }
-
-    Base = Op->getOperand(0);
-    Offset = DAG.getConstant(RHSC, DL, MVT::i8);
-    AM = ISD::PRE_DEC;
-
-    return true;
+  // (dp),Y, a constant offset takes the place of the index.
+  if (NumRegs == 2) {
+    return Offs == 0;
   }
 
-  return false;
-}
-
-/// Returns true by value, base pointer and
-/// offset pointer and addressing mode by reference if this node can be
-/// combined with a load / store to form a post-indexed load / store.
-bool SNESTargetLowering::getPostIndexedAddressParts(SDNode *N, SDNode *Op,
-                                                   SDValue &Base,
-                                                   SDValue &Offset,
-                                                   ISD::MemIndexedMode &AM,
-                                                   SelectionDAG &DAG) const {
-  EVT VT;
-  SDLoc DL(N);
-
-  if (const LoadSDNode *LD = dyn_cast<LoadSDNode>(N)) {
-    VT = LD->getMemoryVT();
-    if (LD->getExtensionType() != ISD::NON_EXTLOAD)
-      return false;
-  } else if (const StoreSDNode *ST = dyn_cast<StoreSDNode>(N)) {
-    VT = ST->getMemoryVT();
-    if (SNES::isProgramMemoryAccess(ST)) {
-      return false;
-    }
-  } else {
-    return false;
-  }
-
-  if (VT != MVT::i8 && VT != MVT::i16) {
-    return false;
-  }
-
-  if (Op->getOpcode() != ISD::ADD && Op->getOpcode() != ISD::SUB) {
-    return false;
-  }
-
-  if (const ConstantSDNode *RHS = dyn_cast<ConstantSDNode>(Op->getOperand(1))) {
-    int RHSC = RHS->getSExtValue();
-    if (Op->getOpcode() == ISD::SUB)
-      RHSC = -RHSC;
-    if ((VT == MVT::i16 && RHSC != 2) || (VT == MVT::i8 && RHSC != 1)) {
-      return false;
-    }
-
-    Base = Op->getOperand(0);
-    Offset = DAG.getConstant(RHSC, DL, MVT::i8);
-    AM = ISD::POST_INC;
-
-    return true;
-  }
-
-  return false;
+  return isUInt<16>(Offs);
 }
 
 bool SNESTargetLowering::isOffsetFoldingLegal(
@@ -867,6 +1240,11 @@ bool SNESTargetLowering::isOffsetFoldingLegal(
 
 #include "SNESGenCallingConv.inc"
 
+CCAssignFn *SNESTargetLowering::CCAssignFnForCall(CallingConv::ID CC,
+                                                   bool IsVarArg) const {
+  return IsVarArg ? ArgCC_SNES_Vararg : ArgCC_SNES;
+}
+
 /// For each argument in a function store the number of pieces it is composed
 /// of.
 static void parseFunctionArgs(const Function *F, const DataLayout *TD,
@@ -1053,6 +1431,12 @@ SDValue SNESTargetLowering::LowerFormalArguments(
   analyzeArguments(nullptr, MF.getFunction(), &DL, 0, &Ins, CallConv, ArgLocs, CCInfo,
                    false, isVarArg);
 
+  // Calls with stack arguments come through the far entry, when there is
+  // one, and the return address of its JSL is in between.
+  unsigned ArgOffset = SNESTargetObjectFile::needsFarEntry(*MF.getFunction())
+                           ? SNESTargetObjectFile::FarReturnSize
+                           : 0;
+
   SDValue ArgValue;
   for (CCValAssign &VA : ArgLocs) {
 
@@ -1061,7 +1445,7 @@ SDValue SNESTargetLowering::LowerFormalArguments(
       EVT RegVT = VA.getLocVT();
       const TargetRegisterClass *RC;
       if (RegVT == MVT::i8) {
-        RC = &SNES::MainRegsRegClass;
+        RC = &SNES::MainLoRegsRegClass;
       } else if (RegVT == MVT::i16) {
         RC = &SNES::MainRegsRegClass;
       } else {
@@ -1106,7 +1490,7 @@ SDValue SNESTargetLowering::LowerFormalArguments(
 
       // Create the frame index object for this incoming parameter.
       int FI = MFI.CreateFixedObject(LocVT.getSizeInBits() / 8,
-                                     VA.getLocMemOffset(), true);
+                                     ArgOffset + VA.getLocMemOffset(), true);
 
       // Create the SelectionDAG nodes corresponding to a load
       // from this parameter.
@@ -1117,13 +1501,17 @@ SDValue SNESTargetLowering::LowerFormalArguments(
     }
   }
 
+  MF.getInfo<SNESMachineFunctionInfo>()->setArgumentStackSize(
+      CCInfo.getNextStackOffset());
+
   // If the function takes variable number of arguments, make a frame index for
   // the start of the first vararg value... for expansion of llvm.va_start.
   if (isVarArg) {
     unsigned StackSize = CCInfo.getNextStackOffset();
     SNESMachineFunctionInfo *AFI = MF.getInfo<SNESMachineFunctionInfo>();
 
-    AFI->setVarArgsFrameIndex(MFI.CreateFixedObject(2, StackSize, true));
+    AFI->setVarArgsFrameIndex(
+        MFI.CreateFixedObject(2, ArgOffset + StackSize, true));
   }
 
   return Chain;
@@ -1133,6 +1521,58 @@ SDValue SNESTargetLowering::LowerFormalArguments(
 //                  Call Calling Convention Implementation
 //===----------------------------------------------------------------------===//
 
+/// Checks whether a call can jump to its callee instead.
+///
+/// The callee then returns straight to our caller with its RTS, which only
+/// works from the same bank: a JMP is never relaxed into a far call, so the
+/// callee must also be defined in this module.
+bool SNESTargetLowering::isEligibleForTailCallOptimization(
+    TargetLowering::CallLoweringInfo &CLI, bool IsFarCall,
+    unsigned NumBytes) const {
+  MachineFunction &MF = CLI.DAG.getMachineFunction();
+  const Function &Caller = *MF.getFunction();
+
+  // Interrupt handlers return with RTI, and the return values must be in the
+  // same registers.
+  if (SNES::isInterruptHandler(Caller) ||
+      Caller.getCallingConv() != CLI.CallConv)
+    return false;
+
+  if (CLI.IsVarArg || Caller.isVarArg() || Caller.hasStructRetAttr())
+    return false;
+
+  const auto *G = dyn_cast<GlobalAddressSDNode>(CLI.Callee);
+  if (!G || IsFarCall)
+    return false;
+
+  const auto *Callee = dyn_cast<Function>(G->getGlobal());
+  if (!Callee || Callee->isDeclaration() || Callee->isInterposable())
+    return false;
+
+  // DB is switched back after a call to a function with another bank.
+  int Bank = SNES::getDataBank(*Callee);
+  if (Bank != -1 && Bank != SNES::getEntryDataBank(Caller))
+    return false;
+
+  // Byval copies live in our frame, which is gone by the time of the JMP.
+  for (const ISD::OutputArg &Out : CLI.Outs)
+    if (Out.Flags.isByVal())
+      return false;
+
+  // Our own stack arguments are further up when we have a far entry, the
+  // callee would not find its own there.
+  if (NumBytes && SNESTargetObjectFile::needsFarEntry(Caller))
+    return false;
+
+  // Stack arguments overwrite our own incoming ones, there must be room.
+  const SNESMachineFunctionInfo *AFI = MF.getInfo<SNESMachineFunctionInfo>();
+  return NumBytes <= AFI->getArgumentStackSize();
+}
+
+bool SNESTargetLowering::mayBeEmittedAsTailCall(const CallInst *CI) const {
+  return CI->isTailCall();
+}
+
 SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
                                      SmallVectorImpl<SDValue> &InVals) const {
   SelectionDAG &DAG = CLI.DAG;
@@ -1147,9 +1587,8 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
   bool isVarArg = CLI.IsVarArg;
 
   MachineFunction &MF = DAG.getMachineFunction();
-
-  // SNES does not yet support tail call optimization.
-  isTailCall = false;
+  MachineFrameInfo &MFI = MF.getFrameInfo();
+  bool IsMustTail = CLI.CS && CLI.CS->isMustTailCall();
 
   // Analyze operands of the call, assigning locations to each operand.
   SmallVector<CCValAssign, 16> ArgLocs;
@@ -1160,17 +1599,8 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
   // direct call is) turn it into a TargetGlobalAddress/TargetExternalSymbol
   // node so that legalize doesn't hack it.
   const Function *F = nullptr;
-  if (const GlobalAddressSDNode *G = dyn_cast<GlobalAddressSDNode>(Callee)) {
-    const GlobalValue *GV = G->getGlobal();
-
-    F = cast<Function>(GV);
-    Callee =
-        DAG.getTargetGlobalAddress(GV, DL, getPointerTy(DAG.getDataLayout()));
-  } else if (const ExternalSymbolSDNode *ES =
-                 dyn_cast<ExternalSymbolSDNode>(Callee)) {
-    Callee = DAG.getTargetExternalSymbol(ES->getSymbol(),
-                                         getPointerTy(DAG.getDataLayout()));
-  }
+  if (const GlobalAddressSDNode *G = dyn_cast<GlobalAddressSDNode>(Callee))
+    F = cast<Function>(G->getGlobal());
 
   analyzeArguments(&CLI, F, &DAG.getDataLayout(), &Outs, 0, CallConv, ArgLocs, CCInfo,
                    true, isVarArg);
@@ -1178,7 +1608,48 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
   // Get a count of how many bytes are to be pushed on the stack.
   unsigned NumBytes = CCInfo.getNextStackOffset();
 
-  Chain = DAG.getCALLSEQ_START(Chain, NumBytes, 0, DL);
+  // The stack arguments decide whether a callee with a far entry is called
+  // through it. Runtime routines are defined outside of the module, so they
+  // always have one.
+  bool IsFarCall = false;
+  if (const GlobalAddressSDNode *G = dyn_cast<GlobalAddressSDNode>(Callee)) {
+    const GlobalValue *GV = G->getGlobal();
+
+    IsFarCall =
+        SNESTargetObjectFile::isFarCall(*MF.getFunction(), GV, NumBytes != 0);
+    Callee = DAG.getTargetGlobalAddress(
+        GV, DL, getPointerTy(DAG.getDataLayout()), 0,
+        IsFarCall ? SNESII::MO_FAR : SNESII::MO_NO_FLAG);
+  } else if (const ExternalSymbolSDNode *ES =
+                 dyn_cast<ExternalSymbolSDNode>(Callee)) {
+    IsFarCall = NumBytes != 0;
+    Callee = DAG.getTargetExternalSymbol(
+        ES->getSymbol(), getPointerTy(DAG.getDataLayout()),
+        IsFarCall ? SNESII::MO_FAR : SNESII::MO_NO_FLAG);
+  }
+
+  // A callee with the "snes-data-bank" attribute is called with DB holding
+  // its bank. DB is restored from the stack, or set again when we know what
+  // it held, which stack arguments need since they must be on top.
+  int CallerBank = SNES::getEntryDataBank(*MF.getFunction());
+  int CalleeBank = F ? SNES::getDataBank(*F) : -1;
+  bool SwitchBank = CalleeBank != -1 && CalleeBank != CallerBank;
+  if (SwitchBank && CallerBank == -1 && NumBytes != 0)
+    report_fatal_error("SNES: cannot switch DB for the call to '" +
+                       F->getName() + "' with stack arguments, the bank of '" +
+                       MF.getFunction()->getName() + "' is not known");
+
+  if (isTailCall)
+    isTailCall = isEligibleForTailCallOptimization(CLI, IsFarCall, NumBytes);
+
+  if (IsMustTail && !isTailCall)
+    report_fatal_error("failed to perform tail call elimination on a call "
+                       "site marked musttail");
+
+  if (isTailCall)
+    MFI.setHasTailCall();
+  else
+    Chain = DAG.getCALLSEQ_START(Chain, NumBytes, 0, DL);
 
   SmallVector<std::pair<unsigned, SDValue>, 8> RegsToPass;
 
@@ -1227,6 +1698,10 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
   // and that the push instruction sequence generated is correct, otherwise they
   // can be freely intermixed.
   if (HasStackArgs) {
+    // A tail call stores over the incoming arguments, after they were read.
+    if (isTailCall)
+      Chain = DAG.getStackArgumentTokenFactor(Chain);
+
     for (AE = AI, AI = ArgLocs.size(); AI != AE; --AI) {
       unsigned Loc = AI - 1;
       CCValAssign &VA = ArgLocs[Loc];
@@ -1234,6 +1709,17 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
 
       assert(VA.isMemLoc());
 
+      // The callee finds them where we found ours.
+      if (isTailCall) {
+        int FI = MFI.CreateFixedObject(VA.getLocVT().getSizeInBits() / 8,
+                                       VA.getLocMemOffset(), true);
+        Chain = DAG.getStore(Chain, DL, Arg,
+                             DAG.getFrameIndex(FI, getPointerTy(
+                                                       DAG.getDataLayout())),
+                             MachinePointerInfo::getFixedStack(MF, FI), 0);
+        continue;
+      }
+
       // SP points to one stack slot further so add one to adjust it.
       SDValue PtrOff = DAG.getNode(
           ISD::ADD, DL, getPointerTy(DAG.getDataLayout()),
@@ -1258,6 +1744,25 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
 
   // Returns a chain & a flag for retval copy to use.
   SDVTList NodeTys = DAG.getVTList(MVT::Other, MVT::Glue);
+
+  // The switch is glued to the call, nothing may use the stack in between.
+  if (SwitchBank) {
+    if (CallerBank == -1) {
+      SmallVector<SDValue, 2> SaveOps(1, Chain);
+      if (InFlag.getNode())
+        SaveOps.push_back(InFlag);
+      Chain = DAG.getNode(SNESISD::SAVE_BANK, DL, NodeTys, SaveOps);
+      InFlag = Chain.getValue(1);
+    }
+
+    SmallVector<SDValue, 3> SetOps;
+    SetOps.push_back(Chain);
+    SetOps.push_back(DAG.getTargetConstant(CalleeBank, DL, MVT::i16));
+    if (InFlag.getNode())
+      SetOps.push_back(InFlag);
+    Chain = DAG.getNode(SNESISD::SET_BANK, DL, NodeTys, SetOps);
+    InFlag = Chain.getValue(1);
+  }
   SmallVector<SDValue, 8> Ops;
   Ops.push_back(Chain);
   Ops.push_back(Callee);
@@ -1280,9 +1785,24 @@ SDValue SNESTargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
     Ops.push_back(InFlag);
   }
 
-  Chain = DAG.getNode(SNESISD::CALL, DL, NodeTys, Ops);
+  // The JMP ends the block, nothing comes back.
+  if (isTailCall)
+    return DAG.getNode(SNESISD::TAIL_CALL, DL, MVT::Other, Ops);
+
+  Chain = DAG.getNode(IsFarCall ? SNESISD::FAR_CALL : SNESISD::CALL, DL,
+                      NodeTys, Ops);
   InFlag = Chain.getValue(1);
 
+  if (SwitchBank) {
+    if (CallerBank == -1)
+      Chain = DAG.getNode(SNESISD::RESTORE_BANK, DL, NodeTys, Chain, InFlag);
+    else
+      Chain = DAG.getNode(SNESISD::SET_BANK, DL, NodeTys, Chain,
+                          DAG.getTargetConstant(CallerBank, DL, MVT::i16),
+                          InFlag);
+    InFlag = Chain.getValue(1);
+  }
+
   // Create the CALLSEQ_END node.
   Chain = DAG.getCALLSEQ_END(Chain, DAG.getIntPtrConstant(NumBytes, DL, true),
                              DAG.getIntPtrConstant(0, DL, true), InFlag, DL);
@@ -1449,28 +1969,28 @@ MachineBasicBlock *SNESTargetLowering::insertShift(MachineInstr &MI,
   default:
     llvm_unreachable("Invalid shift opcode!");
   case SNES::Lsl8:
-    Opc = SNES::LSLRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::ASLA8;
+    RC = &SNES::Acc8RegsRegClass;
     break;
   case SNES::Lsl16:
-    Opc = SNES::LSLWRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::ASLA16;
+    RC = &SNES::AccRegsRegClass;
     break;
   case SNES::Asr8:
-    Opc = SNES::ASRRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::ASRA8;
+    RC = &SNES::Acc8RegsRegClass;
     break;
   case SNES::Asr16:
-    Opc = SNES::ASRWRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::ASRA16;
+    RC = &SNES::AccRegsRegClass;
     break;
   case SNES::Lsr8:
-    Opc = SNES::LSRRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::LSRA8;
+    RC = &SNES::Acc8RegsRegClass;
     break;
   case SNES::Lsr16:
-    Opc = SNES::LSRWRd;
-    RC = &SNES::MainRegsRegClass;
+    Opc = SNES::LSRA16;
+    RC = &SNES::AccRegsRegClass;
     break;
   case SNES::Rol8:
     Opc = SNES::ROLRd;
@@ -1513,8 +2033,9 @@ MachineBasicBlock *SNESTargetLowering::insertShift(MachineInstr &MI,
   LoopBB->addSuccessor(RemBB);
   LoopBB->addSuccessor(LoopBB);
 
-  unsigned ShiftAmtReg = RI.createVirtualRegister(&SNES::MainLoRegsRegClass);
-  unsigned ShiftAmtReg2 = RI.createVirtualRegister(&SNES::MainLoRegsRegClass);
+  // The count goes down in X, `DEX; BNE loop`.
+  unsigned ShiftAmtReg = RI.createVirtualRegister(&SNES::IndexXRegsRegClass);
+  unsigned ShiftAmtReg2 = RI.createVirtualRegister(&SNES::IndexXRegsRegClass);
   unsigned ShiftReg = RI.createVirtualRegister(RC);
   unsigned ShiftReg2 = RI.createVirtualRegister(RC);
   unsigned ShiftAmtSrcReg = MI.getOperand(2).getReg();
@@ -1522,31 +2043,34 @@ MachineBasicBlock *SNESTargetLowering::insertShift(MachineInstr &MI,
   unsigned DstReg = MI.getOperand(0).getReg();
 
   // BB:
-  // cpi N, 0
-  // breq RemBB
-  BuildMI(BB, dl, TII.get(SNES::CPIRdK)).addReg(ShiftAmtSrcReg).addImm(0);
-  BuildMI(BB, dl, TII.get(SNES::BREQk)).addMBB(RemBB);
+  // ShiftAmt0 = copy N
+  // cpx #0
+  // beq RemBB
+  unsigned ShiftAmtReg0 = RI.createVirtualRegister(&SNES::IndexXRegsRegClass);
+  BuildMI(BB, dl, TII.get(SNES::COPY), ShiftAmtReg0).addReg(ShiftAmtSrcReg);
+  BuildMI(BB, dl, TII.get(SNES::BREQXk)).addReg(ShiftAmtReg0).addMBB(RemBB);
 
   // LoopBB:
   // ShiftReg = phi [%SrcReg, BB], [%ShiftReg2, LoopBB]
-  // ShiftAmt = phi [%N, BB],      [%ShiftAmt2, LoopBB]
+  // ShiftAmt = phi [%ShiftAmt0, BB], [%ShiftAmt2, LoopBB]
   // ShiftReg2 = shift ShiftReg
-  // ShiftAmt2 = ShiftAmt - 1;
+  // ShiftAmt2 = ShiftAmt - 1
   BuildMI(LoopBB, dl, TII.get(SNES::PHI), ShiftReg)
       .addReg(SrcReg)
       .addMBB(BB)
       .addReg(ShiftReg2)
       .addMBB(LoopBB);
   BuildMI(LoopBB, dl, TII.get(SNES::PHI), ShiftAmtReg)
-      .addReg(ShiftAmtSrcReg)
+      .addReg(ShiftAmtReg0)
       .addMBB(BB)
       .addReg(ShiftAmtReg2)
       .addMBB(LoopBB);
   BuildMI(LoopBB, dl, TII.get(Opc), ShiftReg2).addReg(ShiftReg);
-  BuildMI(LoopBB, dl, TII.get(SNES::SUBIRdK), ShiftAmtReg2)
-      .addReg(ShiftAmtReg)
-      .addImm(1);
-  BuildMI(LoopBB, dl, TII.get(SNES::BRNEk)).addMBB(LoopBB);
+  BuildMI(LoopBB, dl, TII.get(SNES::DEXr), ShiftAmtReg2)
+      .addReg(ShiftAmtReg);
+  BuildMI(LoopBB, dl, TII.get(SNES::BRNEXk))
+      .addReg(ShiftAmtReg2)
+      .addMBB(LoopBB);
 
   // RemBB:
   // DestReg = phi [%SrcReg, BB], [%ShiftReg, LoopBB]
@@ -1588,6 +2112,346 @@ MachineBasicBlock *SNESTargetLowering::insertMul(MachineInstr &MI,
   return BB;
 }
 
+MachineBasicBlock *SNESTargetLowering::insertHwMul(MachineInstr &MI,
+                                                  MachineBasicBlock *BB) const {
+  const SNESTargetMachine &TM = (const SNESTargetMachine &)getTargetMachine();
+  const TargetInstrInfo &TII = *TM.getSubtargetImpl()->getInstrInfo();
+  MachineRegisterInfo &MRI = BB->getParent()->getRegInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  // The operands are stored through the accumulator, the write to WRMPYB
+  // starts the multiplication. The stores must be of one byte each, a word
+  // store to WRMPYA would start it with the high byte of A. They are of AL,
+  // so SNESAccumulatorWidth sets M around them.
+  unsigned Lhs = MRI.createVirtualRegister(&SNES::Acc8RegsRegClass);
+  unsigned Rhs = MRI.createVirtualRegister(&SNES::Acc8RegsRegClass);
+
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), Lhs)
+      .addReg(MI.getOperand(1).getReg());
+  BuildMI(*BB, MI, dl, TII.get(SNES::STAabs8))
+      .addImm(SNES::WRMPYA)
+      .addReg(Lhs, RegState::Kill);
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), Rhs)
+      .addReg(MI.getOperand(2).getReg());
+  BuildMI(*BB, MI, dl, TII.get(SNES::STAabs8))
+      .addImm(SNES::WRMPYB)
+      .addReg(Rhs, RegState::Kill);
+
+  // The product is ready 8 cycles after the write. Three NOPs plus the
+  // three cycles LDA takes to fetch its operand cover it.
+  for (unsigned I = 0; I != 3; ++I)
+    BuildMI(*BB, MI, dl, TII.get(SNES::NOP));
+
+  BuildMI(*BB, MI, dl, TII.get(SNES::LDAabs16), MI.getOperand(0).getReg())
+      .addImm(SNES::RDMPYL);
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+MachineBasicBlock *SNESTargetLowering::insertSA1Mul(MachineInstr &MI,
+                                                   MachineBasicBlock *BB) const {
+  const SNESTargetMachine &TM = (const SNESTargetMachine &)getTargetMachine();
+  const TargetInstrInfo &TII = *TM.getSubtargetImpl()->getInstrInfo();
+  MachineRegisterInfo &MRI = BB->getParent()->getRegInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  // Select the multiply, another function may have left the unit dividing.
+  // The word store clears the low byte of MA as well, which is written next.
+  unsigned Zero = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+  unsigned Lhs = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+  unsigned Rhs = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+
+  BuildMI(*BB, MI, dl, TII.get(SNES::LDAimm16), Zero).addImm(0);
+  BuildMI(*BB, MI, dl, TII.get(SNES::STAabs16))
+      .addImm(SNES::SA1MCNT)
+      .addReg(Zero, RegState::Kill);
+
+  // The write to the high byte of MB starts the multiplication.
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), Lhs)
+      .addReg(MI.getOperand(1).getReg());
+  BuildMI(*BB, MI, dl, TII.get(SNES::STAabs16))
+      .addImm(SNES::SA1MAL)
+      .addReg(Lhs, RegState::Kill);
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), Rhs)
+      .addReg(MI.getOperand(2).getReg());
+  BuildMI(*BB, MI, dl, TII.get(SNES::STAabs16))
+      .addImm(SNES::SA1MBL)
+      .addReg(Rhs, RegState::Kill);
+
+  // The product is ready 5 cycles after the write, one NOP plus the three
+  // cycles LDA takes to fetch its operand.
+  BuildMI(*BB, MI, dl, TII.get(SNES::NOP));
+
+  BuildMI(*BB, MI, dl, TII.get(SNES::LDAabs16), MI.getOperand(0).getReg())
+      .addImm(SNES::SA1MR);
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertIndirectY(MachineInstr &MI,
+                                    MachineBasicBlock *BB) const {
+  const SNESTargetMachine &TM = (const SNESTargetMachine &)getTargetMachine();
+  const TargetInstrInfo &TII = *TM.getSubtargetImpl()->getInstrInfo();
+  DebugLoc dl = MI.getDebugLoc();
+  unsigned Opc = MI.getOpcode();
+  bool IsStore = Opc == SNES::STIndirectY8 || Opc == SNES::STIndirectY16;
+  bool Is8Bit = Opc == SNES::LDIndirectY8 || Opc == SNES::STIndirectY8;
+  unsigned PtrOp = IsStore ? 0 : 1;
+  unsigned Acc = Is8Bit ? SNES::AL : SNES::A;
+
+  // The pointer is pushed and the access goes through (1,S),Y, which needs
+  // no scratch memory an interrupt could overwrite. PLX pulls the pointer
+  // back into X. Only physical registers are used between the push and the
+  // pull, so no spill code can move S in between.
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), SNES::X)
+      .addReg(MI.getOperand(PtrOp).getReg());
+  BuildMI(*BB, MI, dl, TII.get(SNES::COPY), SNES::Y)
+      .addReg(MI.getOperand(PtrOp + 1).getReg());
+  if (IsStore)
+    BuildMI(*BB, MI, dl, TII.get(SNES::COPY), Acc)
+        .addReg(MI.getOperand(2).getReg());
+
+  BuildMI(*BB, MI, dl, TII.get(SNES::PHX)).addReg(SNES::X, RegState::Kill);
+  if (IsStore) {
+    BuildMI(*BB, MI, dl, TII.get(Is8Bit ? SNES::STAsry8 : SNES::STAsry16))
+        .addReg(SNES::SP)
+        .addImm(1)
+        .addReg(SNES::Y, RegState::Kill)
+        .addReg(Acc, RegState::Kill)
+        .setMemRefs(MI.memoperands_begin(), MI.memoperands_end());
+  } else {
+    BuildMI(*BB, MI, dl, TII.get(Is8Bit ? SNES::LDAsry8 : SNES::LDAsry16), Acc)
+        .addReg(SNES::SP)
+        .addImm(1)
+        .addReg(SNES::Y, RegState::Kill)
+        .setMemRefs(MI.memoperands_begin(), MI.memoperands_end());
+  }
+  BuildMI(*BB, MI, dl, TII.get(SNES::PLX))
+      .addReg(SNES::X, RegState::Define | RegState::Dead);
+
+  if (!IsStore)
+    BuildMI(*BB, MI, dl, TII.get(SNES::COPY), MI.getOperand(0).getReg())
+        .addReg(Acc, RegState::Kill);
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+/// Splits \p BB after \p MI, the instructions after it and the successors
+/// of \p BB move to the returned block.
+static MachineBasicBlock *splitBlockAfter(MachineInstr &MI,
+                                          MachineBasicBlock *BB) {
+  MachineFunction *MF = BB->getParent();
+  MachineBasicBlock *TailMBB = MF->CreateMachineBasicBlock(BB->getBasicBlock());
+  MF->insert(std::next(MachineFunction::iterator(BB)), TailMBB);
+
+  TailMBB->splice(TailMBB->begin(), BB,
+                  std::next(MachineBasicBlock::iterator(MI)), BB->end());
+  TailMBB->transferSuccessorsAndUpdatePHIs(BB);
+  return TailMBB;
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertSelect(MachineInstr &MI,
+                                 MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  const SNESInstrInfo &STII = static_cast<const SNESInstrInfo &>(TII);
+  DebugLoc dl = MI.getDebugLoc();
+
+  // A triangle rather than a diamond: the true value is ready when the
+  // branch is taken, and the false value is copied on the way through, so
+  // no path takes more than one branch.
+  //
+  //   BB:      Bcc  TailMBB
+  //   FalseMBB:               (copy of the false value)
+  //   TailMBB: PHI
+  MachineFunction *MF = BB->getParent();
+  MachineBasicBlock *TailMBB = splitBlockAfter(MI, BB);
+  MachineBasicBlock *FalseMBB =
+      MF->CreateMachineBasicBlock(BB->getBasicBlock());
+  MF->insert(MachineFunction::iterator(TailMBB), FalseMBB);
+
+  SNESCC::CondCodes CC = (SNESCC::CondCodes)MI.getOperand(3).getImm();
+  BuildMI(BB, dl, STII.getBrCond(CC)).addMBB(TailMBB);
+  BB->addSuccessor(FalseMBB);
+  BB->addSuccessor(TailMBB);
+  FalseMBB->addSuccessor(TailMBB);
+
+  BuildMI(*TailMBB, TailMBB->begin(), dl, TII.get(SNES::PHI),
+          MI.getOperand(0).getReg())
+      .addReg(MI.getOperand(1).getReg())
+      .addMBB(BB)
+      .addReg(MI.getOperand(2).getReg())
+      .addMBB(FalseMBB);
+
+  MI.eraseFromParent();
+  return TailMBB;
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertCarry(MachineInstr &MI,
+                                MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  MachineRegisterInfo &MRI = BB->getParent()->getRegInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  // LDA #0 leaves the carry as it is.
+  unsigned Zero = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+  BuildMI(*BB, MI, dl, TII.get(SNES::LDAimm16), Zero).addImm(0);
+
+  if (MI.getOpcode() == SNES::CarryBit16) {
+    BuildMI(*BB, MI, dl, TII.get(SNES::ROLA), MI.getOperand(0).getReg())
+        .addReg(Zero, RegState::Kill);
+  } else {
+    BuildMI(*BB, MI, dl, TII.get(SNES::SBCimm16), MI.getOperand(0).getReg())
+        .addReg(Zero, RegState::Kill)
+        .addImm(0);
+  }
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+/// Gets the ADC or SBC of an add or subtract pseudo.
+static unsigned getCarryOpcode(unsigned Opcode, bool &IsSub) {
+  IsSub = false;
+  switch (Opcode) {
+  default:
+    llvm_unreachable("Unexpected add pseudo");
+  case SNES::ADDimm8:
+    return SNES::ADCimm8;
+  case SNES::ADDimm16:
+    return SNES::ADCimm16;
+  case SNES::ADDdp8:
+    return SNES::ADCdp8;
+  case SNES::ADDabs8:
+    return SNES::ADCabs8;
+  case SNES::ADDdpx8:
+    return SNES::ADCdpx8;
+  case SNES::ADDabsx8:
+    return SNES::ADCabsx8;
+  case SNES::ADDdp16:
+    return SNES::ADCdp16;
+  case SNES::ADDabs16:
+    return SNES::ADCabs16;
+  case SNES::ADDdpx16:
+    return SNES::ADCdpx16;
+  case SNES::ADDabsx16:
+    return SNES::ADCabsx16;
+  case SNES::SUBimm8:
+    IsSub = true;
+    return SNES::SBCimm8;
+  case SNES::SUBimm16:
+    IsSub = true;
+    return SNES::SBCimm16;
+  case SNES::SUBdp8:
+    IsSub = true;
+    return SNES::SBCdp8;
+  case SNES::SUBabs8:
+    IsSub = true;
+    return SNES::SBCabs8;
+  case SNES::SUBdpx8:
+    IsSub = true;
+    return SNES::SBCdpx8;
+  case SNES::SUBabsx8:
+    IsSub = true;
+    return SNES::SBCabsx8;
+  case SNES::SUBdp16:
+    IsSub = true;
+    return SNES::SBCdp16;
+  case SNES::SUBabs16:
+    IsSub = true;
+    return SNES::SBCabs16;
+  case SNES::SUBdpx16:
+    IsSub = true;
+    return SNES::SBCdpx16;
+  case SNES::SUBabsx16:
+    IsSub = true;
+    return SNES::SBCabsx16;
+  }
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertAddImm(MachineInstr &MI,
+                                 MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  bool IsSub;
+  unsigned Opc = getCarryOpcode(MI.getOpcode(), IsSub);
+
+  // ADC adds the carry in and SBC subtracts the borrow.
+  BuildMI(*BB, MI, dl, TII.get(IsSub ? SNES::SEC : SNES::CLC));
+  MachineInstrBuilder MIB =
+      BuildMI(*BB, MI, dl, TII.get(Opc), MI.getOperand(0).getReg());
+  for (unsigned I = 1, E = MI.getNumExplicitOperands(); I != E; ++I)
+    MIB.add(MI.getOperand(I));
+  MIB.setMemRefs(MI.memoperands_begin(), MI.memoperands_end());
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertAbs(MachineInstr &MI, MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  MachineRegisterInfo &MRI = BB->getParent()->getRegInfo();
+  DebugLoc dl = MI.getDebugLoc();
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(1).getReg();
+
+  //   BB:      CMP #0; BPL TailMBB
+  //   NegMBB:  EOR #$FFFF; INC A
+  //   TailMBB: PHI
+  MachineFunction *MF = BB->getParent();
+  MachineBasicBlock *TailMBB = splitBlockAfter(MI, BB);
+  MachineBasicBlock *NegMBB = MF->CreateMachineBasicBlock(BB->getBasicBlock());
+  MF->insert(MachineFunction::iterator(TailMBB), NegMBB);
+
+  BuildMI(BB, dl, TII.get(SNES::CMPimm16)).addReg(SrcReg).addImm(0);
+  BuildMI(BB, dl, TII.get(SNES::BRPLk)).addMBB(TailMBB);
+  BB->addSuccessor(NegMBB);
+  BB->addSuccessor(TailMBB);
+  NegMBB->addSuccessor(TailMBB);
+
+  unsigned NotReg = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+  unsigned NegReg = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+  BuildMI(NegMBB, dl, TII.get(SNES::EORimm16), NotReg)
+      .addReg(SrcReg)
+      .addImm(0xFFFF);
+  BuildMI(NegMBB, dl, TII.get(SNES::INA), NegReg)
+      .addReg(NotReg, RegState::Kill);
+
+  BuildMI(*TailMBB, TailMBB->begin(), dl, TII.get(SNES::PHI), DstReg)
+      .addReg(SrcReg)
+      .addMBB(BB)
+      .addReg(NegReg)
+      .addMBB(NegMBB);
+
+  MI.eraseFromParent();
+  return TailMBB;
+}
+
+MachineBasicBlock *
+SNESTargetLowering::insertSetBank(MachineInstr &MI,
+                                  MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  DebugLoc dl = MI.getDebugLoc();
+  int64_t Bank = MI.getOperand(0).getImm();
+
+  // There is no instruction which loads DB. The PEA pushes the bank in both
+  // of its bytes and each PLB pulls one.
+  BuildMI(*BB, MI, dl, TII.get(SNES::PEA)).addImm(Bank << 8 | Bank);
+  BuildMI(*BB, MI, dl, TII.get(SNES::PLB));
+  BuildMI(*BB, MI, dl, TII.get(SNES::PLB));
+
+  MI.eraseFromParent();
+  return BB;
+}
+
 MachineBasicBlock *
 SNESTargetLowering::EmitInstrWithCustomInserter(MachineInstr &MI,
                                                MachineBasicBlock *MBB) const {
@@ -1610,60 +2474,49 @@ SNESTargetLowering::EmitInstrWithCustomInserter(MachineInstr &MI,
   case SNES::MULRdRr:
   case SNES::MULSRdRr:
     return insertMul(MI, MBB);
+  case SNES::HWMUL8:
+    return insertHwMul(MI, MBB);
+  case SNES::SA1MUL16:
+    return insertSA1Mul(MI, MBB);
+  case SNES::LDIndirectY8:
+  case SNES::LDIndirectY16:
+  case SNES::STIndirectY8:
+  case SNES::STIndirectY16:
+    return insertIndirectY(MI, MBB);
+  case SNES::Select8:
+  case SNES::Select16:
+    return insertSelect(MI, MBB);
+  case SNES::CarryBit16:
+  case SNES::CarryMask16:
+    return insertCarry(MI, MBB);
+  case SNES::ADDimm8:
+  case SNES::ADDimm16:
+  case SNES::SUBimm8:
+  case SNES::SUBimm16:
+  case SNES::ADDdp8:
+  case SNES::ADDabs8:
+  case SNES::ADDdpx8:
+  case SNES::ADDabsx8:
+  case SNES::ADDdp16:
+  case SNES::ADDabs16:
+  case SNES::ADDdpx16:
+  case SNES::ADDabsx16:
+  case SNES::SUBdp8:
+  case SNES::SUBabs8:
+  case SNES::SUBdpx8:
+  case SNES::SUBabsx8:
+  case SNES::SUBdp16:
+  case SNES::SUBabs16:
+  case SNES::SUBdpx16:
+  case SNES::SUBabsx16:
+    return insertAddImm(MI, MBB);
+  case SNES::Abs16:
+    return insertAbs(MI, MBB);
+  case SNES::SETDB:
+    return insertSetBank(MI, MBB);
+  default:
+    llvm_unreachable("Unexpected instr type to insert");
   }
-
-  assert((Opc == SNES::Select16 || Opc == SNES::Select8) &&
-         "Unexpected instr type to insert");
-
-  const SNESInstrInfo &TII = (const SNESInstrInfo &)*MI.getParent()
-                                ->getParent()
-                                ->getSubtarget()
-                                .getInstrInfo();
-  DebugLoc dl = MI.getDebugLoc();
-
-  // To "insert" a SELECT instruction, we insert the diamond
-  // control-flow pattern. The incoming instruction knows the
-  // destination vreg to set, the condition code register to branch
-  // on, the true/false values to select between, and a branch opcode
-  // to use.
-
-  MachineFunction *MF = MBB->getParent();
-  const BasicBlock *LLVM_BB = MBB->getBasicBlock();
-  MachineBasicBlock *trueMBB = MF->CreateMachineBasicBlock(LLVM_BB);
-  MachineBasicBlock *falseMBB = MF->CreateMachineBasicBlock(LLVM_BB);
-
-  MachineFunction::iterator I;
-  for (I = MF->begin(); I != MF->end() && &(*I) != MBB; ++I);
-  if (I != MF->end()) ++I;
-  MF->insert(I, trueMBB);
-  MF->insert(I, falseMBB);
-
-  // Transfer remaining instructions and all successors of the current
-  // block to the block which will contain the Phi node for the
-  // select.
-  trueMBB->splice(trueMBB->begin(), MBB,
-                  std::next(MachineBasicBlock::iterator(MI)), MBB->end());
-  trueMBB->transferSuccessorsAndUpdatePHIs(MBB);
-
-  SNESCC::CondCodes CC = (SNESCC::CondCodes)MI.getOperand(3).getImm();
-  BuildMI(MBB, dl, TII.getBrCond(CC)).addMBB(trueMBB);
-  BuildMI(MBB, dl, TII.get(SNES::RJMPk)).addMBB(falseMBB);
-  MBB->addSuccessor(falseMBB);
-  MBB->addSuccessor(trueMBB);
-
-  // Unconditionally flow back to the true block
-  BuildMI(falseMBB, dl, TII.get(SNES::RJMPk)).addMBB(trueMBB);
-  falseMBB->addSuccessor(trueMBB);
-
-  // Set up the Phi node to determine where we came from
-  BuildMI(*trueMBB, trueMBB->begin(), dl, TII.get(SNES::PHI), MI.getOperand(0).getReg())
-    .addReg(MI.getOperand(1).getReg())
-    .addMBB(MBB)
-    .addReg(MI.getOperand(2).getReg())
-    .addMBB(falseMBB) ;
-
-  MI.eraseFromParent(); // The pseudo instruction is gone now.
-  return trueMBB;
 }
 
 //===----------------------------------------------------------------------===//
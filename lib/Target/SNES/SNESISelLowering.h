@@ -33,9 +33,31 @@ enum NodeType {
   /// Represents an abstract call instruction,
   /// which includes a bunch of information.
   CALL,
+  /// A call to a callee in another bank, through its far entry.
+  FAR_CALL,
+  /// A tail call, a JMP to a callee in the same bank.
+  TAIL_CALL,
+  /// Push DB, PHB, before switching it for a call.
+  SAVE_BANK,
+  /// Switch DB to the bank of operand 1, `PEA #$nnnn; PLB; PLB`.
+  SET_BANK,
+  /// Pull DB back after a call, PLB.
+  RESTORE_BANK,
   /// A wrapper node for TargetConstantPool,
   /// TargetExternalSymbol, and TargetGlobalAddress.
   WRAPPER,
+  /// An unsigned 8x8 multiply on the hardware multiplier.
+  HWMUL,
+  /// The low word of a 16x16 multiply on the SA-1 arithmetic unit.
+  SA1MUL,
+  /// A jump through a jump table, `JMP (table,X)`. Operand 1 is the table
+  /// and operand 2 the offset of the entry.
+  BR_JT,
+  /// A 4 digit packed BCD add and subtract, ADC and SBC in decimal mode.
+  BCDADD,
+  BCDSUB,
+  /// Decrement of a loop counter, also produces the flags for a BRCOND.
+  DEC,
   LSL,     ///< Logical shift left.
   LSR,     ///< Logical shift right.
   ASR,     ///< Arithmetic shift right.
@@ -59,7 +81,17 @@ enum NodeType {
   TST,
   /// Operand 0 and operand 1 are selection variable, operand 2
   /// is condition code and operand 3 is flag operand.
-  SELECT_CC
+  SELECT_CC,
+  /// The carry left by a compare as 1 or 0. Operand 0 is the flag operand.
+  CARRY_BIT,
+  /// The carry left by a compare as a mask, 0 when it is set and all ones
+  /// when it is clear. Operand 0 is the flag operand.
+  CARRY_MASK,
+  /// Set the bits of memory which are set in a mask, TSB. Operand 1 is the
+  /// address and operand 2 the mask.
+  TSB = ISD::FIRST_TARGET_MEMORY_OPCODE,
+  /// Clear the bits of memory which are set in a mask, TRB.
+  TRB
 };
 
 } // end of namespace SNESISD
@@ -79,25 +111,36 @@ public:
 
   SDValue LowerOperation(SDValue Op, SelectionDAG &DAG) const override;
 
+  SDValue PerformDAGCombine(SDNode *N, DAGCombinerInfo &DCI) const override;
+
   void ReplaceNodeResults(SDNode *N, SmallVectorImpl<SDValue> &Results,
                           SelectionDAG &DAG) const override;
 
   bool isLegalAddressingMode(const DataLayout &DL, const AddrMode &AM, Type *Ty,
                              unsigned AS) const override;
 
-  bool getPreIndexedAddressParts(SDNode *N, SDValue &Base, SDValue &Offset,
-                                 ISD::MemIndexedMode &AM,
-                                 SelectionDAG &DAG) const override;
+  bool isOffsetFoldingLegal(const GlobalAddressSDNode *GA) const override;
 
-  bool getPostIndexedAddressParts(SDNode *N, SDNode *Op, SDValue &Base,
-                                  SDValue &Offset, ISD::MemIndexedMode &AM,
-                                  SelectionDAG &DAG) const override;
+  unsigned getJumpTableEncoding() const override;
 
-  bool isOffsetFoldingLegal(const GlobalAddressSDNode *GA) const override;
+  /// The direct page is the first 256 bytes of bank 0 with D = 0, so a
+  /// direct page pointer is also a valid data pointer.
+  bool isNoopAddrSpaceCast(unsigned SrcAS, unsigned DestAS) const override {
+    return true;
+  }
 
   EVT getSetCCResultType(const DataLayout &DL, LLVMContext &Context,
                          EVT VT) const override;
 
+  /// Soft-float comparisons return an `int`, which is 16 bits wide.
+  MVT::SimpleValueType getCmpLibcallReturnType() const override {
+    return MVT::i16;
+  }
+
+  bool isTypeDesirableForOp(unsigned Opc, EVT VT) const override;
+
+  bool IsDesirableToPromoteOp(SDValue Op, EVT &PVT) const override;
+
   MachineBasicBlock *
   EmitInstrWithCustomInserter(MachineInstr &MI,
                               MachineBasicBlock *MBB) const override;
@@ -121,20 +164,36 @@ public:
   unsigned getRegisterByName(const char* RegName, EVT VT,
                              SelectionDAG &DAG) const override;
 
+  /// The conventions for single register arguments and for return values,
+  /// used by the GlobalISel call lowering.
+  CCAssignFn *CCAssignFnForCall(CallingConv::ID CC, bool IsVarArg) const;
+  CCAssignFn *CCAssignFnForReturn(CallingConv::ID CC) const;
+
 private:
   SDValue getSNESCmp(SDValue LHS, SDValue RHS, ISD::CondCode CC, SDValue &SNEScc,
                     SelectionDAG &DAG, SDLoc dl) const;
   SDValue LowerShifts(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerDivRem(SDValue Op, SelectionDAG &DAG) const;
+  SDValue LowerMUL(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerGlobalAddress(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerBlockAddress(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerBR_CC(SDValue Op, SelectionDAG &DAG) const;
+  SDValue LowerBR_JT(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerINLINEASM(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerSELECT_CC(SDValue Op, SelectionDAG &DAG) const;
   SDValue LowerSETCC(SDValue Op, SelectionDAG &DAG) const;
+  SDValue lowerSelect(SDValue TrueV, SDValue FalseV, SDValue TargetCC,
+                      SDValue Cmp, const SDLoc &DL, SelectionDAG &DAG) const;
   SDValue LowerVASTART(SDValue Op, SelectionDAG &DAG) const;
-
-  CCAssignFn *CCAssignFnForReturn(CallingConv::ID CC) const;
+  SDValue LowerATOMIC_LOAD(SDValue Op, SelectionDAG &DAG) const;
+  SDValue LowerATOMIC_STORE(SDValue Op, SelectionDAG &DAG) const;
+  SDValue LowerATOMIC_LOAD_OP(SDValue Op, SelectionDAG &DAG) const;
+  SDValue getByteMul(SDValue LHS, SDValue RHS, const SDLoc &DL,
+                     SelectionDAG &DAG) const;
+  SDValue lowerFixedMul(SDValue LHS, SDValue RHS, unsigned FracBits,
+                        const SDLoc &DL, SelectionDAG &DAG) const;
+  SDValue combineINTRINSIC_WO_CHAIN(SDNode *N, SelectionDAG &DAG) const;
+  SDValue combineSTORE(SDNode *N, SelectionDAG &DAG) const;
 
   bool CanLowerReturn(CallingConv::ID CallConv,
                       MachineFunction &MF, bool isVarArg,
@@ -152,6 +211,10 @@ private:
                                SmallVectorImpl<SDValue> &InVals) const override;
   SDValue LowerCall(TargetLowering::CallLoweringInfo &CLI,
                     SmallVectorImpl<SDValue> &InVals) const override;
+  bool isEligibleForTailCallOptimization(TargetLowering::CallLoweringInfo &CLI,
+                                         bool IsFarCall,
+                                         unsigned NumBytes) const;
+  bool mayBeEmittedAsTailCall(const CallInst *CI) const override;
   SDValue LowerCallResult(SDValue Chain, SDValue InFlag,
                           CallingConv::ID CallConv, bool isVarArg,
                           const SmallVectorImpl<ISD::InputArg> &Ins,
@@ -161,6 +224,21 @@ private:
 private:
   MachineBasicBlock *insertShift(MachineInstr &MI, MachineBasicBlock *BB) const;
   MachineBasicBlock *insertMul(MachineInstr &MI, MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertHwMul(MachineInstr &MI,
+                                 MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertSA1Mul(MachineInstr &MI,
+                                  MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertIndirectY(MachineInstr &MI,
+                                     MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertSelect(MachineInstr &MI,
+                                  MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertCarry(MachineInstr &MI,
+                                 MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertAddImm(MachineInstr &MI,
+                                  MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertAbs(MachineInstr &MI, MachineBasicBlock *BB) const;
+  MachineBasicBlock *insertSetBank(MachineInstr &MI,
+                                   MachineBasicBlock *BB) const;
 };
 
 } // end namespace llvm
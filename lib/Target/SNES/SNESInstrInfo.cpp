@@ -18,9 +18,12 @@
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/CodeGen/MachineMemOperand.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
 #include "llvm/MC/MCContext.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/TargetRegistry.h"
@@ -29,6 +32,7 @@
 #include "SNESMachineFunctionInfo.h"
 #include "SNESRegisterInfo.h"
 #include "SNESTargetMachine.h"
+#include "SNESTargetObjectFile.h"
 #include "MCTargetDesc/SNESMCTargetDesc.h"
 
 #define GET_INSTRINFO_CTOR_DTOR
@@ -36,6 +40,10 @@
 
 namespace llvm {
 
+static cl::opt<unsigned> OutlinerCyclesPerByte(
+    "snes-outliner-cycles-per-byte", cl::Hidden, cl::init(4),
+    cl::desc("Cycles the machine outliner may add to save a byte of ROM"));
+
 SNESInstrInfo::SNESInstrInfo()
     : SNESGenInstrInfo(SNES::ADJCALLSTACKDOWN, SNES::ADJCALLSTACKUP), RI() {}
 
@@ -47,28 +55,24 @@ void SNESInstrInfo::copyPhysReg(MachineBasicBlock &MBB,
   const SNESRegisterInfo &TRI = *STI.getRegisterInfo();
   unsigned Opc;
 
-  // Not all SNES devices support the 16-bit `MOVW` instruction.
-  if (SNES::MainRegsRegClass.contains(DestReg, SrcReg)) {
-    // TODO: check if we need hasMOVW
-    // if (STI.hasMOVW()) {
-    //   BuildMI(MBB, MI, DL, get(SNES::MOVWRdRr), DestReg)
-    //       .addReg(SrcReg, getKillRegState(KillSrc));
-    // } else {
-      unsigned DestLo, DestHi, SrcLo, SrcHi;
-
-      TRI.splitReg(DestReg, DestLo, DestHi);
-      TRI.splitReg(SrcReg,  SrcLo,  SrcHi);
-
-      // Copy each individual register with the `MOV` instruction.
-      BuildMI(MBB, MI, DL, get(SNES::MOVRdRr), DestLo)
-        .addReg(SrcLo, getKillRegState(KillSrc));
-      BuildMI(MBB, MI, DL, get(SNES::MOVRdRr), DestHi)
-        .addReg(SrcHi, getKillRegState(KillSrc));
-    // }
+  // Copies between A, X and Y are transfers. A byte is copied with the same
+  // transfer whatever M is: the high byte of a register holding a byte is
+  // never live, so it does not matter whether it is copied too.
+  if (SNES::MainRegsRegClass.contains(DestReg, SrcReg) ||
+      SNES::MainLoRegsRegClass.contains(DestReg, SrcReg)) {
+    unsigned Dst = DestReg, Src = SrcReg;
+    if (SNES::MainLoRegsRegClass.contains(DestReg)) {
+      Dst = TRI.getMatchingSuperReg(DestReg, SNES::sub_lo,
+                                    &SNES::MainRegsRegClass);
+      Src = TRI.getMatchingSuperReg(SrcReg, SNES::sub_lo,
+                                    &SNES::MainRegsRegClass);
+    }
+
+    BuildMI(MBB, MI, DL, get(getTransferOpcode(Dst, Src)))
+        .addReg(DestReg, RegState::Define | RegState::Implicit)
+        .addReg(SrcReg, RegState::Implicit | getKillRegState(KillSrc));
   } else {
-    if (SNES::MainRegsRegClass.contains(DestReg, SrcReg)) {
-      Opc = SNES::MOVRdRr;
-    } else if (SrcReg == SNES::SP && SNES::MainRegsRegClass.contains(DestReg)) {
+    if (SrcReg == SNES::SP && SNES::MainRegsRegClass.contains(DestReg)) {
       Opc = SNES::SPREAD;
     } else if (DestReg == SNES::SP && SNES::MainRegsRegClass.contains(SrcReg)) {
       Opc = SNES::SPWRITE;
@@ -84,8 +88,8 @@ void SNESInstrInfo::copyPhysReg(MachineBasicBlock &MBB,
 unsigned SNESInstrInfo::isLoadFromStackSlot(const MachineInstr &MI,
                                            int &FrameIndex) const {
   switch (MI.getOpcode()) {
-  case SNES::LDDRdPtrQ:
-  case SNES::LDDWRdYQ: { //:FIXME: remove this once PR13375 gets fixed
+  case SNES::LDsr8:
+  case SNES::LDsr16: {
     if (MI.getOperand(1).isFI() && MI.getOperand(2).isImm() &&
         MI.getOperand(2).getImm() == 0) {
       FrameIndex = MI.getOperand(1).getIndex();
@@ -103,8 +107,8 @@ unsigned SNESInstrInfo::isLoadFromStackSlot(const MachineInstr &MI,
 unsigned SNESInstrInfo::isStoreToStackSlot(const MachineInstr &MI,
                                           int &FrameIndex) const {
   switch (MI.getOpcode()) {
-  case SNES::STDPtrQRr:
-  case SNES::STDWPtrQRr: {
+  case SNES::STsr8:
+  case SNES::STsr16: {
     if (MI.getOperand(0).isFI() && MI.getOperand(1).isImm() &&
         MI.getOperand(1).getImm() == 0) {
       FrameIndex = MI.getOperand(0).getIndex();
@@ -119,6 +123,198 @@ unsigned SNESInstrInfo::isStoreToStackSlot(const MachineInstr &MI,
   return 0;
 }
 
+bool SNESInstrInfo::isReallyTriviallyReMaterializable(const MachineInstr &MI,
+                                                      AliasAnalysis *AA) const {
+  // Loads of a constant or of an address define P, which the generic check
+  // turns down. Only N and Z change, and nothing keeps those live across
+  // anything but the branch glued to the compare which set them.
+  switch (MI.getOpcode()) {
+  case SNES::LDIWRdK:
+  case SNES::LDAimm8:
+  case SNES::LDAimm16:
+  case SNES::LDXimm8:
+  case SNES::LDXimm16:
+  case SNES::LDYimm8:
+  case SNES::LDYimm16: {
+    const MachineOperand &MO = MI.getOperand(1);
+    return MO.isImm() || MO.isGlobal() || MO.isBlockAddress() ||
+           MO.isSymbol();
+  }
+  default:
+    return false;
+  }
+}
+
+/// Gets the stack relative form of a register/register ALU instruction, or
+/// zero if there is none.
+static unsigned getStackRelativeOpcode(unsigned Opcode) {
+  switch (Opcode) {
+  case SNES::ADDRdRr:
+  case SNES::ADDWRdRr:
+    return SNES::ADCsr16;
+  case SNES::SUBRdRr:
+  case SNES::SUBWRdRr:
+    return SNES::SBCsr16;
+  case SNES::ANDRdRr:
+  case SNES::ANDWRdRr:
+    return SNES::ANDsr16;
+  case SNES::ORRdRr:
+  case SNES::ORWRdRr:
+    return SNES::ORAsr16;
+  case SNES::EORRdRr:
+  case SNES::EORWRdRr:
+    return SNES::EORsr16;
+  default:
+    return 0;
+  }
+}
+
+bool SNESInstrInfo::isStackRelative(const MachineInstr &MI) {
+  switch (MI.getOpcode()) {
+  case SNES::ADCsr8:
+  case SNES::ADCsr16:
+  case SNES::SBCsr8:
+  case SNES::SBCsr16:
+  case SNES::ANDsr8:
+  case SNES::ANDsr16:
+  case SNES::ORAsr8:
+  case SNES::ORAsr16:
+  case SNES::EORsr8:
+  case SNES::EORsr16:
+  case SNES::LDAsr8:
+  case SNES::LDAsr16:
+  case SNES::STAsr8:
+  case SNES::STAsr16:
+  case SNES::LDsr8:
+  case SNES::LDsr16:
+  case SNES::STsr8:
+  case SNES::STsr16:
+    return true;
+  default:
+    return false;
+  }
+}
+
+unsigned SNESInstrInfo::getTransferOpcode(unsigned Dst, unsigned Src) {
+  switch (Src) {
+  case SNES::A:
+    return Dst == SNES::X ? SNES::TAX : SNES::TAY;
+  case SNES::X:
+    return Dst == SNES::A ? SNES::TXA : SNES::TXY;
+  case SNES::Y:
+    return Dst == SNES::A ? SNES::TYA : SNES::TYX;
+  default:
+    llvm_unreachable("Not a transfer between A, X and Y");
+  }
+}
+
+bool SNESInstrInfo::isTransfer(const MachineInstr &MI, unsigned &Dst,
+                               unsigned &Src) {
+  switch (MI.getOpcode()) {
+  case SNES::TAX:
+    Dst = SNES::X, Src = SNES::A;
+    return true;
+  case SNES::TAY:
+    Dst = SNES::Y, Src = SNES::A;
+    return true;
+  case SNES::TXA:
+    Dst = SNES::A, Src = SNES::X;
+    return true;
+  case SNES::TYA:
+    Dst = SNES::A, Src = SNES::Y;
+    return true;
+  case SNES::TXY:
+    Dst = SNES::Y, Src = SNES::X;
+    return true;
+  case SNES::TYX:
+    Dst = SNES::X, Src = SNES::Y;
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool SNESInstrInfo::isNZReadAfter(MachineBasicBlock &MBB,
+                                  MachineBasicBlock::iterator I) {
+  for (auto J = std::next(I), E = MBB.end(); J != E; ++J) {
+    if (J->readsRegister(SNES::P))
+      return true;
+    if (!J->definesRegister(SNES::P))
+      continue;
+
+    switch (J->getOpcode()) {
+    case SNES::CLC:
+    case SNES::SEC:
+    case SNES::CLD:
+    case SNES::SED:
+    case SNES::CLI:
+    case SNES::SEI:
+    case SNES::CLV:
+    case SNES::XCE:
+      continue;
+    case SNES::SEP:
+    case SNES::REP:
+      if (!(J->getOperand(0).getImm() & (SNESII::NFlag | SNESII::ZFlag)))
+        continue;
+      return false;
+    default:
+      return false;
+    }
+  }
+
+  for (const MachineBasicBlock *Succ : MBB.successors())
+    if (Succ->isLiveIn(SNES::P))
+      return true;
+  return false;
+}
+
+/// Checks if a register is known to live in the accumulator.
+static bool isAccumulator(const MachineRegisterInfo &MRI, unsigned Reg) {
+  if (TargetRegisterInfo::isPhysicalRegister(Reg)) {
+    return SNES::AccRegsRegClass.contains(Reg);
+  }
+
+  return SNES::AccRegsRegClass.hasSubClassEq(MRI.getRegClass(Reg));
+}
+
+MachineInstr *SNESInstrInfo::foldMemoryOperandImpl(
+    MachineFunction &MF, MachineInstr &MI, ArrayRef<unsigned> Ops,
+    MachineBasicBlock::iterator InsertPt, int FrameIndex,
+    LiveIntervals *LIS) const {
+  // Only a reload of the right hand side can be folded, the left hand side is
+  // tied to the result.
+  if (Ops.size() != 1 || Ops[0] != 2) {
+    return nullptr;
+  }
+
+  unsigned Opcode = getStackRelativeOpcode(MI.getOpcode());
+  if (!Opcode) {
+    return nullptr;
+  }
+
+  // The stack relative forms only operate on the accumulator, don't narrow
+  // the class of a register while it is being spilled.
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(1).getReg();
+  if (!isAccumulator(MRI, DstReg) || !isAccumulator(MRI, SrcReg)) {
+    return nullptr;
+  }
+
+  // ADC and SBC take the carry in, so the add starts with CLC and the
+  // subtract with SEC. The spiller adds it to the slot indexes with the fold.
+  MachineBasicBlock &MBB = *InsertPt->getParent();
+  if (Opcode == SNES::ADCsr16 || Opcode == SNES::SBCsr16) {
+    BuildMI(MBB, InsertPt, MI.getDebugLoc(),
+            get(Opcode == SNES::SBCsr16 ? SNES::SEC : SNES::CLC));
+  }
+
+  return BuildMI(MBB, InsertPt, MI.getDebugLoc(), get(Opcode), DstReg)
+      .addReg(SrcReg, getKillRegState(MI.getOperand(1).isKill()))
+      .addFrameIndex(FrameIndex)
+      .addImm(0);
+}
+
 void SNESInstrInfo::storeRegToStackSlot(MachineBasicBlock &MBB,
                                        MachineBasicBlock::iterator MI,
                                        unsigned SrcReg, bool isKill,
@@ -144,15 +340,13 @@ void SNESInstrInfo::storeRegToStackSlot(MachineBasicBlock &MBB,
 
   unsigned Opcode = 0;
   if (TRI->isTypeLegalForClass(*RC, MVT::i8)) {
-    Opcode = SNES::STDPtrQRr;
+    Opcode = SNES::STsr8;
   } else if (TRI->isTypeLegalForClass(*RC, MVT::i16)) {
-    Opcode = SNES::STDWPtrQRr;
+    Opcode = SNES::STsr16;
   } else {
     llvm_unreachable("Cannot store this register into a stack slot!");
   }
 
-  fddfd
-
   BuildMI(MBB, MI, DL, get(Opcode))
       .addFrameIndex(FrameIndex)
       .addImm(0)
@@ -180,11 +374,9 @@ void SNESInstrInfo::loadRegFromStackSlot(MachineBasicBlock &MBB,
 
   unsigned Opcode = 0;
   if (TRI->isTypeLegalForClass(*RC, MVT::i8)) {
-    Opcode = SNES::LDDRdPtrQ;
+    Opcode = SNES::LDsr8;
   } else if (TRI->isTypeLegalForClass(*RC, MVT::i16)) {
-    // Opcode = SNES::LDDWRdPtrQ;
-    //:FIXME: remove this once PR13375 gets fixed
-    Opcode = SNES::LDDWRdYQ;
+    Opcode = SNES::LDsr16;
   } else {
     llvm_unreachable("Cannot load this register from a stack slot!");
   }
@@ -543,21 +735,118 @@ bool SNESInstrInfo::isBranchOffsetInRange(unsigned BranchOp,
     assert(BrOffset >= 0 && "offset must be absolute address");
     return isUIntN(16, BrOffset);
   case SNES::RCALLk:
-  case SNES::RJMPk:
     return isIntN(13, BrOffset);
-  case SNES::BRBSsk:
-  case SNES::BRBCsk:
+  case SNES::RJMPk:
   case SNES::BREQk:
   case SNES::BRNEk:
   case SNES::BRSHk:
   case SNES::BRLOk:
   case SNES::BRMIk:
   case SNES::BRPLk:
+    return isIntN(8, BrOffset);
+  case SNES::BRBSsk:
+  case SNES::BRBCsk:
   case SNES::BRGEk:
   case SNES::BRLTk:
     return isIntN(7, BrOffset);
   }
 }
 
-} // end of namespace llvm
+//===----------------------------------------------------------------------===//
+// Machine outliner
+//===----------------------------------------------------------------------===//
+
+/// The average size of an instruction, the outliner only counts them.
+static const unsigned AverageInstSize = 2;
+
+unsigned SNESInstrInfo::getOutliningBenefit(size_t SequenceSize,
+                                            size_t Occurrences,
+                                            bool CanBeTailCall) const {
+  // Each occurrence becomes a 3 byte JSR or JMP. A called sequence also needs
+  // an RTS, and costs 12 cycles for the JSR and RTS, a tail called one only
+  // the 3 cycles of the JMP.
+  unsigned NotOutlinedSize = SequenceSize * Occurrences * AverageInstSize;
+  unsigned OutlinedSize = SequenceSize * AverageInstSize + Occurrences * 3;
+  unsigned AddedCycles = Occurrences * 3;
+  if (!CanBeTailCall) {
+    OutlinedSize += 1;
+    AddedCycles = Occurrences * 12;
+  }
+
+  // Charge for the time lost, so that a short sequence is only outlined when
+  // it occurs often enough.
+  OutlinedSize += alignTo(AddedCycles, OutlinerCyclesPerByte) /
+                  OutlinerCyclesPerByte;
+
+  if (NotOutlinedSize <= OutlinedSize)
+    return 0;
+  return (NotOutlinedSize - OutlinedSize) / AverageInstSize;
+}
+
+bool SNESInstrInfo::isFunctionSafeToOutlineFrom(MachineFunction &MF) const {
+  // Outlined functions have no profile data and end up in the generic text
+  // section. Only outline from functions placed there too, so that the JSR
+  // or JMP stays within the bank. This also leaves the FastROM code alone,
+  // which is where the time goes.
+  const Function &F = *MF.getFunction();
+  return SNESTargetObjectFile::getROMPlacement(F) ==
+         SNESTargetObjectFile::DefaultROM;
+}
+
+SNESInstrInfo::MachineOutlinerInstrType
+SNESInstrInfo::getOutliningType(MachineInstr &MI) const {
+  if (MI.isDebugValue() || MI.isIndirectDebugValue())
+    return MachineOutlinerInstrType::Invisible;
+
+  // A sequence ending the function can be jumped to, its RTS returns to our
+  // caller. Branches cannot be outlined.
+  if (MI.isTerminator() || MI.isReturn()) {
+    if (MI.getOpcode() == SNES::RTS && MI.getParent()->succ_empty())
+      return MachineOutlinerInstrType::Legal;
+    return MachineOutlinerInstrType::Illegal;
+  }
 
+  // The JSR pushes the return address, which moves every stack slot, and
+  // outlined functions do not save anything, so they cannot call either.
+  if (MI.isCall() || MI.modifiesRegister(SNES::SP, &RI) ||
+      MI.readsRegister(SNES::SP, &RI) ||
+      MI.getDesc().hasImplicitUseOfPhysReg(SNES::SP) ||
+      MI.getDesc().hasImplicitDefOfPhysReg(SNES::SP) || isStackRelative(MI))
+    return MachineOutlinerInstrType::Illegal;
+
+  if (MI.isPosition() || MI.isInlineAsm())
+    return MachineOutlinerInstrType::Illegal;
+
+  for (const MachineOperand &MO : MI.operands())
+    if (MO.isCPI() || MO.isJTI() || MO.isCFIIndex() || MO.isFI() ||
+        MO.isTargetIndex() || MO.isMBB() || MO.isBlockAddress())
+      return MachineOutlinerInstrType::Illegal;
+
+  return MachineOutlinerInstrType::Legal;
+}
+
+void SNESInstrInfo::insertOutlinerEpilogue(MachineBasicBlock &MBB,
+                                           MachineFunction &MF,
+                                           bool IsTailCall) const {
+  // A tail called sequence has the RTS of the function it came from.
+  if (IsTailCall)
+    return;
+
+  MBB.insert(MBB.end(), BuildMI(MF, DebugLoc(), get(SNES::RTS)));
+}
+
+void SNESInstrInfo::insertOutlinerPrologue(MachineBasicBlock &MBB,
+                                           MachineFunction &MF,
+                                           bool IsTailCall) const {}
+
+MachineBasicBlock::iterator
+SNESInstrInfo::insertOutlinedCall(Module &M, MachineBasicBlock &MBB,
+                                  MachineBasicBlock::iterator &It,
+                                  MachineFunction &MF, bool IsTailCall) const {
+  unsigned Opc = IsTailCall ? SNES::JMPabs : SNES::JSRabs;
+  It = MBB.insert(It, BuildMI(MF, DebugLoc(), get(Opc))
+                          .addGlobalAddress(M.getNamedValue(MF.getName())));
+  return It;
+}
+
+} // end of namespace llvm
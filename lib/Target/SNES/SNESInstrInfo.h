@@ -56,7 +56,22 @@ enum TOF {
   MO_HI = (1 << 2),
 
   /// On a symbol operand, this represents it has to be negated.
-  MO_NEG = (1 << 3)
+  MO_NEG = (1 << 3),
+
+  /// On a function operand, this represents its far entry.
+  MO_FAR = (1 << 4)
+};
+
+/// The bits of the P register, as set by SEP and cleared by REP.
+enum StatusFlags {
+  CFlag = 0x01, //!< Carry
+  ZFlag = 0x02, //!< Zero
+  IFlag = 0x04, //!< Interrupt disable
+  DFlag = 0x08, //!< Decimal mode
+  XFlag = 0x10, //!< 8-bit index registers
+  MFlag = 0x20, //!< 8-bit accumulator
+  VFlag = 0x40, //!< Overflow
+  NFlag = 0x80  //!< Negative
 };
 
 } // end of namespace SNESII
@@ -88,6 +103,32 @@ public:
                                int &FrameIndex) const override;
   unsigned isStoreToStackSlot(const MachineInstr &MI,
                               int &FrameIndex) const override;
+  bool isReallyTriviallyReMaterializable(const MachineInstr &MI,
+                                         AliasAnalysis *AA) const override;
+
+  // Memory operand folding.
+  using TargetInstrInfo::foldMemoryOperandImpl;
+  MachineInstr *foldMemoryOperandImpl(MachineFunction &MF, MachineInstr &MI,
+                                      ArrayRef<unsigned> Ops,
+                                      MachineBasicBlock::iterator InsertPt,
+                                      int FrameIndex,
+                                      LiveIntervals *LIS = nullptr) const override;
+
+  /// Checks if an instruction addresses its frame index relative to S.
+  static bool isStackRelative(const MachineInstr &MI);
+
+  /// The transfer instruction which copies \p Src to \p Dst, two of A, X
+  /// and Y.
+  static unsigned getTransferOpcode(unsigned Dst, unsigned Src);
+
+  /// Checks if an instruction is a transfer between A, X and Y, and gets the
+  /// 16-bit registers it copies between.
+  static bool isTransfer(const MachineInstr &MI, unsigned &Dst, unsigned &Src);
+
+  /// Checks if the N and Z flags set before \p I are tested after it. The
+  /// instructions which only set or clear flags, like CLC and SEP, keep them.
+  static bool isNZReadAfter(MachineBasicBlock &MBB,
+                            MachineBasicBlock::iterator I);
 
   // Branch analysis.
   bool analyzeBranch(MachineBasicBlock &MBB, MachineBasicBlock *&TBB,
@@ -107,6 +148,20 @@ public:
 
   bool isBranchOffsetInRange(unsigned BranchOpc,
                              int64_t BrOffset) const override;
+
+  // Machine outliner.
+  unsigned getOutliningBenefit(size_t SequenceSize, size_t Occurrences,
+                               bool CanBeTailCall) const override;
+  bool isFunctionSafeToOutlineFrom(MachineFunction &MF) const override;
+  MachineOutlinerInstrType getOutliningType(MachineInstr &MI) const override;
+  void insertOutlinerEpilogue(MachineBasicBlock &MBB, MachineFunction &MF,
+                              bool IsTailCall) const override;
+  void insertOutlinerPrologue(MachineBasicBlock &MBB, MachineFunction &MF,
+                              bool IsTailCall) const override;
+  MachineBasicBlock::iterator
+  insertOutlinedCall(Module &M, MachineBasicBlock &MBB,
+                     MachineBasicBlock::iterator &It, MachineFunction &MF,
+                     bool IsTailCall) const override;
 private:
   const SNESRegisterInfo RI;
 };
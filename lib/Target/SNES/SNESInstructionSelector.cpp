@@ -0,0 +1,667 @@
+//===- SNESInstructionSelector.cpp ---------------------------*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// This file implements the targeting of the InstructionSelector class for
+/// SNES.
+///
+/// Only branches are imported from the SelectionDAG patterns, the rest is
+/// selected here into the same pseudos SelectionDAG uses, so both selectors
+/// share the custom inserters and the pseudo expansion.
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESRegisterBankInfo.h"
+#include "SNESSubtarget.h"
+#include "SNESTargetMachine.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "snes-isel"
+
+#include "llvm/CodeGen/GlobalISel/InstructionSelectorImpl.h"
+
+using namespace llvm;
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "You shouldn't build this"
+#endif
+
+namespace {
+
+#define GET_GLOBALISEL_PREDICATE_BITSET
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_PREDICATE_BITSET
+
+class SNESInstructionSelector : public InstructionSelector {
+public:
+  SNESInstructionSelector(const SNESTargetMachine &TM,
+                          const SNESSubtarget &STI,
+                          const SNESRegisterBankInfo &RBI);
+
+  bool select(MachineInstr &I) const override;
+
+private:
+  bool selectImpl(MachineInstr &I) const;
+
+  /// Gives the virtual register \p Reg the class of its bank, if it doesn't
+  /// have a class yet. The generic constraining only finds a class through
+  /// the bank when the bank covers the operand class exactly, and inserts a
+  /// copy otherwise, which is wrong for definitions.
+  bool assignRegClass(unsigned Reg, MachineRegisterInfo &MRI) const;
+
+  /// Selects \p NewMI, built to replace \p I, and erases \p I. A
+  /// definition of another class than its operand is copied out after
+  /// \p NewMI, the generic constraining would copy it in before.
+  bool replace(MachineInstr &I, MachineInstrBuilder NewMI,
+               MachineRegisterInfo &MRI) const;
+
+  bool selectCopy(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectBinOp(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectLoadStore(MachineInstr &I, MachineRegisterInfo &MRI) const;
+
+  /// Emits the compare for \p Cond before \p InsertPt, and returns the
+  /// condition to branch or select on. A G_ICMP is folded, anything else is
+  /// tested against zero.
+  SNESCC::CondCodes emitCondition(unsigned Cond, MachineInstr &InsertPt,
+                                  MachineRegisterInfo &MRI) const;
+
+  const SNESInstrInfo &TII;
+  const SNESRegisterInfo &TRI;
+  const SNESTargetMachine &TM;
+  const SNESRegisterBankInfo &RBI;
+  const SNESSubtarget &STI;
+
+#define GET_GLOBALISEL_PREDICATES_DECL
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_PREDICATES_DECL
+
+// We declare the temporaries used by selectImpl() in the class to minimize the
+// cost of constructing placeholder values.
+#define GET_GLOBALISEL_TEMPORARIES_DECL
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_TEMPORARIES_DECL
+};
+} // end anonymous namespace
+
+namespace llvm {
+InstructionSelector *
+createSNESInstructionSelector(const SNESTargetMachine &TM,
+                              const SNESSubtarget &STI,
+                              const SNESRegisterBankInfo &RBI) {
+  return new SNESInstructionSelector(TM, STI, RBI);
+}
+} // end namespace llvm
+
+#define GET_GLOBALISEL_IMPL
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_IMPL
+
+SNESInstructionSelector::SNESInstructionSelector(
+    const SNESTargetMachine &TM, const SNESSubtarget &STI,
+    const SNESRegisterBankInfo &RBI)
+    : InstructionSelector(), TII(*STI.getInstrInfo()),
+      TRI(*STI.getRegisterInfo()), TM(TM), RBI(RBI), STI(STI),
+#define GET_GLOBALISEL_PREDICATES_INIT
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_PREDICATES_INIT
+#define GET_GLOBALISEL_TEMPORARIES_INIT
+#include "SNESGenGlobalISel.inc"
+#undef GET_GLOBALISEL_TEMPORARIES_INIT
+{
+}
+
+bool SNESInstructionSelector::assignRegClass(unsigned Reg,
+                                             MachineRegisterInfo &MRI) const {
+  if (TargetRegisterInfo::isPhysicalRegister(Reg) ||
+      MRI.getRegClassOrNull(Reg))
+    return true;
+
+  const RegisterBank *RB = MRI.getRegBankOrNull(Reg);
+  if (!RB)
+    return false;
+
+  const TargetRegisterClass *RC = SNESRegisterBankInfo::getRegClassFor(
+      *RB, MRI.getType(Reg).getSizeInBits());
+  if (!RC)
+    return false;
+
+  MRI.setRegClass(Reg, RC);
+  return true;
+}
+
+/// Only the compares emitCondition builds right before their user leave P
+/// live, it is dead after anything else the selector builds. The register
+/// coalescer relies on it to rematerialize constants.
+static void setFlagsDead(MachineInstr &MI) {
+  for (MachineOperand &MO : MI.implicit_operands())
+    if (MO.isReg() && MO.isDef() && MO.getReg() == SNES::P)
+      MO.setIsDead();
+}
+
+bool SNESInstructionSelector::replace(MachineInstr &I,
+                                      MachineInstrBuilder NewMI,
+                                      MachineRegisterInfo &MRI) const {
+  MachineInstr &MI = *NewMI;
+  MachineBasicBlock &MBB = *MI.getParent();
+  const MachineFunction &MF = *MBB.getParent();
+
+  for (unsigned OpI = 0, E = MI.getDesc().getNumDefs(); OpI != E; ++OpI) {
+    MachineOperand &MO = MI.getOperand(OpI);
+    unsigned Reg = MO.getReg();
+    const TargetRegisterClass *RC = TII.getRegClass(MI.getDesc(), OpI, &TRI,
+                                                    MF);
+    if (!RC || !TargetRegisterInfo::isVirtualRegister(Reg) ||
+        RBI.constrainGenericRegister(Reg, *RC, MRI))
+      continue;
+
+    unsigned NewReg = MRI.createVirtualRegister(RC);
+    MO.setReg(NewReg);
+    BuildMI(MBB, std::next(MI.getIterator()), MI.getDebugLoc(),
+            TII.get(TargetOpcode::COPY), Reg)
+        .addReg(NewReg);
+  }
+
+  setFlagsDead(MI);
+  I.eraseFromParent();
+  return constrainSelectedInstRegOperands(MI, TII, TRI, RBI);
+}
+
+bool SNESInstructionSelector::selectCopy(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  // Copies between the banks are moves between A and the index registers,
+  // copyPhysReg turns them into TAX, TXA and friends.
+  for (const MachineOperand &MO : I.operands())
+    if (MO.isReg() && !assignRegClass(MO.getReg(), MRI))
+      return false;
+  return true;
+}
+
+/// The SelectionDAG condition for \p Pred, and whether the operands must be
+/// swapped for it. The P flags only give the four orders with the equality
+/// on the same side as the operands of the compare.
+static SNESCC::CondCodes getCondCode(CmpInst::Predicate Pred, bool &Swap) {
+  Swap = false;
+  switch (Pred) {
+  default:
+    llvm_unreachable("Unknown integer predicate");
+  case CmpInst::ICMP_EQ:
+    return SNESCC::COND_EQ;
+  case CmpInst::ICMP_NE:
+    return SNESCC::COND_NE;
+  case CmpInst::ICMP_SGE:
+    return SNESCC::COND_GE;
+  case CmpInst::ICMP_SLT:
+    return SNESCC::COND_LT;
+  case CmpInst::ICMP_UGE:
+    return SNESCC::COND_SH;
+  case CmpInst::ICMP_ULT:
+    return SNESCC::COND_LO;
+  case CmpInst::ICMP_SGT:
+    Swap = true;
+    return SNESCC::COND_LT;
+  case CmpInst::ICMP_SLE:
+    Swap = true;
+    return SNESCC::COND_GE;
+  case CmpInst::ICMP_UGT:
+    Swap = true;
+    return SNESCC::COND_LO;
+  case CmpInst::ICMP_ULE:
+    Swap = true;
+    return SNESCC::COND_SH;
+  }
+}
+
+SNESCC::CondCodes
+SNESInstructionSelector::emitCondition(unsigned Cond, MachineInstr &InsertPt,
+                                       MachineRegisterInfo &MRI) const {
+  MachineBasicBlock &MBB = *InsertPt.getParent();
+  const DebugLoc &DL = InsertPt.getDebugLoc();
+
+  MachineInstr *CondMI = MRI.getVRegDef(Cond);
+  if (CondMI && CondMI->getOpcode() == TargetOpcode::G_ICMP) {
+    // The compare is emitted right before its user, nothing may come between
+    // them and P. The G_ICMP itself is dead once all its users are selected.
+    auto Pred = (CmpInst::Predicate)CondMI->getOperand(1).getPredicate();
+    unsigned LHS = CondMI->getOperand(2).getReg();
+    unsigned RHS = CondMI->getOperand(3).getReg();
+
+    bool Swap;
+    SNESCC::CondCodes CC = getCondCode(Pred, Swap);
+    if (Swap)
+      std::swap(LHS, RHS);
+
+    if (!assignRegClass(LHS, MRI) || !assignRegClass(RHS, MRI))
+      return SNESCC::COND_INVALID;
+
+    MachineInstrBuilder Cmp;
+    if (auto Imm = getConstantVRegVal(RHS, MRI))
+      Cmp = BuildMI(MBB, InsertPt, DL, TII.get(SNES::CPIWRdK))
+                .addReg(LHS)
+                .addImm(*Imm);
+    else
+      Cmp = BuildMI(MBB, InsertPt, DL, TII.get(SNES::CPWRdRr))
+                .addReg(LHS)
+                .addReg(RHS);
+    if (!constrainSelectedInstRegOperands(*Cmp, TII, TRI, RBI))
+      return SNESCC::COND_INVALID;
+    return CC;
+  }
+
+  // A boolean held in a byte, only its low bit is defined.
+  if (!assignRegClass(Cond, MRI))
+    return SNESCC::COND_INVALID;
+
+  unsigned Wide = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+  unsigned Bit = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+  BuildMI(MBB, InsertPt, DL, TII.get(SNES::ZEXT), Wide).addReg(Cond);
+  BuildMI(MBB, InsertPt, DL, TII.get(SNES::ANDIWRdK), Bit)
+      .addReg(Wide)
+      .addImm(1);
+  BuildMI(MBB, InsertPt, DL, TII.get(SNES::CPIWRdK)).addReg(Bit).addImm(0);
+  return SNESCC::COND_NE;
+}
+
+bool SNESInstructionSelector::selectBinOp(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  unsigned Dst = I.getOperand(0).getReg();
+  unsigned LHS = I.getOperand(1).getReg();
+  unsigned RHS = I.getOperand(2).getReg();
+
+  // Immediates are folded as SelectionDAG does, `ADC #imm` rather than
+  // loading the constant in another register.
+  if (auto Imm = getConstantVRegVal(RHS, MRI)) {
+    unsigned Opc = 0;
+    switch (I.getOpcode()) {
+    case TargetOpcode::G_ADD:
+    case TargetOpcode::G_GEP:
+      Opc = SNES::ADDimm16;
+      break;
+    case TargetOpcode::G_SUB:
+      Opc = SNES::SUBimm16;
+      break;
+    case TargetOpcode::G_AND:
+      Opc = SNES::ANDIWRdK;
+      break;
+    case TargetOpcode::G_OR:
+      Opc = SNES::ORIWRdK;
+      break;
+    case TargetOpcode::G_XOR:
+      Opc = SNES::EORimm16;
+      break;
+    }
+
+    if (Opc)
+      return replace(I,
+                     BuildMI(MBB, I, DL, TII.get(Opc), Dst)
+                         .addReg(LHS)
+                         .addImm(*Imm & 0xffff),
+                     MRI);
+
+    // A constant shift is a run of single bit shifts, as in LowerShifts.
+    switch (I.getOpcode()) {
+    case TargetOpcode::G_SHL:
+      Opc = SNES::ASLA16;
+      break;
+    case TargetOpcode::G_LSHR:
+      Opc = SNES::LSRA16;
+      break;
+    case TargetOpcode::G_ASHR:
+      Opc = SNES::ASRA16;
+      break;
+    }
+
+    if (Opc && *Imm > 0 && *Imm < 16) {
+      unsigned Src = LHS;
+      for (int64_t N = 1; N != *Imm; ++N) {
+        unsigned Shifted = MRI.createVirtualRegister(&SNES::AccRegsRegClass);
+        MachineInstr &Shift =
+            *BuildMI(MBB, I, DL, TII.get(Opc), Shifted).addReg(Src);
+        setFlagsDead(Shift);
+        if (!constrainSelectedInstRegOperands(Shift, TII, TRI, RBI))
+          return false;
+        Src = Shifted;
+      }
+      return replace(I, BuildMI(MBB, I, DL, TII.get(Opc), Dst).addReg(Src),
+                     MRI);
+    }
+  }
+
+  unsigned Opc;
+  switch (I.getOpcode()) {
+  default:
+    return false;
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_GEP:
+    Opc = SNES::ADDWRdRr;
+    break;
+  case TargetOpcode::G_SUB:
+    Opc = SNES::SUBWRdRr;
+    break;
+  case TargetOpcode::G_AND:
+    Opc = SNES::ANDWRdRr;
+    break;
+  case TargetOpcode::G_OR:
+    Opc = SNES::ORWRdRr;
+    break;
+  case TargetOpcode::G_XOR:
+    Opc = SNES::EORWRdRr;
+    break;
+  case TargetOpcode::G_SHL:
+    Opc = SNES::Lsl16;
+    break;
+  case TargetOpcode::G_LSHR:
+    Opc = SNES::Lsr16;
+    break;
+  case TargetOpcode::G_ASHR:
+    Opc = SNES::Asr16;
+    break;
+  }
+
+  return replace(
+      I, BuildMI(MBB, I, DL, TII.get(Opc), Dst).addReg(LHS).addReg(RHS), MRI);
+}
+
+/// The definition of \p Reg, through the copies the IRTranslator leaves for
+/// no-op casts and GEPs.
+static MachineInstr *getDefThroughCopies(unsigned Reg,
+                                         MachineRegisterInfo &MRI) {
+  MachineInstr *Def = MRI.getVRegDef(Reg);
+  while (Def->isCopy() &&
+         TargetRegisterInfo::isVirtualRegister(Def->getOperand(1).getReg()))
+    Def = MRI.getVRegDef(Def->getOperand(1).getReg());
+  return Def;
+}
+
+bool SNESInstructionSelector::selectLoadStore(MachineInstr &I,
+                                              MachineRegisterInfo &MRI) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  const DebugLoc &DL = I.getDebugLoc();
+  bool IsLoad = I.getOpcode() == TargetOpcode::G_LOAD;
+  unsigned Val = I.getOperand(0).getReg();
+  unsigned Ptr = I.getOperand(1).getReg();
+  bool IsByte = MRI.getType(Val).getSizeInBits() == 8;
+
+  // Split a constant offset or an index off the address.
+  int64_t Offset = 0;
+  unsigned Index = 0;
+  MachineInstr *Base = getDefThroughCopies(Ptr, MRI);
+  MachineInstr *GEP = nullptr;
+  if (Base->getOpcode() == TargetOpcode::G_GEP) {
+    GEP = Base;
+    unsigned Off = GEP->getOperand(2).getReg();
+    if (auto Imm = getConstantVRegVal(Off, MRI))
+      Offset = *Imm;
+    else
+      Index = Off;
+    Base = getDefThroughCopies(GEP->getOperand(1).getReg(), MRI);
+  }
+
+  // There is no `LDA dp,X` on a word of the direct page we can index.
+  bool IsGlobal = Base->getOpcode() == TargetOpcode::G_GLOBAL_VALUE &&
+                  !(Index && SNES::isDirectPageAddress(
+                                 Base->getOperand(1).getGlobal()));
+
+  MachineInstrBuilder MIB;
+  if (IsGlobal) {
+    // `LDA abs`, `LDA dp` or `LDA abs,X`, the address is in the instruction.
+    const GlobalValue *GV = Base->getOperand(1).getGlobal();
+    Offset += Base->getOperand(1).getOffset();
+
+    unsigned Opc;
+    if (Index) {
+      Opc = IsLoad ? (IsByte ? SNES::LDAabsx8 : SNES::LDAabsx16)
+                   : (IsByte ? SNES::STAabsx8 : SNES::STAabsx16);
+    } else if (SNES::isDirectPageAddress(GV)) {
+      Opc = IsLoad ? (IsByte ? SNES::LDAdp8 : SNES::LDAdp16)
+                   : (IsByte ? SNES::STAdp8 : SNES::STAdp16);
+    } else {
+      Opc = IsLoad ? (IsByte ? SNES::LDAabs8 : SNES::LDAabs16)
+                   : (IsByte ? SNES::STAabs8 : SNES::STAabs16);
+    }
+
+    if (Index && !assignRegClass(Index, MRI))
+      return false;
+
+    MIB = BuildMI(MBB, I, DL, TII.get(Opc));
+    if (IsLoad)
+      MIB.addDef(Val);
+    MIB.addGlobalAddress(GV, Offset);
+    if (Index)
+      MIB.addReg(Index);
+    if (!IsLoad)
+      MIB.addReg(Val);
+  } else if (Base->getOpcode() == TargetOpcode::G_FRAME_INDEX && !Index &&
+             !IsByte) {
+    // A stack slot, `LDA d,S`.
+    int FI = Base->getOperand(1).getIndex();
+    if (IsLoad)
+      MIB = BuildMI(MBB, I, DL, TII.get(SNES::LDDWRdPtrQ), Val)
+                .addFrameIndex(FI)
+                .addImm(Offset);
+    else
+      MIB = BuildMI(MBB, I, DL, TII.get(SNES::STDWPtrQRr))
+                .addFrameIndex(FI)
+                .addImm(Offset)
+                .addReg(Val);
+  } else if (!IsByte && !Index && !Offset) {
+    if (IsLoad)
+      MIB = BuildMI(MBB, I, DL, TII.get(SNES::LDWRdPtr), Val).addReg(Ptr);
+    else
+      MIB = BuildMI(MBB, I, DL, TII.get(SNES::STWPtrRr))
+                .addReg(Ptr)
+                .addReg(Val);
+  } else {
+    // `LDA (dp),Y` through the scratch pointer, with the index or the offset
+    // in Y.
+    unsigned PtrReg = Ptr;
+    if (Index || Offset)
+      PtrReg = GEP->getOperand(1).getReg();
+    if (!Index) {
+      Index = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+      setFlagsDead(*BuildMI(MBB, I, DL, TII.get(SNES::LDIWRdK), Index)
+                        .addImm(Offset & 0xffff));
+    }
+    if (!assignRegClass(PtrReg, MRI) || !assignRegClass(Index, MRI))
+      return false;
+
+    unsigned Opc = IsLoad ? (IsByte ? SNES::LDIndirectY8 : SNES::LDIndirectY16)
+                          : (IsByte ? SNES::STIndirectY8 : SNES::STIndirectY16);
+    MIB = BuildMI(MBB, I, DL, TII.get(Opc));
+    if (IsLoad)
+      MIB.addDef(Val);
+    MIB.addReg(PtrReg).addReg(Index);
+    if (!IsLoad)
+      MIB.addReg(Val);
+  }
+
+  MIB.setMemRefs(I.memoperands_begin(), I.memoperands_end());
+  return replace(I, MIB, MRI);
+}
+
+bool SNESInstructionSelector::select(MachineInstr &I) const {
+  assert(I.getParent() && "Instruction should be in a basic block!");
+  assert(I.getParent()->getParent() && "Instruction should be in a function!");
+
+  auto &MBB = *I.getParent();
+  auto &MF = *MBB.getParent();
+  auto &MRI = MF.getRegInfo();
+
+  if (!isPreISelGenericOpcode(I.getOpcode())) {
+    if (I.isCopy() || I.isPHI())
+      return selectCopy(I, MRI);
+
+    return true;
+  }
+
+  if (selectImpl(I))
+    return true;
+
+  // Every register defined or used by the new instructions gets the class of
+  // its bank first, see assignRegClass.
+  for (const MachineOperand &MO : I.operands())
+    if (MO.isReg() && !assignRegClass(MO.getReg(), MRI))
+      return false;
+
+  const DebugLoc &DL = I.getDebugLoc();
+  unsigned Dst = I.getOperand(0).isReg() ? I.getOperand(0).getReg() : 0;
+
+  switch (I.getOpcode()) {
+  default:
+    return false;
+  case TargetOpcode::G_CONSTANT: {
+    int64_t Imm = I.getOperand(1).getCImm()->getSExtValue();
+    if (MRI.getType(Dst).getSizeInBits() == 8)
+      return replace(I,
+                     BuildMI(MBB, I, DL, TII.get(SNES::LDAimm8), Dst)
+                         .addImm(Imm & 0xff),
+                     MRI);
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(SNES::LDIWRdK), Dst)
+                       .addImm(Imm & 0xffff),
+                   MRI);
+  }
+  case TargetOpcode::G_GLOBAL_VALUE:
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(SNES::LDIWRdK), Dst)
+                       .addGlobalAddress(I.getOperand(1).getGlobal(),
+                                         I.getOperand(1).getOffset()),
+                   MRI);
+  case TargetOpcode::G_FRAME_INDEX:
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(SNES::FRMIDX), Dst)
+                       .addFrameIndex(I.getOperand(1).getIndex())
+                       .addImm(0),
+                   MRI);
+  case TargetOpcode::G_IMPLICIT_DEF:
+    I.setDesc(TII.get(TargetOpcode::IMPLICIT_DEF));
+    return true;
+  case TargetOpcode::G_INTTOPTR:
+  case TargetOpcode::G_PTRTOINT:
+    I.setDesc(TII.get(TargetOpcode::COPY));
+    return true;
+  case TargetOpcode::G_TRUNC: {
+    unsigned Src = I.getOperand(1).getReg();
+    if (MRI.getType(Src).getSizeInBits() == 16)
+      BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), Dst)
+          .addReg(Src, 0, SNES::sub_lo);
+    else
+      BuildMI(MBB, I, DL, TII.get(TargetOpcode::COPY), Dst).addReg(Src);
+    I.eraseFromParent();
+    return true;
+  }
+  case TargetOpcode::G_ANYEXT: {
+    // The high byte is whatever is there, no code.
+    unsigned Undef = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::IMPLICIT_DEF), Undef);
+    BuildMI(MBB, I, DL, TII.get(TargetOpcode::INSERT_SUBREG), Dst)
+        .addReg(Undef)
+        .addReg(I.getOperand(1).getReg())
+        .addImm(SNES::sub_lo);
+    I.eraseFromParent();
+    return true;
+  }
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT: {
+    unsigned Src = I.getOperand(1).getReg();
+    bool IsSigned = I.getOpcode() == TargetOpcode::G_SEXT;
+    if (MRI.getType(Src).getSizeInBits() == 8)
+      return replace(I,
+                     BuildMI(MBB, I, DL,
+                             TII.get(IsSigned ? SNES::SEXT : SNES::ZEXT), Dst)
+                         .addReg(Src),
+                     MRI);
+
+    // Booleans only define their low bit: `AND #1`, and negated for a sign
+    // extension.
+    unsigned Wide = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+    BuildMI(MBB, I, DL, TII.get(SNES::ZEXT), Wide).addReg(Src);
+    if (!IsSigned)
+      return replace(I,
+                     BuildMI(MBB, I, DL, TII.get(SNES::ANDIWRdK), Dst)
+                         .addReg(Wide)
+                         .addImm(1),
+                     MRI);
+
+    unsigned Bit = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+    unsigned Zero = MRI.createVirtualRegister(&SNES::MainRegsRegClass);
+    BuildMI(MBB, I, DL, TII.get(SNES::ANDIWRdK), Bit).addReg(Wide).addImm(1);
+    setFlagsDead(*BuildMI(MBB, I, DL, TII.get(SNES::LDIWRdK), Zero).addImm(0));
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(SNES::SUBWRdRr), Dst)
+                       .addReg(Zero)
+                       .addReg(Bit),
+                   MRI);
+  }
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_SUB:
+  case TargetOpcode::G_AND:
+  case TargetOpcode::G_OR:
+  case TargetOpcode::G_XOR:
+  case TargetOpcode::G_SHL:
+  case TargetOpcode::G_LSHR:
+  case TargetOpcode::G_ASHR:
+  case TargetOpcode::G_GEP:
+    return selectBinOp(I, MRI);
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    return selectLoadStore(I, MRI);
+  case TargetOpcode::G_ICMP: {
+    // Only reached when the result is used as a value, compares used by a
+    // branch or a select are emitted there. `LDA #1` or `LDA #0`.
+    SNESCC::CondCodes CC = emitCondition(Dst, I, MRI);
+    if (CC == SNESCC::COND_INVALID)
+      return false;
+
+    unsigned One = MRI.createVirtualRegister(&SNES::MainLoRegsRegClass);
+    unsigned Zero = MRI.createVirtualRegister(&SNES::MainLoRegsRegClass);
+    MachineBasicBlock::iterator Cmp = std::prev(I.getIterator());
+    setFlagsDead(
+        *BuildMI(MBB, Cmp, DL, TII.get(SNES::LDAimm8), One).addImm(1));
+    setFlagsDead(
+        *BuildMI(MBB, Cmp, DL, TII.get(SNES::LDAimm8), Zero).addImm(0));
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(SNES::Select8), Dst)
+                       .addReg(One)
+                       .addReg(Zero)
+                       .addImm(CC),
+                   MRI);
+  }
+  case TargetOpcode::G_BRCOND: {
+    SNESCC::CondCodes CC =
+        emitCondition(I.getOperand(0).getReg(), I, MRI);
+    if (CC == SNESCC::COND_INVALID)
+      return false;
+
+    BuildMI(MBB, I, DL, TII.getBrCond(CC)).addMBB(I.getOperand(1).getMBB());
+    I.eraseFromParent();
+    return true;
+  }
+  case TargetOpcode::G_SELECT: {
+    SNESCC::CondCodes CC = emitCondition(I.getOperand(1).getReg(), I, MRI);
+    if (CC == SNESCC::COND_INVALID)
+      return false;
+
+    unsigned Opc =
+        MRI.getType(Dst).getSizeInBits() == 8 ? SNES::Select8 : SNES::Select16;
+    return replace(I,
+                   BuildMI(MBB, I, DL, TII.get(Opc), Dst)
+                       .addReg(I.getOperand(2).getReg())
+                       .addReg(I.getOperand(3).getReg())
+                       .addImm(CC),
+                   MRI);
+  }
+  }
+}
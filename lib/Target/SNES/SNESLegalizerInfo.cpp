@@ -0,0 +1,151 @@
+//===-- SNESLegalizerInfo.cpp - SNES machine legalizer --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the targeting of the MachineLegalizer class for SNES.
+//
+// The accumulator does 16-bit arithmetic, and switching it to 8 bits costs a
+// SEP/REP pair each way, so byte arithmetic is done on words and the result
+// truncated. Bytes in memory are still loaded and stored as bytes, with the
+// M flag set around the access before the function is emitted.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNESLegalizerInfo.h"
+
+#include "llvm/CodeGen/GlobalISel/LegalizerHelper.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Type.h"
+#include "llvm/Target/TargetOpcodes.h"
+
+#include "SNES.h"
+#include "SNESSubtarget.h"
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "This shouldn't be built without GISel"
+#endif
+
+namespace llvm {
+
+SNESLegalizerInfo::SNESLegalizerInfo(const SNESSubtarget &ST) {
+  using namespace TargetOpcode;
+
+  // Direct page pointers are data pointers too, see isNoopAddrSpaceCast.
+  const LLT p0 = LLT::pointer(SNES::DataMemory, 16);
+  const LLT p2 = LLT::pointer(SNES::DirectPage, 16);
+
+  const LLT s1 = LLT::scalar(1);
+  const LLT s8 = LLT::scalar(8);
+  const LLT s16 = LLT::scalar(16);
+
+  setAction({G_FRAME_INDEX, p0}, Legal);
+
+  for (auto Ty : {p0, p2}) {
+    setAction({G_GLOBAL_VALUE, Ty}, Legal);
+    setAction({G_GEP, Ty}, Legal);
+    setAction({G_INTTOPTR, Ty}, Legal);
+    setAction({G_PTRTOINT, 1, Ty}, Legal);
+    setAction({G_ICMP, 1, Ty}, Legal);
+    setAction({G_SELECT, Ty}, Legal);
+    setAction({G_CONSTANT, Ty}, Legal);
+    setAction({G_IMPLICIT_DEF, Ty}, Legal);
+  }
+  setAction({G_GEP, 1, s16}, Legal);
+  setAction({G_INTTOPTR, 1, s16}, Legal);
+  setAction({G_PTRTOINT, s16}, Legal);
+
+  for (unsigned Op : {G_LOAD, G_STORE}) {
+    for (auto Ty : {s8, s16, p0, p2})
+      setAction({Op, Ty}, Legal);
+    setAction({Op, s1}, WidenScalar);
+    for (auto Ty : {p0, p2})
+      setAction({Op, 1, Ty}, Legal);
+  }
+
+  for (unsigned Op : {G_ADD, G_SUB, G_AND, G_OR, G_XOR, G_SHL, G_LSHR,
+                      G_ASHR}) {
+    for (auto Ty : {s1, s8})
+      setAction({Op, Ty}, WidenScalar);
+    setAction({Op, s16}, Legal);
+  }
+
+  // __mulhi3, or a shift by a power of two. Division goes through
+  // __divmodhi4, which returns a pair.
+  setAction({G_MUL, s8}, WidenScalar);
+  setAction({G_MUL, s16}, Custom);
+
+  for (unsigned Op : {G_SEXT, G_ZEXT, G_ANYEXT}) {
+    setAction({Op, s16}, Legal);
+    for (auto Ty : {s1, s8})
+      setAction({Op, 1, Ty}, Legal);
+  }
+
+  for (auto Ty : {s8, s16})
+    setAction({G_IMPLICIT_DEF, Ty}, Legal);
+
+  setAction({G_CONSTANT, s1}, WidenScalar);
+  for (auto Ty : {s8, s16})
+    setAction({G_CONSTANT, Ty}, Legal);
+
+  setAction({G_ICMP, s1}, Legal);
+  setAction({G_ICMP, 1, s8}, WidenScalar);
+  setAction({G_ICMP, 1, s16}, Legal);
+
+  setAction({G_SELECT, s8}, Legal);
+  setAction({G_SELECT, s16}, Legal);
+  setAction({G_SELECT, 1, s1}, Legal);
+
+  setAction({G_BRCOND, s1}, Legal);
+
+  computeTables();
+}
+
+bool SNESLegalizerInfo::legalizeCustom(MachineInstr &MI,
+                                       MachineRegisterInfo &MRI,
+                                       MachineIRBuilder &MIRBuilder) const {
+  using namespace TargetOpcode;
+
+  MIRBuilder.setInstr(MI);
+
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case G_MUL: {
+    // A power of two, the element size of a G_GEP index most of the time,
+    // is a shift. The IRTranslator puts that one on the left.
+    unsigned Src = MI.getOperand(1).getReg();
+    auto Imm = getConstantVRegVal(MI.getOperand(2).getReg(), MRI);
+    if (!Imm) {
+      Imm = getConstantVRegVal(Src, MRI);
+      Src = MI.getOperand(2).getReg();
+    }
+    if (Imm && *Imm > 0 && isPowerOf2_64(*Imm)) {
+      auto Amount = MIRBuilder.buildConstant(LLT::scalar(16), Log2_64(*Imm));
+      MIRBuilder.buildInstr(G_SHL, MI.getOperand(0).getReg(), Src, Amount);
+      break;
+    }
+
+    auto &Ctx = MIRBuilder.getMF().getFunction()->getContext();
+    Type *Ty = Type::getInt16Ty(Ctx);
+    auto Status = createLibcall(MIRBuilder, RTLIB::MUL_I16,
+                                {MI.getOperand(0).getReg(), Ty},
+                                {{MI.getOperand(1).getReg(), Ty},
+                                 {MI.getOperand(2).getReg(), Ty}});
+    if (Status != LegalizerHelper::Legalized)
+      return false;
+    break;
+  }
+  }
+
+  MI.eraseFromParent();
+  return true;
+}
+
+} // end of namespace llvm
@@ -0,0 +1,37 @@
+//===-- SNESLegalizerInfo.h - SNES machine legalizer --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the targeting of the MachineLegalizer class for SNES.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_LEGALIZER_INFO_H
+#define LLVM_SNES_LEGALIZER_INFO_H
+
+#include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
+
+namespace llvm {
+
+class SNESSubtarget;
+
+/// Describes the types GlobalISel may leave in a function.
+///
+/// Words are legal, bytes are only loaded, stored and extended, arithmetic
+/// on them is widened to a word. Anything wider is left to SelectionDAG.
+class SNESLegalizerInfo : public LegalizerInfo {
+public:
+  SNESLegalizerInfo(const SNESSubtarget &ST);
+
+  bool legalizeCustom(MachineInstr &MI, MachineRegisterInfo &MRI,
+                      MachineIRBuilder &MIRBuilder) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_LEGALIZER_INFO_H
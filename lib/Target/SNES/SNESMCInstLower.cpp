@@ -15,10 +15,13 @@
 #include "SNESMCInstLower.h"
 
 #include "SNESInstrInfo.h"
+#include "SNESTargetObjectFile.h"
 #include "MCTargetDesc/SNESMCExpr.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
 
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/IR/Mangler.h"
+#include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCInst.h"
 #include "llvm/Support/ErrorHandling.h"
 
@@ -27,6 +30,12 @@ namespace llvm {
 MCOperand SNESMCInstLower::lowerSymbolOperand(const MachineOperand &MO,
                                              MCSymbol *Sym) const {
   unsigned char TF = MO.getTargetFlags();
+
+  // Calls from another bank go through the far entry of the function.
+  if (TF & SNESII::MO_FAR) {
+    Sym = Ctx.getOrCreateSymbol(Sym->getName() + ".far");
+    TF &= ~SNESII::MO_FAR;
+  }
   const MCExpr *Expr = MCSymbolRefExpr::create(Sym, Ctx);
 
   bool IsNegated = false;
@@ -106,6 +115,24 @@ void SNESMCInstLower::lowerInstruction(const MachineInstr &MI, MCInst &OutMI) co
 
     OutMI.addOperand(MCOp);
   }
+
+  // A JSR the assembler finds out of the bank is relaxed into a JSL to the
+  // far entry, which is given as an extra operand. Without it, the callee
+  // has no far entry and is always in the same bank.
+  if (MI.getOpcode() == SNES::JSRabs) {
+    const MachineOperand &MO = MI.getOperand(0);
+    const auto *F = MO.isGlobal() ? dyn_cast<Function>(MO.getGlobal())
+                                  : nullptr;
+    const auto *Ref = dyn_cast<MCSymbolRefExpr>(OutMI.getOperand(0).getExpr());
+
+    if (Ref && (MO.isSymbol() ||
+                (F && SNESTargetObjectFile::needsFarEntry(*F)))) {
+      MCSymbol *FarSym =
+          Ctx.getOrCreateSymbol(Ref->getSymbol().getName() + ".far");
+      OutMI.addOperand(
+          MCOperand::createExpr(MCSymbolRefExpr::create(FarSym, Ctx)));
+    }
+  }
 }
 
 } // end of namespace llvm
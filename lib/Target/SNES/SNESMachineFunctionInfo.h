@@ -39,14 +39,18 @@ class SNESMachineFunctionInfo : public MachineFunctionInfo {
   /// FrameIndex for start of varargs area.
   int VarArgsFrameIndex;
 
+  /// Size of the incoming arguments passed on the stack, which a tail call
+  /// may reuse for its own arguments.
+  unsigned ArgumentStackSize;
+
 public:
   SNESMachineFunctionInfo()
       : HasSpills(false), HasAllocas(false), HasStackArgs(false),
-        CalleeSavedFrameSize(0), VarArgsFrameIndex(0) {}
+        CalleeSavedFrameSize(0), VarArgsFrameIndex(0), ArgumentStackSize(0) {}
 
   explicit SNESMachineFunctionInfo(MachineFunction &MF)
       : HasSpills(false), HasAllocas(false), HasStackArgs(false),
-        CalleeSavedFrameSize(0), VarArgsFrameIndex(0) {}
+        CalleeSavedFrameSize(0), VarArgsFrameIndex(0), ArgumentStackSize(0) {}
 
   bool getHasSpills() const { return HasSpills; }
   void setHasSpills(bool B) { HasSpills = B; }
@@ -62,6 +66,9 @@ public:
 
   int getVarArgsFrameIndex() const { return VarArgsFrameIndex; }
   void setVarArgsFrameIndex(int Idx) { VarArgsFrameIndex = Idx; }
+
+  unsigned getArgumentStackSize() const { return ArgumentStackSize; }
+  void setArgumentStackSize(unsigned Bytes) { ArgumentStackSize = Bytes; }
 };
 
 } // end llvm namespace
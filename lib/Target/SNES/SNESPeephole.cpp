@@ -0,0 +1,517 @@
+//===-- SNESPeephole.cpp - Remove redundant loads, stores and flags -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which removes the loads, stores and flag changes
+// that have no effect, in the final code.
+//
+// Within a block the pass follows what is known about the flags in P and
+// what A, X and Y hold: a constant, or for A the contents of a direct page,
+// absolute or long address. With that it removes:
+//
+//   * a load of what the register already holds, `STA x; LDA x`,
+//   * a store of what the location already holds, `LDA x; STA x`,
+//   * a CLC, SEC, REP or SEP which sets flags to what they already are, like
+//     a second CLC with only loads, stores and logic in between,
+//   * a flag instruction whose bits are all changed by the next one, like
+//     the `CLD; SED` between two BCD adds, and merges two REPs or two SEPs
+//     in a row.
+//
+// Loads set N and Z, so they are only removed when nothing tests the flags.
+// Volatile accesses are left alone. The transfers between A, X and Y are
+// handled before, by SNESTransferOpt.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESTargetMachine.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "snes-peephole"
+
+STATISTIC(NumLoadsRemoved, "Number of redundant loads removed");
+STATISTIC(NumStoresRemoved, "Number of redundant stores removed");
+STATISTIC(NumFlagOpsRemoved, "Number of redundant flag instructions removed");
+STATISTIC(NumFlagOpsMerged, "Number of REP and SEP merged with the next one");
+
+#define SNES_PEEPHOLE_NAME "SNES peephole optimization pass"
+
+namespace {
+
+/// What a register is known to hold.
+struct RegValue {
+  enum Kind { Unknown, Imm, Dp, Abs, Long };
+
+  Kind K;
+  /// Whether the whole word is known, or only the low byte.
+  bool IsWord;
+  /// The constant or address, in the instruction which loaded or stored it.
+  const MachineOperand *Op;
+
+  RegValue() : K(Unknown), IsWord(false), Op(nullptr) {}
+  RegValue(Kind K, bool IsWord, const MachineOperand *Op)
+      : K(K), IsWord(IsWord), Op(Op) {}
+
+  bool isMemory() const { return K != Unknown && K != Imm; }
+
+  /// Checks if the register holds \p V, or a word whose low byte is \p V.
+  bool covers(const RegValue &V) const {
+    if (K == Unknown || K != V.K || (V.IsWord && !IsWord))
+      return false;
+    if (K == Imm && Op->isImm() && V.Op->isImm()) {
+      int64_t Mask = V.IsWord ? 0xFFFF : 0xFF;
+      return (Op->getImm() & Mask) == (V.Op->getImm() & Mask);
+    }
+    return Op->isIdenticalTo(*V.Op);
+  }
+};
+
+/// A load of a constant or a load or store of A.
+struct Access {
+  unsigned Reg;
+  bool IsStore;
+  RegValue Value;
+};
+
+class SNESPeephole : public MachineFunctionPass {
+public:
+  static char ID;
+
+  SNESPeephole() : MachineFunctionPass(ID) {
+    initializeSNESPeepholePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return SNES_PEEPHOLE_NAME; }
+
+private:
+  typedef MachineBasicBlock Block;
+  typedef Block::iterator BlockIt;
+
+  const TargetRegisterInfo *TRI;
+
+  /// The bits of P with a known value, and their values.
+  unsigned KnownFlags, FlagValues;
+  /// What A, X and Y hold.
+  RegValue A, X, Y;
+  /// The flag instruction right before the current one, if any, and the
+  /// flags known before it.
+  MachineInstr *LastFlagOp;
+  unsigned LastKnownFlags, LastFlagValues;
+
+  static bool getFlagOp(const MachineInstr &MI, unsigned &Mask,
+                        unsigned &Bits);
+  static bool preservesCarry(const MachineInstr &MI);
+  static bool getAccess(const MachineInstr &MI, Access &Acc);
+
+  RegValue &getValue(unsigned Reg);
+  void resetBlock(Block &MBB);
+  bool optimizeFlagOp(MachineInstr &MI, unsigned Mask, unsigned Bits);
+  bool optimizeAccess(Block &MBB, MachineInstr &MI, const Access &Acc);
+  void update(const MachineInstr &MI);
+  bool optimizeBlock(Block &MBB);
+};
+
+char SNESPeephole::ID = 0;
+
+/// Gets the bits of P an instruction sets or clears, and their new value.
+bool SNESPeephole::getFlagOp(const MachineInstr &MI, unsigned &Mask,
+                             unsigned &Bits) {
+  switch (MI.getOpcode()) {
+  case SNES::CLC:
+    Mask = SNESII::CFlag, Bits = 0;
+    return true;
+  case SNES::SEC:
+    Mask = Bits = SNESII::CFlag;
+    return true;
+  case SNES::CLD:
+    Mask = SNESII::DFlag, Bits = 0;
+    return true;
+  case SNES::SED:
+    Mask = Bits = SNESII::DFlag;
+    return true;
+  case SNES::CLI:
+    Mask = SNESII::IFlag, Bits = 0;
+    return true;
+  case SNES::SEI:
+    Mask = Bits = SNESII::IFlag;
+    return true;
+  case SNES::CLV:
+    Mask = SNESII::VFlag, Bits = 0;
+    return true;
+  case SNES::REP:
+    Mask = MI.getOperand(0).getImm() & 0xFF, Bits = 0;
+    return true;
+  case SNES::SEP:
+    Mask = Bits = MI.getOperand(0).getImm() & 0xFF;
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Checks if an instruction which sets N and Z leaves C and V alone.
+bool SNESPeephole::preservesCarry(const MachineInstr &MI) {
+  unsigned Dst, Src;
+  if (SNESInstrInfo::isTransfer(MI, Dst, Src))
+    return true;
+
+  switch (MI.getOpcode()) {
+  case SNES::LDAimm8:
+  case SNES::LDAimm16:
+  case SNES::LDXimm8:
+  case SNES::LDXimm16:
+  case SNES::LDYimm8:
+  case SNES::LDYimm16:
+  case SNES::LDAdp8:
+  case SNES::LDAdp16:
+  case SNES::LDAabs8:
+  case SNES::LDAabs16:
+  case SNES::LDAlong8:
+  case SNES::LDAlong16:
+  case SNES::LDAdpx8:
+  case SNES::LDAdpx16:
+  case SNES::LDAabsx8:
+  case SNES::LDAabsx16:
+  case SNES::LDAabsy8:
+  case SNES::LDAabsy16:
+  case SNES::LDAindy8:
+  case SNES::LDAindy16:
+  case SNES::LDYabsx8:
+  case SNES::LDYabsx16:
+  case SNES::ANDimm8:
+  case SNES::ANDimm16:
+  case SNES::ANDdp8:
+  case SNES::ANDdp16:
+  case SNES::ANDabs8:
+  case SNES::ANDabs16:
+  case SNES::ORAimm8:
+  case SNES::ORAimm16:
+  case SNES::ORAdp8:
+  case SNES::ORAdp16:
+  case SNES::ORAabs8:
+  case SNES::ORAabs16:
+  case SNES::EORimm8:
+  case SNES::EORimm16:
+  case SNES::EORdp8:
+  case SNES::EORdp16:
+  case SNES::EORabs8:
+  case SNES::EORabs16:
+  case SNES::INA:
+  case SNES::DEA:
+  case SNES::INX:
+  case SNES::DEX:
+  case SNES::INY:
+  case SNES::DEY:
+  case SNES::DEXr:
+  case SNES::DEYr:
+  case SNES::INCdp8:
+  case SNES::INCdp16:
+  case SNES::INCabs8:
+  case SNES::INCabs16:
+  case SNES::DECdp8:
+  case SNES::DECdp16:
+  case SNES::DECabs8:
+  case SNES::DECabs16:
+  case SNES::TSBdp8:
+  case SNES::TSBdp16:
+  case SNES::TSBabs8:
+  case SNES::TSBabs16:
+  case SNES::TRBdp8:
+  case SNES::TRBdp16:
+  case SNES::TRBabs8:
+  case SNES::TRBabs16:
+  case SNES::TDC:
+  case SNES::TSC:
+  case SNES::TSX:
+  case SNES::XBA:
+  case SNES::PLB:
+  case SNES::PLX:
+  case SNES::PLY:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool SNESPeephole::getAccess(const MachineInstr &MI, Access &Acc) {
+  unsigned Reg = SNES::A, AddrIdx = 1;
+  bool IsStore = false, IsWord = true;
+  RegValue::Kind K;
+
+  switch (MI.getOpcode()) {
+  case SNES::LDAimm8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDAimm16:
+    K = RegValue::Imm;
+    break;
+  case SNES::LDXimm8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDXimm16:
+    K = RegValue::Imm, Reg = SNES::X;
+    break;
+  case SNES::LDYimm8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDYimm16:
+    K = RegValue::Imm, Reg = SNES::Y;
+    break;
+  case SNES::LDAdp8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDAdp16:
+    K = RegValue::Dp;
+    break;
+  case SNES::LDAabs8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDAabs16:
+    K = RegValue::Abs;
+    break;
+  case SNES::LDAlong8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::LDAlong16:
+    K = RegValue::Long;
+    break;
+  case SNES::STAdp8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::STAdp16:
+    K = RegValue::Dp, IsStore = true, AddrIdx = 0;
+    break;
+  case SNES::STAabs8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::STAabs16:
+    K = RegValue::Abs, IsStore = true, AddrIdx = 0;
+    break;
+  case SNES::STAlong8:
+    IsWord = false;
+    LLVM_FALLTHROUGH;
+  case SNES::STAlong16:
+    K = RegValue::Long, IsStore = true, AddrIdx = 0;
+    break;
+  default:
+    return false;
+  }
+
+  // A volatile access may be to a hardware register, which does not hold
+  // what was stored to it. Constants have no memory operands, which
+  // hasOrderedMemoryRef() takes as volatile.
+  if (K != RegValue::Imm && MI.hasOrderedMemoryRef())
+    return false;
+
+  Acc.Reg = Reg;
+  Acc.IsStore = IsStore;
+  Acc.Value = RegValue(K, IsWord, &MI.getOperand(AddrIdx));
+  return true;
+}
+
+RegValue &SNESPeephole::getValue(unsigned Reg) {
+  switch (Reg) {
+  case SNES::A:
+    return A;
+  case SNES::X:
+    return X;
+  default:
+    assert(Reg == SNES::Y && "Not one of A, X and Y!");
+    return Y;
+  }
+}
+
+void SNESPeephole::resetBlock(Block &MBB) {
+  const MachineFunction &MF = *MBB.getParent();
+
+  // Only the widths and D are known on entry to a function, M, X and D are
+  // clear at calls. An interrupt can come in with any width, but always
+  // clears D.
+  KnownFlags = FlagValues = 0;
+  if (&MBB == &MF.front()) {
+    KnownFlags = SNESII::DFlag;
+    if (!SNES::isInterruptHandler(*MF.getFunction()))
+      KnownFlags |= SNESII::MFlag | SNESII::XFlag;
+  }
+
+  A = X = Y = RegValue();
+  LastFlagOp = nullptr;
+}
+
+bool SNESPeephole::optimizeFlagOp(MachineInstr &MI, unsigned Mask,
+                                  unsigned Bits) {
+  unsigned PrevKnownFlags = KnownFlags, PrevFlagValues = FlagValues;
+  unsigned Same = KnownFlags & ~(FlagValues ^ Bits);
+  KnownFlags |= Mask;
+  FlagValues = (FlagValues & ~Mask) | Bits;
+
+  if ((Mask & ~Same) == 0) {
+    MI.eraseFromParent();
+    ++NumFlagOpsRemoved;
+    return true;
+  }
+
+  if (!LastFlagOp) {
+    LastFlagOp = &MI;
+    LastKnownFlags = PrevKnownFlags;
+    LastFlagValues = PrevFlagValues;
+    return false;
+  }
+
+  unsigned LastMask, LastBits;
+  getFlagOp(*LastFlagOp, LastMask, LastBits);
+
+  // `REP #$20; SEP #$20` only needs the SEP, and `SED; CLD; SED` only the
+  // first SED.
+  if ((LastMask & ~Mask) == 0) {
+    LastFlagOp->eraseFromParent();
+    ++NumFlagOpsMerged;
+    if ((Mask & ~(LastKnownFlags & ~(LastFlagValues ^ Bits))) == 0) {
+      MI.eraseFromParent();
+      ++NumFlagOpsRemoved;
+      LastFlagOp = nullptr;
+      return true;
+    }
+    LastFlagOp = &MI;
+    return true;
+  }
+
+  // `REP #$20; REP #$01` is `REP #$21`.
+  if (LastFlagOp->getOpcode() == MI.getOpcode() &&
+      (MI.getOpcode() == SNES::REP || MI.getOpcode() == SNES::SEP)) {
+    LastFlagOp->getOperand(0).setImm(LastMask | Mask);
+    MI.eraseFromParent();
+    ++NumFlagOpsMerged;
+    return true;
+  }
+
+  LastFlagOp = &MI;
+  LastKnownFlags = PrevKnownFlags;
+  LastFlagValues = PrevFlagValues;
+  return false;
+}
+
+bool SNESPeephole::optimizeAccess(Block &MBB, MachineInstr &MI,
+                                  const Access &Acc) {
+  RegValue &Reg = getValue(Acc.Reg);
+
+  if (Acc.IsStore) {
+    // The location already holds A, nothing else was stored since.
+    if (Reg.covers(Acc.Value)) {
+      MI.eraseFromParent();
+      ++NumStoresRemoved;
+      return true;
+    }
+
+    // A is what is at the address now, and only there.
+    Reg = Acc.Value;
+    return false;
+  }
+
+  if (Reg.covers(Acc.Value) &&
+      !SNESInstrInfo::isNZReadAfter(MBB, BlockIt(MI))) {
+    MI.eraseFromParent();
+    ++NumLoadsRemoved;
+    return true;
+  }
+
+  Reg = Acc.Value;
+  return false;
+}
+
+/// Forgets what an instruction changes.
+void SNESPeephole::update(const MachineInstr &MI) {
+  if (MI.isCall()) {
+    KnownFlags = SNESII::MFlag | SNESII::XFlag | SNESII::DFlag;
+    FlagValues = 0;
+    A = X = Y = RegValue();
+    return;
+  }
+
+  if (MI.isInlineAsm() || MI.getOpcode() == SNES::PLP ||
+      MI.getOpcode() == SNES::XCE) {
+    KnownFlags = 0;
+  } else if (MI.definesRegister(SNES::P)) {
+    KnownFlags &= ~(SNESII::NFlag | SNESII::ZFlag);
+    if (!preservesCarry(MI))
+      KnownFlags &= ~(SNESII::CFlag | SNESII::VFlag);
+  }
+
+  if (MI.modifiesRegister(SNES::A, TRI))
+    A = RegValue();
+  if (MI.modifiesRegister(SNES::X, TRI))
+    X = RegValue();
+  if (MI.modifiesRegister(SNES::Y, TRI))
+    Y = RegValue();
+
+  // The direct page and absolute addresses move with D and DB.
+  if (A.isMemory() && (MI.mayStore() || MI.isInlineAsm() ||
+                       MI.getOpcode() == SNES::TCD ||
+                       MI.modifiesRegister(SNES::DB, TRI)))
+    A = RegValue();
+}
+
+bool SNESPeephole::optimizeBlock(Block &MBB) {
+  bool Modified = false;
+  resetBlock(MBB);
+
+  for (BlockIt MBBI = MBB.begin(), E = MBB.end(); MBBI != E;) {
+    MachineInstr &MI = *MBBI++;
+    if (MI.isDebugValue())
+      continue;
+
+    unsigned Mask, Bits;
+    if (getFlagOp(MI, Mask, Bits)) {
+      Modified |= optimizeFlagOp(MI, Mask, Bits);
+      continue;
+    }
+    LastFlagOp = nullptr;
+
+    Access Acc;
+    if (getAccess(MI, Acc)) {
+      if (!Acc.IsStore)
+        KnownFlags &= ~(SNESII::NFlag | SNESII::ZFlag);
+      Modified |= optimizeAccess(MBB, MI, Acc);
+      continue;
+    }
+
+    update(MI);
+  }
+
+  return Modified;
+}
+
+bool SNESPeephole::runOnMachineFunction(MachineFunction &MF) {
+  TRI = MF.getSubtarget<SNESSubtarget>().getRegisterInfo();
+
+  bool Modified = false;
+  for (Block &MBB : MF)
+    Modified |= optimizeBlock(MBB);
+  return Modified;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESPeephole, "snes-peephole", SNES_PEEPHOLE_NAME, false,
+                false)
+
+namespace llvm {
+
+FunctionPass *createSNESPeepholePass() { return new SNESPeephole(); }
+
+} // end of namespace llvm
@@ -0,0 +1,162 @@
+//===-- SNESRegisterBankInfo.cpp - SNES register banks --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the targeting of the RegisterBankInfo class for SNES.
+//
+// The mapping only looks at types: pointers go to the index bank, where they
+// can be used with `abs,X` or kept out of the way of the accumulator, and
+// everything else to the accumulator bank, as a byte or a word. RegBankSelect
+// inserts the TAX/TXA copies where the two meet.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNESRegisterBankInfo.h"
+
+#include "llvm/CodeGen/GlobalISel/RegisterBank.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+#include "SNESRegisterInfo.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#define GET_TARGET_REGBANK_IMPL
+#include "SNESGenRegisterBank.inc"
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+#error "This shouldn't be built without GISel"
+#endif
+
+namespace llvm {
+namespace SNES {
+
+enum PartialMappingIdx { PMI_Acc8, PMI_Acc16, PMI_Index16 };
+
+RegisterBankInfo::PartialMapping PartMappings[] = {
+    // A byte in AL, XL or YL.
+    {0, 8, AccRegBank},
+    // A word in A, X or Y.
+    {0, 16, AccRegBank},
+    // A pointer in X or Y.
+    {0, 16, IndexRegBank},
+};
+
+RegisterBankInfo::ValueMapping ValueMappings[] = {
+    {&PartMappings[PMI_Acc8], 1},
+    {&PartMappings[PMI_Acc16], 1},
+    {&PartMappings[PMI_Index16], 1},
+};
+
+} // end namespace SNES
+} // end namespace llvm
+
+using namespace llvm;
+
+/// The bank and width of a value of type \p Ty, or null if no register holds
+/// it.
+static const RegisterBankInfo::ValueMapping *getTypeMapping(LLT Ty) {
+  if (Ty.isPointer())
+    return &SNES::ValueMappings[SNES::PMI_Index16];
+
+  if (!Ty.isScalar() || Ty.getSizeInBits() > 16)
+    return nullptr;
+
+  // Conditions, s1, live in a byte.
+  return &SNES::ValueMappings[Ty.getSizeInBits() <= 8 ? SNES::PMI_Acc8
+                                                        : SNES::PMI_Acc16];
+}
+
+SNESRegisterBankInfo::SNESRegisterBankInfo(const TargetRegisterInfo &TRI)
+    : SNESGenRegisterBankInfo() {
+  const RegisterBank &RBAcc = getRegBank(SNES::AccRegBankID);
+  const RegisterBank &RBIndex = getRegBank(SNES::IndexRegBankID);
+  (void)RBAcc;
+  (void)RBIndex;
+
+  assert(&SNES::AccRegBank == &RBAcc && "The order in RegBanks is messed up");
+  assert(RBAcc.covers(*TRI.getRegClass(SNES::MainRegsRegClassID)) &&
+         RBAcc.covers(*TRI.getRegClass(SNES::MainLoRegsRegClassID)) &&
+         "Subclass not added?");
+  assert(RBIndex.covers(*TRI.getRegClass(SNES::IndexRegsRegClassID)) &&
+         "Subclass not added?");
+  assert(RBAcc.getSize() == 16 && RBIndex.getSize() == 16 &&
+         "The registers are 16-bit wide");
+}
+
+const RegisterBank &SNESRegisterBankInfo::getRegBankFromRegClass(
+    const TargetRegisterClass &RC) const {
+  switch (RC.getID()) {
+  case SNES::IndexRegsRegClassID:
+  case SNES::IndexXRegsRegClassID:
+  case SNES::IndexYRegsRegClassID:
+  case SNES::StackPointerRegsRegClassID:
+    return getRegBank(SNES::IndexRegBankID);
+  case SNES::MainRegsRegClassID:
+  case SNES::MainLoRegsRegClassID:
+  case SNES::AccRegsRegClassID:
+  case SNES::Acc8RegsRegClassID:
+  case SNES::Index8RegsRegClassID:
+  case SNES::IndexX8RegsRegClassID:
+  case SNES::IndexY8RegsRegClassID:
+    return getRegBank(SNES::AccRegBankID);
+  default:
+    llvm_unreachable("Unsupported register kind");
+  }
+}
+
+const TargetRegisterClass *
+SNESRegisterBankInfo::getRegClassFor(const RegisterBank &RB, unsigned Size) {
+  if (RB.getID() == SNES::IndexRegBankID)
+    return Size == 16 ? &SNES::IndexRegsRegClass : nullptr;
+
+  if (Size <= 8)
+    return &SNES::MainLoRegsRegClass;
+  if (Size == 16)
+    return &SNES::MainRegsRegClass;
+  return nullptr;
+}
+
+const RegisterBankInfo::InstructionMapping &
+SNESRegisterBankInfo::getInstrMapping(const MachineInstr &MI) const {
+  unsigned Opc = MI.getOpcode();
+
+  // Try the default logic for non-generic instructions that are either copies
+  // or already have some operands assigned to banks.
+  if (!isPreISelGenericOpcode(Opc)) {
+    const InstructionMapping &Mapping = getInstrMappingImpl(MI);
+    if (Mapping.isValid())
+      return Mapping;
+  }
+
+  const MachineFunction &MF = *MI.getParent()->getParent();
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  unsigned NumOperands = MI.getNumOperands();
+
+  SmallVector<const ValueMapping *, 4> OpdsMapping(NumOperands, nullptr);
+  for (unsigned Idx = 0; Idx != NumOperands; ++Idx) {
+    const MachineOperand &MO = MI.getOperand(Idx);
+    if (!MO.isReg() || !MO.getReg())
+      continue;
+
+    LLT Ty = MRI.getType(MO.getReg());
+    if (!Ty.isValid())
+      continue;
+
+    OpdsMapping[Idx] = getTypeMapping(Ty);
+    if (!OpdsMapping[Idx])
+      return getInvalidInstructionMapping();
+  }
+
+  // An offset added to a pointer is address arithmetic, keep it with the
+  // pointer.
+  if (Opc == TargetOpcode::G_GEP)
+    OpdsMapping[2] = &SNES::ValueMappings[SNES::PMI_Index16];
+
+  return getInstructionMapping(DefaultMappingID, /*Cost=*/1,
+                               getOperandsMapping(OpdsMapping), NumOperands);
+}
@@ -0,0 +1,53 @@
+//===-- SNESRegisterBankInfo.h - SNES register banks --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the targeting of the RegisterBankInfo class for SNES.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_REGISTER_BANK_INFO_H
+#define LLVM_SNES_REGISTER_BANK_INFO_H
+
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+
+#define GET_REGBANK_DECLARATIONS
+#include "SNESGenRegisterBank.inc"
+
+namespace llvm {
+
+class TargetRegisterInfo;
+
+class SNESGenRegisterBankInfo : public RegisterBankInfo {
+#define GET_TARGET_REGBANK_CLASS
+#include "SNESGenRegisterBank.inc"
+};
+
+/// Places values in the accumulator bank and pointers in the index bank.
+///
+/// The width of a value in the accumulator bank is the width of its type, a
+/// byte or a word. Pointers are always words.
+class SNESRegisterBankInfo final : public SNESGenRegisterBankInfo {
+public:
+  SNESRegisterBankInfo(const TargetRegisterInfo &TRI);
+
+  const RegisterBank &
+  getRegBankFromRegClass(const TargetRegisterClass &RC) const override;
+
+  const InstructionMapping &
+  getInstrMapping(const MachineInstr &MI) const override;
+
+  /// The register class a virtual register of \p Size bits in \p RB is
+  /// given once selected.
+  static const TargetRegisterClass *getRegClassFor(const RegisterBank &RB,
+                                                   unsigned Size);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_REGISTER_BANK_INFO_H
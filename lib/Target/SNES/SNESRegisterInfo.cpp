@@ -17,6 +17,8 @@
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/VirtRegMap.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Target/TargetFrameLowering.h"
 
@@ -34,7 +36,8 @@ SNESRegisterInfo::SNESRegisterInfo() : SNESGenRegisterInfo(0) {}
 
 const uint16_t *
 SNESRegisterInfo::getCalleeSavedRegs(const MachineFunction *MF) const {
-  return CSR_Normal_SaveList;
+  return SNES::isInterruptHandler(*MF->getFunction()) ? CSR_Interrupts_SaveList
+                                                      : CSR_Normal_SaveList;
 }
 
 const uint32_t *
@@ -75,9 +78,123 @@ SNESRegisterInfo::getLargestLegalSuperClass(const TargetRegisterClass *RC,
     return &SNES::MainRegsRegClass;
   }
 
+  if (TRI->isTypeLegalForClass(*RC, MVT::i8)) {
+    return &SNES::MainLoRegsRegClass;
+  }
+
   llvm_unreachable("Invalid register size");
 }
 
+/// The stack pointer and the direct page register are only copied to and
+/// from A, with TSC/TCS and TDC/TCD.
+const TargetRegisterClass *
+SNESRegisterInfo::getCrossCopyRegClass(const TargetRegisterClass *RC) const {
+  if (RC == &SNES::StackPointerRegsRegClass ||
+      RC == &SNES::DirectPageRegsRegClass)
+    return &SNES::AccRegsRegClass;
+  return RC;
+}
+
+/// The 16-bit register of A, X or Y, or of their low bytes.
+static unsigned getWordReg(const SNESRegisterInfo &TRI, unsigned Reg) {
+  if (SNES::MainRegsRegClass.contains(Reg))
+    return Reg;
+  if (SNES::MainLoRegsRegClass.contains(Reg))
+    return TRI.getMatchingSuperReg(Reg, SNES::sub_lo, &SNES::MainRegsRegClass);
+  return 0;
+}
+
+/// Only A does arithmetic and only X and Y index memory, every other use of
+/// them costs a transfer. The registers a virtual register would rather be
+/// in are weighted by the operands which name A, X or Y, directly or through
+/// the class of the register at the other end of a copy.
+void SNESRegisterInfo::getRegAllocationHints(unsigned VirtReg,
+                                             ArrayRef<MCPhysReg> Order,
+                                             SmallVectorImpl<MCPhysReg> &Hints,
+                                             const MachineFunction &MF,
+                                             const VirtRegMap *VRM,
+                                             const LiveRegMatrix *Matrix) const {
+  // A copy hint removes the copy, which beats anything below.
+  TargetRegisterInfo::getRegAllocationHints(VirtReg, Order, Hints, MF, VRM,
+                                            Matrix);
+
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
+  DenseMap<unsigned, unsigned> Weight;
+
+  auto AddClass = [&](const TargetRegisterClass *RC) {
+    // MainRegs and MainLoRegs say nothing.
+    if (!RC || RC->getNumRegs() >= SNES::MainRegsRegClass.getNumRegs())
+      return;
+    for (MCPhysReg Reg : *RC)
+      if (unsigned Word = getWordReg(*this, Reg))
+        ++Weight[Word];
+  };
+
+  for (const MachineOperand &MO : MRI.reg_nodbg_operands(VirtReg)) {
+    const MachineInstr &MI = *MO.getParent();
+    if (!MI.isCopy()) {
+      AddClass(MI.getRegClassConstraint(MI.getOperandNo(&MO), TII, this));
+      continue;
+    }
+
+    unsigned Other = MI.getOperand(MO.isDef() ? 1 : 0).getReg();
+    if (isVirtualRegister(Other) && VRM && VRM->hasPhys(Other))
+      Other = VRM->getPhys(Other);
+
+    if (isPhysicalRegister(Other)) {
+      if (unsigned Word = getWordReg(*this, Other))
+        ++Weight[Word];
+    } else if (isVirtualRegister(Other)) {
+      AddClass(MRI.getRegClass(Other));
+    }
+  }
+
+  SmallVector<MCPhysReg, 3> Weighted;
+  for (MCPhysReg Reg : Order)
+    if (Weight.lookup(getWordReg(*this, Reg)) && !is_contained(Hints, Reg) &&
+        !MRI.isReserved(Reg))
+      Weighted.push_back(Reg);
+
+  std::stable_sort(Weighted.begin(), Weighted.end(),
+                   [&](MCPhysReg L, MCPhysReg R) {
+                     return Weight.lookup(getWordReg(*this, L)) >
+                            Weight.lookup(getWordReg(*this, R));
+                   });
+  Hints.append(Weighted.begin(), Weighted.end());
+}
+
+/// Joining a copy into A pins the whole live range there. A is needed by
+/// nearly every instruction, so a value which lives past the block of the copy
+/// is better left where it is, and moved with a transfer when A is free, than
+/// spilled when it is not.
+bool SNESRegisterInfo::shouldCoalesce(MachineInstr *MI,
+                                      const TargetRegisterClass *SrcRC,
+                                      unsigned SubReg,
+                                      const TargetRegisterClass *DstRC,
+                                      unsigned DstSubReg,
+                                      const TargetRegisterClass *NewRC) const {
+  if (NewRC != &SNES::AccRegsRegClass && NewRC != &SNES::Acc8RegsRegClass)
+    return true;
+
+  const MachineRegisterInfo &MRI = MI->getParent()->getParent()->getRegInfo();
+  for (const MachineOperand &MO : MI->operands()) {
+    if (!MO.isReg() || !isVirtualRegister(MO.getReg()))
+      continue;
+
+    // The register which is already in A has nothing to lose.
+    const TargetRegisterClass *RC = MRI.getRegClass(MO.getReg());
+    if (RC == &SNES::AccRegsRegClass || RC == &SNES::Acc8RegsRegClass)
+      continue;
+
+    for (const MachineInstr &UseMI : MRI.reg_nodbg_instructions(MO.getReg()))
+      if (UseMI.getParent() != MI->getParent())
+        return false;
+  }
+
+  return true;
+}
+
 void SNESRegisterInfo::eliminateFrameIndex(MachineBasicBlock::iterator II,
                                           int SPAdj, unsigned FIOperandNum,
                                           RegScavenger *RS) const {
@@ -98,11 +215,26 @@ void SNESRegisterInfo::eliminateFrameIndex(MachineBasicBlock::iterator II,
   // Fold incoming offset.
   Offset += MI.getOperand(FIOperandNum + 1).getImm();
 
+  // Folded reloads address the slot relative to S directly.
+  if (SNESInstrInfo::isStackRelative(MI)) {
+    MI.getOperand(FIOperandNum).ChangeToRegister(SNES::SP, false);
+    assert(isUInt<8>(Offset) && "Offset is out of range");
+    MI.getOperand(FIOperandNum + 1).ChangeToImmediate(Offset);
+    return;
+  }
+
   MI.getOperand(FIOperandNum).ChangeToRegister(SNES::A, false);
   assert(isUInt<6>(Offset) && "Offset is out of range");
   MI.getOperand(FIOperandNum + 1).ChangeToImmediate(Offset);
 }
 
+/// The post-RA passes look at the live-ins of the successors, e.g. to tell
+/// if P is tested after a block.
+bool SNESRegisterInfo::trackLivenessAfterRegAlloc(
+    const MachineFunction &MF) const {
+  return true;
+}
+
 unsigned SNESRegisterInfo::getFrameRegister(const MachineFunction &MF) const {
   const TargetFrameLowering *TFI = MF.getSubtarget().getFrameLowering();
   if (TFI->hasFP(MF)) {
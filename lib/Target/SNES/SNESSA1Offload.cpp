@@ -0,0 +1,303 @@
+//===-- SNESSA1Offload.cpp - Call SA-1 functions through the mailbox ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which splits the program between the S-CPU and
+// the SA-1 core of the cartridge.
+//
+// Functions with the "snes-sa1" attribute run on the SA-1. The S-CPU cannot
+// jump into them, it writes the long address of the function to a mailbox in
+// I-RAM and hands the arguments to `__sa1_call` in the runtime, which wakes
+// up the SA-1 and waits for the result. Each call from S-CPU code is sent to
+// a stub doing this:
+//
+//   @f.sa1addr = private constant i32 ptrtoint (i8 (i8, i16)* @f to i32)
+//
+//   define internal i8 @f.sa1call(i8 %a, i16 %b) {
+//     %addr = load i32, i32* @f.sa1addr
+//     store volatile i32 %addr, i32* @__sa1_mailbox_fn
+//     %a.ext = zext i8 %a to i16
+//     %r = call i16 @__sa1_call(i16 %a.ext, i16 %b, i16 undef)
+//     %r.trunc = trunc i16 %r to i8
+//     ret i8 %r.trunc
+//   }
+//
+// The dispatcher on the SA-1 side passes the words back in A, X and Y, which
+// is where the calling convention expects the first three arguments. So the
+// functions have to take their arguments in registers: at most three of them,
+// and none wider than a word.
+//
+// The address in the table is the 24-bit one of the far entry of the
+// function, see SNESAsmPrinter::lowerConstant, which the SA-1 calls with a
+// JSL. A value can't hold more than the 16 bits of a pointer, so it is read
+// from a constant instead.
+//
+// Internal functions only called from the SA-1 run on it as well, so that
+// they are lowered for its core. Other functions the SA-1 calls are cloned
+// for it, since the S-CPU ones may use what the SA-1 can't reach, like the
+// multiplier at WRMPYA. A function the SA-1 calls which is not in the module
+// must have the attribute as well.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "snes-sa1-offload"
+
+#define SNES_SA1_OFFLOAD_NAME "SNES SA-1 call offloading pass"
+
+namespace {
+
+class SNESSA1Offload : public ModulePass {
+public:
+  static char ID;
+
+  SNESSA1Offload() : ModulePass(ID) {
+    initializeSNESSA1OffloadPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  StringRef getPassName() const override { return SNES_SA1_OFFLOAD_NAME; }
+
+private:
+  /// The number of words the mailbox passes to the SA-1.
+  static const unsigned NumArgs = 3;
+
+  /// Marks the internal functions only called from the SA-1.
+  bool propagateAttribute(Module &M);
+
+  /// Gives the SA-1 its own copies of the functions it calls which run on
+  /// the S-CPU.
+  bool cloneSharedCallees(Module &M);
+
+  /// Checks if a value of type \p Ty fits in a word of the mailbox.
+  static bool fitsInWord(Type *Ty);
+
+  /// Creates the S-CPU stub of \p F.
+  Function *createStub(Function &F, GlobalVariable *FnSlot, Function *Call);
+};
+
+char SNESSA1Offload::ID = 0;
+
+/// Checks if \p U is a direct call to its operand from a function on the
+/// SA-1.
+static bool isSA1Call(const Use &U) {
+  ImmutableCallSite CS(U.getUser());
+  if (!CS || !CS.isCallee(&U))
+    return false;
+
+  return SNES::isSA1Function(*CS.getInstruction()->getFunction());
+}
+
+bool SNESSA1Offload::propagateAttribute(Module &M) {
+  bool Changed = false;
+  bool LocalChange;
+  do {
+    LocalChange = false;
+    for (Function &F : M) {
+      if (!F.hasLocalLinkage() || F.isDeclaration() ||
+          SNES::isSA1Function(F) || SNES::isInterruptHandler(F) ||
+          F.use_empty())
+        continue;
+
+      if (!std::all_of(F.use_begin(), F.use_end(), isSA1Call))
+        continue;
+
+      DEBUG(dbgs() << "Running " << F.getName() << " on the SA-1\n");
+      F.addFnAttr("snes-sa1");
+      LocalChange = Changed = true;
+    }
+  } while (LocalChange);
+
+  return Changed;
+}
+
+bool SNESSA1Offload::cloneSharedCallees(Module &M) {
+  DenseMap<Function *, Function *> Clones;
+  SmallVector<Function *, 8> Worklist;
+  for (Function &F : M)
+    if (SNES::isSA1Function(F) && !F.isDeclaration())
+      Worklist.push_back(&F);
+
+  bool Changed = false;
+  while (!Worklist.empty()) {
+    Function *F = Worklist.pop_back_val();
+    for (Instruction &I : instructions(*F)) {
+      CallSite CS(&I);
+      Function *Callee = CS ? CS.getCalledFunction() : nullptr;
+      if (!Callee || Callee->isIntrinsic() || SNES::isSA1Function(*Callee))
+        continue;
+
+      if (Callee->isDeclaration() || Callee->isInterposable())
+        report_fatal_error("function '" + Callee->getName() +
+                           "' is called from the SA-1 function '" +
+                           F->getName() + "' but is compiled for the S-CPU, "
+                           "it must have the \"snes-sa1\" attribute");
+
+      Function *&Clone = Clones[Callee];
+      if (!Clone) {
+        ValueToValueMapTy VMap;
+        Clone = CloneFunction(Callee, VMap);
+        Clone->setName(Callee->getName() + ".sa1");
+        Clone->setLinkage(GlobalValue::InternalLinkage);
+        Clone->addFnAttr("snes-sa1");
+        Worklist.push_back(Clone);
+        DEBUG(dbgs() << "Cloning " << Callee->getName() << " for the SA-1\n");
+      }
+
+      CS.setCalledFunction(Clone);
+      Changed = true;
+    }
+  }
+
+  return Changed;
+}
+
+bool SNESSA1Offload::fitsInWord(Type *Ty) {
+  if (Ty->isPointerTy())
+    return true;
+
+  return Ty->isIntegerTy() && Ty->getIntegerBitWidth() <= 16;
+}
+
+Function *SNESSA1Offload::createStub(Function &F, GlobalVariable *FnSlot,
+                                     Function *Call) {
+  FunctionType *FTy = F.getFunctionType();
+  Type *AddrTy = FnSlot->getValueType();
+  Type *WordTy = Call->getReturnType();
+
+  if (FTy->isVarArg() || FTy->getNumParams() > NumArgs)
+    report_fatal_error("SA-1 function '" + F.getName() +
+                       "' must take at most " + Twine(NumArgs) +
+                       " arguments, and no variable arguments");
+
+  Type *RetTy = FTy->getReturnType();
+  if (!RetTy->isVoidTy() && !fitsInWord(RetTy))
+    report_fatal_error("SA-1 function '" + F.getName() +
+                       "' must return a value of at most 16 bits");
+
+  Function *Stub = Function::Create(FTy, GlobalValue::InternalLinkage,
+                                    F.getName() + ".sa1call", F.getParent());
+  Stub->copyAttributesFrom(&F);
+  Stub->removeFnAttr("snes-sa1");
+
+  auto *Addr = new GlobalVariable(
+      *F.getParent(), AddrTy, /*isConstant=*/true, GlobalValue::PrivateLinkage,
+      ConstantExpr::getPtrToInt(&F, AddrTy), F.getName() + ".sa1addr");
+  Addr->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+
+  IRBuilder<> Builder(BasicBlock::Create(F.getContext(), "entry", Stub));
+  Builder.CreateStore(Builder.CreateLoad(Addr), FnSlot, /*isVolatile=*/true);
+
+  SmallVector<Value *, NumArgs> Words;
+  for (Argument &Arg : Stub->args()) {
+    Type *Ty = Arg.getType();
+    if (!fitsInWord(Ty))
+      report_fatal_error("SA-1 function '" + F.getName() +
+                         "' must take arguments of at most 16 bits");
+
+    if (Ty->isPointerTy())
+      Words.push_back(Builder.CreatePtrToInt(&Arg, WordTy));
+    else if (Stub->hasParamAttribute(Arg.getArgNo(), Attribute::SExt))
+      Words.push_back(Builder.CreateSExt(&Arg, WordTy));
+    else
+      Words.push_back(Builder.CreateZExt(&Arg, WordTy));
+  }
+  Words.resize(NumArgs, UndefValue::get(WordTy));
+
+  Value *Result = Builder.CreateCall(Call, Words);
+  if (RetTy->isVoidTy())
+    Builder.CreateRetVoid();
+  else if (RetTy->isPointerTy())
+    Builder.CreateRet(Builder.CreateIntToPtr(Result, RetTy));
+  else
+    Builder.CreateRet(Builder.CreateTrunc(Result, RetTy));
+
+  return Stub;
+}
+
+bool SNESSA1Offload::runOnModule(Module &M) {
+  if (skipModule(M))
+    return false;
+
+  bool Changed = propagateAttribute(M);
+  Changed |= cloneSharedCallees(M);
+
+  SmallVector<Function *, 8> SA1Functions;
+  for (Function &F : M)
+    if (SNES::isSA1Function(F))
+      SA1Functions.push_back(&F);
+
+  if (SA1Functions.empty())
+    return Changed;
+
+  // Both live in the runtime, see Runtime/sa1.c.
+  LLVMContext &Ctx = M.getContext();
+  Type *WordTy = Type::getInt16Ty(Ctx);
+  auto *FnSlot = cast<GlobalVariable>(
+      M.getOrInsertGlobal("__sa1_mailbox_fn", Type::getInt32Ty(Ctx)));
+  auto *Call = cast<Function>(M.getOrInsertFunction(
+      "__sa1_call", FunctionType::get(WordTy, {WordTy, WordTy, WordTy},
+                                      /*isVarArg=*/false)));
+
+  for (Function *F : SA1Functions) {
+    if (SNES::isInterruptHandler(*F))
+      report_fatal_error("interrupt handler '" + F->getName() +
+                         "' cannot run on the SA-1");
+
+    // Calls from the SA-1 stay direct. Taking the address is left alone as
+    // well: only the SA-1 can call through it.
+    SmallVector<Use *, 8> MainCalls;
+    for (Use &U : F->uses()) {
+      ImmutableCallSite CS(U.getUser());
+      if (CS && CS.isCallee(&U) && !isSA1Call(U))
+        MainCalls.push_back(&U);
+    }
+
+    if (MainCalls.empty())
+      continue;
+
+    Function *Stub = createStub(*F, FnSlot, Call);
+    for (Use *U : MainCalls)
+      U->set(Stub);
+    Changed = true;
+  }
+
+  return Changed;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESSA1Offload, "snes-sa1-offload", SNES_SA1_OFFLOAD_NAME,
+                false, false)
+
+namespace llvm {
+
+ModulePass *createSNESSA1OffloadPass() { return new SNESSA1Offload(); }
+
+} // end of namespace llvm
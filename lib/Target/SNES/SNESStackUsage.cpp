@@ -0,0 +1,352 @@
+//===-- SNESStackUsage.cpp - Worst-case stack depth of a program ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the analysis of the stack and static RAM a whole program
+// uses.
+//
+// The stack and the direct page share the 8 KiB of low WRAM, and nothing
+// stops the stack from running into the variables below it. The report gives
+// the deepest the stack can get, so that the space reserved for it can be
+// cut down to what is needed, and -snes-stack-budget turns running over into
+// an error.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNESStackUsage.h"
+
+#include "SNES.h"
+#include "SNESTargetObjectFile.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/MCSectionELF.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetLoweringObjectFile.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace llvm;
+
+static cl::opt<std::string> StackReport(
+    "snes-stack-report", cl::Hidden, cl::init(""),
+    cl::desc("Write the worst-case stack depth and the static RAM map of the "
+             "program to this file, - for stdout"));
+
+static cl::opt<unsigned> StackBudget(
+    "snes-stack-budget", cl::Hidden, cl::init(0),
+    cl::desc("Fail when the stack may take more than this many bytes"));
+
+namespace {
+
+/// The bytes pushed to get into a function. JSR pushes a return address and
+/// JSL the bank too. A far call goes through the `JSR body; RTL` far entry of
+/// its callee, and the hardware pushes PB, PC and P for an interrupt.
+enum : unsigned { NearCallSize = 2, FarCallSize = 3 + 2, InterruptSize = 4 };
+
+/// The size of the direct page, where D is zero.
+enum : uint64_t { DirectPageSize = 256 };
+
+} // end of anonymous namespace
+
+/// The bytes an instruction pushes, or pulls when negative.
+static int getPushSize(unsigned Opcode) {
+  switch (Opcode) {
+  case SNES::PHAstk:
+  case SNES::PHX:
+  case SNES::PHY:
+  case SNES::PEA:
+    return 2;
+  case SNES::PHB:
+  case SNES::PHP:
+    return 1;
+  case SNES::PLX:
+  case SNES::PLY:
+    return -2;
+  case SNES::PLB:
+  case SNES::PLP:
+    return -1;
+  default:
+    return 0;
+  }
+}
+
+bool SNESStackUsage::isEnabled() {
+  return !StackReport.empty() || StackBudget != 0;
+}
+
+void SNESStackUsage::addFunction(const MachineFunction &MF) {
+  const Function &F = *MF.getFunction();
+  const MachineFrameInfo &MFI = MF.getFrameInfo();
+
+  FunctionUsage &Usage = Functions[F.getName()];
+  // The stack size has the callee saved registers in it already.
+  Usage.FrameSize = MFI.getStackSize();
+  Usage.MaxPushed = 0;
+  Usage.Calls.clear();
+  Usage.Unbounded =
+      MFI.hasVarSizedObjects() ? "has a variable sized object" : nullptr;
+  Usage.IsInterruptHandler = SNES::isInterruptHandler(F);
+  Usage.IsSA1Function = SNES::isSA1Function(F);
+
+  for (const MachineBasicBlock &MBB : MF) {
+    // The prologue and epilogue are in the frame size, and the pushes of the
+    // code are pulled again in the same block.
+    int Pushed = 0;
+    for (const MachineInstr &MI : MBB) {
+      if (MI.getFlag(MachineInstr::FrameSetup) ||
+          MI.getFlag(MachineInstr::FrameDestroy))
+        continue;
+
+      if (MI.isCall()) {
+        Call C;
+        C.Size = Pushed + FarCallSize;
+
+        const MachineOperand &Target = MI.getOperand(0);
+        if (Target.isGlobal()) {
+          const GlobalValue *GV = Target.getGlobal();
+          C.Callee = GV->getName();
+
+          // A JSR out of the module may be relaxed into a far call.
+          if (MI.getOpcode() == SNES::JSRabs && !GV->isDeclaration() &&
+              !SNESTargetObjectFile::isFarCall(F, GV,
+                                               /*HasStackArgs=*/false))
+            C.Size = Pushed + NearCallSize;
+        } else if (Target.isSymbol()) {
+          C.Callee = Target.getSymbolName();
+        }
+
+        // A tail call leaves with the frame popped and reuses the return
+        // address.
+        if (MI.getOpcode() == SNES::JMPabs)
+          C.Size = 0;
+
+        Usage.Calls.push_back(C);
+        continue;
+      }
+
+      if (int Size = getPushSize(MI.getOpcode())) {
+        Pushed = std::max(0, Pushed + Size);
+        Usage.MaxPushed = std::max(Usage.MaxPushed, unsigned(Pushed));
+      } else if (MI.definesRegister(SNES::SP)) {
+        // The arguments of a call are dropped by writing S.
+        Pushed = 0;
+      }
+    }
+  }
+}
+
+SNESStackUsage::Depth SNESStackUsage::getDepth(StringRef Name) {
+  auto Known = Depths.find(Name);
+  if (Known != Depths.end())
+    return Known->second;
+
+  Depth D;
+  D.Bytes = 0;
+  if (!Visiting.insert(Name).second) {
+    D.Unbounded = "'" + Name.str() + "' is recursive";
+    return D;
+  }
+
+  auto I = Functions.find(Name);
+  if (I == Functions.end()) {
+    D.Unbounded = "'" + Name.str() + "' is not in the module";
+  } else if (I->second.Unbounded) {
+    D.Unbounded = "'" + Name.str() + "' " + I->second.Unbounded;
+  } else {
+    const FunctionUsage &Usage = I->second;
+    D.Bytes = Usage.FrameSize + Usage.MaxPushed;
+    for (const Call &C : Usage.Calls) {
+      if (C.Callee.empty()) {
+        D.Unbounded = "'" + Name.str() + "' makes an indirect call";
+        break;
+      }
+
+      Depth Callee = getDepth(C.Callee);
+      if (!Callee.isBounded()) {
+        D.Unbounded = Callee.Unbounded;
+        break;
+      }
+      D.Bytes = std::max(D.Bytes, Usage.FrameSize + C.Size + Callee.Bytes);
+    }
+  }
+
+  Visiting.erase(Name);
+  Depths[Name] = D;
+  return D;
+}
+
+void SNESStackUsage::printDepth(raw_ostream &OS, StringRef Name,
+                                unsigned EntrySize) {
+  Depth D = getDepth(Name);
+  OS << format("  %-32s ", Name.str().c_str());
+  if (D.isBounded())
+    OS << format("%6llu", (unsigned long long)(EntrySize + D.Bytes));
+  else
+    OS << "unbounded, " << D.Unbounded;
+}
+
+uint64_t SNESStackUsage::printStaticRAM(raw_ostream &OS, const Module &M,
+                                        const TargetMachine &TM) {
+  const DataLayout &DL = M.getDataLayout();
+  const TargetLoweringObjectFile &TLOF = *TM.getObjFileLowering();
+
+  // Constants are in the ROM.
+  std::map<std::string, std::vector<std::pair<StringRef, uint64_t>>> Sections;
+  for (const GlobalVariable &GV : M.globals()) {
+    if (GV.isDeclaration() || GV.isConstant() ||
+        GV.getName().startswith("llvm."))
+      continue;
+
+    auto *Section = cast<MCSectionELF>(TLOF.SectionForGlobal(&GV, TM));
+    Sections[Section->getSectionName()].push_back(
+        std::make_pair(GV.getName(), DL.getTypeAllocSize(GV.getValueType())));
+  }
+
+  uint64_t DirectPageBytes = 0;
+  OS << "\nStatic RAM:\n";
+  for (auto &Section : Sections) {
+    uint64_t Total = 0;
+    for (auto &Var : Section.second)
+      Total += Var.second;
+    if (Section.first == ".directpage")
+      DirectPageBytes = Total;
+
+    OS << format("  %-32s %6llu\n", Section.first.c_str(),
+                 (unsigned long long)Total);
+    for (auto &Var : Section.second)
+      OS << format("    %-30s %6llu\n", Var.first.str().c_str(),
+                   (unsigned long long)Var.second);
+  }
+
+  return DirectPageBytes;
+}
+
+void SNESStackUsage::finish(const Module &M, const TargetMachine &TM) {
+  std::unique_ptr<raw_fd_ostream> File;
+  raw_ostream *OS = &nulls();
+  if (!StackReport.empty()) {
+    std::error_code EC;
+    File.reset(new raw_fd_ostream(StackReport, EC, sys::fs::F_Text));
+    if (EC)
+      report_fatal_error("SNES: cannot open the stack report '" + StackReport +
+                         "': " + EC.message());
+    OS = File.get();
+  }
+
+  StringSet<> Called;
+  std::vector<StringRef> Names;
+  for (auto &Entry : Functions) {
+    Names.push_back(Entry.first());
+    for (const Call &C : Entry.second.Calls)
+      if (C.Callee != Entry.first())
+        Called.insert(C.Callee);
+  }
+  std::sort(Names.begin(), Names.end());
+
+  // The functions nothing else calls are entry points. A cycle of calls
+  // which nothing outside of it reaches has none, the first function in it
+  // is taken as one, so that its recursion is seen.
+  StringSet<> Entries, Reached;
+  auto Reach = [&](StringRef Name) {
+    SmallVector<StringRef, 8> Worklist(1, Name);
+    while (!Worklist.empty()) {
+      auto I = Functions.find(Worklist.pop_back_val());
+      if (I == Functions.end() || !Reached.insert(I->first()).second)
+        continue;
+      for (const Call &C : I->second.Calls)
+        Worklist.push_back(C.Callee);
+    }
+  };
+  for (StringRef Name : Names)
+    if (!Called.count(Name) || Functions[Name].IsInterruptHandler) {
+      Entries.insert(Name);
+      Reach(Name);
+    }
+  for (StringRef Name : Names)
+    if (!Reached.count(Name)) {
+      Entries.insert(Name);
+      Reach(Name);
+    }
+
+  *OS << "Stack usage of " << M.getModuleIdentifier()
+      << ", in bytes below the return address:\n";
+  for (StringRef Name : Names) {
+    const FunctionUsage &Usage = Functions[Name];
+    *OS << format("  %-32s frame %4u", Name.str().c_str(),
+                  Usage.FrameSize + Usage.MaxPushed);
+    Depth D = getDepth(Name);
+    if (D.isBounded())
+      *OS << format(", depth %6llu\n", (unsigned long long)D.Bytes);
+    else
+      *OS << ", unbounded\n";
+  }
+
+  // Anything may be interrupted, and an NMI may come in during an IRQ, so
+  // the handlers are all counted on top of the deepest of the rest. The
+  // SA-1 has its own stack.
+  uint64_t Main = 0, Interrupts = 0;
+  std::string Unbounded;
+  *OS << "\nEntry points, with what is pushed to enter them:\n";
+  for (StringRef Name : Names) {
+    if (!Entries.count(Name))
+      continue;
+    const FunctionUsage &Usage = Functions[Name];
+
+    unsigned EntrySize =
+        Usage.IsInterruptHandler ? unsigned(InterruptSize) : FarCallSize;
+    printDepth(*OS, Name, EntrySize);
+
+    Depth D = getDepth(Name);
+    if (Usage.IsSA1Function) {
+      *OS << " (SA-1)\n";
+      continue;
+    }
+    *OS << (Usage.IsInterruptHandler ? " (interrupt)\n" : "\n");
+
+    if (!D.isBounded()) {
+      if (Unbounded.empty())
+        Unbounded = D.Unbounded;
+    } else if (Usage.IsInterruptHandler) {
+      Interrupts += EntrySize + D.Bytes;
+    } else {
+      Main = std::max(Main, EntrySize + D.Bytes);
+    }
+  }
+
+  uint64_t Worst = Main + Interrupts;
+  if (Unbounded.empty())
+    *OS << format("\nWorst case: %llu bytes\n", (unsigned long long)Worst);
+  else
+    *OS << "\nWorst case: unbounded, " << Unbounded << "\n";
+
+  uint64_t DirectPageBytes = printStaticRAM(*OS, M, TM);
+  OS->flush();
+
+  if (StackBudget) {
+    if (!Unbounded.empty())
+      report_fatal_error("SNES: the stack depth has no bound, " + Unbounded);
+    if (Worst > StackBudget)
+      report_fatal_error("SNES: the stack may take " + Twine(Worst) +
+                         " bytes, more than the budget of " +
+                         Twine(StackBudget));
+  }
+
+  if (DirectPageBytes > DirectPageSize)
+    report_fatal_error("SNES: the direct page variables take " +
+                       Twine(DirectPageBytes) + " bytes, more than the " +
+                       Twine(uint64_t(DirectPageSize)) + " of the direct page");
+}
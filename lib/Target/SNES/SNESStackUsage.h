@@ -0,0 +1,96 @@
+//===-- SNESStackUsage.h - Worst-case stack depth of a program --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the analysis of the stack and static RAM a whole program
+// uses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_STACK_USAGE_H
+#define LLVM_SNES_STACK_USAGE_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
+#include <string>
+
+namespace llvm {
+
+class MachineFunction;
+class Module;
+class raw_ostream;
+class TargetMachine;
+
+/// Finds how deep the stack can get, from the frames and calls of the machine
+/// functions.
+///
+/// The asm printer hands every function to it as it is emitted. At the end
+/// of the module the deepest call chain is found from each entry point: the
+/// functions nothing else calls, one function of each cycle of calls nothing
+/// else reaches, and the interrupt handlers, which may come in on top of any
+/// of them. Recursion, indirect calls, calls out of the module and
+/// variable sized objects make the depth unbounded.
+///
+/// Like SNESStaticFrames, this only makes sense on the whole program, and is
+/// only done when asked for with -snes-stack-report or -snes-stack-budget.
+class SNESStackUsage {
+public:
+  /// Checks if the analysis was asked for.
+  static bool isEnabled();
+
+  /// Records the frame and the calls of a function.
+  void addFunction(const MachineFunction &MF);
+
+  /// Writes the report, and fails when the stack or the direct page does not
+  /// fit.
+  void finish(const Module &M, const TargetMachine &TM);
+
+private:
+  struct Call {
+    /// The callee, empty for an indirect call.
+    std::string Callee;
+    /// The bytes pushed at the call, with the return address.
+    unsigned Size;
+  };
+
+  struct FunctionUsage {
+    /// The frame, including the callee saved registers.
+    unsigned FrameSize;
+    /// The most bytes pushed on top of the frame outside of calls.
+    unsigned MaxPushed;
+    SmallVector<Call, 4> Calls;
+    /// Why the frame has no fixed size, if it does not.
+    const char *Unbounded;
+    bool IsInterruptHandler;
+    bool IsSA1Function;
+  };
+
+  /// The deepest the stack gets in a function and in what it calls, or why
+  /// there is no bound.
+  struct Depth {
+    uint64_t Bytes;
+    std::string Unbounded;
+
+    bool isBounded() const { return Unbounded.empty(); }
+  };
+
+  StringMap<FunctionUsage> Functions;
+  StringMap<Depth> Depths;
+  StringSet<> Visiting;
+
+  Depth getDepth(StringRef Name);
+  void printDepth(raw_ostream &OS, StringRef Name, unsigned EntrySize);
+  uint64_t printStaticRAM(raw_ostream &OS, const Module &M,
+                          const TargetMachine &TM);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_STACK_USAGE_H
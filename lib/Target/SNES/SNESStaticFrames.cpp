@@ -0,0 +1,290 @@
+//===-- SNESStaticFrames.cpp - Compiled stack for non-reentrant code ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which gives the stack objects of functions that
+// can never be reentered a fixed address, the way cc65 and SDCC compile a
+// static stack.
+//
+// The 65816 has no addressing mode that takes both a stack offset and an
+// index, and no read-modify-write instruction on the stack, so a local in
+// memory with a fixed address is both smaller and faster to use. A function
+// qualifies when it is not part of a call graph cycle, cannot be reached from
+// an interrupt handler or from the SA-1, and has only static allocas. Frames
+// of functions that are never live at the same time share memory: each frame
+// is placed after the frames of every qualifying function that may be active
+// when it is called.
+//
+// The pass has to see the whole program, it is only run when asked for with
+// -snes-static-frames, on the output of LTO or of a single translation unit
+// that holds every function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "snes-static-frames"
+
+#define SNES_STATIC_FRAMES_NAME "SNES static frame allocation pass"
+
+static cl::opt<unsigned> DirectPageBudget(
+    "snes-static-frames-dp-size", cl::Hidden, cl::init(0),
+    cl::desc("Place the static frames in the direct page when they fit in "
+             "this many bytes"));
+
+namespace {
+
+class SNESStaticFrames : public ModulePass {
+public:
+  static char ID;
+
+  SNESStaticFrames() : ModulePass(ID) {
+    initializeSNESStaticFramesPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<CallGraphWrapperPass>();
+  }
+
+  StringRef getPassName() const override { return SNES_STATIC_FRAMES_NAME; }
+
+private:
+  typedef SmallPtrSet<const Function *, 32> FunctionSet;
+
+  /// A stack object and its offset in the frame of its function.
+  typedef std::pair<AllocaInst *, uint64_t> FrameSlot;
+
+  /// Finds the functions which may be active more than once at a time, or
+  /// while a frame the call graph does not know about is live.
+  void findReentrant(CallGraph &CG, FunctionSet &Reentrant);
+
+  /// Lays out the frame of \p F, returns false if it has a dynamic alloca.
+  bool layoutFrame(Function &F, const DataLayout &DL,
+                   SmallVectorImpl<FrameSlot> &Slots, uint64_t &Size);
+};
+
+char SNESStaticFrames::ID = 0;
+
+void SNESStaticFrames::findReentrant(CallGraph &CG, FunctionSet &Reentrant) {
+  // Recursion.
+  for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+    if (!I.hasLoop())
+      continue;
+
+    for (const CallGraphNode *Node : *I)
+      if (const Function *F = Node->getFunction())
+        Reentrant.insert(F);
+  }
+
+  SmallVector<const CallGraphNode *, 16> Worklist;
+  SmallPtrSet<const CallGraphNode *, 32> Visited;
+  auto MarkReachable = [&]() {
+    while (!Worklist.empty()) {
+      const CallGraphNode *Node = Worklist.pop_back_val();
+      if (!Visited.insert(Node).second)
+        continue;
+
+      if (const Function *F = Node->getFunction())
+        Reentrant.insert(F);
+
+      for (const CallGraphNode::CallRecord &Call : *Node)
+        Worklist.push_back(Call.second);
+    }
+  };
+
+  // Anything reachable from an interrupt handler may be entered again while
+  // it runs, and the handlers themselves may be interrupted by an NMI. Code
+  // on the SA-1 runs alongside the S-CPU, which may be in the same function.
+  for (const auto &Entry : CG)
+    if (const Function *F = Entry.first)
+      if (SNES::isInterruptHandler(*F) || SNES::isSA1Function(*F))
+        Worklist.push_back(Entry.second.get());
+  MarkReachable();
+
+  // Indirect calls go to the calls-external node, which has no edges out,
+  // and so do calls into code we cannot see. Neither a cycle through a
+  // function pointer or a callback, nor the frames live at the call, are in
+  // the call graph, so if the program makes such calls at all, give up on
+  // the functions they may reach, and on everything those call.
+  bool HasUnknownCalls = Visited.count(CG.getCallsExternalNode());
+  for (const auto &Entry : CG) {
+    const Function *F = Entry.first;
+    if (!F || F->isDeclaration())
+      continue;
+    for (const CallGraphNode::CallRecord &Call : *Entry.second) {
+      const Function *Callee = Call.second->getFunction();
+      if (!Callee || Callee->isDeclaration())
+        HasUnknownCalls = true;
+    }
+  }
+
+  if (HasUnknownCalls) {
+    for (const CallGraphNode::CallRecord &Call : *CG.getExternalCallingNode())
+      if (const Function *F = Call.second->getFunction())
+        if (F->hasAddressTaken())
+          Worklist.push_back(Call.second);
+    MarkReachable();
+  }
+}
+
+bool SNESStaticFrames::layoutFrame(Function &F, const DataLayout &DL,
+                                   SmallVectorImpl<FrameSlot> &Slots,
+                                   uint64_t &Size) {
+  Size = 0;
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      auto *AI = dyn_cast<AllocaInst>(&I);
+      if (!AI)
+        continue;
+
+      if (!AI->isStaticAlloca())
+        return false;
+
+      uint64_t Align = std::max(1U, AI->getAlignment());
+      Size = alignTo(Size, Align);
+      Slots.push_back(FrameSlot(AI, Size));
+      Size += DL.getTypeAllocSize(AI->getAllocatedType()) *
+              cast<ConstantInt>(AI->getArraySize())->getZExtValue();
+    }
+  }
+
+  return true;
+}
+
+bool SNESStaticFrames::runOnModule(Module &M) {
+  if (skipModule(M))
+    return false;
+
+  CallGraph &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  const DataLayout &DL = M.getDataLayout();
+
+  FunctionSet Reentrant;
+  findReentrant(CG, Reentrant);
+
+  // The frame of every function which qualifies.
+  DenseMap<const Function *, uint64_t> FrameSize;
+  DenseMap<const Function *, SmallVector<FrameSlot, 8>> FrameSlots;
+  for (Function &F : M) {
+    if (F.isDeclaration() || F.isVarArg() || Reentrant.count(&F) ||
+        F.callsFunctionThatReturnsTwice())
+      continue;
+
+    SmallVector<FrameSlot, 8> Slots;
+    uint64_t Size;
+    if (!layoutFrame(F, DL, Slots, Size) || Slots.empty())
+      continue;
+
+    FrameSize[&F] = Size;
+    FrameSlots[&F] = std::move(Slots);
+  }
+
+  if (FrameSlots.empty())
+    return false;
+
+  // Place the frames. The SCCs come callees first, walk them callers first
+  // and push the end of the frames live in each function to its callees.
+  std::vector<std::vector<CallGraphNode *>> SCCs;
+  for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I)
+    SCCs.push_back(*I);
+
+  DenseMap<const CallGraphNode *, uint64_t> Start;
+  DenseMap<const Function *, uint64_t> FrameOffset;
+  for (auto I = SCCs.rbegin(), E = SCCs.rend(); I != E; ++I) {
+    // Functions in a cycle have no static frame, but may call each other,
+    // so they all see the frames live in any of them.
+    uint64_t SCCStart = 0;
+    for (const CallGraphNode *Node : *I)
+      SCCStart = std::max(SCCStart, Start.lookup(Node));
+
+    for (const CallGraphNode *Node : *I) {
+      uint64_t End = SCCStart;
+      const Function *F = Node->getFunction();
+      if (F && FrameSize.count(F)) {
+        FrameOffset[F] = SCCStart;
+        End += FrameSize[F];
+      }
+
+      for (const CallGraphNode::CallRecord &Call : *Node) {
+        uint64_t &CalleeStart = Start[Call.second];
+        CalleeStart = std::max(CalleeStart, End);
+      }
+    }
+  }
+
+  // The memory for all the frames.
+  uint64_t TotalSize = 0;
+  for (auto &Entry : FrameSize)
+    TotalSize = std::max(TotalSize, FrameOffset.lookup(Entry.first) +
+                                        Entry.second);
+
+  LLVMContext &Ctx = M.getContext();
+  unsigned AddrSpace = TotalSize <= DirectPageBudget ? SNES::DirectPage
+                                                     : SNES::DataMemory;
+  ArrayType *FramesTy = ArrayType::get(Type::getInt8Ty(Ctx), TotalSize);
+  auto *Frames = new GlobalVariable(
+      M, FramesTy, false, GlobalValue::InternalLinkage,
+      ConstantAggregateZero::get(FramesTy), "__snes_static_frames", nullptr,
+      GlobalVariable::NotThreadLocal, AddrSpace);
+
+  DEBUG(dbgs() << "Static frames: " << TotalSize << " bytes in "
+               << (AddrSpace == SNES::DirectPage ? "the direct page" : "WRAM")
+               << "\n");
+
+  Type *IndexTy = DL.getIntPtrType(Ctx, AddrSpace);
+  for (auto &Entry : FrameSlots) {
+    uint64_t Offset = FrameOffset[Entry.first];
+    DEBUG(dbgs() << "  " << Entry.first->getName() << ": " << Offset << ", "
+                 << FrameSize[Entry.first] << " bytes\n");
+
+    for (FrameSlot &Slot : Entry.second) {
+      AllocaInst *AI = Slot.first;
+      Constant *Indices[] = {ConstantInt::get(IndexTy, 0),
+                             ConstantInt::get(IndexTy, Offset + Slot.second)};
+      Constant *Addr =
+          ConstantExpr::getInBoundsGetElementPtr(FramesTy, Frames, Indices);
+      Addr = ConstantExpr::getPointerBitCastOrAddrSpaceCast(Addr,
+                                                            AI->getType());
+
+      AI->replaceAllUsesWith(Addr);
+      AI->eraseFromParent();
+    }
+  }
+
+  return true;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS_BEGIN(SNESStaticFrames, "snes-static-frames",
+                      SNES_STATIC_FRAMES_NAME, false, false)
+INITIALIZE_PASS_DEPENDENCY(CallGraphWrapperPass)
+INITIALIZE_PASS_END(SNESStaticFrames, "snes-static-frames",
+                    SNES_STATIC_FRAMES_NAME, false, false)
+
+namespace llvm {
+
+ModulePass *createSNESStaticFramesPass() { return new SNESStaticFrames(); }
+
+} // end of namespace llvm
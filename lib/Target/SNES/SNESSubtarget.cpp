@@ -14,9 +14,15 @@
 #include "SNESSubtarget.h"
 
 #include "llvm/BinaryFormat/ELF.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
 #include "llvm/Support/TargetRegistry.h"
 
 #include "SNES.h"
+#ifdef LLVM_BUILD_GLOBAL_ISEL
+#include "SNESCallLowering.h"
+#include "SNESLegalizerInfo.h"
+#include "SNESRegisterBankInfo.h"
+#endif
 #include "SNESTargetMachine.h"
 #include "MCTargetDesc/SNESMCTargetDesc.h"
 
@@ -28,14 +34,76 @@
 
 namespace llvm {
 
+#ifdef LLVM_BUILD_GLOBAL_ISEL
+namespace {
+
+struct SNESGISelActualAccessor : public GISelAccessor {
+  std::unique_ptr<CallLowering> CallLoweringInfo;
+  std::unique_ptr<InstructionSelector> InstSelector;
+  std::unique_ptr<LegalizerInfo> Legalizer;
+  std::unique_ptr<RegisterBankInfo> RegBankInfo;
+
+  const CallLowering *getCallLowering() const override {
+    return CallLoweringInfo.get();
+  }
+
+  const InstructionSelector *getInstructionSelector() const override {
+    return InstSelector.get();
+  }
+
+  const LegalizerInfo *getLegalizerInfo() const override {
+    return Legalizer.get();
+  }
+
+  const RegisterBankInfo *getRegBankInfo() const override {
+    return RegBankInfo.get();
+  }
+};
+
+} // end anonymous namespace
+#endif
+
 SNESSubtarget::SNESSubtarget(const Triple &TT, const std::string &CPU,
                            const std::string &FS, SNESTargetMachine &TM)
     : SNESGenSubtargetInfo(TT, CPU, FS), InstrInfo(), FrameLowering(),
       TLInfo(TM), TSInfo(),
       // Subtarget features
-      ELFArch(false), m_FeatureSetDummy(false) {
+      ELFArch(false), HasSA1(false), m_FeatureSetDummy(false) {
   // Parse features string.
   ParseSubtargetFeatures(CPU, FS);
+
+#ifndef LLVM_BUILD_GLOBAL_ISEL
+  GISelAccessor *GISel = new GISelAccessor();
+#else
+  SNESGISelActualAccessor *GISel = new SNESGISelActualAccessor();
+  GISel->CallLoweringInfo.reset(new SNESCallLowering(*getTargetLowering()));
+  GISel->Legalizer.reset(new SNESLegalizerInfo(*this));
+
+  auto *RBI = new SNESRegisterBankInfo(*getRegisterInfo());
+  GISel->InstSelector.reset(createSNESInstructionSelector(TM, *this, *RBI));
+  GISel->RegBankInfo.reset(RBI);
+#endif
+  setGISelAccessor(*GISel);
+}
+
+const CallLowering *SNESSubtarget::getCallLowering() const {
+  assert(GISel && "Access to GlobalISel APIs not set");
+  return GISel->getCallLowering();
+}
+
+const InstructionSelector *SNESSubtarget::getInstructionSelector() const {
+  assert(GISel && "Access to GlobalISel APIs not set");
+  return GISel->getInstructionSelector();
+}
+
+const LegalizerInfo *SNESSubtarget::getLegalizerInfo() const {
+  assert(GISel && "Access to GlobalISel APIs not set");
+  return GISel->getLegalizerInfo();
+}
+
+const RegisterBankInfo *SNESSubtarget::getRegBankInfo() const {
+  assert(GISel && "Access to GlobalISel APIs not set");
+  return GISel->getRegBankInfo();
 }
 
 } // end of namespace llvm
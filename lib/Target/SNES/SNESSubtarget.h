@@ -14,6 +14,7 @@
 #ifndef LLVM_SNES_SUBTARGET_H
 #define LLVM_SNES_SUBTARGET_H
 
+#include "llvm/CodeGen/GlobalISel/GISelAccessor.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
@@ -45,6 +46,15 @@ public:
   const SNESSelectionDAGInfo *getSelectionDAGInfo() const override { return &TSInfo; }
   const SNESRegisterInfo *getRegisterInfo() const override { return &InstrInfo.getRegisterInfo(); }
 
+  /// The GlobalISel objects, only set when LLVM is built with GlobalISel.
+  /// This object takes ownership of \p GISel.
+  void setGISelAccessor(GISelAccessor &GISel) { this->GISel.reset(&GISel); }
+
+  const CallLowering *getCallLowering() const override;
+  const InstructionSelector *getInstructionSelector() const override;
+  const LegalizerInfo *getLegalizerInfo() const override;
+  const RegisterBankInfo *getRegBankInfo() const override;
+
   /// Parses a subtarget feature string, setting appropriate options.
   /// \note Definition of function is auto generated by `tblgen`.
   void ParseSubtargetFeatures(StringRef CPU, StringRef FS);
@@ -57,15 +67,26 @@ public:
     return ELFArch;
   }
 
+  /// Checks if the cartridge has an SA-1, whose core runs the functions
+  /// marked with the "snes-sa1" attribute.
+  bool hasSA1() const { return HasSA1; }
+
 private:
   SNESInstrInfo InstrInfo;
   SNESFrameLowering FrameLowering;
   SNESTargetLowering TLInfo;
   SNESSelectionDAGInfo TSInfo;
 
+  /// The accessors to the GlobalISel APIs, which keep the #ifdefs in the
+  /// constructor.
+  std::unique_ptr<GISelAccessor> GISel;
+
   /// The ELF e_flags architecture.
   unsigned ELFArch;
 
+  // Subtarget features.
+  bool HasSA1;
+
   // Dummy member, used by FeatureSet's. We cannot have a SubtargetFeature with
   // no variable, so we instead bind pseudo features to this variable.
   bool m_FeatureSetDummy;
@@ -13,22 +13,37 @@
 
 #include "SNESTargetMachine.h"
 
+#include "llvm/CodeGen/GlobalISel/IRTranslator.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelect.h"
+#include "llvm/CodeGen/GlobalISel/Legalizer.h"
+#include "llvm/CodeGen/GlobalISel/RegBankSelect.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/TargetRegistry.h"
 
 #include "SNES.h"
 #include "SNESTargetObjectFile.h"
+#include "SNESTargetTransformInfo.h"
+#include "SPC700.h"
 #include "MCTargetDesc/SNESMCTargetDesc.h"
 
 namespace llvm {
 
+static cl::opt<bool> EnableStaticFrames(
+    "snes-static-frames", cl::Hidden, cl::init(false),
+    cl::desc("Give the locals of non-reentrant functions fixed addresses, "
+             "the module must hold the whole program"));
+
 static const char *SNESDataLayout = "e-p:16:8:8-i1:8:8-i8:8:8-i16:8:8-n8:16";
 
 /// Processes a CPU name.
 static StringRef getCPU(StringRef CPU) {
+  if (CPU.empty() || CPU == "generic")
+    return "snes";
+
   return CPU;
 }
 
@@ -60,9 +75,16 @@ public:
     return getTM<SNESTargetMachine>();
   }
 
+  void addIRPasses() override;
   bool addInstSelector() override;
-  // void addPreSched2() override;
-  // void addPreEmitPass() override;
+#ifdef LLVM_BUILD_GLOBAL_ISEL
+  bool addIRTranslator() override;
+  bool addLegalizeMachineIR() override;
+  bool addRegBankSelect() override;
+  bool addGlobalInstructionSelect() override;
+#endif
+  void addPreSched2() override;
+  void addPreEmitPass() override;
   // void addPreRegAlloc() override;
 };
 } // namespace
@@ -71,15 +93,31 @@ TargetPassConfig *SNESTargetMachine::createPassConfig(PassManagerBase &PM) {
   return new SNESPassConfig(*this, PM);
 }
 
+TargetIRAnalysis SNESTargetMachine::getTargetIRAnalysis() {
+  return TargetIRAnalysis([this](const Function &F) {
+    return TargetTransformInfo(SNESTTIImpl(this, F));
+  });
+}
+
 extern "C" void LLVMInitializeSNESTarget() {
   // Register the target.
   RegisterTargetMachine<SNESTargetMachine> X(getTheSNESTarget());
 
-  // TODO: check the passes that we will use
-  // auto &PR = *PassRegistry::getPassRegistry();
-  // initializeSNESExpandPseudoPass(PR);
-  // initializeSNESInstrumentFunctionsPass(PR);
-  // initializeSNESRelaxMemPass(PR);
+  initializeGlobalISel(*PassRegistry::getPassRegistry());
+
+  registerSPC700Target();
+
+  auto &PR = *PassRegistry::getPassRegistry();
+  initializeSNESExpandPseudoPass(PR);
+  initializeSNESInstrumentFunctionsPass(PR);
+  initializeSNESRelaxMemPass(PR);
+  initializeSNESDataBankOptPass(PR);
+  initializeSNESAccumulatorWidthPass(PR);
+  initializeSNESTransferOptPass(PR);
+  initializeSNESPeepholePass(PR);
+  initializeSNESStaticFramesPass(PR);
+  initializeSNESCoroFramesPass(PR);
+  initializeSNESSA1OffloadPass(PR);
 }
 
 const SNESSubtarget *SNESTargetMachine::getSubtargetImpl() const {
@@ -94,6 +132,22 @@ const SNESSubtarget *SNESTargetMachine::getSubtargetImpl(const Function &) const
 // Pass Pipeline Configuration
 //===----------------------------------------------------------------------===//
 
+void SNESPassConfig::addIRPasses() {
+  // Needed for correctness, the S-CPU cannot call into SA-1 code. It also
+  // tells the static frame allocator which functions run on the SA-1.
+  if (getSNESTargetMachine().getSubtargetImpl()->hasSA1())
+    addPass(createSNESSA1OffloadPass());
+
+  // There is no heap, coroutine frames always come from static pools.
+  addPass(createSNESCoroFramesPass());
+
+  // Run before the generic IR passes, so the call graph is still intact.
+  if (EnableStaticFrames && getOptLevel() != CodeGenOpt::None)
+    addPass(createSNESStaticFramesPass());
+
+  TargetPassConfig::addIRPasses();
+}
+
 bool SNESPassConfig::addInstSelector() {
   // Install an instruction selector.
   addPass(createSNESISelDag(getSNESTargetMachine(), getOptLevel()));
@@ -103,19 +157,54 @@ bool SNESPassConfig::addInstSelector() {
   return false;
 }
 
+#ifdef LLVM_BUILD_GLOBAL_ISEL
+bool SNESPassConfig::addIRTranslator() {
+  addPass(new IRTranslator());
+  return false;
+}
+
+bool SNESPassConfig::addLegalizeMachineIR() {
+  addPass(new Legalizer());
+  return false;
+}
+
+bool SNESPassConfig::addRegBankSelect() {
+  addPass(new RegBankSelect());
+  return false;
+}
+
+bool SNESPassConfig::addGlobalInstructionSelect() {
+  addPass(new InstructionSelect());
+  return false;
+}
+#endif
+
 // void SNESPassConfig::addPreRegAlloc() {
 //   // Create the dynalloc SP save/restore pass to handle variable sized allocas.
 //   // addPass(createSNESDynAllocaSRPass());
 // }
 
-// void SNESPassConfig::addPreSched2() {
-//   // addPass(createSNESRelaxMemPass());
-//   // addPass(createSNESExpandPseudoPass());
-// }
+void SNESPassConfig::addPreSched2() {
+  // addPass(createSNESRelaxMemPass());
+  addPass(createSNESExpandPseudoPass());
+}
 
-// void SNESPassConfig::addPreEmitPass() {
-//   // Must run branch selection immediately preceding the asm printer.
-//   // addPass(&BranchRelaxationPassID);
-// }
+void SNESPassConfig::addPreEmitPass() {
+  if (getOptLevel() != CodeGenOpt::None) {
+    addPass(createSNESTransferOptPass());
+    addPass(createSNESDataBankOptPass());
+  }
+
+  // Needed for correctness, the byte instructions only differ from the word
+  // ones by the M flag.
+  addPass(createSNESAccumulatorWidthPass());
+
+  // Sees the REP and SEP added by the accumulator width pass.
+  if (getOptLevel() != CodeGenOpt::None)
+    addPass(createSNESPeepholePass());
+
+  // Must run branch selection immediately preceding the asm printer.
+  // addPass(&BranchRelaxationPassID);
+}
 
 } // end of namespace llvm
@@ -41,6 +41,8 @@ public:
 
   TargetPassConfig *createPassConfig(PassManagerBase &PM) override;
 
+  TargetIRAnalysis getTargetIRAnalysis() override;
+
   bool isMachineVerifierClean() const override {
     return false;
   }
@@ -10,20 +10,121 @@
 #include "SNESTargetObjectFile.h"
 
 #include "llvm/BinaryFormat/ELF.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCSectionELF.h"
+#include "llvm/Support/CommandLine.h"
 
 #include "SNES.h"
+#include "SNESTargetMachine.h"
 
 namespace llvm {
+
+static cl::opt<bool>
+    ProfileGuidedBankPlacement("snes-profile-bank-placement", cl::Hidden,
+                               cl::init(true),
+                               cl::desc("Place hot functions in FastROM and "
+                                        "cold functions in SlowROM banks"));
+
+static cl::opt<unsigned> FastROMEntryCount(
+    "snes-fastrom-entry-count", cl::Hidden, cl::init(0),
+    cl::desc("Minimum function entry count for FastROM placement when the "
+             "function has no profile section prefix (0 disables)"));
+
 void SNESTargetObjectFile::Initialize(MCContext &Ctx, const TargetMachine &TM) {
   Base::Initialize(Ctx, TM);
   // TODO: check the place where global variables would go
   // ProgmemDataSection =
   //     Ctx.getELFSection(".progmem.data", ELF::SHT_PROGBITS, ELF::SHF_ALLOC);
+
+  // The linker script maps these onto the $80+ mirrors and the low banks.
+  FastROMTextSection = Ctx.getELFSection(".text.fastrom", ELF::SHT_PROGBITS,
+                                         ELF::SHF_ALLOC | ELF::SHF_EXECINSTR);
+  SlowROMTextSection = Ctx.getELFSection(".text.slowrom", ELF::SHT_PROGBITS,
+                                         ELF::SHF_ALLOC | ELF::SHF_EXECINSTR);
+
+  // Mapped at $0000-$00FF, which is where D points to.
+  DirectPageSection = Ctx.getELFSection(".directpage", ELF::SHT_PROGBITS,
+                                        ELF::SHF_ALLOC | ELF::SHF_WRITE);
+
+  // Mapped at $40:0000 for the S-CPU and $6000-$7FFF of the low banks for
+  // both CPUs, the SA-1 cannot reach WRAM.
+  BWRAMDataSection = Ctx.getELFSection(".bwram.data", ELF::SHT_PROGBITS,
+                                       ELF::SHF_ALLOC | ELF::SHF_WRITE);
+  BWRAMBSSSection = Ctx.getELFSection(".bwram.bss", ELF::SHT_NOBITS,
+                                      ELF::SHF_ALLOC | ELF::SHF_WRITE);
+}
+
+SNESTargetObjectFile::ROMPlacement
+SNESTargetObjectFile::getROMPlacement(const Function &F) {
+  if (!ProfileGuidedBankPlacement || F.hasSection())
+    return DefaultROM;
+
+  // CodeGenPrepare tags functions with the profile summary's verdict.
+  if (auto Prefix = F.getSectionPrefix()) {
+    if (*Prefix == ".hot")
+      return FastROM;
+    if (*Prefix == ".unlikely")
+      return SlowROM;
+  }
+
+  if (F.hasFnAttribute(Attribute::Cold))
+    return SlowROM;
+
+  // Fall back to the raw entry count when no summary is available.
+  if (FastROMEntryCount) {
+    if (auto Count = F.getEntryCount())
+      return *Count >= FastROMEntryCount ? FastROM : SlowROM;
+  }
+
+  return DefaultROM;
+}
+
+bool SNESTargetObjectFile::isInSameSection(const Function &F1,
+                                           const Function &F2) {
+  if (F1.hasSection() || F2.hasSection())
+    return F1.getSection() == F2.getSection();
+
+  return getROMPlacement(F1) == getROMPlacement(F2);
+}
+
+bool SNESTargetObjectFile::needsFarEntry(const Function &F) {
+  // Anything visible outside of the module may be called from any bank.
+  if (!F.hasLocalLinkage())
+    return true;
+
+  for (const User *U : F.users()) {
+    ImmutableCallSite CS(U);
+
+    // Taking the address lets the function escape to anywhere.
+    if (!CS || CS.getCalledValue() != &F)
+      return true;
+
+    if (!isInSameSection(*CS.getCaller(), F))
+      return true;
+  }
+
+  return false;
+}
+
+bool SNESTargetObjectFile::isFarCall(const Function &Caller,
+                                     const GlobalValue *GV,
+                                     bool HasStackArgs) {
+  const auto *Callee = dyn_cast<Function>(GV);
+  if (!Callee)
+    return false;
+
+  if (HasStackArgs && needsFarEntry(*Callee))
+    return true;
+
+  if (Callee->isDeclaration() || Callee->isInterposable())
+    return false;
+
+  return !isInSameSection(Caller, *Callee);
 }
 
 MCSection *
@@ -36,8 +137,37 @@ SNESTargetObjectFile::SelectSectionForGlobal(const GlobalObject *GO,
   // if (SNES::isProgramMemoryAddress(GO) && !GO->hasSection())
   //   return ProgmemDataSection;
 
+  // Variables in the direct page address space are reached with the
+  // 8-bit direct page addressing modes.
+  if (SNES::isDirectPageAddress(GO) && !GO->hasSection())
+    return DirectPageSection;
+
+  // Code on the SA-1 may touch any variable.
+  const auto &STI = *static_cast<const SNESTargetMachine &>(TM)
+                         .getSubtargetImpl();
+  if (STI.hasSA1() && !GO->hasSection()) {
+    if (Kind.isBSS())
+      return BWRAMBSSSection;
+    if (Kind.isData())
+      return BWRAMDataSection;
+  }
+
+  // Hot functions are clustered together so that calls between them stay
+  // within a bank and can use JSR instead of JSL.
+  if (const auto *F = dyn_cast<Function>(GO)) {
+    if (Kind.isText()) {
+      switch (getROMPlacement(*F)) {
+      case FastROM:
+        return FastROMTextSection;
+      case SlowROM:
+        return SlowROMTextSection;
+      case DefaultROM:
+        break;
+      }
+    }
+  }
+
   // Otherwise, we work the same way as ELF.
   return Base::SelectSectionForGlobal(GO, Kind, TM);
 }
 } // end of namespace llvm
-
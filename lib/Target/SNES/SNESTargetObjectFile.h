@@ -14,19 +14,80 @@
 
 namespace llvm {
 
+class Function;
+class GlobalValue;
+
 /// Lowering for an SNES ELF32 object file.
 class SNESTargetObjectFile : public TargetLoweringObjectFileELF {
   typedef TargetLoweringObjectFileELF Base;
 
 public:
+  /// The ROM region a function is placed in.
+  ///
+  /// Code in the FastROM mirrors (banks $80 and up) runs at 3.58 MHz once
+  /// MEMSEL is set, while the SlowROM banks always run at 2.68 MHz.
+  enum ROMPlacement {
+    /// No profile information, use the generic text section.
+    DefaultROM,
+    /// Hot code, clustered in `.text.fastrom`.
+    FastROM,
+    /// Cold code, moved out of the way into `.text.slowrom`.
+    SlowROM
+  };
+
   void Initialize(MCContext &ctx, const TargetMachine &TM) override;
 
   MCSection *SelectSectionForGlobal(const GlobalObject *GO, SectionKind Kind,
                                     const TargetMachine &TM) const override;
 
+  /// Jump tables are read with `JMP (table,X)`, from the program bank, so
+  /// they stay in the section of their function.
+  bool shouldPutJumpTableInFunctionSection(bool UsesLabelDifference,
+                                           const Function &F) const override {
+    return true;
+  }
+
+  /// Classifies a function from its profile data.
+  static ROMPlacement getROMPlacement(const Function &F);
+
+  /// Checks whether two functions end up in the same text section, and thus
+  /// in the same bank.
+  static bool isInSameSection(const Function &F1, const Function &F2);
+
+  /// The bytes a call through the far entry of a function leaves between
+  /// the stack arguments and the return address of the body: the return
+  /// address of the `JSL`.
+  static const unsigned FarReturnSize = 3;
+
+  /// Checks whether a function can be called from another bank, and thus
+  /// gets a `JSR body; RTL` far entry in front of it.
+  ///
+  /// The body of such a function finds its stack arguments `FarReturnSize`
+  /// bytes further up, so the calls which pass any always go through the far
+  /// entry, even from the same bank.
+  static bool needsFarEntry(const Function &F);
+
+  /// Checks whether a direct call goes through the far entry of its callee.
+  ///
+  /// Only callees defined in this module have a known placement. Anything
+  /// else is called with a plain JSR, which the assembler relaxes into a far
+  /// call once the layout is known, unless it passes stack arguments.
+  static bool isFarCall(const Function &Caller, const GlobalValue *GV,
+                        bool HasStackArgs);
+
 private:
   // TODO: check program data section
   // MCSection *ProgmemDataSection;
+
+  /// Hot functions, linked into the FastROM banks.
+  MCSection *FastROMTextSection;
+  /// Cold functions, linked into the SlowROM banks.
+  MCSection *SlowROMTextSection;
+  /// Variables accessed through the direct page.
+  MCSection *DirectPageSection;
+  /// Variables in the SA-1's BW-RAM, which both CPUs can reach.
+  MCSection *BWRAMDataSection;
+  MCSection *BWRAMBSSSection;
 };
 
 } // end namespace llvm
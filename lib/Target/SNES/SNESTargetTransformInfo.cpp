@@ -0,0 +1,267 @@
+//===-- SNESTargetTransformInfo.cpp - SNES specific TTI -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The costs reported to the IR passes are 65816 cycle counts, scaled so that
+// TCC_Basic is a 16-bit accumulator operation on a direct page operand
+// (`AND dp`, 4 cycles). The counts assume a 16-bit accumulator and index
+// registers, and are rounded to the nearest unit.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNESTargetTransformInfo.h"
+
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/CommandLine.h"
+
+namespace llvm {
+
+static cl::opt<unsigned> UnrollThreshold(
+    "snes-unroll-threshold", cl::Hidden, cl::init(32),
+    cl::desc("Maximum cost of a loop fully unrolled on the SNES"));
+
+/// Cycles in one TCC_Basic.
+static const unsigned CyclesPerUnit = 4;
+
+static unsigned cyclesToCost(unsigned Cycles) {
+  return std::max(1U, (Cycles + CyclesPerUnit / 2) / CyclesPerUnit);
+}
+
+namespace {
+/// The cycles an operation takes on a legal type, i8 or i16.
+struct CostEntry {
+  int ISD;
+  unsigned Cycles;
+};
+} // end of anonymous namespace
+
+static const CostEntry ArithCosts[] = {
+    {ISD::ADD, 6},   // CLC; ADC dp
+    {ISD::SUB, 6},   // SEC; SBC dp
+    {ISD::AND, 4},   // AND dp
+    {ISD::OR, 4},    // ORA dp
+    {ISD::XOR, 4},   // EOR dp
+    {ISD::MUL, 180}, // __mulhi3, four 8x8 products on the hardware multiplier
+    {ISD::UDIV, 420}, // __udivhi3, shift and subtract loop
+    {ISD::SDIV, 460}, // __divhi3
+    {ISD::UREM, 420}, // __umodhi3
+    {ISD::SREM, 460}, // __modhi3
+    {ISD::SHL, 72},  // variable shift, ASL loop of about 9 cycles a bit
+    {ISD::SRL, 72},  // LSR loop
+    {ISD::SRA, 120}, // CMP #$8000; ROR loop
+    {ISD::FADD, 650}, // __addsf3
+    {ISD::FSUB, 680}, // __subsf3
+    {ISD::FMUL, 900}, // __mulsf3
+    {ISD::FDIV, 2600}, // __divsf3
+    {ISD::FREM, 4000}, // fmodf
+};
+
+static const CostEntry *lookupCost(ArrayRef<CostEntry> Table, int ISD) {
+  for (const CostEntry &Entry : Table)
+    if (Entry.ISD == ISD)
+      return &Entry;
+  return nullptr;
+}
+
+int SNESTTIImpl::getIntImmCost(const APInt &Imm, Type *Ty) {
+  // LDA #imm for each 16-bit half.
+  unsigned Bits = std::max(16U, Imm.getBitWidth());
+  return TTI::TCC_Basic * ((Bits + 15) / 16);
+}
+
+int SNESTTIImpl::getIntImmCost(unsigned Opcode, unsigned Idx, const APInt &Imm,
+                               Type *Ty) {
+  // Immediates are encoded in the instructions (`ADC #imm`, `CMP #imm`), and
+  // hoisting them would only take one of our three registers.
+  switch (Opcode) {
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+  case Instruction::ICmp:
+  case Instruction::Shl:
+  case Instruction::LShr:
+  case Instruction::AShr:
+  case Instruction::Store:
+  case Instruction::Ret:
+    return TTI::TCC_Free;
+  default:
+    return getIntImmCost(Imm, Ty);
+  }
+}
+
+unsigned SNESTTIImpl::getArithmeticInstrCost(
+    unsigned Opcode, Type *Ty, TTI::OperandValueKind Opd1Info,
+    TTI::OperandValueKind Opd2Info, TTI::OperandValueProperties Opd1PropInfo,
+    TTI::OperandValueProperties Opd2PropInfo, ArrayRef<const Value *> Args) {
+  if (Ty->isVectorTy())
+    return BaseT::getArithmeticInstrCost(Opcode, Ty, Opd1Info, Opd2Info,
+                                         Opd1PropInfo, Opd2PropInfo, Args);
+
+  int ISD = TLI->InstructionOpcodeToISD(Opcode);
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(DL, Ty);
+  const CostEntry *Entry = lookupCost(ArithCosts, ISD);
+  if (!Entry)
+    return BaseT::getArithmeticInstrCost(Opcode, Ty, Opd1Info, Opd2Info,
+                                         Opd1PropInfo, Opd2PropInfo, Args);
+
+  // Shifts by a constant are unrolled, ASL A is 2 cycles a bit. From 8 bits
+  // on, XBA moves a whole byte.
+  if ((ISD == ISD::SHL || ISD == ISD::SRL || ISD == ISD::SRA) &&
+      Args.size() == 2) {
+    if (const auto *C = dyn_cast<ConstantInt>(Args[1])) {
+      unsigned Amount = C->getLimitedValue(Ty->getScalarSizeInBits());
+      unsigned Cycles = Amount >= 8 ? 6 + 2 * (Amount - 8) : 2 * Amount;
+      if (ISD == ISD::SRA)
+        Cycles += 8;
+      return LT.first * cyclesToCost(Cycles);
+    }
+  }
+
+  // Wide multiplies and divides are one libcall, not one call per part, but
+  // a longer one.
+  unsigned Cycles = Entry->Cycles;
+  switch (ISD) {
+  case ISD::MUL:
+  case ISD::UDIV:
+  case ISD::SDIV:
+  case ISD::UREM:
+  case ISD::SREM:
+    return cyclesToCost(Cycles * LT.first * LT.first);
+  default:
+    return LT.first * cyclesToCost(Cycles);
+  }
+}
+
+unsigned SNESTTIImpl::getCastInstrCost(unsigned Opcode, Type *Dst, Type *Src,
+                                       const Instruction *I) {
+  if (Dst->isVectorTy() || Src->isVectorTy())
+    return BaseT::getCastInstrCost(Opcode, Dst, Src, I);
+
+  int ISD = TLI->InstructionOpcodeToISD(Opcode);
+  unsigned DstBits = Dst->getScalarSizeInBits();
+
+  switch (ISD) {
+  case ISD::TRUNCATE:
+  case ISD::BITCAST:
+    return TTI::TCC_Free;
+  case ISD::ZERO_EXTEND:
+    // AND #$00FF, and a STZ for each extra 16-bit half.
+    return cyclesToCost(3 + 4 * (DstBits > 16 ? (DstBits - 1) / 16 : 0));
+  case ISD::SIGN_EXTEND:
+    // Test the sign and ORA #$FF00 or fill the high half with $FFFF.
+    return cyclesToCost(10 + 6 * (DstBits > 16 ? (DstBits - 1) / 16 : 0));
+  case ISD::SINT_TO_FP:
+  case ISD::UINT_TO_FP:
+  case ISD::FP_TO_SINT:
+  case ISD::FP_TO_UINT:
+    // Soft float conversions.
+    return cyclesToCost(300);
+  default:
+    return BaseT::getCastInstrCost(Opcode, Dst, Src, I);
+  }
+}
+
+unsigned SNESTTIImpl::getCmpSelInstrCost(unsigned Opcode, Type *ValTy,
+                                         Type *CondTy, const Instruction *I) {
+  if (ValTy->isVectorTy())
+    return BaseT::getCmpSelInstrCost(Opcode, ValTy, CondTy, I);
+
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(DL, ValTy);
+
+  switch (Opcode) {
+  case Instruction::ICmp:
+    // CMP dp and a branch, for each part.
+    return LT.first * cyclesToCost(7);
+  case Instruction::FCmp:
+    // __cmpsf2 and friends.
+    return cyclesToCost(150);
+  case Instruction::Select:
+    // There are no conditional moves, a select is a branch around a load.
+    // Between two constants it is often made out of the carry instead, see
+    // SNESTargetLowering::lowerSelect.
+    if (I && isa<Constant>(I->getOperand(1)) && isa<Constant>(I->getOperand(2)))
+      return LT.first * cyclesToCost(6);
+    return LT.first * cyclesToCost(9);
+  default:
+    return BaseT::getCmpSelInstrCost(Opcode, ValTy, CondTy, I);
+  }
+}
+
+unsigned SNESTTIImpl::getMemoryOpCost(unsigned Opcode, Type *Src,
+                                      unsigned Alignment,
+                                      unsigned AddressSpace,
+                                      const Instruction *I) {
+  if (Src->isVectorTy())
+    return BaseT::getMemoryOpCost(Opcode, Src, Alignment, AddressSpace, I);
+
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(DL, Src);
+
+  // LDA dp is 4 cycles, LDA abs and LDA abs,X are 5. Loads from ROM through
+  // a long address are 6.
+  unsigned Cycles = 5;
+  if (AddressSpace == SNES::DirectPage)
+    Cycles = 4;
+  else if (AddressSpace == SNES::ProgramMemory)
+    Cycles = 6;
+
+  return LT.first * cyclesToCost(Cycles);
+}
+
+unsigned SNESTTIImpl::getIntrinsicInstrCost(Intrinsic::ID IID, Type *RetTy,
+                                            ArrayRef<Type *> Tys,
+                                            FastMathFlags FMF,
+                                            unsigned ScalarizationCostPassed) {
+  if (RetTy->isVectorTy())
+    return BaseT::getIntrinsicInstrCost(IID, RetTy, Tys, FMF,
+                                        ScalarizationCostPassed);
+
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(DL, RetTy);
+
+  switch (IID) {
+  case Intrinsic::bswap:
+    // XBA.
+    return LT.first * cyclesToCost(3);
+  case Intrinsic::ctpop:
+  case Intrinsic::ctlz:
+  case Intrinsic::cttz:
+    // A shift loop over every bit.
+    return LT.first * cyclesToCost(130);
+  case Intrinsic::snes_umul8:
+    // Two stores, the wait and the load of the product.
+    return cyclesToCost(24);
+  case Intrinsic::snes_fixed16_mul8_8:
+    return cyclesToCost(4 * 24 + 20);
+  case Intrinsic::snes_fixed16_mul16_16:
+    return cyclesToCost(16 * 24 + 60);
+  case Intrinsic::snes_bcd_add:
+  case Intrinsic::snes_bcd_sub:
+    // SED; CLC; ADC; CLD.
+    return cyclesToCost(9);
+  default:
+    return BaseT::getIntrinsicInstrCost(IID, RetTy, Tys, FMF,
+                                        ScalarizationCostPassed);
+  }
+}
+
+void SNESTTIImpl::getUnrollingPreferences(Loop *L, ScalarEvolution &SE,
+                                          TTI::UnrollingPreferences &UP) {
+  // The loop overhead is a `DEX; BNE`, 5 cycles, against ROM space that is
+  // just as scarce. Only fully unroll small loops and never add a runtime
+  // remainder loop.
+  UP.Threshold = UnrollThreshold;
+  UP.PartialThreshold = UnrollThreshold / 2;
+  UP.OptSizeThreshold = 0;
+  UP.PartialOptSizeThreshold = 0;
+  UP.Partial = false;
+  UP.Runtime = false;
+  UP.MaxCount = 8;
+}
+
+} // end of namespace llvm
@@ -0,0 +1,113 @@
+//===-- SNESTargetTransformInfo.h - SNES specific TTI -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file a TargetTransformInfo::Concept conforming object specific to the
+// SNES target machine. It uses the target's detailed information to
+// provide more precise answers to certain TTI queries, while letting the
+// target independent and default TTI implementations handle the rest.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SNES_TARGET_TRANSFORM_INFO_H
+#define LLVM_SNES_TARGET_TRANSFORM_INFO_H
+
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/CodeGen/BasicTTIImpl.h"
+#include "llvm/Target/TargetLowering.h"
+
+#include "SNES.h"
+#include "SNESSubtarget.h"
+#include "SNESTargetMachine.h"
+
+namespace llvm {
+
+class SNESTTIImpl : public BasicTTIImplBase<SNESTTIImpl> {
+  typedef BasicTTIImplBase<SNESTTIImpl> BaseT;
+  typedef TargetTransformInfo TTI;
+  friend BaseT;
+
+  const SNESSubtarget *ST;
+  const SNESTargetLowering *TLI;
+
+  const SNESSubtarget *getST() const { return ST; }
+  const SNESTargetLowering *getTLI() const { return TLI; }
+
+public:
+  explicit SNESTTIImpl(const SNESTargetMachine *TM, const Function &F)
+      : BaseT(TM, F.getParent()->getDataLayout()), ST(TM->getSubtargetImpl(F)),
+        TLI(ST->getTargetLowering()) {}
+
+  /// A, X and Y.
+  unsigned getNumberOfRegisters(bool Vector) { return Vector ? 0 : 3; }
+
+  unsigned getRegisterBitWidth(bool Vector) const { return Vector ? 0 : 16; }
+
+  /// With three registers, every extra live value in a loop is a spill, so
+  /// LSR should first minimize the registers and then the instructions. This
+  /// favours a single counter in X counting down to zero, which is also the
+  /// index of the `abs,X` accesses.
+  bool isLSRCostLess(TTI::LSRCost &C1, TTI::LSRCost &C2) {
+    return std::tie(C1.NumRegs, C1.Insns, C1.AddRecCost, C1.NumIVMuls,
+                    C1.NumBaseAdds, C1.ScaleCost, C1.ImmCost, C1.SetupCost) <
+           std::tie(C2.NumRegs, C2.Insns, C2.AddRecCost, C2.NumIVMuls,
+                    C2.NumBaseAdds, C2.ScaleCost, C2.ImmCost, C2.SetupCost);
+  }
+
+  /// The index of `abs,X` and `(dp),Y` is added for free as long as the
+  /// address moves by a constant step. Anything else needs the address
+  /// computed in the accumulator and stored to the direct page.
+  unsigned getAddressComputationCost(Type *Ty, ScalarEvolution *SE,
+                                     const SCEV *Ptr) {
+    if (!SE || !Ptr)
+      return 0;
+
+    if (const auto *AR = dyn_cast<SCEVAddRecExpr>(Ptr))
+      if (AR->isAffine() && isa<SCEVConstant>(AR->getStepRecurrence(*SE)))
+        return 0;
+
+    return 2;
+  }
+
+  // The costs below are derived from cycle counts, see
+  // SNESTargetTransformInfo.cpp.
+  using BaseT::getIntImmCost;
+  int getIntImmCost(const APInt &Imm, Type *Ty);
+  int getIntImmCost(unsigned Opcode, unsigned Idx, const APInt &Imm, Type *Ty);
+
+  unsigned getArithmeticInstrCost(
+      unsigned Opcode, Type *Ty,
+      TTI::OperandValueKind Opd1Info = TTI::OK_AnyValue,
+      TTI::OperandValueKind Opd2Info = TTI::OK_AnyValue,
+      TTI::OperandValueProperties Opd1PropInfo = TTI::OP_None,
+      TTI::OperandValueProperties Opd2PropInfo = TTI::OP_None,
+      ArrayRef<const Value *> Args = ArrayRef<const Value *>());
+
+  unsigned getCastInstrCost(unsigned Opcode, Type *Dst, Type *Src,
+                            const Instruction *I = nullptr);
+
+  unsigned getCmpSelInstrCost(unsigned Opcode, Type *ValTy, Type *CondTy,
+                              const Instruction *I = nullptr);
+
+  unsigned getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
+                           unsigned AddressSpace,
+                           const Instruction *I = nullptr);
+
+  using BaseT::getIntrinsicInstrCost;
+  unsigned getIntrinsicInstrCost(Intrinsic::ID IID, Type *RetTy,
+                                 ArrayRef<Type *> Tys, FastMathFlags FMF,
+                                 unsigned ScalarizationCostPassed = UINT_MAX);
+
+  void getUnrollingPreferences(Loop *L, ScalarEvolution &SE,
+                               TTI::UnrollingPreferences &UP);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SNES_TARGET_TRANSFORM_INFO_H
@@ -0,0 +1,204 @@
+//===-- SNESTransferOpt.cpp - Remove transfers between A, X and Y ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass which cleans up the transfers between A, X and Y
+// left by register allocation.
+//
+// Copies are lowered to TAX, TXA, TAY, TYA, TXY and TYX after allocation, so
+// the generic copy propagation never sees them. Within a block the pass
+// follows which of A, X and Y hold the same value and:
+//
+//   * removes a transfer to a register which already holds the value,
+//   * removes a transfer whose destination is not read again,
+//   * turns a value moved through a register which dies there into a direct
+//     transfer, `TXA; TAY` into `TXY`.
+//
+// Transfers set N and Z, so they are only removed when nothing tests the
+// flags they set.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SNES.h"
+#include "SNESInstrInfo.h"
+#include "SNESTargetMachine.h"
+#include "MCTargetDesc/SNESMCTargetDesc.h"
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "snes-transfer-opt"
+
+STATISTIC(NumTransfersRemoved, "Number of redundant or dead transfers removed");
+STATISTIC(NumTransfersFolded, "Number of transfer pairs folded into one");
+
+#define SNES_TRANSFER_OPT_NAME "SNES transfer optimization pass"
+
+namespace {
+
+class SNESTransferOpt : public MachineFunctionPass {
+public:
+  static char ID;
+
+  SNESTransferOpt() : MachineFunctionPass(ID) {
+    initializeSNESTransferOptPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return SNES_TRANSFER_OPT_NAME; }
+
+private:
+  typedef MachineBasicBlock Block;
+  typedef Block::iterator BlockIt;
+
+  const SNESInstrInfo *TII;
+  const TargetRegisterInfo *TRI;
+
+  /// A number for the value each of A, X and Y holds. Equal numbers are
+  /// equal values.
+  DenseMap<unsigned, unsigned> Value;
+  unsigned NextValue;
+
+  bool isDeadAfter(Block &MBB, BlockIt I, unsigned Reg) const;
+  bool foldTransfers(Block &MBB, BlockIt I, BlockIt Next);
+  bool optimizeBlock(Block &MBB);
+};
+
+char SNESTransferOpt::ID = 0;
+
+static const unsigned Regs[] = {SNES::A, SNES::X, SNES::Y};
+
+/// Checks if the value of a register after an instruction is never read.
+bool SNESTransferOpt::isDeadAfter(Block &MBB, BlockIt I, unsigned Reg) const {
+  for (BlockIt J = std::next(I), E = MBB.end(); J != E; ++J) {
+    // readsRegister() does not see a read of the low half, e.g. a byte
+    // store of AL after a TXA.
+    for (const MachineOperand &MO : J->operands())
+      if (MO.isReg() && MO.isUse() && MO.getReg() &&
+          TRI->regsOverlap(MO.getReg(), Reg))
+        return false;
+    // A byte written to the low half leaves the high half, which is read as
+    // part of the word.
+    if (J->findRegisterDefOperandIdx(Reg, false, false, TRI) != -1)
+      return true;
+  }
+
+  for (const Block *Succ : MBB.successors())
+    for (const auto &LI : Succ->liveins())
+      if (TRI->regsOverlap(LI.PhysReg, Reg))
+        return false;
+  return true;
+}
+
+/// Turns `I: R1 -> R2; Next: R2 -> R3` into `R1 -> R3` when R2 is not read
+/// after. Both set N and Z from the same value.
+bool SNESTransferOpt::foldTransfers(Block &MBB, BlockIt I, BlockIt Next) {
+  unsigned Dst1, Src1, Dst2, Src2;
+  if (Next == MBB.end() || !SNESInstrInfo::isTransfer(*I, Dst1, Src1) ||
+      !SNESInstrInfo::isTransfer(*Next, Dst2, Src2) || Src2 != Dst1 ||
+      Dst2 == Src1 || !isDeadAfter(MBB, Next, Dst1))
+    return false;
+
+  // Keep the width of the copy into A, the accumulator width pass reads it
+  // off the operands.
+  unsigned Dst = Dst2, Src = Src1;
+  if (Dst2 == SNES::A && Next->definesRegister(SNES::AL)) {
+    Dst = SNES::AL;
+    Src = TRI->getSubReg(Src1, SNES::sub_lo);
+  }
+
+  BuildMI(MBB, Next, Next->getDebugLoc(),
+          TII->get(SNESInstrInfo::getTransferOpcode(Dst2, Src1)))
+      .addReg(Dst, RegState::Define | RegState::Implicit)
+      .addReg(Src, RegState::Implicit);
+
+  // The new transfer is looked at again, and only then copies the value.
+  Next->eraseFromParent();
+  I->eraseFromParent();
+  return true;
+}
+
+bool SNESTransferOpt::optimizeBlock(Block &MBB) {
+  bool Modified = false;
+
+  // Nothing is known to be equal on entry.
+  for (unsigned Reg : Regs)
+    Value[Reg] = NextValue++;
+
+  BlockIt MBBI = MBB.begin(), E = MBB.end();
+  while (MBBI != E) {
+    BlockIt Next = std::next(MBBI);
+    unsigned Dst, Src;
+
+    if (!SNESInstrInfo::isTransfer(*MBBI, Dst, Src)) {
+      for (unsigned Reg : Regs)
+        if (MBBI->modifiesRegister(Reg, TRI))
+          Value[Reg] = NextValue++;
+      MBBI = Next;
+      continue;
+    }
+
+    // A transfer sets N and Z, which a branch may test after a CLC or a
+    // SEP that leaves them alone.
+    bool FlagsRead = SNESInstrInfo::isNZReadAfter(MBB, MBBI);
+    if (!FlagsRead &&
+        (Value[Dst] == Value[Src] || isDeadAfter(MBB, MBBI, Dst))) {
+      MBBI->eraseFromParent();
+      MBBI = Next;
+      ++NumTransfersRemoved;
+      Modified = true;
+      continue;
+    }
+
+    BlockIt After = Next == E ? E : std::next(Next);
+    if (!FlagsRead && foldTransfers(MBB, MBBI, Next)) {
+      // Look at the new transfer again, it may be redundant now.
+      MBBI = std::prev(After);
+      ++NumTransfersFolded;
+      Modified = true;
+      continue;
+    }
+
+    // With M set TXA and TYA only copy the low byte.
+    if (Dst == SNES::A && MBBI->definesRegister(SNES::AL))
+      Value[Dst] = NextValue++;
+    else
+      Value[Dst] = Value[Src];
+    MBBI = Next;
+  }
+
+  return Modified;
+}
+
+bool SNESTransferOpt::runOnMachineFunction(MachineFunction &MF) {
+  const SNESSubtarget &STI = MF.getSubtarget<SNESSubtarget>();
+  TII = STI.getInstrInfo();
+  TRI = STI.getRegisterInfo();
+  NextValue = 0;
+
+  bool Modified = false;
+  for (Block &MBB : MF)
+    Modified |= optimizeBlock(MBB);
+  return Modified;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SNESTransferOpt, "snes-transfer-opt", SNES_TRANSFER_OPT_NAME,
+                false, false)
+
+namespace llvm {
+
+FunctionPass *createSNESTransferOptPass() { return new SNESTransferOpt(); }
+
+} // end of namespace llvm
@@ -0,0 +1,54 @@
+//===-- SPC700.h - Top-level interface for SPC700 ---------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the entry points for global functions defined in the LLVM
+// SPC700 back-end. The SPC700 is the CPU of the SNES audio subsystem, it is
+// built as part of the SNES target.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_H
+#define LLVM_SPC700_H
+
+#include "llvm/Target/TargetMachine.h"
+
+namespace llvm {
+
+class SPC700TargetMachine;
+class FunctionPass;
+
+FunctionPass *createSPC700ISelDag(SPC700TargetMachine &TM,
+                                  CodeGenOpt::Level OptLevel);
+FunctionPass *createSPC700ExpandPseudoPass();
+
+void initializeSPC700ExpandPseudoPass(PassRegistry&);
+
+/// Register the SPC700 target machine and asm printer, called along with the
+/// SNES ones.
+void registerSPC700Target();
+void registerSPC700AsmPrinter();
+
+/// Contains the SPC700 backend.
+namespace SPC700 {
+
+/// The stack lives in page 1, SP only holds the low byte of its address.
+const unsigned StackPage = 0x100;
+
+/// The largest frame the stack pseudos can address.
+const unsigned MaxFrameSize = 0xff;
+
+/// The runtime's trampoline for indirect calls, a `JMP !abs` in the direct
+/// page whose operand the caller overwrites.
+const char *const IndirectCallTrampoline = "__spc700_icall";
+
+} // end of namespace SPC700
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_H
@@ -0,0 +1,52 @@
+//===-- SPC700AsmPrinter.cpp - SPC700 LLVM assembly writer ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a printer that converts from our internal representation
+// of machine-dependent LLVM code to GAS-format SPC700 assembly language.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700.h"
+#include "SPC700MCInstLower.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/CodeGen/AsmPrinter.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/TargetRegistry.h"
+
+#define DEBUG_TYPE "spc700-asm-printer"
+
+namespace llvm {
+
+/// An SPC700 assembly code printer.
+class SPC700AsmPrinter : public AsmPrinter {
+public:
+  SPC700AsmPrinter(TargetMachine &TM, std::unique_ptr<MCStreamer> Streamer)
+      : AsmPrinter(TM, std::move(Streamer)) {}
+
+  StringRef getPassName() const override { return "SPC700 Assembly Printer"; }
+
+  void EmitInstruction(const MachineInstr *MI) override;
+};
+
+void SPC700AsmPrinter::EmitInstruction(const MachineInstr *MI) {
+  SPC700MCInstLower MCInstLowering(OutContext, *this);
+
+  MCInst I;
+  MCInstLowering.lowerInstruction(*MI, I);
+  EmitToStreamer(*OutStreamer, I);
+}
+
+void registerSPC700AsmPrinter() {
+  RegisterAsmPrinter<SPC700AsmPrinter> X(getTheSPC700Target());
+}
+
+} // end of namespace llvm
@@ -0,0 +1,721 @@
+//===-- SPC700ExpandPseudoInsts.cpp - Expand pseudo instructions ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains a pass that expands pseudo instructions into target
+// instructions. This pass should be run after register allocation but before
+// the post-regalloc scheduling pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700.h"
+#include "SPC700InstrInfo.h"
+#include "SPC700TargetMachine.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+#define SPC700_EXPAND_PSEUDO_NAME "SPC700 pseudo instruction expansion pass"
+
+namespace {
+
+/// Expands "placeholder" instructions marked as pseudo into
+/// actual SPC700 instructions.
+class SPC700ExpandPseudo : public MachineFunctionPass {
+public:
+  static char ID;
+
+  SPC700ExpandPseudo() : MachineFunctionPass(ID) {
+    initializeSPC700ExpandPseudoPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return SPC700_EXPAND_PSEUDO_NAME; }
+
+private:
+  typedef MachineBasicBlock Block;
+  typedef Block::iterator BlockIt;
+
+  const SPC700RegisterInfo *TRI;
+  const SPC700InstrInfo *TII;
+
+  /// The reserved direct page bytes used for temporary storage. A goes in
+  /// the first, X in the second.
+  const unsigned SCRATCH_A = SPC700::R14;
+  const unsigned SCRATCH_X = SPC700::R15;
+
+  bool expandMBB(Block &MBB);
+  bool expandMI(Block &MBB, BlockIt MBBI);
+  template <unsigned OP> bool expand(Block &MBB, BlockIt MBBI);
+
+  MachineInstrBuilder buildMI(Block &MBB, BlockIt MBBI, unsigned Opcode) {
+    return BuildMI(MBB, MBBI, MBBI->getDebugLoc(), TII->get(Opcode));
+  }
+
+  MachineInstrBuilder buildMI(Block &MBB, BlockIt MBBI, unsigned Opcode,
+                              unsigned DstReg) {
+    return BuildMI(MBB, MBBI, MBBI->getDebugLoc(), TII->get(Opcode), DstReg);
+  }
+
+  void buildLoadImm8(Block &MBB, BlockIt MBBI, unsigned DstReg,
+                     const MachineOperand &Op, unsigned Byte);
+  void buildMoveFromA(Block &MBB, BlockIt MBBI, unsigned DstReg);
+  void buildMoveToA(Block &MBB, BlockIt MBBI, unsigned SrcReg);
+
+  bool expandLogic(unsigned Op, Block &MBB, BlockIt MBBI);
+  bool expandLogicImm(unsigned Op, Block &MBB, BlockIt MBBI);
+  bool expandFrameLoad(Block &MBB, BlockIt MBBI);
+  bool expandFrameStore(Block &MBB, BlockIt MBBI);
+};
+
+char SPC700ExpandPseudo::ID = 0;
+
+/// Gets the byte \p Byte of an immediate or a symbol operand.
+static MachineOperand getByte(const MachineOperand &Op, unsigned Byte) {
+  if (Op.isImm())
+    return MachineOperand::CreateImm((Op.getImm() >> (8 * Byte)) & 0xff);
+
+  MachineOperand MO = Op;
+  MO.setTargetFlags(Byte ? SPC700II::MO_HI : SPC700II::MO_LO);
+  return MO;
+}
+
+/// Gets an address operand \p Offset bytes after \p Op.
+static MachineOperand getAddrPlus(const MachineOperand &Op, int64_t Offset) {
+  if (Op.isImm())
+    return MachineOperand::CreateImm(Op.getImm() + Offset);
+
+  MachineOperand MO = Op;
+  MO.setOffset(MO.getOffset() + Offset);
+  return MO;
+}
+
+bool SPC700ExpandPseudo::expandMBB(MachineBasicBlock &MBB) {
+  bool Modified = false;
+
+  BlockIt MBBI = MBB.begin(), E = MBB.end();
+  while (MBBI != E) {
+    BlockIt NMBBI = std::next(MBBI);
+    Modified |= expandMI(MBB, MBBI);
+    MBBI = NMBBI;
+  }
+
+  return Modified;
+}
+
+bool SPC700ExpandPseudo::runOnMachineFunction(MachineFunction &MF) {
+  bool Modified = false;
+
+  const SPC700Subtarget &STI = MF.getSubtarget<SPC700Subtarget>();
+  TRI = STI.getRegisterInfo();
+  TII = STI.getInstrInfo();
+
+  for (Block &MBB : MF)
+    Modified |= expandMBB(MBB);
+
+  return Modified;
+}
+
+void SPC700ExpandPseudo::buildLoadImm8(Block &MBB, BlockIt MBBI,
+                                       unsigned DstReg,
+                                       const MachineOperand &Op,
+                                       unsigned Byte) {
+  unsigned Opc;
+  switch (DstReg) {
+  case SPC700::A:
+    Opc = SPC700::MOVAimm;
+    break;
+  case SPC700::X:
+    Opc = SPC700::MOVXimm;
+    break;
+  case SPC700::Y:
+    Opc = SPC700::MOVYimm;
+    break;
+  default:
+    Opc = SPC700::MOVdpimm;
+    break;
+  }
+
+  buildMI(MBB, MBBI, Opc, DstReg).add(getByte(Op, Byte));
+}
+
+void SPC700ExpandPseudo::buildMoveFromA(Block &MBB, BlockIt MBBI,
+                                        unsigned DstReg) {
+  switch (DstReg) {
+  case SPC700::A:
+    return;
+  case SPC700::X:
+    buildMI(MBB, MBBI, SPC700::MOVXA, DstReg).addReg(SPC700::A);
+    return;
+  case SPC700::Y:
+    buildMI(MBB, MBBI, SPC700::MOVYA, DstReg).addReg(SPC700::A);
+    return;
+  default:
+    buildMI(MBB, MBBI, SPC700::MOVdpA, DstReg).addReg(SPC700::A);
+    return;
+  }
+}
+
+void SPC700ExpandPseudo::buildMoveToA(Block &MBB, BlockIt MBBI,
+                                      unsigned SrcReg) {
+  switch (SrcReg) {
+  case SPC700::A:
+    return;
+  case SPC700::X:
+    buildMI(MBB, MBBI, SPC700::MOVAX, SPC700::A).addReg(SrcReg);
+    return;
+  case SPC700::Y:
+    buildMI(MBB, MBBI, SPC700::MOVAY, SPC700::A).addReg(SrcReg);
+    return;
+  default:
+    buildMI(MBB, MBBI, SPC700::MOVAdp, SPC700::A).addReg(SrcReg);
+    return;
+  }
+}
+
+bool SPC700ExpandPseudo::expandLogic(unsigned Op, Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned SrcLoReg, SrcHiReg, DstLoReg, DstHiReg;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned SrcReg = MI.getOperand(2).getReg();
+  bool SrcIsKill = MI.getOperand(2).isKill();
+  TRI->splitReg(SrcReg, SrcLoReg, SrcHiReg);
+  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
+
+  buildMI(MBB, MBBI, Op, DstLoReg)
+      .addReg(DstLoReg, RegState::Kill)
+      .addReg(SrcLoReg, getKillRegState(SrcIsKill));
+
+  buildMI(MBB, MBBI, Op, DstHiReg)
+      .addReg(DstHiReg, RegState::Kill)
+      .addReg(SrcHiReg, getKillRegState(SrcIsKill));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+bool SPC700ExpandPseudo::expandLogicImm(unsigned Op, Block &MBB,
+                                        BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  unsigned Imm = MI.getOperand(2).getImm();
+  TRI->splitReg(DstReg, DstLoReg, DstHiReg);
+
+  for (unsigned Byte = 0; Byte != 2; ++Byte) {
+    unsigned Reg = Byte ? DstHiReg : DstLoReg;
+    unsigned Val = (Imm >> (8 * Byte)) & 0xff;
+
+    // `AND #$FF`, `OR #0` and `EOR #0` leave the byte alone.
+    if ((Op == SPC700::ANDdpimm && Val == 0xff) ||
+        (Op != SPC700::ANDdpimm && Val == 0))
+      continue;
+
+    // The result doesn't depend on the byte, a plain store is shorter.
+    if ((Op == SPC700::ANDdpimm && Val == 0) ||
+        (Op == SPC700::ORdpimm && Val == 0xff)) {
+      buildMI(MBB, MBBI, SPC700::MOVdpimm, Reg).addImm(Val);
+      continue;
+    }
+
+    buildMI(MBB, MBBI, Op, Reg).addReg(Reg, RegState::Kill).addImm(Val);
+  }
+
+  MI.eraseFromParent();
+  return true;
+}
+
+/// Loads a stack slot through `!$0100+offset+X`, with SP in X.
+///
+/// A and X are parked in the scratch bytes unless they are the
+/// destination, the flags are pushed when they are live.
+bool SPC700ExpandPseudo::expandFrameLoad(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+  int64_t Offset = MI.getOperand(2).getImm();
+
+  // The bytes to load, the one in A comes last.
+  SmallVector<std::pair<unsigned, unsigned>, 2> Bytes;
+  if (DstReg == SPC700::YA) {
+    Bytes.push_back(std::make_pair(SPC700::Y, 1u));
+    Bytes.push_back(std::make_pair(SPC700::A, 0u));
+  } else if (SPC700::GPR16RegClass.contains(DstReg)) {
+    unsigned DstLoReg, DstHiReg;
+    TRI->splitReg(DstReg, DstLoReg, DstHiReg);
+    Bytes.push_back(std::make_pair(DstLoReg, 0u));
+    Bytes.push_back(std::make_pair(DstHiReg, 1u));
+  } else {
+    Bytes.push_back(std::make_pair(DstReg, 0u));
+  }
+
+  bool SavePSW = TII->isPSWLive(MBB, MBBI);
+  bool SaveA = Bytes.back().first != SPC700::A;
+  bool SaveX = DstReg != SPC700::X;
+
+  // Pushing the flags moves SP down by one.
+  if (SavePSW) {
+    buildMI(MBB, MBBI, SPC700::PUSHPSW);
+    ++Offset;
+  }
+  if (SaveA)
+    buildMI(MBB, MBBI, SPC700::MOVdpA, SCRATCH_A).addReg(SPC700::A);
+  if (SaveX)
+    buildMI(MBB, MBBI, SPC700::MOVdpX, SCRATCH_X).addReg(SPC700::X);
+
+  buildMI(MBB, MBBI, SPC700::MOVXSP, SPC700::X);
+  for (auto &B : Bytes) {
+    buildMI(MBB, MBBI, SPC700::MOVAabsX, SPC700::A)
+        .addImm(SPC700::StackPage + Offset + B.second)
+        .addReg(SPC700::X);
+    buildMoveFromA(MBB, MBBI, B.first);
+  }
+
+  if (SaveX)
+    buildMI(MBB, MBBI, SPC700::MOVXdp, SPC700::X).addReg(SCRATCH_X);
+  if (SaveA)
+    buildMI(MBB, MBBI, SPC700::MOVAdp, SPC700::A).addReg(SCRATCH_A);
+  if (SavePSW)
+    buildMI(MBB, MBBI, SPC700::POPPSW);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+/// Stores to a stack slot through `!$0100+offset+X`, with SP in X.
+///
+/// Every byte goes through A. A and X are restored from the scratch bytes,
+/// a source in X is read back from there.
+bool SPC700ExpandPseudo::expandFrameStore(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  int64_t Offset = MI.getOperand(1).getImm();
+  unsigned SrcReg = MI.getOperand(2).getReg();
+
+  // The bytes to store, the one in A comes first.
+  SmallVector<std::pair<unsigned, unsigned>, 2> Bytes;
+  if (SrcReg == SPC700::YA) {
+    Bytes.push_back(std::make_pair(SPC700::A, 0u));
+    Bytes.push_back(std::make_pair(SPC700::Y, 1u));
+  } else if (SPC700::GPR16RegClass.contains(SrcReg)) {
+    unsigned SrcLoReg, SrcHiReg;
+    TRI->splitReg(SrcReg, SrcLoReg, SrcHiReg);
+    Bytes.push_back(std::make_pair(SrcLoReg, 0u));
+    Bytes.push_back(std::make_pair(SrcHiReg, 1u));
+  } else {
+    Bytes.push_back(std::make_pair(SrcReg, 0u));
+  }
+
+  bool SavePSW = TII->isPSWLive(MBB, MBBI);
+  bool SaveA = SrcReg != SPC700::A;
+
+  if (SavePSW) {
+    buildMI(MBB, MBBI, SPC700::PUSHPSW);
+    ++Offset;
+  }
+  if (SaveA)
+    buildMI(MBB, MBBI, SPC700::MOVdpA, SCRATCH_A).addReg(SPC700::A);
+  buildMI(MBB, MBBI, SPC700::MOVdpX, SCRATCH_X).addReg(SPC700::X);
+
+  buildMI(MBB, MBBI, SPC700::MOVXSP, SPC700::X);
+  for (auto &B : Bytes) {
+    buildMoveToA(MBB, MBBI, B.first == SPC700::X ? SCRATCH_X : B.first);
+    buildMI(MBB, MBBI, SPC700::MOVabsXA)
+        .addImm(SPC700::StackPage + Offset + B.second)
+        .addReg(SPC700::X)
+        .addReg(SPC700::A);
+  }
+
+  buildMI(MBB, MBBI, SPC700::MOVXdp, SPC700::X).addReg(SCRATCH_X);
+  if (SaveA)
+    buildMI(MBB, MBBI, SPC700::MOVAdp, SPC700::A).addReg(SCRATCH_A);
+  if (SavePSW)
+    buildMI(MBB, MBBI, SPC700::POPPSW);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDI8>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  buildLoadImm8(MBB, MBBI, MI.getOperand(0).getReg(), MI.getOperand(1), 0);
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDI16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  buildLoadImm8(MBB, MBBI, DstLoReg, MI.getOperand(1), 0);
+  buildLoadImm8(MBB, MBBI, DstHiReg, MI.getOperand(1), 1);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::SEXT>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  unsigned SrcReg = MI.getOperand(1).getReg();
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  // mov a, src
+  // mov lo, a
+  // asl a        ; the sign goes in C
+  // mov a, #0
+  // sbc a, #0    ; $00 if negative, $FF otherwise
+  // eor a, #$ff
+  // mov hi, a
+  buildMoveToA(MBB, MBBI, SrcReg);
+  buildMI(MBB, MBBI, SPC700::MOVdpA, DstLoReg).addReg(SPC700::A);
+  buildMI(MBB, MBBI, SPC700::ASLA, SPC700::A).addReg(SPC700::A);
+  buildMI(MBB, MBBI, SPC700::MOVAimm, SPC700::A).addImm(0);
+  buildMI(MBB, MBBI, SPC700::SBCAimm, SPC700::A)
+      .addReg(SPC700::A)
+      .addImm(0);
+  buildMI(MBB, MBBI, SPC700::EORAimm, SPC700::A)
+      .addReg(SPC700::A)
+      .addImm(0xff);
+  buildMI(MBB, MBBI, SPC700::MOVdpA, DstHiReg)
+      .addReg(SPC700::A, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::AND16dd>(Block &MBB, BlockIt MBBI) {
+  return expandLogic(SPC700::ANDdpdp, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::AND16di>(Block &MBB, BlockIt MBBI) {
+  return expandLogicImm(SPC700::ANDdpimm, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::OR16dd>(Block &MBB, BlockIt MBBI) {
+  return expandLogic(SPC700::ORdpdp, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::OR16di>(Block &MBB, BlockIt MBBI) {
+  return expandLogicImm(SPC700::ORdpimm, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::XOR16dd>(Block &MBB, BlockIt MBBI) {
+  return expandLogic(SPC700::EORdpdp, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::XOR16di>(Block &MBB, BlockIt MBBI) {
+  return expandLogicImm(SPC700::EORdpimm, MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::ASR8>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstReg = MI.getOperand(0).getReg();
+
+  // cmp r, #$80  ; C = sign
+  // ror r
+  buildMI(MBB, MBBI, SPC700::CMPdpimm).addReg(DstReg).addImm(0x80);
+  buildMI(MBB, MBBI, SPC700::RORdp, DstReg).addReg(DstReg, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LSL16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  buildMI(MBB, MBBI, SPC700::ASLdp, DstLoReg)
+      .addReg(DstLoReg, RegState::Kill);
+  buildMI(MBB, MBBI, SPC700::ROLdp, DstHiReg)
+      .addReg(DstHiReg, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LSR16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  buildMI(MBB, MBBI, SPC700::LSRdp, DstHiReg)
+      .addReg(DstHiReg, RegState::Kill);
+  buildMI(MBB, MBBI, SPC700::RORdp, DstLoReg)
+      .addReg(DstLoReg, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::ASR16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  buildMI(MBB, MBBI, SPC700::CMPdpimm).addReg(DstHiReg).addImm(0x80);
+  buildMI(MBB, MBBI, SPC700::RORdp, DstHiReg)
+      .addReg(DstHiReg, RegState::Kill);
+  buildMI(MBB, MBBI, SPC700::RORdp, DstLoReg)
+      .addReg(DstLoReg, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDabs16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  const MachineOperand &Addr = MI.getOperand(1);
+
+  buildMI(MBB, MBBI, SPC700::MOVAabs, SPC700::A).add(getAddrPlus(Addr, 0));
+  buildMI(MBB, MBBI, SPC700::MOVYabs, SPC700::Y).add(getAddrPlus(Addr, 1));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::STabs16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  const MachineOperand &Addr = MI.getOperand(0);
+  bool SrcIsKill = MI.getOperand(1).isKill();
+
+  buildMI(MBB, MBBI, SPC700::MOVabsA)
+      .add(getAddrPlus(Addr, 0))
+      .addReg(SPC700::A, getKillRegState(SrcIsKill));
+  buildMI(MBB, MBBI, SPC700::MOVabsY)
+      .add(getAddrPlus(Addr, 1))
+      .addReg(SPC700::Y, getKillRegState(SrcIsKill));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDind16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned PtrReg = MI.getOperand(1).getReg();
+  bool PtrIsKill = MI.getOperand(1).isKill();
+  int64_t Offset = MI.getOperand(2).getImm();
+
+  // mov y, #off+1
+  // mov a, [ptr]+y
+  // mov scratch, a
+  // dec y
+  // mov a, [ptr]+y
+  // mov y, scratch
+  buildMI(MBB, MBBI, SPC700::MOVYimm, SPC700::Y).addImm(Offset + 1);
+  buildMI(MBB, MBBI, SPC700::MOVAindY, SPC700::A)
+      .addReg(PtrReg)
+      .addReg(SPC700::Y);
+  buildMI(MBB, MBBI, SPC700::MOVdpA, SCRATCH_A).addReg(SPC700::A);
+  buildMI(MBB, MBBI, SPC700::DECY, SPC700::Y).addReg(SPC700::Y);
+  buildMI(MBB, MBBI, SPC700::MOVAindY, SPC700::A)
+      .addReg(PtrReg, getKillRegState(PtrIsKill))
+      .addReg(SPC700::Y);
+  buildMI(MBB, MBBI, SPC700::MOVYdp, SPC700::Y).addReg(SCRATCH_A);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::STind16>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned PtrReg = MI.getOperand(0).getReg();
+  bool PtrIsKill = MI.getOperand(0).isKill();
+  int64_t Offset = MI.getOperand(1).getImm();
+
+  // mov scratch, y
+  // mov y, #off
+  // mov [ptr]+y, a
+  // mov a, scratch
+  // inc y
+  // mov [ptr]+y, a
+  buildMI(MBB, MBBI, SPC700::MOVdpY, SCRATCH_A).addReg(SPC700::Y);
+  buildMI(MBB, MBBI, SPC700::MOVYimm, SPC700::Y).addImm(Offset);
+  buildMI(MBB, MBBI, SPC700::MOVindYA)
+      .addReg(PtrReg)
+      .addReg(SPC700::Y)
+      .addReg(SPC700::A);
+  buildMI(MBB, MBBI, SPC700::MOVAdp, SPC700::A).addReg(SCRATCH_A);
+  buildMI(MBB, MBBI, SPC700::INCY, SPC700::Y).addReg(SPC700::Y);
+  buildMI(MBB, MBBI, SPC700::MOVindYA)
+      .addReg(PtrReg, getKillRegState(PtrIsKill))
+      .addReg(SPC700::Y)
+      .addReg(SPC700::A);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDfi8>(Block &MBB, BlockIt MBBI) {
+  return expandFrameLoad(MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::LDfi16>(Block &MBB, BlockIt MBBI) {
+  return expandFrameLoad(MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::STfi8>(Block &MBB, BlockIt MBBI) {
+  return expandFrameStore(MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::STfi16>(Block &MBB, BlockIt MBBI) {
+  return expandFrameStore(MBB, MBBI);
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::FRMIDX>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned DstLoReg, DstHiReg;
+  int64_t Offset = MI.getOperand(2).getImm();
+  TRI->splitReg(MI.getOperand(0).getReg(), DstLoReg, DstHiReg);
+
+  // mov scratch, x
+  // mov x, sp
+  // mov lo, x
+  // mov hi, #1
+  // clrc
+  // adc lo, #off
+  // adc hi, #0
+  // mov x, scratch
+  buildMI(MBB, MBBI, SPC700::MOVdpX, SCRATCH_X).addReg(SPC700::X);
+  buildMI(MBB, MBBI, SPC700::MOVXSP, SPC700::X);
+  buildMI(MBB, MBBI, SPC700::MOVdpX, DstLoReg).addReg(SPC700::X);
+  buildMI(MBB, MBBI, SPC700::MOVdpimm, DstHiReg)
+      .addImm(SPC700::StackPage >> 8);
+  buildMI(MBB, MBBI, SPC700::CLRC);
+  buildMI(MBB, MBBI, SPC700::ADCdpimm, DstLoReg)
+      .addReg(DstLoReg, RegState::Kill)
+      .addImm(Offset);
+  buildMI(MBB, MBBI, SPC700::ADCdpimm, DstHiReg)
+      .addReg(DstHiReg, RegState::Kill)
+      .addImm(0);
+  buildMI(MBB, MBBI, SPC700::MOVXdp, SPC700::X).addReg(SCRATCH_X);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::ICALL>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned PtrLoReg, PtrHiReg;
+  TRI->splitReg(MI.getOperand(0).getReg(), PtrLoReg, PtrHiReg);
+
+  // There is no indirect call. The runtime keeps a `JMP !abs` in the direct
+  // page, the target goes in its operand and the call goes through it.
+  MachineOperand Trampoline = MachineOperand::CreateES(
+      SPC700::IndirectCallTrampoline);
+
+  buildMI(MBB, MBBI, SPC700::MOVdpaddrdp)
+      .add(getAddrPlus(Trampoline, 1))
+      .addReg(PtrLoReg);
+  buildMI(MBB, MBBI, SPC700::MOVdpaddrdp)
+      .add(getAddrPlus(Trampoline, 2))
+      .addReg(PtrHiReg);
+
+  // Keep the argument registers and the register mask.
+  MachineInstrBuilder MIB = buildMI(MBB, MBBI, SPC700::CALL).add(Trampoline);
+  for (unsigned I = 1, E = MI.getNumOperands(); I != E; ++I)
+    MIB.add(MI.getOperand(I));
+
+  MI.eraseFromParent();
+  return true;
+}
+
+template <>
+bool SPC700ExpandPseudo::expand<SPC700::BRIND>(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  unsigned PtrReg = MI.getOperand(0).getReg();
+
+  // mov x, #0
+  // jmp [!ptr+x]
+  buildMI(MBB, MBBI, SPC700::MOVXimm, SPC700::X).addImm(0);
+  buildMI(MBB, MBBI, SPC700::JMPabsX)
+      .addImm(TRI->getEncodingValue(PtrReg))
+      .addReg(SPC700::X, RegState::Kill);
+
+  MI.eraseFromParent();
+  return true;
+}
+
+bool SPC700ExpandPseudo::expandMI(Block &MBB, BlockIt MBBI) {
+  MachineInstr &MI = *MBBI;
+  int Opcode = MBBI->getOpcode();
+
+#define EXPAND(Op)               \
+  case Op:                       \
+    return expand<Op>(MBB, MI)
+
+  switch (Opcode) {
+    EXPAND(SPC700::LDI8);
+    EXPAND(SPC700::LDI16);
+    EXPAND(SPC700::SEXT);
+    EXPAND(SPC700::AND16dd);
+    EXPAND(SPC700::AND16di);
+    EXPAND(SPC700::OR16dd);
+    EXPAND(SPC700::OR16di);
+    EXPAND(SPC700::XOR16dd);
+    EXPAND(SPC700::XOR16di);
+    EXPAND(SPC700::ASR8);
+    EXPAND(SPC700::LSL16);
+    EXPAND(SPC700::LSR16);
+    EXPAND(SPC700::ASR16);
+    EXPAND(SPC700::LDabs16);
+    EXPAND(SPC700::STabs16);
+    EXPAND(SPC700::LDind16);
+    EXPAND(SPC700::STind16);
+    EXPAND(SPC700::LDfi8);
+    EXPAND(SPC700::LDfi16);
+    EXPAND(SPC700::STfi8);
+    EXPAND(SPC700::STfi16);
+    EXPAND(SPC700::FRMIDX);
+    EXPAND(SPC700::ICALL);
+    EXPAND(SPC700::BRIND);
+  }
+#undef EXPAND
+  return false;
+}
+
+} // end of anonymous namespace
+
+INITIALIZE_PASS(SPC700ExpandPseudo, "spc700-expand-pseudo",
+                SPC700_EXPAND_PSEUDO_NAME, false, false)
+namespace llvm {
+
+FunctionPass *createSPC700ExpandPseudoPass() {
+  return new SPC700ExpandPseudo();
+}
+
+} // end of namespace llvm
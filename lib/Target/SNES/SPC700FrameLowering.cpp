@@ -0,0 +1,164 @@
+//===-- SPC700FrameLowering.cpp - SPC700 Frame Information ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the SPC700 implementation of TargetFrameLowering class.
+//
+// The stack is in page 1 and SP holds the low byte of the first free slot.
+// There is no frame pointer and no stack relative addressing: the frame is
+// allocated in one go in the prologue and the stack slots are reached from
+// SP, see the LDfi/STfi pseudos in SPC700ExpandPseudoInsts.cpp.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700FrameLowering.h"
+
+#include "SPC700.h"
+#include "SPC700InstrInfo.h"
+#include "SPC700Subtarget.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
+
+namespace llvm {
+
+/// Frames up to this size are pushed and popped a byte at a time, which is
+/// smaller and not slower than going through A.
+static const unsigned MaxPushedFrameSize = 6;
+
+SPC700FrameLowering::SPC700FrameLowering()
+    : TargetFrameLowering(TargetFrameLowering::StackGrowsDown, 1, 0) {}
+
+bool SPC700FrameLowering::hasFP(const MachineFunction &MF) const {
+  return false;
+}
+
+bool SPC700FrameLowering::hasReservedCallFrame(
+    const MachineFunction &MF) const {
+  // Nothing is passed on the stack.
+  return true;
+}
+
+/// Moves SP by \p Amount through A and X. `MOV X, SP` and `MOV SP, X` are the
+/// only ways to read or write SP, and only A has an `ADC`.
+static void adjustSP(MachineBasicBlock &MBB, MachineBasicBlock::iterator MBBI,
+                     const DebugLoc &DL, const SPC700InstrInfo &TII,
+                     int Amount, bool SaveX, MachineInstr::MIFlag Flag) {
+  // A holds an argument or the return value, keep it.
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVdpA), SPC700::R14)
+      .addReg(SPC700::A)
+      .setMIFlag(Flag);
+  if (SaveX) {
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVdpX), SPC700::R15)
+        .addReg(SPC700::X)
+        .setMIFlag(Flag);
+  }
+
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVXSP), SPC700::X).setMIFlag(Flag);
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVAX), SPC700::A)
+      .addReg(SPC700::X, RegState::Kill)
+      .setMIFlag(Flag);
+
+  if (Amount < 0) {
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::SETC)).setMIFlag(Flag);
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::SBCAimm), SPC700::A)
+        .addReg(SPC700::A)
+        .addImm(-Amount)
+        .setMIFlag(Flag);
+  } else {
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::CLRC)).setMIFlag(Flag);
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::ADCAimm), SPC700::A)
+        .addReg(SPC700::A)
+        .addImm(Amount)
+        .setMIFlag(Flag);
+  }
+
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVXA), SPC700::X)
+      .addReg(SPC700::A, RegState::Kill)
+      .setMIFlag(Flag);
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVSPX))
+      .addReg(SPC700::X, RegState::Kill)
+      .setMIFlag(Flag);
+
+  BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVAdp), SPC700::A)
+      .addReg(SPC700::R14)
+      .setMIFlag(Flag);
+  if (SaveX) {
+    BuildMI(MBB, MBBI, DL, TII.get(SPC700::MOVXdp), SPC700::X)
+        .addReg(SPC700::R15)
+        .setMIFlag(Flag);
+  }
+}
+
+void SPC700FrameLowering::emitPrologue(MachineFunction &MF,
+                                       MachineBasicBlock &MBB) const {
+  MachineBasicBlock::iterator MBBI = MBB.begin();
+  DebugLoc DL = (MBBI != MBB.end()) ? MBBI->getDebugLoc() : DebugLoc();
+  const SPC700Subtarget &STI = MF.getSubtarget<SPC700Subtarget>();
+  const SPC700InstrInfo &TII = *STI.getInstrInfo();
+  unsigned FrameSize = MF.getFrameInfo().getStackSize();
+
+  if (FrameSize == 0) {
+    return;
+  }
+
+  if (FrameSize > SPC700::MaxFrameSize) {
+    report_fatal_error("SPC700: stack frame of '" +
+                       MF.getFunction()->getName() + "' is too large");
+  }
+
+  // The arguments are already in A, X and Y, `PUSH A` leaves them there.
+  if (FrameSize <= MaxPushedFrameSize) {
+    for (unsigned I = 0; I != FrameSize; ++I) {
+      BuildMI(MBB, MBBI, DL, TII.get(SPC700::PUSHA))
+          .addReg(SPC700::A)
+          .setMIFlag(MachineInstr::FrameSetup);
+    }
+    return;
+  }
+
+  adjustSP(MBB, MBBI, DL, TII, -int(FrameSize), true,
+           MachineInstr::FrameSetup);
+}
+
+void SPC700FrameLowering::emitEpilogue(MachineFunction &MF,
+                                       MachineBasicBlock &MBB) const {
+  MachineBasicBlock::iterator MBBI = MBB.getLastNonDebugInstr();
+  DebugLoc DL = MBBI->getDebugLoc();
+  const SPC700Subtarget &STI = MF.getSubtarget<SPC700Subtarget>();
+  const SPC700InstrInfo &TII = *STI.getInstrInfo();
+  unsigned FrameSize = MF.getFrameInfo().getStackSize();
+
+  if (FrameSize == 0) {
+    return;
+  }
+
+  // The return value is in A, YA or $06/$07, X is free.
+  if (FrameSize <= MaxPushedFrameSize) {
+    for (unsigned I = 0; I != FrameSize; ++I) {
+      BuildMI(MBB, MBBI, DL, TII.get(SPC700::POPX), SPC700::X)
+          .setMIFlag(MachineInstr::FrameDestroy);
+    }
+    return;
+  }
+
+  adjustSP(MBB, MBBI, DL, TII, FrameSize, false, MachineInstr::FrameDestroy);
+}
+
+MachineBasicBlock::iterator SPC700FrameLowering::eliminateCallFramePseudoInstr(
+    MachineFunction &MF, MachineBasicBlock &MBB,
+    MachineBasicBlock::iterator MI) const {
+  // Nothing is passed on the stack, the call frame is always empty.
+  return MBB.erase(MI);
+}
+
+} // end of namespace llvm
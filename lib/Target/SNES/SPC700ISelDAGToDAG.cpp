@@ -0,0 +1,114 @@
+//===-- SPC700ISelDAGToDAG.cpp - A dag to dag inst selector for SPC700 ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines an instruction selector for the SPC700 target.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700.h"
+#include "SPC700TargetMachine.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/SelectionDAGISel.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "spc700-isel"
+
+namespace llvm {
+
+/// Lowers LLVM IR (in DAG form) to SPC700 MC instructions (in DAG form).
+class SPC700DAGToDAGISel : public SelectionDAGISel {
+public:
+  SPC700DAGToDAGISel(SPC700TargetMachine &TM, CodeGenOpt::Level OptLevel)
+      : SelectionDAGISel(TM, OptLevel) {}
+
+  StringRef getPassName() const override {
+    return "SPC700 DAG->DAG Instruction Selection";
+  }
+
+  bool SelectAddrFI(SDValue N, SDValue &Base, SDValue &Disp);
+
+// Include the pieces autogenerated from the target description.
+#include "SPC700GenDAGISel.inc"
+
+private:
+  void Select(SDNode *N) override;
+  bool trySelect(SDNode *N);
+};
+
+/// Matches a stack slot, optionally with a constant offset into it.
+bool SPC700DAGToDAGISel::SelectAddrFI(SDValue N, SDValue &Base,
+                                      SDValue &Disp) {
+  SDLoc dl(N);
+  MVT PtrVT = getTargetLowering()->getPointerTy(CurDAG->getDataLayout());
+
+  if (const FrameIndexSDNode *FIN = dyn_cast<FrameIndexSDNode>(N)) {
+    Base = CurDAG->getTargetFrameIndex(FIN->getIndex(), PtrVT);
+    Disp = CurDAG->getTargetConstant(0, dl, MVT::i16);
+    return true;
+  }
+
+  if (!CurDAG->isBaseWithConstantOffset(N) ||
+      N.getOperand(0).getOpcode() != ISD::FrameIndex)
+    return false;
+
+  int FI = cast<FrameIndexSDNode>(N.getOperand(0))->getIndex();
+  int64_t Offset = cast<ConstantSDNode>(N.getOperand(1))->getSExtValue();
+
+  // The whole frame is below 256 bytes, eliminateFrameIndex checks the sum.
+  Base = CurDAG->getTargetFrameIndex(FI, PtrVT);
+  Disp = CurDAG->getTargetConstant(Offset, dl, MVT::i16);
+  return true;
+}
+
+void SPC700DAGToDAGISel::Select(SDNode *N) {
+  // Dump information about the Node being selected
+  DEBUG(errs() << "Selecting: "; N->dump(CurDAG); errs() << "\n");
+
+  // If we have a custom node, we already have selected!
+  if (N->isMachineOpcode()) {
+    DEBUG(errs() << "== "; N->dump(CurDAG); errs() << "\n");
+    N->setNodeId(-1);
+    return;
+  }
+
+  // See if subclasses can handle this node.
+  if (trySelect(N))
+    return;
+
+  // Select the default instruction
+  SelectCode(N);
+}
+
+bool SPC700DAGToDAGISel::trySelect(SDNode *N) {
+  switch (N->getOpcode()) {
+  case ISD::FrameIndex: {
+    // The address of a stack slot is computed from SP at the point of use.
+    auto DL = CurDAG->getDataLayout();
+    MVT PtrVT = getTargetLowering()->getPointerTy(DL);
+    int FI = cast<FrameIndexSDNode>(N)->getIndex();
+    SDValue TFI = CurDAG->getTargetFrameIndex(FI, PtrVT);
+
+    CurDAG->SelectNodeTo(N, SPC700::FRMIDX, PtrVT, TFI,
+                         CurDAG->getTargetConstant(0, SDLoc(N), MVT::i16));
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+FunctionPass *createSPC700ISelDag(SPC700TargetMachine &TM,
+                                  CodeGenOpt::Level OptLevel) {
+  return new SPC700DAGToDAGISel(TM, OptLevel);
+}
+
+} // end of namespace llvm
@@ -0,0 +1,969 @@
+//===-- SPC700ISelLowering.cpp - SPC700 DAG Lowering Implementation -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the interfaces that SPC700 uses to lower LLVM code into a
+// selection DAG.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700ISelLowering.h"
+
+#include "llvm/CodeGen/CallingConvLower.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/SelectionDAG.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
+
+#include "SPC700.h"
+#include "SPC700TargetMachine.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+namespace llvm {
+
+#include "SPC700GenCallingConv.inc"
+
+SPC700TargetLowering::SPC700TargetLowering(SPC700TargetMachine &tm)
+    : TargetLowering(tm) {
+  // Set up the register classes.
+  addRegisterClass(MVT::i8, &SPC700::GPR8RegClass);
+  addRegisterClass(MVT::i16, &SPC700::GPR16RegClass);
+
+  // Compute derived properties from the register classes.
+  computeRegisterProperties(tm.getSubtargetImpl()->getRegisterInfo());
+
+  setBooleanContents(ZeroOrOneBooleanContent);
+  setBooleanVectorContents(ZeroOrOneBooleanContent);
+  setSchedulingPreference(Sched::RegPressure);
+
+  setOperationAction(ISD::GlobalAddress, MVT::i16, Custom);
+  setOperationAction(ISD::ExternalSymbol, MVT::i16, Custom);
+  setOperationAction(ISD::BlockAddress, MVT::i16, Custom);
+
+  // SP is only 8 bits and can only be moved through X, there is no dynamic
+  // stack allocation.
+  setOperationAction(ISD::STACKSAVE, MVT::Other, Expand);
+  setOperationAction(ISD::STACKRESTORE, MVT::Other, Expand);
+  setOperationAction(ISD::DYNAMIC_STACKALLOC, MVT::i16, Custom);
+
+  for (MVT VT : MVT::integer_valuetypes()) {
+    for (auto N : {ISD::EXTLOAD, ISD::SEXTLOAD, ISD::ZEXTLOAD}) {
+      setLoadExtAction(N, VT, MVT::i1, Promote);
+      setLoadExtAction(N, VT, MVT::i8, Expand);
+    }
+  }
+
+  setTruncStoreAction(MVT::i16, MVT::i8, Expand);
+
+  for (MVT VT : {MVT::i8, MVT::i16}) {
+    // The shift instructions only shift a bit at a time.
+    setOperationAction(ISD::SHL, VT, Custom);
+    setOperationAction(ISD::SRL, VT, Custom);
+    setOperationAction(ISD::SRA, VT, Custom);
+    setOperationAction(ISD::SHL_PARTS, VT, Expand);
+    setOperationAction(ISD::SRL_PARTS, VT, Expand);
+    setOperationAction(ISD::SRA_PARTS, VT, Expand);
+    setOperationAction(ISD::ROTL, VT, Expand);
+    setOperationAction(ISD::ROTR, VT, Expand);
+
+    setOperationAction(ISD::BR_CC, VT, Custom);
+    setOperationAction(ISD::SELECT_CC, VT, Custom);
+    setOperationAction(ISD::SETCC, VT, Custom);
+    setOperationAction(ISD::SELECT, VT, Expand);
+
+    // ADC and SBC always take the carry in, the add and subtract pseudos
+    // clear or set it. Wider additions compare the low halves instead.
+    setOperationAction(ISD::ADDC, VT, Expand);
+    setOperationAction(ISD::ADDE, VT, Expand);
+    setOperationAction(ISD::SUBC, VT, Expand);
+    setOperationAction(ISD::SUBE, VT, Expand);
+    setOperationAction(ISD::UADDO, VT, Expand);
+    setOperationAction(ISD::USUBO, VT, Expand);
+
+    setOperationAction(ISD::MULHS, VT, Expand);
+    setOperationAction(ISD::SMUL_LOHI, VT, Expand);
+    setOperationAction(ISD::UMUL_LOHI, VT, Expand);
+    setOperationAction(ISD::SDIV, VT, Expand);
+    setOperationAction(ISD::SREM, VT, Expand);
+    setOperationAction(ISD::SDIVREM, VT, Expand);
+
+    setOperationAction(ISD::CTPOP, VT, Expand);
+    setOperationAction(ISD::CTLZ, VT, Expand);
+    setOperationAction(ISD::CTTZ, VT, Expand);
+    setOperationAction(ISD::SIGN_EXTEND_INREG, MVT::i1, Expand);
+  }
+
+  setOperationAction(ISD::BRCOND, MVT::Other, Expand);
+  setOperationAction(ISD::BR_JT, MVT::Other, Expand);
+  setOperationAction(ISD::BSWAP, MVT::i16, Expand);
+
+  // `MUL YA` is 8x8 to 16, a word product only uses it when both high bytes
+  // are known to be zero, otherwise it is `__mulhi3`.
+  setOperationAction(ISD::MUL, MVT::i16, Custom);
+  setOperationAction(ISD::MULHU, MVT::i16, Expand);
+
+  // `DIV YA, X` divides a word by a byte, which covers the unsigned byte
+  // division. The others are calls to the runtime.
+  setOperationAction(ISD::UDIV, MVT::i8, Custom);
+  setOperationAction(ISD::UREM, MVT::i8, Custom);
+  setOperationAction(ISD::UDIVREM, MVT::i8, Custom);
+  setOperationAction(ISD::UDIV, MVT::i16, Expand);
+  setOperationAction(ISD::UREM, MVT::i16, Expand);
+  setOperationAction(ISD::UDIVREM, MVT::i16, Expand);
+
+  setMinFunctionAlignment(1);
+  setMinimumJumpTableEntries(INT_MAX);
+}
+
+const char *SPC700TargetLowering::getTargetNodeName(unsigned Opcode) const {
+#define NODE(name)       \
+  case SPC700ISD::name:  \
+    return #name
+
+  switch (Opcode) {
+  default:
+    return nullptr;
+    NODE(RET_FLAG);
+    NODE(CALL);
+    NODE(WRAPPER);
+    NODE(MUL8);
+    NODE(UDIVREM8);
+    NODE(LSL);
+    NODE(LSR);
+    NODE(ASR);
+    NODE(LSL8);
+    NODE(LSR8);
+    NODE(ASR8);
+    NODE(LSLLOOP);
+    NODE(LSRLOOP);
+    NODE(ASRLOOP);
+    NODE(BRCOND);
+    NODE(CMP);
+    NODE(SELECT_CC);
+#undef NODE
+  }
+}
+
+EVT SPC700TargetLowering::getSetCCResultType(const DataLayout &DL,
+                                             LLVMContext &, EVT VT) const {
+  assert(!VT.isVector() && "No SPC700 SetCC type for vectors!");
+  return MVT::i8;
+}
+
+SDValue SPC700TargetLowering::LowerShifts(SDValue Op, SelectionDAG &DAG) const {
+  const SDNode *N = Op.getNode();
+  EVT VT = Op.getValueType();
+  SDLoc dl(N);
+
+  // Expand non-constant shifts to loops, the count is a byte.
+  if (!isa<ConstantSDNode>(N->getOperand(1))) {
+    SDValue Amount = DAG.getZExtOrTrunc(N->getOperand(1), dl, MVT::i8);
+    switch (Op.getOpcode()) {
+    default:
+      llvm_unreachable("Invalid shift opcode!");
+    case ISD::SHL:
+      return DAG.getNode(SPC700ISD::LSLLOOP, dl, VT, N->getOperand(0), Amount);
+    case ISD::SRL:
+      return DAG.getNode(SPC700ISD::LSRLOOP, dl, VT, N->getOperand(0), Amount);
+    case ISD::SRA:
+      return DAG.getNode(SPC700ISD::ASRLOOP, dl, VT, N->getOperand(0), Amount);
+    }
+  }
+
+  uint64_t ShiftAmount = cast<ConstantSDNode>(N->getOperand(1))->getZExtValue();
+  SDValue Victim = N->getOperand(0);
+
+  if (ShiftAmount >= VT.getSizeInBits())
+    return DAG.getUNDEF(VT);
+
+  unsigned Opc8, OpcByte;
+  switch (Op.getOpcode()) {
+  case ISD::SRA:
+    Opc8 = SPC700ISD::ASR;
+    OpcByte = SPC700ISD::ASR8;
+    break;
+  case ISD::SRL:
+    Opc8 = SPC700ISD::LSR;
+    OpcByte = SPC700ISD::LSR8;
+    break;
+  case ISD::SHL:
+    Opc8 = SPC700ISD::LSL;
+    OpcByte = SPC700ISD::LSL8;
+    break;
+  default:
+    llvm_unreachable("Invalid shift opcode");
+  }
+
+  // Moving the bytes around is cheaper than eight single bit shifts.
+  if (VT == MVT::i16 && ShiftAmount >= 8) {
+    Victim = DAG.getNode(OpcByte, dl, VT, Victim);
+    ShiftAmount -= 8;
+  }
+
+  while (ShiftAmount--) {
+    Victim = DAG.getNode(Opc8, dl, VT, Victim);
+  }
+
+  return Victim;
+}
+
+SDValue SPC700TargetLowering::LowerMUL(SDValue Op, SelectionDAG &DAG) const {
+  SDValue LHS = Op.getOperand(0);
+  SDValue RHS = Op.getOperand(1);
+  SDLoc dl(Op);
+
+  // Falls back to the `__mulhi3` libcall.
+  APInt HighByte = APInt::getHighBitsSet(16, 8);
+  if (!DAG.MaskedValueIsZero(LHS, HighByte) ||
+      !DAG.MaskedValueIsZero(RHS, HighByte))
+    return SDValue();
+
+  return DAG.getNode(SPC700ISD::MUL8, dl, MVT::i16,
+                     DAG.getNode(ISD::TRUNCATE, dl, MVT::i8, LHS),
+                     DAG.getNode(ISD::TRUNCATE, dl, MVT::i8, RHS));
+}
+
+SDValue SPC700TargetLowering::LowerDivRem(SDValue Op, SelectionDAG &DAG) const {
+  SDLoc dl(Op);
+
+  // A zero extended byte in YA always gives a quotient which fits in A.
+  SDValue DivRem = DAG.getNode(
+      SPC700ISD::UDIVREM8, dl, DAG.getVTList(MVT::i8, MVT::i8),
+      DAG.getNode(ISD::ZERO_EXTEND, dl, MVT::i16, Op.getOperand(0)),
+      Op.getOperand(1));
+
+  switch (Op.getOpcode()) {
+  default:
+    llvm_unreachable("Invalid division opcode");
+  case ISD::UDIV:
+    return DivRem.getValue(0);
+  case ISD::UREM:
+    return DivRem.getValue(1);
+  case ISD::UDIVREM:
+    return DivRem;
+  }
+}
+
+SDValue SPC700TargetLowering::LowerGlobalAddress(SDValue Op,
+                                                 SelectionDAG &DAG) const {
+  auto DL = DAG.getDataLayout();
+
+  const GlobalValue *GV = cast<GlobalAddressSDNode>(Op)->getGlobal();
+  int64_t Offset = cast<GlobalAddressSDNode>(Op)->getOffset();
+
+  // Create the TargetGlobalAddress node, folding in the constant offset.
+  SDValue Result =
+      DAG.getTargetGlobalAddress(GV, SDLoc(Op), getPointerTy(DL), Offset);
+  return DAG.getNode(SPC700ISD::WRAPPER, SDLoc(Op), getPointerTy(DL), Result);
+}
+
+SDValue SPC700TargetLowering::LowerExternalSymbol(SDValue Op,
+                                                  SelectionDAG &DAG) const {
+  auto DL = DAG.getDataLayout();
+  const char *Sym = cast<ExternalSymbolSDNode>(Op)->getSymbol();
+
+  SDValue Result = DAG.getTargetExternalSymbol(Sym, getPointerTy(DL));
+  return DAG.getNode(SPC700ISD::WRAPPER, SDLoc(Op), getPointerTy(DL), Result);
+}
+
+SDValue SPC700TargetLowering::LowerBlockAddress(SDValue Op,
+                                                SelectionDAG &DAG) const {
+  auto DL = DAG.getDataLayout();
+  const BlockAddress *BA = cast<BlockAddressSDNode>(Op)->getBlockAddress();
+
+  SDValue Result = DAG.getTargetBlockAddress(BA, getPointerTy(DL));
+
+  return DAG.getNode(SPC700ISD::WRAPPER, SDLoc(Op), getPointerTy(DL), Result);
+}
+
+/// Converts a DAG integer condition code, either an equality or an unsigned
+/// greater or equal/lower, to an SPC700 CC.
+static SPC700CC::CondCodes intCCToSPC700CC(ISD::CondCode CC) {
+  switch (CC) {
+  default:
+    llvm_unreachable("Unknown condition code!");
+  case ISD::SETEQ:
+    return SPC700CC::COND_EQ;
+  case ISD::SETNE:
+    return SPC700CC::COND_NE;
+  case ISD::SETUGE:
+    return SPC700CC::COND_CS;
+  case ISD::SETULT:
+    return SPC700CC::COND_CC;
+  }
+}
+
+/// Gets the unsigned version of a signed condition code.
+static ISD::CondCode getUnsignedCC(ISD::CondCode CC) {
+  switch (CC) {
+  default:
+    return CC;
+  case ISD::SETLT:
+    return ISD::SETULT;
+  case ISD::SETLE:
+    return ISD::SETULE;
+  case ISD::SETGT:
+    return ISD::SETUGT;
+  case ISD::SETGE:
+    return ISD::SETUGE;
+  }
+}
+
+/// Returns the SPC700 CMP node and the condition code for the given operands.
+///
+/// `CMP` and `CMPW` only set the carry for an unsigned greater or equal, the
+/// other conditions are rewritten into one. A signed comparison flips the
+/// sign bits first, except for the sign tests which branch on N.
+SDValue SPC700TargetLowering::getSPC700Cmp(SDValue LHS, SDValue RHS,
+                                           ISD::CondCode CC,
+                                           SDValue &SPC700cc,
+                                           SelectionDAG &DAG,
+                                           SDLoc DL) const {
+  EVT VT = LHS.getValueType();
+  assert((VT == MVT::i8 || VT == MVT::i16) && "Invalid comparison size");
+
+  // Comparing with zero leaves the sign of the left hand side in N.
+  bool IsSignTest = false;
+  if (isNullConstant(RHS) && (CC == ISD::SETLT || CC == ISD::SETGE)) {
+    IsSignTest = true;
+  } else if (isAllOnesConstant(RHS) &&
+             (CC == ISD::SETGT || CC == ISD::SETLE)) {
+    IsSignTest = true;
+    RHS = DAG.getConstant(0, DL, VT);
+    CC = CC == ISD::SETGT ? ISD::SETGE : ISD::SETLT;
+  }
+
+  if (IsSignTest) {
+    SPC700cc = DAG.getConstant(
+        CC == ISD::SETLT ? SPC700CC::COND_MI : SPC700CC::COND_PL, DL, MVT::i8);
+    return DAG.getNode(SPC700ISD::CMP, DL, MVT::Glue, LHS, RHS);
+  }
+
+  if (ISD::isSignedIntSetCC(CC)) {
+    SDValue SignBit = DAG.getConstant(APInt::getSignMask(VT.getSizeInBits()),
+                                      DL, VT);
+    LHS = DAG.getNode(ISD::XOR, DL, VT, LHS, SignBit);
+    RHS = DAG.getNode(ISD::XOR, DL, VT, RHS, SignBit);
+    CC = getUnsignedCC(CC);
+  }
+
+  switch (CC) {
+  default:
+    break;
+  case ISD::SETUGT:
+  case ISD::SETULE: {
+    // Turn lhs > k into lhs >= k+1 so that the constant stays on the right,
+    // otherwise swap the operands.
+    const ConstantSDNode *C = dyn_cast<ConstantSDNode>(RHS);
+    if (C && !C->getAPIntValue().isMaxValue()) {
+      RHS = DAG.getConstant(C->getAPIntValue() + 1, DL, VT);
+      CC = CC == ISD::SETUGT ? ISD::SETUGE : ISD::SETULT;
+      break;
+    }
+    std::swap(LHS, RHS);
+    CC = CC == ISD::SETUGT ? ISD::SETULT : ISD::SETUGE;
+    break;
+  }
+  }
+
+  SPC700cc = DAG.getConstant(intCCToSPC700CC(CC), DL, MVT::i8);
+  return DAG.getNode(SPC700ISD::CMP, DL, MVT::Glue, LHS, RHS);
+}
+
+SDValue SPC700TargetLowering::LowerBR_CC(SDValue Op, SelectionDAG &DAG) const {
+  SDValue Chain = Op.getOperand(0);
+  ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(1))->get();
+  SDValue LHS = Op.getOperand(2);
+  SDValue RHS = Op.getOperand(3);
+  SDValue Dest = Op.getOperand(4);
+  SDLoc dl(Op);
+
+  SDValue TargetCC;
+  SDValue Cmp = getSPC700Cmp(LHS, RHS, CC, TargetCC, DAG, dl);
+
+  return DAG.getNode(SPC700ISD::BRCOND, dl, MVT::Other, Chain, Dest, TargetCC,
+                     Cmp);
+}
+
+SDValue SPC700TargetLowering::LowerSELECT_CC(SDValue Op,
+                                             SelectionDAG &DAG) const {
+  SDValue LHS = Op.getOperand(0);
+  SDValue RHS = Op.getOperand(1);
+  SDValue TrueV = Op.getOperand(2);
+  SDValue FalseV = Op.getOperand(3);
+  ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(4))->get();
+  SDLoc dl(Op);
+
+  SDValue TargetCC;
+  SDValue Cmp = getSPC700Cmp(LHS, RHS, CC, TargetCC, DAG, dl);
+
+  return DAG.getNode(SPC700ISD::SELECT_CC, dl, Op.getValueType(), TrueV,
+                     FalseV, TargetCC, Cmp);
+}
+
+SDValue SPC700TargetLowering::LowerSETCC(SDValue Op, SelectionDAG &DAG) const {
+  SDValue LHS = Op.getOperand(0);
+  SDValue RHS = Op.getOperand(1);
+  ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(2))->get();
+  SDLoc DL(Op);
+
+  SDValue TargetCC;
+  SDValue Cmp = getSPC700Cmp(LHS, RHS, CC, TargetCC, DAG, DL);
+
+  SDValue TrueV = DAG.getConstant(1, DL, Op.getValueType());
+  SDValue FalseV = DAG.getConstant(0, DL, Op.getValueType());
+
+  return DAG.getNode(SPC700ISD::SELECT_CC, DL, Op.getValueType(), TrueV,
+                     FalseV, TargetCC, Cmp);
+}
+
+SDValue SPC700TargetLowering::LowerOperation(SDValue Op,
+                                             SelectionDAG &DAG) const {
+  switch (Op.getOpcode()) {
+  default:
+    llvm_unreachable("Don't know how to custom lower this!");
+  case ISD::SHL:
+  case ISD::SRA:
+  case ISD::SRL:
+    return LowerShifts(Op, DAG);
+  case ISD::GlobalAddress:
+    return LowerGlobalAddress(Op, DAG);
+  case ISD::ExternalSymbol:
+    return LowerExternalSymbol(Op, DAG);
+  case ISD::BlockAddress:
+    return LowerBlockAddress(Op, DAG);
+  case ISD::BR_CC:
+    return LowerBR_CC(Op, DAG);
+  case ISD::SELECT_CC:
+    return LowerSELECT_CC(Op, DAG);
+  case ISD::SETCC:
+    return LowerSETCC(Op, DAG);
+  case ISD::MUL:
+    return LowerMUL(Op, DAG);
+  case ISD::UDIV:
+  case ISD::UREM:
+  case ISD::UDIVREM:
+    return LowerDivRem(Op, DAG);
+  case ISD::DYNAMIC_STACKALLOC:
+    report_fatal_error("SPC700: variable sized stack objects are not "
+                       "supported");
+  }
+
+  return SDValue();
+}
+
+bool SPC700TargetLowering::isLegalAddressingMode(const DataLayout &DL,
+                                                 const AddrMode &AM, Type *Ty,
+                                                 unsigned AS) const {
+  // A global, `!abs`.
+  if (AM.BaseGV && !AM.HasBaseReg && !AM.Scale)
+    return true;
+
+  // A pointer in a register pair plus what Y can hold, `[dp]+Y`, with room
+  // for the second byte of a word.
+  if (!AM.BaseGV && !AM.Scale && AM.BaseOffs >= 0 && AM.BaseOffs < 255)
+    return true;
+
+  return false;
+}
+
+//===----------------------------------------------------------------------===//
+//             Formal Arguments Calling Convention Implementation
+//===----------------------------------------------------------------------===//
+
+/// Gets the register class of a value passed in a register.
+static const TargetRegisterClass *getArgRegClass(EVT VT) {
+  if (VT == MVT::i8)
+    return &SPC700::GPR8RegClass;
+  if (VT == MVT::i16)
+    return &SPC700::GPR16RegClass;
+  llvm_unreachable("Unknown argument type!");
+}
+
+SDValue SPC700TargetLowering::LowerFormalArguments(
+    SDValue Chain, CallingConv::ID CallConv, bool isVarArg,
+    const SmallVectorImpl<ISD::InputArg> &Ins, const SDLoc &dl,
+    SelectionDAG &DAG, SmallVectorImpl<SDValue> &InVals) const {
+  MachineFunction &MF = DAG.getMachineFunction();
+
+  if (isVarArg)
+    report_fatal_error("SPC700: variadic functions are not supported");
+
+  // Assign locations to all of the incoming arguments.
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(CallConv, isVarArg, MF, ArgLocs, *DAG.getContext());
+  CCInfo.AnalyzeFormalArguments(Ins, ArgCC_SPC700);
+
+  for (CCValAssign &VA : ArgLocs) {
+    if (!VA.isRegLoc())
+      report_fatal_error("SPC700: too many arguments to '" +
+                         MF.getFunction()->getName() +
+                         "', nothing is passed on the stack");
+
+    EVT RegVT = VA.getLocVT();
+    unsigned Reg = MF.addLiveIn(VA.getLocReg(), getArgRegClass(RegVT));
+    SDValue ArgValue = DAG.getCopyFromReg(Chain, dl, Reg, RegVT);
+
+    switch (VA.getLocInfo()) {
+    default:
+      llvm_unreachable("Unknown loc info!");
+    case CCValAssign::Full:
+      break;
+    case CCValAssign::SExt:
+      ArgValue = DAG.getNode(ISD::AssertSext, dl, RegVT, ArgValue,
+                             DAG.getValueType(VA.getValVT()));
+      ArgValue = DAG.getNode(ISD::TRUNCATE, dl, VA.getValVT(), ArgValue);
+      break;
+    case CCValAssign::ZExt:
+      ArgValue = DAG.getNode(ISD::AssertZext, dl, RegVT, ArgValue,
+                             DAG.getValueType(VA.getValVT()));
+      ArgValue = DAG.getNode(ISD::TRUNCATE, dl, VA.getValVT(), ArgValue);
+      break;
+    case CCValAssign::AExt:
+      ArgValue = DAG.getNode(ISD::TRUNCATE, dl, VA.getValVT(), ArgValue);
+      break;
+    }
+
+    InVals.push_back(ArgValue);
+  }
+
+  return Chain;
+}
+
+//===----------------------------------------------------------------------===//
+//                  Call Calling Convention Implementation
+//===----------------------------------------------------------------------===//
+
+SDValue
+SPC700TargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
+                                SmallVectorImpl<SDValue> &InVals) const {
+  SelectionDAG &DAG = CLI.DAG;
+  SDLoc &DL = CLI.DL;
+  SmallVectorImpl<ISD::OutputArg> &Outs = CLI.Outs;
+  SmallVectorImpl<SDValue> &OutVals = CLI.OutVals;
+  SmallVectorImpl<ISD::InputArg> &Ins = CLI.Ins;
+  SDValue Chain = CLI.Chain;
+  SDValue Callee = CLI.Callee;
+  CallingConv::ID CallConv = CLI.CallConv;
+  bool isVarArg = CLI.IsVarArg;
+
+  // The callee returns to us, RET can't jump to a third function.
+  CLI.IsTailCall = false;
+
+  if (isVarArg)
+    report_fatal_error("SPC700: calls to variadic functions are not "
+                       "supported");
+
+  // Analyze operands of the call, assigning locations to each operand.
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(CallConv, isVarArg, DAG.getMachineFunction(), ArgLocs,
+                 *DAG.getContext());
+  CCInfo.AnalyzeCallOperands(Outs, ArgCC_SPC700);
+
+  // If the callee is a GlobalAddress/ExternalSymbol node (quite common, every
+  // direct call is) turn it into a TargetGlobalAddress/TargetExternalSymbol
+  // node so that legalize doesn't hack it. Anything else is called through
+  // the runtime's trampoline.
+  if (const GlobalAddressSDNode *G = dyn_cast<GlobalAddressSDNode>(Callee)) {
+    Callee = DAG.getTargetGlobalAddress(G->getGlobal(), DL,
+                                        getPointerTy(DAG.getDataLayout()));
+  } else if (const ExternalSymbolSDNode *ES =
+                 dyn_cast<ExternalSymbolSDNode>(Callee)) {
+    Callee = DAG.getTargetExternalSymbol(ES->getSymbol(),
+                                         getPointerTy(DAG.getDataLayout()));
+  }
+
+  Chain = DAG.getCALLSEQ_START(Chain, 0, 0, DL);
+
+  // Walk the register assignments, inserting copies.
+  SmallVector<std::pair<unsigned, SDValue>, 8> RegsToPass;
+  for (unsigned AI = 0, AE = ArgLocs.size(); AI != AE; ++AI) {
+    CCValAssign &VA = ArgLocs[AI];
+    EVT RegVT = VA.getLocVT();
+    SDValue Arg = OutVals[AI];
+
+    if (!VA.isRegLoc())
+      report_fatal_error("SPC700: too many arguments in a call, nothing is "
+                         "passed on the stack");
+
+    // Promote the value if needed.
+    switch (VA.getLocInfo()) {
+    default:
+      llvm_unreachable("Unknown loc info!");
+    case CCValAssign::Full:
+      break;
+    case CCValAssign::SExt:
+      Arg = DAG.getNode(ISD::SIGN_EXTEND, DL, RegVT, Arg);
+      break;
+    case CCValAssign::ZExt:
+      Arg = DAG.getNode(ISD::ZERO_EXTEND, DL, RegVT, Arg);
+      break;
+    case CCValAssign::AExt:
+      Arg = DAG.getNode(ISD::ANY_EXTEND, DL, RegVT, Arg);
+      break;
+    }
+
+    RegsToPass.push_back(std::make_pair(VA.getLocReg(), Arg));
+  }
+
+  // Build a sequence of copy-to-reg nodes chained together with token chain and
+  // flag operands which copy the outgoing args into registers.  The InFlag in
+  // necessary since all emited instructions must be stuck together.
+  SDValue InFlag;
+  for (auto Reg : RegsToPass) {
+    Chain = DAG.getCopyToReg(Chain, DL, Reg.first, Reg.second, InFlag);
+    InFlag = Chain.getValue(1);
+  }
+
+  // Returns a chain & a flag for retval copy to use.
+  SDVTList NodeTys = DAG.getVTList(MVT::Other, MVT::Glue);
+  SmallVector<SDValue, 8> Ops;
+  Ops.push_back(Chain);
+  Ops.push_back(Callee);
+
+  // Add argument registers to the end of the list so that they are known live
+  // into the call.
+  for (auto Reg : RegsToPass) {
+    Ops.push_back(DAG.getRegister(Reg.first, Reg.second.getValueType()));
+  }
+
+  // Add a register mask operand representing the call-preserved registers.
+  const TargetRegisterInfo *TRI = DAG.getSubtarget().getRegisterInfo();
+  const uint32_t *Mask =
+      TRI->getCallPreservedMask(DAG.getMachineFunction(), CallConv);
+  assert(Mask && "Missing call preserved mask for calling convention");
+  Ops.push_back(DAG.getRegisterMask(Mask));
+
+  if (InFlag.getNode()) {
+    Ops.push_back(InFlag);
+  }
+
+  Chain = DAG.getNode(SPC700ISD::CALL, DL, NodeTys, Ops);
+  InFlag = Chain.getValue(1);
+
+  // Create the CALLSEQ_END node.
+  Chain = DAG.getCALLSEQ_END(Chain, DAG.getIntPtrConstant(0, DL, true),
+                             DAG.getIntPtrConstant(0, DL, true), InFlag, DL);
+
+  if (!Ins.empty()) {
+    InFlag = Chain.getValue(1);
+  }
+
+  // Handle result values, copying them out of physregs into vregs that we
+  // return.
+  return LowerCallResult(Chain, InFlag, CallConv, isVarArg, Ins, DL, DAG,
+                         InVals);
+}
+
+/// Lower the result values of a call into the
+/// appropriate copies out of appropriate physical registers.
+///
+SDValue SPC700TargetLowering::LowerCallResult(
+    SDValue Chain, SDValue InFlag, CallingConv::ID CallConv, bool isVarArg,
+    const SmallVectorImpl<ISD::InputArg> &Ins, const SDLoc &dl,
+    SelectionDAG &DAG, SmallVectorImpl<SDValue> &InVals) const {
+
+  // Assign locations to each value returned by this call.
+  SmallVector<CCValAssign, 16> RVLocs;
+  CCState CCInfo(CallConv, isVarArg, DAG.getMachineFunction(), RVLocs,
+                 *DAG.getContext());
+  CCInfo.AnalyzeCallResult(Ins, RetCC_SPC700);
+
+  // Copy all of the result registers out of their specified physreg.
+  for (CCValAssign const &RVLoc : RVLocs) {
+    Chain = DAG.getCopyFromReg(Chain, dl, RVLoc.getLocReg(), RVLoc.getValVT(),
+                               InFlag)
+                .getValue(1);
+    InFlag = Chain.getValue(2);
+    InVals.push_back(Chain.getValue(0));
+  }
+
+  return Chain;
+}
+
+//===----------------------------------------------------------------------===//
+//               Return Value Calling Convention Implementation
+//===----------------------------------------------------------------------===//
+
+bool SPC700TargetLowering::CanLowerReturn(
+    CallingConv::ID CallConv, MachineFunction &MF, bool isVarArg,
+    const SmallVectorImpl<ISD::OutputArg> &Outs, LLVMContext &Context) const {
+  SmallVector<CCValAssign, 16> RVLocs;
+  CCState CCInfo(CallConv, isVarArg, MF, RVLocs, Context);
+
+  return CCInfo.CheckReturn(Outs, RetCC_SPC700);
+}
+
+SDValue
+SPC700TargetLowering::LowerReturn(SDValue Chain, CallingConv::ID CallConv,
+                                  bool isVarArg,
+                                  const SmallVectorImpl<ISD::OutputArg> &Outs,
+                                  const SmallVectorImpl<SDValue> &OutVals,
+                                  const SDLoc &dl, SelectionDAG &DAG) const {
+  // CCValAssign - represent the assignment of the return value to locations.
+  SmallVector<CCValAssign, 16> RVLocs;
+
+  // CCState - Info about the registers and stack slot.
+  CCState CCInfo(CallConv, isVarArg, DAG.getMachineFunction(), RVLocs,
+                 *DAG.getContext());
+
+  // Analyze return values. The low word of a long comes first, in YA.
+  CCInfo.AnalyzeReturn(Outs, RetCC_SPC700);
+
+  SDValue Flag;
+  SmallVector<SDValue, 4> RetOps(1, Chain);
+  // Copy the result values into the output registers.
+  for (unsigned i = 0, e = RVLocs.size(); i != e; ++i) {
+    CCValAssign &VA = RVLocs[i];
+    assert(VA.isRegLoc() && "Can only return in registers!");
+
+    Chain = DAG.getCopyToReg(Chain, dl, VA.getLocReg(), OutVals[i], Flag);
+
+    // Guarantee that all emitted copies are stuck together with flags.
+    Flag = Chain.getValue(1);
+    RetOps.push_back(DAG.getRegister(VA.getLocReg(), VA.getLocVT()));
+  }
+
+  RetOps[0] = Chain; // Update chain.
+
+  if (Flag.getNode()) {
+    RetOps.push_back(Flag);
+  }
+
+  return DAG.getNode(SPC700ISD::RET_FLAG, dl, MVT::Other, RetOps);
+}
+
+//===----------------------------------------------------------------------===//
+//  Custom Inserters
+//===----------------------------------------------------------------------===//
+
+MachineBasicBlock *
+SPC700TargetLowering::insertShift(MachineInstr &MI,
+                                  MachineBasicBlock *BB) const {
+  unsigned Opc;
+  const TargetRegisterClass *RC;
+  MachineFunction *F = BB->getParent();
+  MachineRegisterInfo &RI = F->getRegInfo();
+  const TargetInstrInfo &TII = *F->getSubtarget().getInstrInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  switch (MI.getOpcode()) {
+  default:
+    llvm_unreachable("Invalid shift opcode!");
+  case SPC700::Lsl8:
+    Opc = SPC700::ASLdp;
+    RC = &SPC700::DPRegsRegClass;
+    break;
+  case SPC700::Lsr8:
+    Opc = SPC700::LSRdp;
+    RC = &SPC700::DPRegsRegClass;
+    break;
+  case SPC700::Asr8:
+    Opc = SPC700::ASR8;
+    RC = &SPC700::DPRegsRegClass;
+    break;
+  case SPC700::Lsl16:
+    Opc = SPC700::LSL16;
+    RC = &SPC700::DPWRegsRegClass;
+    break;
+  case SPC700::Lsr16:
+    Opc = SPC700::LSR16;
+    RC = &SPC700::DPWRegsRegClass;
+    break;
+  case SPC700::Asr16:
+    Opc = SPC700::ASR16;
+    RC = &SPC700::DPWRegsRegClass;
+    break;
+  }
+
+  const BasicBlock *LLVM_BB = BB->getBasicBlock();
+  MachineFunction::iterator I = std::next(MachineFunction::iterator(BB));
+
+  // Create loop block.
+  MachineBasicBlock *LoopBB = F->CreateMachineBasicBlock(LLVM_BB);
+  MachineBasicBlock *RemBB = F->CreateMachineBasicBlock(LLVM_BB);
+
+  F->insert(I, LoopBB);
+  F->insert(I, RemBB);
+
+  // Update machine-CFG edges by transferring all successors of the current
+  // block to the block containing instructions after shift.
+  RemBB->splice(RemBB->begin(), BB, std::next(MachineBasicBlock::iterator(MI)),
+                BB->end());
+  RemBB->transferSuccessorsAndUpdatePHIs(BB);
+
+  // Add adges BB => LoopBB => RemBB, BB => RemBB, LoopBB => LoopBB.
+  BB->addSuccessor(LoopBB);
+  BB->addSuccessor(RemBB);
+  LoopBB->addSuccessor(RemBB);
+  LoopBB->addSuccessor(LoopBB);
+
+  unsigned ShiftAmtReg = RI.createVirtualRegister(&SPC700::DPRegsRegClass);
+  unsigned ShiftAmtReg2 = RI.createVirtualRegister(&SPC700::DPRegsRegClass);
+  unsigned ShiftReg = RI.createVirtualRegister(RC);
+  unsigned ShiftReg2 = RI.createVirtualRegister(RC);
+  unsigned ShiftAmtSrcReg = MI.getOperand(2).getReg();
+  unsigned SrcReg = MI.getOperand(1).getReg();
+  unsigned DstReg = MI.getOperand(0).getReg();
+
+  // BB:
+  // cmp N, #0
+  // beq RemBB
+  BuildMI(BB, dl, TII.get(SPC700::CMPdpimm)).addReg(ShiftAmtSrcReg).addImm(0);
+  BuildMI(BB, dl, TII.get(SPC700::BEQ)).addMBB(RemBB);
+
+  // LoopBB:
+  // ShiftReg = phi [%SrcReg, BB], [%ShiftReg2, LoopBB]
+  // ShiftAmt = phi [%N, BB],      [%ShiftAmt2, LoopBB]
+  // ShiftReg2 = shift ShiftReg
+  // ShiftAmt2 = dec ShiftAmt
+  // bne LoopBB
+  BuildMI(LoopBB, dl, TII.get(SPC700::PHI), ShiftReg)
+      .addReg(SrcReg)
+      .addMBB(BB)
+      .addReg(ShiftReg2)
+      .addMBB(LoopBB);
+  BuildMI(LoopBB, dl, TII.get(SPC700::PHI), ShiftAmtReg)
+      .addReg(ShiftAmtSrcReg)
+      .addMBB(BB)
+      .addReg(ShiftAmtReg2)
+      .addMBB(LoopBB);
+  BuildMI(LoopBB, dl, TII.get(Opc), ShiftReg2).addReg(ShiftReg);
+  BuildMI(LoopBB, dl, TII.get(SPC700::DECdp), ShiftAmtReg2)
+      .addReg(ShiftAmtReg);
+  BuildMI(LoopBB, dl, TII.get(SPC700::BNE)).addMBB(LoopBB);
+
+  // RemBB:
+  // DestReg = phi [%SrcReg, BB], [%ShiftReg2, LoopBB]
+  BuildMI(*RemBB, RemBB->begin(), dl, TII.get(SPC700::PHI), DstReg)
+      .addReg(SrcReg)
+      .addMBB(BB)
+      .addReg(ShiftReg2)
+      .addMBB(LoopBB);
+
+  MI.eraseFromParent(); // The pseudo instruction is gone now.
+  return RemBB;
+}
+
+MachineBasicBlock *
+SPC700TargetLowering::insertAddSub(MachineInstr &MI,
+                                   MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  DebugLoc dl = MI.getDebugLoc();
+
+  // `ADC` and `SBC` always take the carry in.
+  unsigned Opc, CarryOpc;
+  switch (MI.getOpcode()) {
+  default:
+    llvm_unreachable("Invalid add/sub opcode!");
+  case SPC700::ADD8dd:
+    Opc = SPC700::ADCdpdp;
+    CarryOpc = SPC700::CLRC;
+    break;
+  case SPC700::ADD8di:
+    Opc = SPC700::ADCdpimm;
+    CarryOpc = SPC700::CLRC;
+    break;
+  case SPC700::SUB8dd:
+    Opc = SPC700::SBCdpdp;
+    CarryOpc = SPC700::SETC;
+    break;
+  case SPC700::SUB8di:
+    Opc = SPC700::SBCdpimm;
+    CarryOpc = SPC700::SETC;
+    break;
+  }
+
+  BuildMI(*BB, MI, dl, TII.get(CarryOpc));
+  BuildMI(*BB, MI, dl, TII.get(Opc), MI.getOperand(0).getReg())
+      .add(MI.getOperand(1))
+      .add(MI.getOperand(2));
+
+  MI.eraseFromParent();
+  return BB;
+}
+
+/// Splits \p BB after \p MI, the instructions after it and the successors
+/// of \p BB move to the returned block.
+static MachineBasicBlock *splitBlockAfter(MachineInstr &MI,
+                                          MachineBasicBlock *BB) {
+  MachineFunction *MF = BB->getParent();
+  MachineBasicBlock *TailMBB = MF->CreateMachineBasicBlock(BB->getBasicBlock());
+  MF->insert(std::next(MachineFunction::iterator(BB)), TailMBB);
+
+  TailMBB->splice(TailMBB->begin(), BB,
+                  std::next(MachineBasicBlock::iterator(MI)), BB->end());
+  TailMBB->transferSuccessorsAndUpdatePHIs(BB);
+  return TailMBB;
+}
+
+MachineBasicBlock *
+SPC700TargetLowering::insertSelect(MachineInstr &MI,
+                                   MachineBasicBlock *BB) const {
+  const TargetInstrInfo &TII = *BB->getParent()->getSubtarget().getInstrInfo();
+  const SPC700InstrInfo &STII = static_cast<const SPC700InstrInfo &>(TII);
+  DebugLoc dl = MI.getDebugLoc();
+
+  // A triangle, the true value is ready when the branch is taken:
+  //
+  //   BB:      Bcc  TailMBB
+  //   FalseMBB:               (copy of the false value)
+  //   TailMBB: PHI
+  //
+  // The copies of the PHI end up before the branch, copyPhysReg keeps the
+  // flags for it.
+  MachineFunction *MF = BB->getParent();
+  MachineBasicBlock *TailMBB = splitBlockAfter(MI, BB);
+  MachineBasicBlock *FalseMBB =
+      MF->CreateMachineBasicBlock(BB->getBasicBlock());
+  MF->insert(MachineFunction::iterator(TailMBB), FalseMBB);
+
+  SPC700CC::CondCodes CC = (SPC700CC::CondCodes)MI.getOperand(3).getImm();
+  BuildMI(BB, dl, STII.getBrCond(CC)).addMBB(TailMBB);
+  BB->addSuccessor(FalseMBB);
+  BB->addSuccessor(TailMBB);
+  FalseMBB->addSuccessor(TailMBB);
+
+  BuildMI(*TailMBB, TailMBB->begin(), dl, TII.get(SPC700::PHI),
+          MI.getOperand(0).getReg())
+      .addReg(MI.getOperand(1).getReg())
+      .addMBB(BB)
+      .addReg(MI.getOperand(2).getReg())
+      .addMBB(FalseMBB);
+
+  MI.eraseFromParent();
+  return TailMBB;
+}
+
+MachineBasicBlock *
+SPC700TargetLowering::EmitInstrWithCustomInserter(
+    MachineInstr &MI, MachineBasicBlock *MBB) const {
+  switch (MI.getOpcode()) {
+  case SPC700::Lsl8:
+  case SPC700::Lsr8:
+  case SPC700::Asr8:
+  case SPC700::Lsl16:
+  case SPC700::Lsr16:
+  case SPC700::Asr16:
+    return insertShift(MI, MBB);
+  case SPC700::ADD8dd:
+  case SPC700::ADD8di:
+  case SPC700::SUB8dd:
+  case SPC700::SUB8di:
+    return insertAddSub(MI, MBB);
+  case SPC700::Select8:
+  case SPC700::Select16:
+    return insertSelect(MI, MBB);
+  default:
+    llvm_unreachable("Unexpected instr type to insert");
+  }
+}
+
+} // end of namespace llvm
@@ -0,0 +1,534 @@
+//===-- SPC700InstrInfo.cpp - SPC700 Instruction Information --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the SPC700 implementation of the TargetInstrInfo class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700InstrInfo.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineMemOperand.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/ErrorHandling.h"
+
+#include "SPC700.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#define GET_INSTRINFO_CTOR_DTOR
+#include "SPC700GenInstrInfo.inc"
+
+namespace llvm {
+
+SPC700InstrInfo::SPC700InstrInfo()
+    : SPC700GenInstrInfo(SPC700::ADJCALLSTACKDOWN, SPC700::ADJCALLSTACKUP),
+      RI() {}
+
+bool SPC700InstrInfo::isPSWLive(MachineBasicBlock &MBB,
+                                MachineBasicBlock::iterator I) const {
+  return MBB.computeRegisterLiveness(&RI, SPC700::PSW, I) !=
+         MachineBasicBlock::LQR_Dead;
+}
+
+/// Gets the opcode of an 8-bit register to register copy, or zero when the
+/// registers can't be copied with a single instruction.
+static unsigned getCopyOpcode(unsigned DestReg, unsigned SrcReg) {
+  bool DestDP = SPC700::DPRegsRegClass.contains(DestReg);
+  bool SrcDP = SPC700::DPRegsRegClass.contains(SrcReg);
+
+  if (DestDP && SrcDP)
+    return SPC700::MOVdpdp;
+
+  if (DestDP) {
+    switch (SrcReg) {
+    case SPC700::A: return SPC700::MOVdpA;
+    case SPC700::X: return SPC700::MOVdpX;
+    case SPC700::Y: return SPC700::MOVdpY;
+    }
+  }
+
+  if (SrcDP) {
+    switch (DestReg) {
+    case SPC700::A: return SPC700::MOVAdp;
+    case SPC700::X: return SPC700::MOVXdp;
+    case SPC700::Y: return SPC700::MOVYdp;
+    }
+  }
+
+  if (DestReg == SPC700::A && SrcReg == SPC700::X)
+    return SPC700::MOVAX;
+  if (DestReg == SPC700::A && SrcReg == SPC700::Y)
+    return SPC700::MOVAY;
+  if (DestReg == SPC700::X && SrcReg == SPC700::A)
+    return SPC700::MOVXA;
+  if (DestReg == SPC700::Y && SrcReg == SPC700::A)
+    return SPC700::MOVYA;
+
+  return 0;
+}
+
+void SPC700InstrInfo::copyPhysReg(MachineBasicBlock &MBB,
+                                  MachineBasicBlock::iterator MI,
+                                  const DebugLoc &DL, unsigned DestReg,
+                                  unsigned SrcReg, bool KillSrc) const {
+  if (SPC700::GPR16RegClass.contains(DestReg, SrcReg)) {
+    if (SPC700::DPWRegsRegClass.contains(DestReg) && SrcReg == SPC700::YA) {
+      BuildMI(MBB, MI, DL, get(SPC700::MOVWdpYA), DestReg)
+          .addReg(SrcReg, getKillRegState(KillSrc));
+      return;
+    }
+
+    if (DestReg == SPC700::YA && SPC700::DPWRegsRegClass.contains(SrcReg)) {
+      // `MOVW` sets N and Z.
+      bool SavePSW = isPSWLive(MBB, MI);
+      if (SavePSW)
+        BuildMI(MBB, MI, DL, get(SPC700::PUSHPSW));
+      BuildMI(MBB, MI, DL, get(SPC700::MOVWYAdp), DestReg)
+          .addReg(SrcReg, getKillRegState(KillSrc));
+      if (SavePSW)
+        BuildMI(MBB, MI, DL, get(SPC700::POPPSW));
+      return;
+    }
+
+    // Copy each byte with `MOV dd, ss`, which leaves the flags alone.
+    unsigned DestLo, DestHi, SrcLo, SrcHi;
+    RI.splitReg(DestReg, DestLo, DestHi);
+    RI.splitReg(SrcReg, SrcLo, SrcHi);
+
+    BuildMI(MBB, MI, DL, get(SPC700::MOVdpdp), DestLo)
+        .addReg(SrcLo, getKillRegState(KillSrc));
+    BuildMI(MBB, MI, DL, get(SPC700::MOVdpdp), DestHi)
+        .addReg(SrcHi, getKillRegState(KillSrc));
+    return;
+  }
+
+  if (!SPC700::GPR8RegClass.contains(DestReg, SrcReg))
+    llvm_unreachable("Impossible reg-to-reg copy");
+
+  // There is no `MOV X, Y`, go through the stack, which keeps A and the
+  // flags.
+  if (SPC700::IndexRegsRegClass.contains(DestReg, SrcReg)) {
+    BuildMI(MBB, MI, DL, get(DestReg == SPC700::X ? SPC700::PUSHY
+                                                  : SPC700::PUSHX))
+        .addReg(SrcReg, getKillRegState(KillSrc));
+    BuildMI(MBB, MI, DL, get(DestReg == SPC700::X ? SPC700::POPX
+                                                  : SPC700::POPY),
+            DestReg);
+    return;
+  }
+
+  unsigned Opc = getCopyOpcode(DestReg, SrcReg);
+  assert(Opc && "Impossible reg-to-reg copy");
+
+  // Only the copies into A, X and Y set N and Z.
+  bool SavePSW = get(Opc).hasImplicitDefOfPhysReg(SPC700::PSW) &&
+                 isPSWLive(MBB, MI);
+  if (SavePSW)
+    BuildMI(MBB, MI, DL, get(SPC700::PUSHPSW));
+  BuildMI(MBB, MI, DL, get(Opc), DestReg)
+      .addReg(SrcReg, getKillRegState(KillSrc));
+  if (SavePSW)
+    BuildMI(MBB, MI, DL, get(SPC700::POPPSW));
+}
+
+unsigned SPC700InstrInfo::isLoadFromStackSlot(const MachineInstr &MI,
+                                              int &FrameIndex) const {
+  switch (MI.getOpcode()) {
+  case SPC700::LDfi8:
+  case SPC700::LDfi16: {
+    if (MI.getOperand(1).isFI() && MI.getOperand(2).isImm() &&
+        MI.getOperand(2).getImm() == 0) {
+      FrameIndex = MI.getOperand(1).getIndex();
+      return MI.getOperand(0).getReg();
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  return 0;
+}
+
+unsigned SPC700InstrInfo::isStoreToStackSlot(const MachineInstr &MI,
+                                             int &FrameIndex) const {
+  switch (MI.getOpcode()) {
+  case SPC700::STfi8:
+  case SPC700::STfi16: {
+    if (MI.getOperand(0).isFI() && MI.getOperand(1).isImm() &&
+        MI.getOperand(1).getImm() == 0) {
+      FrameIndex = MI.getOperand(0).getIndex();
+      return MI.getOperand(2).getReg();
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  return 0;
+}
+
+bool SPC700InstrInfo::isReallyTriviallyReMaterializable(
+    const MachineInstr &MI, AliasAnalysis *AA) const {
+  // The constant pseudos define PSW, which the generic check turns down.
+  // Nothing keeps the flags live across anything but the branch glued to
+  // the compare which set them.
+  switch (MI.getOpcode()) {
+  case SPC700::LDI8:
+  case SPC700::LDI16:
+  case SPC700::MOVAimm:
+  case SPC700::MOVXimm:
+  case SPC700::MOVYimm: {
+    const MachineOperand &MO = MI.getOperand(1);
+    return MO.isImm() || MO.isGlobal() || MO.isBlockAddress() ||
+           MO.isSymbol();
+  }
+  default:
+    return false;
+  }
+}
+
+void SPC700InstrInfo::storeRegToStackSlot(MachineBasicBlock &MBB,
+                                          MachineBasicBlock::iterator MI,
+                                          unsigned SrcReg, bool isKill,
+                                          int FrameIndex,
+                                          const TargetRegisterClass *RC,
+                                          const TargetRegisterInfo *TRI) const {
+  DebugLoc DL;
+  if (MI != MBB.end()) {
+    DL = MI->getDebugLoc();
+  }
+
+  MachineFunction &MF = *MBB.getParent();
+  const MachineFrameInfo &MFI = MF.getFrameInfo();
+
+  MachineMemOperand *MMO = MF.getMachineMemOperand(
+      MachinePointerInfo::getFixedStack(MF, FrameIndex),
+      MachineMemOperand::MOStore, MFI.getObjectSize(FrameIndex),
+      MFI.getObjectAlignment(FrameIndex));
+
+  unsigned Opcode = 0;
+  if (TRI->isTypeLegalForClass(*RC, MVT::i8)) {
+    Opcode = SPC700::STfi8;
+  } else if (TRI->isTypeLegalForClass(*RC, MVT::i16)) {
+    Opcode = SPC700::STfi16;
+  } else {
+    llvm_unreachable("Cannot store this register into a stack slot!");
+  }
+
+  BuildMI(MBB, MI, DL, get(Opcode))
+      .addFrameIndex(FrameIndex)
+      .addImm(0)
+      .addReg(SrcReg, getKillRegState(isKill))
+      .addMemOperand(MMO);
+}
+
+void SPC700InstrInfo::loadRegFromStackSlot(
+    MachineBasicBlock &MBB, MachineBasicBlock::iterator MI, unsigned DestReg,
+    int FrameIndex, const TargetRegisterClass *RC,
+    const TargetRegisterInfo *TRI) const {
+  DebugLoc DL;
+  if (MI != MBB.end()) {
+    DL = MI->getDebugLoc();
+  }
+
+  MachineFunction &MF = *MBB.getParent();
+  const MachineFrameInfo &MFI = MF.getFrameInfo();
+
+  MachineMemOperand *MMO = MF.getMachineMemOperand(
+      MachinePointerInfo::getFixedStack(MF, FrameIndex),
+      MachineMemOperand::MOLoad, MFI.getObjectSize(FrameIndex),
+      MFI.getObjectAlignment(FrameIndex));
+
+  unsigned Opcode = 0;
+  if (TRI->isTypeLegalForClass(*RC, MVT::i8)) {
+    Opcode = SPC700::LDfi8;
+  } else if (TRI->isTypeLegalForClass(*RC, MVT::i16)) {
+    Opcode = SPC700::LDfi16;
+  } else {
+    llvm_unreachable("Cannot load this register from a stack slot!");
+  }
+
+  BuildMI(MBB, MI, DL, get(Opcode), DestReg)
+      .addFrameIndex(FrameIndex)
+      .addImm(0)
+      .addMemOperand(MMO);
+}
+
+const MCInstrDesc &SPC700InstrInfo::getBrCond(SPC700CC::CondCodes CC) const {
+  switch (CC) {
+  default:
+    llvm_unreachable("Unknown condition code!");
+  case SPC700CC::COND_EQ:
+    return get(SPC700::BEQ);
+  case SPC700CC::COND_NE:
+    return get(SPC700::BNE);
+  case SPC700CC::COND_CS:
+    return get(SPC700::BCS);
+  case SPC700CC::COND_CC:
+    return get(SPC700::BCC);
+  case SPC700CC::COND_MI:
+    return get(SPC700::BMI);
+  case SPC700CC::COND_PL:
+    return get(SPC700::BPL);
+  }
+}
+
+SPC700CC::CondCodes SPC700InstrInfo::getCondFromBranchOpc(unsigned Opc) const {
+  switch (Opc) {
+  default:
+    return SPC700CC::COND_INVALID;
+  case SPC700::BEQ:
+    return SPC700CC::COND_EQ;
+  case SPC700::BNE:
+    return SPC700CC::COND_NE;
+  case SPC700::BCS:
+    return SPC700CC::COND_CS;
+  case SPC700::BCC:
+    return SPC700CC::COND_CC;
+  case SPC700::BMI:
+    return SPC700CC::COND_MI;
+  case SPC700::BPL:
+    return SPC700CC::COND_PL;
+  }
+}
+
+SPC700CC::CondCodes
+SPC700InstrInfo::getOppositeCondition(SPC700CC::CondCodes CC) const {
+  switch (CC) {
+  default:
+    llvm_unreachable("Invalid condition!");
+  case SPC700CC::COND_EQ:
+    return SPC700CC::COND_NE;
+  case SPC700CC::COND_NE:
+    return SPC700CC::COND_EQ;
+  case SPC700CC::COND_CS:
+    return SPC700CC::COND_CC;
+  case SPC700CC::COND_CC:
+    return SPC700CC::COND_CS;
+  case SPC700CC::COND_MI:
+    return SPC700CC::COND_PL;
+  case SPC700CC::COND_PL:
+    return SPC700CC::COND_MI;
+  }
+}
+
+bool SPC700InstrInfo::analyzeBranch(MachineBasicBlock &MBB,
+                                    MachineBasicBlock *&TBB,
+                                    MachineBasicBlock *&FBB,
+                                    SmallVectorImpl<MachineOperand> &Cond,
+                                    bool AllowModify) const {
+  // Start from the bottom of the block and work up, examining the
+  // terminator instructions.
+  MachineBasicBlock::iterator I = MBB.end();
+  MachineBasicBlock::iterator UnCondBrIter = MBB.end();
+
+  while (I != MBB.begin()) {
+    --I;
+    if (I->isDebugValue()) {
+      continue;
+    }
+
+    // Working from the bottom, when we see a non-terminator
+    // instruction, we're done.
+    if (!isUnpredicatedTerminator(*I)) {
+      break;
+    }
+
+    // A terminator that isn't a branch can't easily be handled
+    // by this analysis.
+    if (!I->getDesc().isBranch()) {
+      return true;
+    }
+
+    // Handle unconditional branches.
+    if (I->getOpcode() == SPC700::BRA) {
+      UnCondBrIter = I;
+
+      if (!AllowModify) {
+        TBB = I->getOperand(0).getMBB();
+        continue;
+      }
+
+      // If the block has any instructions after a BRA, delete them.
+      while (std::next(I) != MBB.end()) {
+        std::next(I)->eraseFromParent();
+      }
+
+      Cond.clear();
+      FBB = 0;
+
+      // Delete the BRA if it's equivalent to a fall-through.
+      if (MBB.isLayoutSuccessor(I->getOperand(0).getMBB())) {
+        TBB = 0;
+        I->eraseFromParent();
+        I = MBB.end();
+        UnCondBrIter = MBB.end();
+        continue;
+      }
+
+      // TBB is used to indicate the unconditinal destination.
+      TBB = I->getOperand(0).getMBB();
+      continue;
+    }
+
+    // Handle conditional branches.
+    SPC700CC::CondCodes BranchCode = getCondFromBranchOpc(I->getOpcode());
+    if (BranchCode == SPC700CC::COND_INVALID) {
+      return true; // Can't handle indirect branch.
+    }
+
+    // Working from the bottom, handle the first conditional branch.
+    if (Cond.empty()) {
+      MachineBasicBlock *TargetBB = I->getOperand(0).getMBB();
+      if (AllowModify && UnCondBrIter != MBB.end() &&
+          MBB.isLayoutSuccessor(TargetBB)) {
+        // Turn `bCC L1; bra L2; L1:` into `bnCC L2; L1:`.
+        BranchCode = getOppositeCondition(BranchCode);
+        unsigned JNCC = getBrCond(BranchCode).getOpcode();
+        MachineBasicBlock::iterator OldInst = I;
+
+        BuildMI(MBB, UnCondBrIter, MBB.findDebugLoc(I), get(JNCC))
+            .addMBB(UnCondBrIter->getOperand(0).getMBB());
+        BuildMI(MBB, UnCondBrIter, MBB.findDebugLoc(I), get(SPC700::BRA))
+            .addMBB(TargetBB);
+
+        OldInst->eraseFromParent();
+        UnCondBrIter->eraseFromParent();
+
+        // Restart the analysis.
+        UnCondBrIter = MBB.end();
+        I = MBB.end();
+        continue;
+      }
+
+      FBB = TBB;
+      TBB = I->getOperand(0).getMBB();
+      Cond.push_back(MachineOperand::CreateImm(BranchCode));
+      continue;
+    }
+
+    // Handle subsequent conditional branches. Only handle the case where all
+    // conditional branches branch to the same destination.
+    assert(Cond.size() == 1);
+    assert(TBB);
+
+    if (TBB != I->getOperand(0).getMBB()) {
+      return true;
+    }
+
+    SPC700CC::CondCodes OldBranchCode = (SPC700CC::CondCodes)Cond[0].getImm();
+    // If the conditions are the same, we can leave them alone.
+    if (OldBranchCode == BranchCode) {
+      continue;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+unsigned SPC700InstrInfo::insertBranch(MachineBasicBlock &MBB,
+                                       MachineBasicBlock *TBB,
+                                       MachineBasicBlock *FBB,
+                                       ArrayRef<MachineOperand> Cond,
+                                       const DebugLoc &DL,
+                                       int *BytesAdded) const {
+  if (BytesAdded) *BytesAdded = 0;
+
+  // Shouldn't be a fall through.
+  assert(TBB && "insertBranch must not be told to insert a fallthrough");
+  assert((Cond.size() == 1 || Cond.size() == 0) &&
+         "SPC700 branch conditions have one component!");
+
+  if (Cond.empty()) {
+    assert(!FBB && "Unconditional branch with multiple successors!");
+    auto &MI = *BuildMI(&MBB, DL, get(SPC700::BRA)).addMBB(TBB);
+    if (BytesAdded)
+      *BytesAdded += getInstSizeInBytes(MI);
+    return 1;
+  }
+
+  // Conditional branch.
+  unsigned Count = 0;
+  SPC700CC::CondCodes CC = (SPC700CC::CondCodes)Cond[0].getImm();
+  auto &CondMI = *BuildMI(&MBB, DL, getBrCond(CC)).addMBB(TBB);
+
+  if (BytesAdded) *BytesAdded += getInstSizeInBytes(CondMI);
+  ++Count;
+
+  if (FBB) {
+    // Two-way Conditional branch. Insert the second branch.
+    auto &MI = *BuildMI(&MBB, DL, get(SPC700::BRA)).addMBB(FBB);
+    if (BytesAdded) *BytesAdded += getInstSizeInBytes(MI);
+    ++Count;
+  }
+
+  return Count;
+}
+
+unsigned SPC700InstrInfo::removeBranch(MachineBasicBlock &MBB,
+                                       int *BytesRemoved) const {
+  if (BytesRemoved) *BytesRemoved = 0;
+
+  MachineBasicBlock::iterator I = MBB.end();
+  unsigned Count = 0;
+
+  while (I != MBB.begin()) {
+    --I;
+    if (I->isDebugValue()) {
+      continue;
+    }
+    if (I->getOpcode() != SPC700::BRA &&
+        getCondFromBranchOpc(I->getOpcode()) == SPC700CC::COND_INVALID) {
+      break;
+    }
+
+    // Remove the branch.
+    if (BytesRemoved) *BytesRemoved += getInstSizeInBytes(*I);
+    I->eraseFromParent();
+    I = MBB.end();
+    ++Count;
+  }
+
+  return Count;
+}
+
+bool SPC700InstrInfo::reverseBranchCondition(
+    SmallVectorImpl<MachineOperand> &Cond) const {
+  assert(Cond.size() == 1 && "Invalid SPC700 branch condition!");
+
+  SPC700CC::CondCodes CC = static_cast<SPC700CC::CondCodes>(Cond[0].getImm());
+  Cond[0].setImm(getOppositeCondition(CC));
+
+  return false;
+}
+
+MachineBasicBlock *
+SPC700InstrInfo::getBranchDestBlock(const MachineInstr &MI) const {
+  switch (MI.getOpcode()) {
+  default:
+    llvm_unreachable("unexpected opcode!");
+  case SPC700::BRA:
+  case SPC700::JMP:
+  case SPC700::BEQ:
+  case SPC700::BNE:
+  case SPC700::BCS:
+  case SPC700::BCC:
+  case SPC700::BMI:
+  case SPC700::BPL:
+    return MI.getOperand(0).getMBB();
+  }
+}
+
+} // end of namespace llvm
@@ -0,0 +1,115 @@
+//===-- SPC700InstrInfo.h - SPC700 Instruction Information ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the SPC700 implementation of the TargetInstrInfo class.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_INSTR_INFO_H
+#define LLVM_SPC700_INSTR_INFO_H
+
+#include "llvm/Target/TargetInstrInfo.h"
+
+#include "SPC700RegisterInfo.h"
+
+#define GET_INSTRINFO_HEADER
+#include "SPC700GenInstrInfo.inc"
+#undef GET_INSTRINFO_HEADER
+
+namespace llvm {
+
+namespace SPC700CC {
+
+/// SPC700 specific condition codes.
+/// These correspond to `SPC700_COND_*` in `SPC700InstrInfo.td`.
+/// They must be kept in synch.
+enum CondCodes {
+  COND_EQ, //!< Equal
+  COND_NE, //!< Not equal
+  COND_CS, //!< Carry set, unsigned higher or same
+  COND_CC, //!< Carry clear, unsigned lower
+  COND_MI, //!< Minus
+  COND_PL, //!< Plus
+  COND_INVALID
+};
+
+} // end of namespace SPC700CC
+
+namespace SPC700II {
+
+/// Specifies a target operand flag.
+enum TOF {
+  MO_NO_FLAG,
+
+  /// On a symbol operand, this represents the lo part.
+  MO_LO = (1 << 1),
+
+  /// On a symbol operand, this represents the hi part.
+  MO_HI = (1 << 2)
+};
+
+} // end of namespace SPC700II
+
+/// Utilities related to the SPC700 instruction set.
+class SPC700InstrInfo : public SPC700GenInstrInfo {
+public:
+  explicit SPC700InstrInfo();
+
+  const SPC700RegisterInfo &getRegisterInfo() const { return RI; }
+  const MCInstrDesc &getBrCond(SPC700CC::CondCodes CC) const;
+  SPC700CC::CondCodes getCondFromBranchOpc(unsigned Opc) const;
+  SPC700CC::CondCodes getOppositeCondition(SPC700CC::CondCodes CC) const;
+
+  void copyPhysReg(MachineBasicBlock &MBB, MachineBasicBlock::iterator MI,
+                   const DebugLoc &DL, unsigned DestReg, unsigned SrcReg,
+                   bool KillSrc) const override;
+  void storeRegToStackSlot(MachineBasicBlock &MBB,
+                           MachineBasicBlock::iterator MI, unsigned SrcReg,
+                           bool isKill, int FrameIndex,
+                           const TargetRegisterClass *RC,
+                           const TargetRegisterInfo *TRI) const override;
+  void loadRegFromStackSlot(MachineBasicBlock &MBB,
+                            MachineBasicBlock::iterator MI, unsigned DestReg,
+                            int FrameIndex, const TargetRegisterClass *RC,
+                            const TargetRegisterInfo *TRI) const override;
+  unsigned isLoadFromStackSlot(const MachineInstr &MI,
+                               int &FrameIndex) const override;
+  unsigned isStoreToStackSlot(const MachineInstr &MI,
+                              int &FrameIndex) const override;
+  bool isReallyTriviallyReMaterializable(const MachineInstr &MI,
+                                         AliasAnalysis *AA) const override;
+
+  /// Checks if the flags may be read after \p I, so that an instruction
+  /// inserted before it has to preserve them.
+  bool isPSWLive(MachineBasicBlock &MBB,
+                 MachineBasicBlock::iterator I) const;
+
+  // Branch analysis.
+  bool analyzeBranch(MachineBasicBlock &MBB, MachineBasicBlock *&TBB,
+                     MachineBasicBlock *&FBB,
+                     SmallVectorImpl<MachineOperand> &Cond,
+                     bool AllowModify = false) const override;
+  unsigned insertBranch(MachineBasicBlock &MBB, MachineBasicBlock *TBB,
+                        MachineBasicBlock *FBB, ArrayRef<MachineOperand> Cond,
+                        const DebugLoc &DL,
+                        int *BytesAdded = nullptr) const override;
+  unsigned removeBranch(MachineBasicBlock &MBB,
+                        int *BytesRemoved = nullptr) const override;
+  bool
+  reverseBranchCondition(SmallVectorImpl<MachineOperand> &Cond) const override;
+
+  MachineBasicBlock *getBranchDestBlock(const MachineInstr &MI) const override;
+
+private:
+  const SPC700RegisterInfo RI;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_INSTR_INFO_H
@@ -0,0 +1,111 @@
+//===-- SPC700RegisterInfo.cpp - SPC700 Register Information --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the SPC700 implementation of the TargetRegisterInfo class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700RegisterInfo.h"
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Target/TargetFrameLowering.h"
+
+#include "SPC700.h"
+#include "SPC700InstrInfo.h"
+#include "SPC700TargetMachine.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#define GET_REGINFO_TARGET_DESC
+#include "SPC700GenRegisterInfo.inc"
+
+namespace llvm {
+
+SPC700RegisterInfo::SPC700RegisterInfo() : SPC700GenRegisterInfo(0) {}
+
+const uint16_t *
+SPC700RegisterInfo::getCalleeSavedRegs(const MachineFunction *MF) const {
+  return CSR_SPC700_SaveList;
+}
+
+const uint32_t *
+SPC700RegisterInfo::getCallPreservedMask(const MachineFunction &MF,
+                                         CallingConv::ID CC) const {
+  return CSR_SPC700_RegMask;
+}
+
+BitVector SPC700RegisterInfo::getReservedRegs(const MachineFunction &MF) const {
+  BitVector Reserved(getNumRegs());
+
+  // Reserve the stack pointer register
+  Reserved.set(SPC700::SP);
+
+  // Reserve the status register
+  Reserved.set(SPC700::PSW);
+
+  // Reserve the scratch registers of the pseudo expansions
+  Reserved.set(SPC700::R14);
+  Reserved.set(SPC700::R15);
+  Reserved.set(SPC700::RW7);
+
+  return Reserved;
+}
+
+void SPC700RegisterInfo::eliminateFrameIndex(MachineBasicBlock::iterator II,
+                                             int SPAdj, unsigned FIOperandNum,
+                                             RegScavenger *RS) const {
+  assert(SPAdj == 0 && "Unexpected SPAdj value");
+
+  MachineInstr &MI = *II;
+  const MachineFunction &MF = *MI.getParent()->getParent();
+  const MachineFrameInfo &MFI = MF.getFrameInfo();
+  int FrameIndex = MI.getOperand(FIOperandNum).getIndex();
+  int Offset = MFI.getObjectOffset(FrameIndex);
+
+  // Add one to the offset because SP points to an empty slot.
+  Offset += MFI.getStackSize() + 1;
+  // Fold incoming offset.
+  Offset += MI.getOperand(FIOperandNum + 1).getImm();
+
+  // The pseudos read both bytes of a word at `Offset` and `Offset + 1`.
+  if (Offset < 0 || Offset + 1 > int(SPC700::MaxFrameSize))
+    report_fatal_error("SPC700: stack frame of '" +
+                       MF.getFunction()->getName() + "' is too large");
+
+  // Only the offset from SP is left, the pseudos index the stack page with
+  // SP in X.
+  MI.getOperand(FIOperandNum).ChangeToImmediate(0);
+  MI.getOperand(FIOperandNum + 1).ChangeToImmediate(Offset);
+}
+
+unsigned SPC700RegisterInfo::getFrameRegister(const MachineFunction &MF) const {
+  return SPC700::SP;
+}
+
+const TargetRegisterClass *
+SPC700RegisterInfo::getPointerRegClass(const MachineFunction &MF,
+                                       unsigned Kind) const {
+  return &SPC700::DPWRegsRegClass;
+}
+
+void SPC700RegisterInfo::splitReg(unsigned Reg,
+                                  unsigned &LoReg,
+                                  unsigned &HiReg) const {
+  assert(SPC700::GPR16RegClass.contains(Reg) &&
+         "can only split 16-bit registers");
+
+  LoReg = getSubReg(Reg, SPC700::sub_lo);
+  HiReg = getSubReg(Reg, SPC700::sub_hi);
+}
+
+} // end of namespace llvm
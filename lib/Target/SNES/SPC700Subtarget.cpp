@@ -0,0 +1,39 @@
+//===-- SPC700Subtarget.cpp - SPC700 Subtarget Information ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SPC700 specific subclass of TargetSubtargetInfo.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700Subtarget.h"
+
+#include "llvm/Support/TargetRegistry.h"
+
+#include "SPC700.h"
+#include "SPC700TargetMachine.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+#define DEBUG_TYPE "spc700-subtarget"
+
+#define GET_SUBTARGETINFO_TARGET_DESC
+#define GET_SUBTARGETINFO_CTOR
+#include "SPC700GenSubtargetInfo.inc"
+
+namespace llvm {
+
+SPC700Subtarget::SPC700Subtarget(const Triple &TT, const std::string &CPU,
+                                 const std::string &FS,
+                                 SPC700TargetMachine &TM)
+    : SPC700GenSubtargetInfo(TT, CPU, FS), InstrInfo(), FrameLowering(),
+      TLInfo(TM), TSInfo() {
+  // Parse features string.
+  ParseSubtargetFeatures(CPU, FS);
+}
+
+} // end of namespace llvm
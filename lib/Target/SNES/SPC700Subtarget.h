@@ -0,0 +1,69 @@
+//===-- SPC700Subtarget.h - Define Subtarget for the SPC700 -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the SPC700 specific subclass of TargetSubtargetInfo.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_SUBTARGET_H
+#define LLVM_SPC700_SUBTARGET_H
+
+#include "llvm/CodeGen/SelectionDAGTargetInfo.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+
+#include "SPC700FrameLowering.h"
+#include "SPC700ISelLowering.h"
+#include "SPC700InstrInfo.h"
+
+#define GET_SUBTARGETINFO_HEADER
+#include "SPC700GenSubtargetInfo.inc"
+
+namespace llvm {
+
+/// The SPC700, there is only the one.
+class SPC700Subtarget : public SPC700GenSubtargetInfo {
+public:
+  //! Creates an SPC700 subtarget.
+  //! \param TT  The target triple.
+  //! \param CPU The CPU to target.
+  //! \param FS  The feature string.
+  //! \param TM  The target machine.
+  SPC700Subtarget(const Triple &TT, const std::string &CPU,
+                  const std::string &FS, SPC700TargetMachine &TM);
+
+  const SPC700InstrInfo *getInstrInfo() const override { return &InstrInfo; }
+  const TargetFrameLowering *getFrameLowering() const override {
+    return &FrameLowering;
+  }
+  const SPC700TargetLowering *getTargetLowering() const override {
+    return &TLInfo;
+  }
+  const SelectionDAGTargetInfo *getSelectionDAGInfo() const override {
+    return &TSInfo;
+  }
+  const SPC700RegisterInfo *getRegisterInfo() const override {
+    return &InstrInfo.getRegisterInfo();
+  }
+
+  /// Parses a subtarget feature string, setting appropriate options.
+  /// \note Definition of function is auto generated by `tblgen`.
+  void ParseSubtargetFeatures(StringRef CPU, StringRef FS);
+
+private:
+  SPC700InstrInfo InstrInfo;
+  SPC700FrameLowering FrameLowering;
+  SPC700TargetLowering TLInfo;
+  SelectionDAGTargetInfo TSInfo;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_SUBTARGET_H
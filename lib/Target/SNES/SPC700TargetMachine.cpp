@@ -0,0 +1,108 @@
+//===-- SPC700TargetMachine.cpp - Define TargetMachine for SPC700 ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SPC700 specific subclass of TargetMachine.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SPC700TargetMachine.h"
+
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/TargetLoweringObjectFileImpl.h"
+#include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Support/TargetRegistry.h"
+
+#include "SPC700.h"
+#include "MCTargetDesc/SPC700MCTargetDesc.h"
+
+namespace llvm {
+
+/// The same layout as the S-CPU side, the ABI of both is 16-bit.
+static const char *SPC700DataLayout = "e-p:16:8:8-i1:8:8-i8:8:8-i16:8:8-n8:16";
+
+/// Processes a CPU name.
+static StringRef getCPU(StringRef CPU) {
+  if (CPU.empty() || CPU == "generic")
+    return "spc700";
+
+  return CPU;
+}
+
+static Reloc::Model getEffectiveRelocModel(Optional<Reloc::Model> RM) {
+  return RM.hasValue() ? *RM : Reloc::Static;
+}
+
+SPC700TargetMachine::SPC700TargetMachine(const Target &T, const Triple &TT,
+                                         StringRef CPU, StringRef FS,
+                                         const TargetOptions &Options,
+                                         Optional<Reloc::Model> RM,
+                                         CodeModel::Model CM,
+                                         CodeGenOpt::Level OL)
+    : LLVMTargetMachine(
+          T, SPC700DataLayout, TT,
+          getCPU(CPU), FS, Options, getEffectiveRelocModel(RM), CM, OL),
+      SubTarget(TT, getCPU(CPU), FS, *this) {
+  this->TLOF = make_unique<TargetLoweringObjectFileELF>();
+  initAsmInfo();
+}
+
+namespace {
+/// SPC700 Code Generator Pass Configuration Options.
+class SPC700PassConfig : public TargetPassConfig {
+public:
+  SPC700PassConfig(SPC700TargetMachine &TM, PassManagerBase &PM)
+      : TargetPassConfig(TM, PM) {}
+
+  SPC700TargetMachine &getSPC700TargetMachine() const {
+    return getTM<SPC700TargetMachine>();
+  }
+
+  bool addInstSelector() override;
+  void addPreSched2() override;
+};
+} // namespace
+
+TargetPassConfig *SPC700TargetMachine::createPassConfig(PassManagerBase &PM) {
+  return new SPC700PassConfig(*this, PM);
+}
+
+/// Registers the SPC700 target machine, called along with the SNES one.
+void registerSPC700Target() {
+  RegisterTargetMachine<SPC700TargetMachine> X(getTheSPC700Target());
+
+  auto &PR = *PassRegistry::getPassRegistry();
+  initializeSPC700ExpandPseudoPass(PR);
+}
+
+const SPC700Subtarget *SPC700TargetMachine::getSubtargetImpl() const {
+  return &SubTarget;
+}
+
+const SPC700Subtarget *
+SPC700TargetMachine::getSubtargetImpl(const Function &) const {
+  return &SubTarget;
+}
+
+//===----------------------------------------------------------------------===//
+// Pass Pipeline Configuration
+//===----------------------------------------------------------------------===//
+
+bool SPC700PassConfig::addInstSelector() {
+  // Install an instruction selector.
+  addPass(createSPC700ISelDag(getSPC700TargetMachine(), getOptLevel()));
+
+  return false;
+}
+
+void SPC700PassConfig::addPreSched2() {
+  addPass(createSPC700ExpandPseudoPass());
+}
+
+} // end of namespace llvm
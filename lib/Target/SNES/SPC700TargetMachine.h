@@ -0,0 +1,55 @@
+//===-- SPC700TargetMachine.h - Define TargetMachine for SPC700 -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the SPC700 specific subclass of TargetMachine.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SPC700_TARGET_MACHINE_H
+#define LLVM_SPC700_TARGET_MACHINE_H
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include "SPC700FrameLowering.h"
+#include "SPC700ISelLowering.h"
+#include "SPC700InstrInfo.h"
+#include "SPC700Subtarget.h"
+
+namespace llvm {
+
+/// The SPC700 audio CPU of the SNES.
+class SPC700TargetMachine : public LLVMTargetMachine {
+public:
+  SPC700TargetMachine(const Target &T, const Triple &TT, StringRef CPU,
+                      StringRef FS, const TargetOptions &Options,
+                      Optional<Reloc::Model> RM, CodeModel::Model CM,
+                      CodeGenOpt::Level OL);
+
+  const SPC700Subtarget *getSubtargetImpl() const;
+  const SPC700Subtarget *getSubtargetImpl(const Function &) const override;
+
+  TargetLoweringObjectFile *getObjFileLowering() const override {
+    return this->TLOF.get();
+  }
+
+  TargetPassConfig *createPassConfig(PassManagerBase &PM) override;
+
+  bool isMachineVerifierClean() const override {
+    return false;
+  }
+
+private:
+  std::unique_ptr<TargetLoweringObjectFile> TLOF;
+  SPC700Subtarget SubTarget;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SPC700_TARGET_MACHINE_H
@@ -14,10 +14,19 @@ Target &getTheSNESTarget() {
   static Target TheSNESTarget;
   return TheSNESTarget;
 }
+
+Target &getTheSPC700Target() {
+  static Target TheSPC700Target;
+  return TheSPC700Target;
+}
 }
 
 extern "C" void LLVMInitializeSNESTargetInfo() {
   llvm::RegisterTarget<llvm::Triple::snes> X(llvm::getTheSNESTarget(), "snes",
                                             "Super Nintendo Entertainment System 65c816");
+  // The audio CPU is built from the same library, see SPC700.td.
+  llvm::RegisterTarget<llvm::Triple::spc700> Y(llvm::getTheSPC700Target(),
+                                               "spc700",
+                                               "Sony SPC700 audio processor");
 }
 
@@ -0,0 +1,76 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Finds the first of 32 boxes the player's box overlaps, as for the enemies
+; and bullets of a frame. Most boxes are far off on X.
+;
+;   struct box { short x, y, w, h; };
+;
+;   int bench_collide(const struct box *a, const struct box *b, unsigned n) {
+;     for (unsigned i = 0; i != n; ++i, ++b)
+;       if (a->x < b->x + b->w && b->x < a->x + a->w &&
+;           a->y < b->y + b->h && b->y < a->y + a->h)
+;         return i;
+;     return -1;
+;   }
+
+%struct.box = type { i16, i16, i16, i16 }
+
+define i16 @bench_collide(%struct.box* %a, %struct.box* %b, i16 %n) {
+entry:
+  %ax.p = getelementptr inbounds %struct.box, %struct.box* %a, i16 0, i32 0
+  %ax = load i16, i16* %ax.p
+  %ay.p = getelementptr inbounds %struct.box, %struct.box* %a, i16 0, i32 1
+  %ay = load i16, i16* %ay.p
+  %aw.p = getelementptr inbounds %struct.box, %struct.box* %a, i16 0, i32 2
+  %aw = load i16, i16* %aw.p
+  %ah.p = getelementptr inbounds %struct.box, %struct.box* %a, i16 0, i32 3
+  %ah = load i16, i16* %ah.p
+  %ax.end = add nsw i16 %ax, %aw
+  %ay.end = add nsw i16 %ay, %ah
+  %empty = icmp eq i16 %n, 0
+  br i1 %empty, label %exit, label %loop, !prof !0
+
+loop:
+  %i = phi i16 [ 0, %entry ], [ %i.next, %next ]
+  %p = phi %struct.box* [ %b, %entry ], [ %p.next, %next ]
+  %bx.p = getelementptr inbounds %struct.box, %struct.box* %p, i16 0, i32 0
+  %bx = load i16, i16* %bx.p
+  %bw.p = getelementptr inbounds %struct.box, %struct.box* %p, i16 0, i32 2
+  %bw = load i16, i16* %bw.p
+  %bx.end = add nsw i16 %bx, %bw
+  %left = icmp slt i16 %ax, %bx.end
+  br i1 %left, label %right.test, label %next, !prof !1
+
+right.test:
+  %right = icmp slt i16 %bx, %ax.end
+  br i1 %right, label %top.test, label %next, !prof !1
+
+top.test:
+  %by.p = getelementptr inbounds %struct.box, %struct.box* %p, i16 0, i32 1
+  %by = load i16, i16* %by.p
+  %bh.p = getelementptr inbounds %struct.box, %struct.box* %p, i16 0, i32 3
+  %bh = load i16, i16* %bh.p
+  %by.end = add nsw i16 %by, %bh
+  %top = icmp slt i16 %ay, %by.end
+  br i1 %top, label %bottom.test, label %next, !prof !2
+
+bottom.test:
+  %bottom = icmp slt i16 %by, %ay.end
+  br i1 %bottom, label %exit, label %next, !prof !2
+
+next:
+  %i.next = add nuw i16 %i, 1
+  %p.next = getelementptr inbounds %struct.box, %struct.box* %p, i16 1
+  %done = icmp eq i16 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !3
+
+exit:
+  %r = phi i16 [ -1, %entry ], [ %i, %bottom.test ], [ -1, %next ]
+  ret i16 %r
+}
+
+!0 = !{!"branch_weights", i32 1, i32 31}
+!1 = !{!"branch_weights", i32 1, i32 3}
+!2 = !{!"branch_weights", i32 1, i32 1}
+!3 = !{!"branch_weights", i32 1, i32 31}
@@ -0,0 +1,97 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Transforms 64 vertices by a 3x3 matrix in 8.8 fixed point. Both factors are
+; cut down to 4.4 so that the products fit in 16 bits, the usual trade on a
+; CPU with an 8x8 multiplier.
+;
+;   void bench_transform(const short *m, const short *in, short *out,
+;                        unsigned n) {
+;     short m00 = m[0] >> 4, m01 = m[1] >> 4, ..., m22 = m[8] >> 4;
+;     for (unsigned i = 0; i != n; ++i, in += 3, out += 3) {
+;       short x = in[0] >> 4, y = in[1] >> 4, z = in[2] >> 4;
+;       out[0] = m00 * x + m01 * y + m02 * z;
+;       out[1] = m10 * x + m11 * y + m12 * z;
+;       out[2] = m20 * x + m21 * y + m22 * z;
+;     }
+;   }
+
+define void @bench_transform(i16* %m, i16* %in, i16* %out, i16 %n) {
+entry:
+  %m00.v = load i16, i16* %m
+  %m00 = ashr i16 %m00.v, 4
+  %m01.p = getelementptr inbounds i16, i16* %m, i16 1
+  %m01.v = load i16, i16* %m01.p
+  %m01 = ashr i16 %m01.v, 4
+  %m02.p = getelementptr inbounds i16, i16* %m, i16 2
+  %m02.v = load i16, i16* %m02.p
+  %m02 = ashr i16 %m02.v, 4
+  %m10.p = getelementptr inbounds i16, i16* %m, i16 3
+  %m10.v = load i16, i16* %m10.p
+  %m10 = ashr i16 %m10.v, 4
+  %m11.p = getelementptr inbounds i16, i16* %m, i16 4
+  %m11.v = load i16, i16* %m11.p
+  %m11 = ashr i16 %m11.v, 4
+  %m12.p = getelementptr inbounds i16, i16* %m, i16 5
+  %m12.v = load i16, i16* %m12.p
+  %m12 = ashr i16 %m12.v, 4
+  %m20.p = getelementptr inbounds i16, i16* %m, i16 6
+  %m20.v = load i16, i16* %m20.p
+  %m20 = ashr i16 %m20.v, 4
+  %m21.p = getelementptr inbounds i16, i16* %m, i16 7
+  %m21.v = load i16, i16* %m21.p
+  %m21 = ashr i16 %m21.v, 4
+  %m22.p = getelementptr inbounds i16, i16* %m, i16 8
+  %m22.v = load i16, i16* %m22.p
+  %m22 = ashr i16 %m22.v, 4
+  %empty = icmp eq i16 %n, 0
+  br i1 %empty, label %exit, label %loop, !prof !0
+
+loop:
+  %i = phi i16 [ 0, %entry ], [ %i.next, %loop ]
+  %src = phi i16* [ %in, %entry ], [ %src.next, %loop ]
+  %dst = phi i16* [ %out, %entry ], [ %dst.next, %loop ]
+  %x.v = load i16, i16* %src
+  %x = ashr i16 %x.v, 4
+  %y.p = getelementptr inbounds i16, i16* %src, i16 1
+  %y.v = load i16, i16* %y.p
+  %y = ashr i16 %y.v, 4
+  %z.p = getelementptr inbounds i16, i16* %src, i16 2
+  %z.v = load i16, i16* %z.p
+  %z = ashr i16 %z.v, 4
+
+  %r0.x = mul nsw i16 %m00, %x
+  %r0.y = mul nsw i16 %m01, %y
+  %r0.z = mul nsw i16 %m02, %z
+  %r0.xy = add nsw i16 %r0.x, %r0.y
+  %r0 = add nsw i16 %r0.xy, %r0.z
+  store i16 %r0, i16* %dst
+
+  %r1.x = mul nsw i16 %m10, %x
+  %r1.y = mul nsw i16 %m11, %y
+  %r1.z = mul nsw i16 %m12, %z
+  %r1.xy = add nsw i16 %r1.x, %r1.y
+  %r1 = add nsw i16 %r1.xy, %r1.z
+  %r1.p = getelementptr inbounds i16, i16* %dst, i16 1
+  store i16 %r1, i16* %r1.p
+
+  %r2.x = mul nsw i16 %m20, %x
+  %r2.y = mul nsw i16 %m21, %y
+  %r2.z = mul nsw i16 %m22, %z
+  %r2.xy = add nsw i16 %r2.x, %r2.y
+  %r2 = add nsw i16 %r2.xy, %r2.z
+  %r2.p = getelementptr inbounds i16, i16* %dst, i16 2
+  store i16 %r2, i16* %r2.p
+
+  %i.next = add nuw i16 %i, 1
+  %src.next = getelementptr inbounds i16, i16* %src, i16 3
+  %dst.next = getelementptr inbounds i16, i16* %dst, i16 3
+  %done = icmp eq i16 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !1
+
+exit:
+  ret void
+}
+
+!0 = !{!"branch_weights", i32 1, i32 63}
+!1 = !{!"branch_weights", i32 1, i32 63}
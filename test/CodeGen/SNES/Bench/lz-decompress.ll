@@ -0,0 +1,97 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Decompresses LZ77 data into RAM, as for graphics on their way to VRAM. A
+; tag byte with the top bit clear starts a run of tag + 1 literals, with the
+; top bit set a copy of (tag & 0x7F) + 3 bytes from a 16-bit offset back.
+; Weighted for a 2 KiB tile set: 64 literal runs and 192 copies of 8 bytes.
+;
+;   void bench_lz_decompress(const unsigned char *src, unsigned char *dst,
+;                            unsigned char *end) {
+;     while (dst != end) {
+;       unsigned char tag = *src++;
+;       if (tag & 0x80) {
+;         unsigned len = (tag & 0x7F) + 3;
+;         const unsigned char *from = dst - (src[0] | src[1] << 8);
+;         src += 2;
+;         do *dst++ = *from++; while (--len);
+;       } else {
+;         unsigned len = tag + 1;
+;         do *dst++ = *src++; while (--len);
+;       }
+;     }
+;   }
+
+define void @bench_lz_decompress(i8* %src, i8* %dst, i8* %end) {
+entry:
+  %empty = icmp eq i8* %dst, %end
+  br i1 %empty, label %exit, label %token, !prof !0
+
+token:
+  %s = phi i8* [ %src, %entry ], [ %s.lit.end, %literal ], [ %s.match, %next.match ]
+  %d = phi i8* [ %dst, %entry ], [ %d.lit.end, %literal ], [ %d.match.end, %next.match ]
+  %tag = load i8, i8* %s
+  %s.tag = getelementptr inbounds i8, i8* %s, i16 1
+  %is.match = icmp slt i8 %tag, 0
+  br i1 %is.match, label %match.start, label %literal.start, !prof !1
+
+match.start:
+  %len.7 = and i8 %tag, 127
+  %len.16 = zext i8 %len.7 to i16
+  %len = add nuw nsw i16 %len.16, 3
+  %off.lo = load i8, i8* %s.tag
+  %off.hi.p = getelementptr inbounds i8, i8* %s, i16 2
+  %off.hi = load i8, i8* %off.hi.p
+  %off.lo.16 = zext i8 %off.lo to i16
+  %off.hi.16 = zext i8 %off.hi to i16
+  %off.hi.sh = shl nuw i16 %off.hi.16, 8
+  %off = or i16 %off.hi.sh, %off.lo.16
+  %off.neg = sub i16 0, %off
+  %from = getelementptr inbounds i8, i8* %d, i16 %off.neg
+  %s.match = getelementptr inbounds i8, i8* %s, i16 3
+  br label %match
+
+match:
+  %m.n = phi i16 [ %len, %match.start ], [ %m.n.next, %match ]
+  %m.from = phi i8* [ %from, %match.start ], [ %m.from.next, %match ]
+  %m.d = phi i8* [ %d, %match.start ], [ %d.match.end, %match ]
+  %m.b = load i8, i8* %m.from
+  store i8 %m.b, i8* %m.d
+  %m.from.next = getelementptr inbounds i8, i8* %m.from, i16 1
+  %d.match.end = getelementptr inbounds i8, i8* %m.d, i16 1
+  %m.n.next = add i16 %m.n, -1
+  %m.done = icmp eq i16 %m.n.next, 0
+  br i1 %m.done, label %next.match, label %match, !prof !2
+
+next.match:
+  %match.end = icmp eq i8* %d.match.end, %end
+  br i1 %match.end, label %exit, label %token, !prof !0
+
+literal.start:
+  %lit.len.8 = zext i8 %tag to i16
+  %lit.len = add nuw nsw i16 %lit.len.8, 1
+  br label %literal.loop
+
+literal.loop:
+  %l.n = phi i16 [ %lit.len, %literal.start ], [ %l.n.next, %literal.loop ]
+  %l.s = phi i8* [ %s.tag, %literal.start ], [ %s.lit.end, %literal.loop ]
+  %l.d = phi i8* [ %d, %literal.start ], [ %d.lit.end, %literal.loop ]
+  %l.b = load i8, i8* %l.s
+  store i8 %l.b, i8* %l.d
+  %s.lit.end = getelementptr inbounds i8, i8* %l.s, i16 1
+  %d.lit.end = getelementptr inbounds i8, i8* %l.d, i16 1
+  %l.n.next = add i16 %l.n, -1
+  %l.done = icmp eq i16 %l.n.next, 0
+  br i1 %l.done, label %literal, label %literal.loop, !prof !2
+
+literal:
+  %literal.end = icmp eq i8* %d.lit.end, %end
+  br i1 %literal.end, label %exit, label %token, !prof !0
+
+exit:
+  ret void
+}
+
+!0 = !{!"branch_weights", i32 1, i32 255}
+!1 = !{!"branch_weights", i32 3, i32 1}
+!2 = !{!"branch_weights", i32 1, i32 7}
@@ -0,0 +1,84 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Block copies and fills, fixed and variable in size: a palette upload
+; buffer, a 2 KiB tile map, a clear of a 256 byte work area and a copy and
+; fill of a size known at run time, plus the byte loop a hand written copy
+; compiles to.
+;
+;   unsigned short palette[16], work[128];
+;   unsigned char map[2048];
+;
+;   void bench_copy_palette(const unsigned short *p) {
+;     memcpy(palette, p, sizeof(palette));
+;   }
+;   void bench_copy_map(const unsigned char *m) { memcpy(map, m, sizeof(map)); }
+;   void bench_clear_work(void) { memset(work, 0, sizeof(work)); }
+;   void bench_memcpy(void *d, const void *s, unsigned n) { memcpy(d, s, n); }
+;   void bench_memset(void *d, int c, unsigned n) { memset(d, c, n); }
+;   void bench_copy_loop(unsigned char *d, const unsigned char *s,
+;                        unsigned n) {
+;     while (n--)
+;       *d++ = *s++;
+;   }
+
+@palette = global [16 x i16] zeroinitializer
+@map = global [2048 x i8] zeroinitializer
+@work = global [128 x i16] zeroinitializer
+
+define void @bench_copy_palette(i16* %p) {
+entry:
+  %src = bitcast i16* %p to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i16(i8* bitcast ([16 x i16]* @palette to i8*), i8* %src, i16 32, i32 1, i1 false)
+  ret void
+}
+
+define void @bench_copy_map(i8* %m) {
+entry:
+  call void @llvm.memcpy.p0i8.p0i8.i16(i8* getelementptr inbounds ([2048 x i8], [2048 x i8]* @map, i16 0, i16 0), i8* %m, i16 2048, i32 1, i1 false)
+  ret void
+}
+
+define void @bench_clear_work() {
+entry:
+  call void @llvm.memset.p0i8.i16(i8* bitcast ([128 x i16]* @work to i8*), i8 0, i16 256, i32 1, i1 false)
+  ret void
+}
+
+define void @bench_memcpy(i8* %d, i8* %s, i16 %n) {
+entry:
+  call void @llvm.memcpy.p0i8.p0i8.i16(i8* %d, i8* %s, i16 %n, i32 1, i1 false)
+  ret void
+}
+
+define void @bench_memset(i8* %d, i16 %c, i16 %n) {
+entry:
+  %c8 = trunc i16 %c to i8
+  call void @llvm.memset.p0i8.i16(i8* %d, i8 %c8, i16 %n, i32 1, i1 false)
+  ret void
+}
+
+define void @bench_copy_loop(i8* %d, i8* %s, i16 %n) {
+entry:
+  %empty = icmp eq i16 %n, 0
+  br i1 %empty, label %exit, label %loop, !prof !0
+
+loop:
+  %i = phi i16 [ 0, %entry ], [ %i.next, %loop ]
+  %from = getelementptr inbounds i8, i8* %s, i16 %i
+  %b = load i8, i8* %from
+  %to = getelementptr inbounds i8, i8* %d, i16 %i
+  store i8 %b, i8* %to
+  %i.next = add nuw i16 %i, 1
+  %done = icmp eq i16 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !1
+
+exit:
+  ret void
+}
+
+declare void @llvm.memcpy.p0i8.p0i8.i16(i8* nocapture, i8* nocapture readonly, i16, i32, i1)
+declare void @llvm.memset.p0i8.i16(i8* nocapture, i8, i16, i32, i1)
+
+!0 = !{!"branch_weights", i32 1, i32 255}
+!1 = !{!"branch_weights", i32 1, i32 255}
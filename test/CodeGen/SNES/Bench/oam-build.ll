@@ -0,0 +1,81 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Builds the OAM shadow of a frame from a list of 128 sprites: four bytes per
+; sprite in the low table, and the ninth bit of X packed into the high table.
+;
+;   struct sprite { short x, y; unsigned char tile, attr; };
+;   unsigned char oam[544];
+;
+;   void bench_oam_build(const struct sprite *s, unsigned count) {
+;     for (unsigned i = 0; i != count; ++i, ++s) {
+;       oam[4 * i] = s->x;
+;       oam[4 * i + 1] = s->y;
+;       oam[4 * i + 2] = s->tile;
+;       oam[4 * i + 3] = s->attr;
+;       if (s->x & 0x100)
+;         oam[512 + i / 4] |= 1 << (i % 4 * 2);
+;     }
+;   }
+
+%struct.sprite = type { i16, i16, i8, i8 }
+
+@oam = global [544 x i8] zeroinitializer
+
+define void @bench_oam_build(%struct.sprite* %s, i16 %count) {
+entry:
+  %empty = icmp eq i16 %count, 0
+  br i1 %empty, label %exit, label %loop, !prof !0
+
+loop:
+  %i = phi i16 [ 0, %entry ], [ %i.next, %next ]
+  %p = phi %struct.sprite* [ %s, %entry ], [ %p.next, %next ]
+  %xp = getelementptr inbounds %struct.sprite, %struct.sprite* %p, i16 0, i32 0
+  %x = load i16, i16* %xp
+  %yp = getelementptr inbounds %struct.sprite, %struct.sprite* %p, i16 0, i32 1
+  %y = load i16, i16* %yp
+  %tilep = getelementptr inbounds %struct.sprite, %struct.sprite* %p, i16 0, i32 2
+  %tile = load i8, i8* %tilep
+  %attrp = getelementptr inbounds %struct.sprite, %struct.sprite* %p, i16 0, i32 3
+  %attr = load i8, i8* %attrp
+  %lo = shl i16 %i, 2
+  %o0 = getelementptr inbounds [544 x i8], [544 x i8]* @oam, i16 0, i16 %lo
+  %x8 = trunc i16 %x to i8
+  store i8 %x8, i8* %o0
+  %o1 = getelementptr inbounds i8, i8* %o0, i16 1
+  %y8 = trunc i16 %y to i8
+  store i8 %y8, i8* %o1
+  %o2 = getelementptr inbounds i8, i8* %o0, i16 2
+  store i8 %tile, i8* %o2
+  %o3 = getelementptr inbounds i8, i8* %o0, i16 3
+  store i8 %attr, i8* %o3
+  %x9 = and i16 %x, 256
+  %offscreen = icmp ne i16 %x9, 0
+  br i1 %offscreen, label %high, label %next, !prof !1
+
+high:
+  %hi = lshr i16 %i, 2
+  %hi.idx = add i16 %hi, 512
+  %hp = getelementptr inbounds [544 x i8], [544 x i8]* @oam, i16 0, i16 %hi.idx
+  %h = load i8, i8* %hp
+  %slot = and i16 %i, 3
+  %shift = shl i16 %slot, 1
+  %bit = shl i16 1, %shift
+  %bit8 = trunc i16 %bit to i8
+  %h.new = or i8 %h, %bit8
+  store i8 %h.new, i8* %hp
+  br label %next
+
+next:
+  %i.next = add nuw i16 %i, 1
+  %p.next = getelementptr inbounds %struct.sprite, %struct.sprite* %p, i16 1
+  %done = icmp eq i16 %i.next, %count
+  br i1 %done, label %exit, label %loop, !prof !2
+
+exit:
+  ret void
+}
+
+!0 = !{!"branch_weights", i32 1, i32 127}
+!1 = !{!"branch_weights", i32 1, i32 7}
+!2 = !{!"branch_weights", i32 1, i32 127}
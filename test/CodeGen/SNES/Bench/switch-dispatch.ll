@@ -0,0 +1,101 @@
+; RUN: llc < %s -march=snes -snes-cost-report=%t -o /dev/null
+; RUN: %snes_bench check %S/Inputs/baseline.txt %t
+
+; Runs the script of an actor, a byte code with eight commands dispatched by
+; a dense switch, until it yields. About 48 commands per call.
+;
+;   struct actor { short x, y, dx, dy; unsigned char tile, timer; };
+;
+;   const unsigned char *bench_run_script(struct actor *a,
+;                                         const unsigned char *pc) {
+;     for (;;) {
+;       switch (*pc++) {
+;       case 0: a->x += (signed char)*pc++; break;
+;       case 1: a->y += (signed char)*pc++; break;
+;       case 2: a->dx = (signed char)*pc++; break;
+;       case 3: a->dy = (signed char)*pc++; break;
+;       case 4: a->tile = *pc++; break;
+;       case 5: a->x += a->dx; a->y += a->dy; break;
+;       case 6: pc -= *pc; break;
+;       default: a->timer = *pc; return pc + 1;
+;       }
+;     }
+;   }
+
+%struct.actor = type { i16, i16, i16, i16, i8, i8 }
+
+define i8* @bench_run_script(%struct.actor* %a, i8* %pc) {
+entry:
+  %xp = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 0
+  %yp = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 1
+  %dxp = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 2
+  %dyp = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 3
+  %tilep = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 4
+  %timerp = getelementptr inbounds %struct.actor, %struct.actor* %a, i16 0, i32 5
+  br label %dispatch
+
+dispatch:
+  %p = phi i8* [ %pc, %entry ], [ %p.arg.next, %move.x ], [ %p.arg.next, %move.y ], [ %p.arg.next, %set.dx ], [ %p.arg.next, %set.dy ], [ %p.arg.next, %set.tile ], [ %p.arg, %step ], [ %p.back, %jump ]
+  %op = load i8, i8* %p
+  %p.arg = getelementptr inbounds i8, i8* %p, i16 1
+  %p.arg.next = getelementptr inbounds i8, i8* %p, i16 2
+  %arg = load i8, i8* %p.arg
+  %arg.s = sext i8 %arg to i16
+  switch i8 %op, label %yield [
+    i8 0, label %move.x
+    i8 1, label %move.y
+    i8 2, label %set.dx
+    i8 3, label %set.dy
+    i8 4, label %set.tile
+    i8 5, label %step
+    i8 6, label %jump
+  ], !prof !0
+
+move.x:
+  %x = load i16, i16* %xp
+  %x.new = add i16 %x, %arg.s
+  store i16 %x.new, i16* %xp
+  br label %dispatch
+
+move.y:
+  %y = load i16, i16* %yp
+  %y.new = add i16 %y, %arg.s
+  store i16 %y.new, i16* %yp
+  br label %dispatch
+
+set.dx:
+  store i16 %arg.s, i16* %dxp
+  br label %dispatch
+
+set.dy:
+  store i16 %arg.s, i16* %dyp
+  br label %dispatch
+
+set.tile:
+  store i8 %arg, i8* %tilep
+  br label %dispatch
+
+step:
+  %sx = load i16, i16* %xp
+  %sdx = load i16, i16* %dxp
+  %sx.new = add i16 %sx, %sdx
+  store i16 %sx.new, i16* %xp
+  %sy = load i16, i16* %yp
+  %sdy = load i16, i16* %dyp
+  %sy.new = add i16 %sy, %sdy
+  store i16 %sy.new, i16* %yp
+  br label %dispatch
+
+jump:
+  %back = zext i8 %arg to i16
+  %back.neg = sub i16 0, %back
+  %p.back = getelementptr inbounds i8, i8* %p.arg, i16 %back.neg
+  br label %dispatch
+
+yield:
+  store i8 %arg, i8* %timerp
+  ret i8* %p.arg.next
+}
+
+; The weights are of the default, then of the cases in order.
+!0 = !{!"branch_weights", i32 1, i32 12, i32 12, i32 4, i32 4, i32 6, i32 6, i32 4}
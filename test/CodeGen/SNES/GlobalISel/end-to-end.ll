@@ -0,0 +1,91 @@
+; RUN: llc < %s -march=snes -global-isel -global-isel-abort=1 | FileCheck %s
+
+; The whole GlobalISel pipeline, without falling back to SelectionDAG. The
+; code matches what SelectionDAG emits for the same functions.
+
+@g = global i16 0
+@t = global [8 x i16] zeroinitializer
+
+; CHECK-LABEL: add_imm:
+; CHECK: CLC
+; CHECK-NEXT: ADC #5
+; CHECK-NEXT: RTS
+define i16 @add_imm(i16 %a) {
+  %r = add i16 %a, 5
+  ret i16 %r
+}
+
+; CHECK-LABEL: shl_const:
+; CHECK: ASL A
+; CHECK-NEXT: ASL A
+; CHECK-NEXT: ASL A
+; CHECK-NEXT: RTS
+define i16 @shl_const(i16 %a) {
+  %r = shl i16 %a, 3
+  ret i16 %r
+}
+
+; CHECK-LABEL: load_global:
+; CHECK: LDA g
+; CHECK-NEXT: RTS
+define i16 @load_global() {
+  %v = load i16, i16* @g
+  ret i16 %v
+}
+
+; CHECK-LABEL: store_global:
+; CHECK: STA g
+; CHECK-NEXT: RTS
+define void @store_global(i16 %v) {
+  store i16 %v, i16* @g
+  ret void
+}
+
+; The element size is a shift, not a call to __mulhi3.
+; CHECK-LABEL: load_indexed:
+; CHECK: ASL A
+; CHECK-NEXT: TAX
+; CHECK-NEXT: LDA t,X
+; CHECK-NEXT: RTS
+define i16 @load_indexed(i16 %i) {
+  %p = getelementptr [8 x i16], [8 x i16]* @t, i16 0, i16 %i
+  %v = load i16, i16* %p
+  ret i16 %v
+}
+
+; CHECK-LABEL: brcond:
+; CHECK: CMP #0
+; CHECK-NEXT: BNE [[F:LBB[0-9_]+]]
+; CHECK: LDA #1
+; CHECK-NEXT: RTS
+; CHECK: [[F]]:
+; CHECK-NEXT: LDA #2
+; CHECK-NEXT: RTS
+define i16 @brcond(i16 %a) {
+entry:
+  %c = icmp eq i16 %a, 0
+  br i1 %c, label %t, label %f
+t:
+  ret i16 1
+f:
+  ret i16 2
+}
+
+; CHECK-LABEL: select:
+; CHECK: BCC [[END:LBB[0-9_]+]]
+; CHECK: TXA
+; CHECK: [[END]]:
+; CHECK-NEXT: RTS
+define i16 @select(i16 %a, i16 %b) {
+  %c = icmp ult i16 %a, %b
+  %r = select i1 %c, i16 %a, i16 %b
+  ret i16 %r
+}
+
+; CHECK-LABEL: mul:
+; CHECK: JSR __mulhi3
+; CHECK-NEXT: RTS
+define i16 @mul(i16 %a, i16 %b) {
+  %r = mul i16 %a, %b
+  ret i16 %r
+}
@@ -0,0 +1,101 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; ADC and SBC take the carry in, an add of a value in memory must clear it
+; first and a subtract must set it.
+
+@w = global i16 0
+@b = global i8 0
+@table = global [8 x i16] zeroinitializer
+@dpw = addrspace(2) global i16 0
+
+define i16 @add16_abs(i16 %a) {
+; CHECK-LABEL: add16_abs:
+; CHECK: CLC
+; CHECK-NEXT: ADC w
+  %v = load i16, i16* @w
+  %r = add i16 %a, %v
+  ret i16 %r
+}
+
+define i16 @sub16_abs(i16 %a) {
+; CHECK-LABEL: sub16_abs:
+; CHECK: SEC
+; CHECK-NEXT: SBC w
+  %v = load i16, i16* @w
+  %r = sub i16 %a, %v
+  ret i16 %r
+}
+
+define i8 @add8_abs(i8 %a) {
+; CHECK-LABEL: add8_abs:
+; CHECK: CLC
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: ADC b
+  %v = load i8, i8* @b
+  %r = add i8 %a, %v
+  ret i8 %r
+}
+
+define i8 @sub8_abs(i8 %a) {
+; CHECK-LABEL: sub8_abs:
+; CHECK: SEC
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: SBC b
+  %v = load i8, i8* @b
+  %r = sub i8 %a, %v
+  ret i8 %r
+}
+
+define i16 @add16_absx(i16 %a, i16 %i) {
+; CHECK-LABEL: add16_absx:
+; CHECK: CLC
+; CHECK-NOT: ADC
+; CHECK: ADC table,X
+  %p = getelementptr inbounds [8 x i16], [8 x i16]* @table, i16 0, i16 %i
+  %v = load i16, i16* %p
+  %r = add i16 %a, %v
+  ret i16 %r
+}
+
+define i16 @add16_dp(i16 %a) {
+; CHECK-LABEL: add16_dp:
+; CHECK: CLC
+; CHECK-NEXT: ADC dpw
+  %v = load i16, i16 addrspace(2)* @dpw
+  %r = add i16 %a, %v
+  ret i16 %r
+}
+
+define i16 @sub16_dp(i16 %a) {
+; CHECK-LABEL: sub16_dp:
+; CHECK: SEC
+; CHECK-NEXT: SBC dpw
+  %v = load i16, i16 addrspace(2)* @dpw
+  %r = sub i16 %a, %v
+  ret i16 %r
+}
+
+; The reload of a spilled right hand side is folded into a stack relative ADC
+; or SBC.
+
+declare i16 @get()
+
+define i16 @add16_reload(i16 %a) {
+; CHECK-LABEL: add16_reload:
+; CHECK: JSR get
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC {{[0-9]+}},S
+  %b = call i16 @get()
+  %r = add i16 %b, %a
+  ret i16 %r
+}
+
+define i16 @sub16_reload(i16 %a) {
+; CHECK-LABEL: sub16_reload:
+; CHECK: JSR get
+; CHECK-NEXT: SEC
+; CHECK-NEXT: SBC {{[0-9]+}},S
+  %b = call i16 @get()
+  %r = sub i16 %b, %a
+  ret i16 %r
+}
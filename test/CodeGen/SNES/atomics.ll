@@ -0,0 +1,77 @@
+; RUN: llc < %s -march=snes -verify-machineinstrs | FileCheck %s
+
+; An atomicrmw or/and on a fixed address whose old value is not used is a
+; single TSB or TRB, which an interrupt cannot split. Any other
+; read-modify-write runs with interrupts off, between PHP; SEI and PLP, with
+; the old value read into Y. Atomic loads and stores of a byte or a word are
+; plain LDA and STA.
+
+@flags = global i8 0
+@word = global i16 0
+
+define void @or8_unused(i8 %m) {
+; CHECK-LABEL: or8_unused:
+; CHECK: SEP #32
+; CHECK-NEXT: TSB flags
+; CHECK-NOT: PHP
+; CHECK: RTS
+  %old = atomicrmw or i8* @flags, i8 %m seq_cst
+  ret void
+}
+
+define void @and16_unused(i16 %m) {
+; CHECK-LABEL: and16_unused:
+; CHECK: EOR #-1
+; CHECK-NEXT: TRB word
+; CHECK-NEXT: RTS
+  %old = atomicrmw and i16* @word, i16 %m seq_cst
+  ret void
+}
+
+define i8 @or8_used(i8 %m) {
+; CHECK-LABEL: or8_used:
+; CHECK: PHP
+; CHECK-NEXT: SEI
+; CHECK-NEXT: LDY 0,X
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: ORA 0,X
+; CHECK-NEXT: STA 0,X
+; CHECK-NEXT: PLP
+; CHECK-NEXT: TYA
+  %old = atomicrmw or i8* @flags, i8 %m seq_cst
+  ret i8 %old
+}
+
+define i16 @add16_used(i16* %p, i16 %v) {
+; CHECK-LABEL: add16_used:
+; CHECK: PHP
+; CHECK-NEXT: SEI
+; CHECK-NEXT: LDY 0,X
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC 0,X
+; CHECK-NEXT: STA 0,X
+; CHECK-NEXT: PLP
+; CHECK: TYA
+; CHECK-NEXT: RTS
+  %old = atomicrmw add i16* %p, i16 %v seq_cst
+  ret i16 %old
+}
+
+define i16 @load16() {
+; CHECK-LABEL: load16:
+; CHECK-NOT: SEI
+; CHECK: LDA word
+; CHECK-NEXT: RTS
+  %v = load atomic i16, i16* @word seq_cst, align 2
+  ret i16 %v
+}
+
+define void @store8(i8 %v) {
+; CHECK-LABEL: store8:
+; CHECK-NOT: SEI
+; CHECK: SEP #32
+; CHECK-NEXT: STA flags
+; CHECK-NEXT: REP #32
+  store atomic i8 %v, i8* @flags seq_cst, align 1
+  ret void
+}
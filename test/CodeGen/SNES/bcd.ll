@@ -0,0 +1,51 @@
+; RUN: llc < %s -march=snes -verify-machineinstrs | FileCheck %s
+
+; BCD adds and subtracts run in decimal mode, between SED and CLD. The
+; operand in an index register is pushed and read back with n,S.
+
+declare i16 @llvm.snes.bcd.add(i16, i16)
+declare i16 @llvm.snes.bcd.sub(i16, i16)
+
+define i16 @bcd_add(i16 %a, i16 %b) {
+; CHECK-LABEL: bcd_add:
+; CHECK: PHX
+; CHECK-NEXT: SED
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC 1,S
+; CHECK-NEXT: CLD
+; CHECK-NEXT: PLX
+; CHECK-NEXT: RTS
+  %r = call i16 @llvm.snes.bcd.add(i16 %a, i16 %b)
+  ret i16 %r
+}
+
+define i16 @bcd_sub(i16 %a, i16 %b) {
+; CHECK-LABEL: bcd_sub:
+; CHECK: PHX
+; CHECK-NEXT: SED
+; CHECK-NEXT: SEC
+; CHECK-NEXT: SBC 1,S
+; CHECK-NEXT: CLD
+; CHECK-NEXT: PLX
+; CHECK-NEXT: RTS
+  %r = call i16 @llvm.snes.bcd.sub(i16 %a, i16 %b)
+  ret i16 %r
+}
+
+; Nothing but the operands is done in decimal mode.
+define i16 @bcd_add2(i16 %a, i16 %b, i16 %c) {
+; CHECK-LABEL: bcd_add2:
+; CHECK: SED
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC 1,S
+; CHECK-NEXT: CLD
+; CHECK-NOT: SED
+; CHECK: PHY
+; CHECK-NEXT: SED
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC 1,S
+; CHECK-NEXT: CLD
+  %r = call i16 @llvm.snes.bcd.add(i16 %a, i16 %b)
+  %s = call i16 @llvm.snes.bcd.add(i16 %r, i16 %c)
+  ret i16 %s
+}
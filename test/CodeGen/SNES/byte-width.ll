@@ -0,0 +1,39 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; Byte arithmetic is done in AL with M set. `SEP #$20` goes in front of the
+; run of byte instructions and `REP #$20` after it, M is clear again on
+; return.
+
+@x = global i8 0
+@y = global i8 0
+
+define void @add8_mem() {
+; CHECK-LABEL: add8_mem:
+; CHECK: SEP #32
+; CHECK-NEXT: LDA x
+; CHECK-NEXT: CLC
+; CHECK-NEXT: ADC y
+; CHECK-NEXT: STA x
+; CHECK-NEXT: REP #32
+; CHECK-NOT: SEP
+; CHECK: RTS
+  %a = load i8, i8* @x
+  %b = load i8, i8* @y
+  %r = add i8 %a, %b
+  store i8 %r, i8* @x
+  ret void
+}
+
+; Words going through a byte operation and back stay words, with no switch.
+
+define i16 @and_low(i16 %a) {
+; CHECK-LABEL: and_low:
+; CHECK-NOT: SEP
+; CHECK: AND #15
+; CHECK-NOT: SEP
+; CHECK: RTS
+  %t = trunc i16 %a to i8
+  %m = and i8 %t, 15
+  %r = zext i8 %m to i16
+  ret i16 %r
+}
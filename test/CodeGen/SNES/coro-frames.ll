@@ -0,0 +1,205 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; Coroutines after CoroSplit, with their frames from malloc. The frames come
+; from static pools instead, the suspend index moves to the direct page, a
+; byte for each frame, and resuming dispatches on it with `JMP (table,X)`.
+; The size of the frames is an absolute symbol for the linker.
+
+%f.Frame = type { void (%f.Frame*)*, void (%f.Frame*)*, i1, i3, i16 }
+%g.Frame = type { void (%g.Frame*)*, void (%g.Frame*)*, i1, i3, i16 }
+
+declare i8* @malloc(i16)
+declare void @free(i8*)
+declare void @print(i16)
+
+; A single frame is a global, reached with absolute addresses.
+; CHECK-LABEL: {{^}}f:
+; CHECK: LDA f.frame.taken
+; CHECK: STA f.frame.taken
+; CHECK: LDX #f.frame
+; CHECK: STA f.state
+; CHECK-LABEL: {{^}}f.resume:
+; CHECK: LDA f.state
+; CHECK: LDA f.frame+6
+; CHECK: JMP ([[FJT:JTI[0-9_]+]],X)
+; CHECK: STA f.state
+; CHECK: STA f.frame.taken
+; CHECK: [[FJT]]:
+; CHECK-NEXT: .short
+; CHECK-NEXT: .short
+; CHECK-NEXT: .short
+; CHECK-NEXT: .short
+; CHECK-LABEL: {{^}}f.destroy:
+; CHECK: STA f.frame.taken
+define i8* @f(i16 %n) {
+entry:
+  %alloc = call i8* @malloc(i16 8)
+  %FramePtr = bitcast i8* %alloc to %f.Frame*
+  %resume.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 0
+  store void (%f.Frame*)* @f.resume, void (%f.Frame*)** %resume.addr
+  %destroy.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 1
+  store void (%f.Frame*)* @f.destroy, void (%f.Frame*)** %destroy.addr
+  %n.spill.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 4
+  store i16 %n, i16* %n.spill.addr
+  %index.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 3
+  store i3 0, i3* %index.addr
+  call void @print(i16 %n)
+  ret i8* %alloc
+}
+
+define internal fastcc void @f.resume(%f.Frame* %FramePtr) {
+entry.resume:
+  %n.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 4
+  %n = load i16, i16* %n.addr
+  %index.addr = getelementptr inbounds %f.Frame, %f.Frame* %FramePtr, i16 0, i32 3
+  %index = load i3, i3* %index.addr
+  switch i3 %index, label %unreachable [
+    i3 0, label %s0
+    i3 1, label %s1
+    i3 2, label %s2
+    i3 3, label %s3
+    i3 4, label %s4
+  ]
+
+s0:
+  %n1 = add i16 %n, 1
+  call void @print(i16 %n1)
+  store i3 1, i3* %index.addr
+  ret void
+
+s1:
+  %n2 = add i16 %n, 2
+  call void @print(i16 %n2)
+  store i3 2, i3* %index.addr
+  ret void
+
+s2:
+  %n3 = add i16 %n, 3
+  call void @print(i16 %n3)
+  store i3 3, i3* %index.addr
+  ret void
+
+s3:
+  %n4 = add i16 %n, 4
+  call void @print(i16 %n4)
+  store i3 4, i3* %index.addr
+  ret void
+
+s4:
+  %mem = bitcast %f.Frame* %FramePtr to i8*
+  call void @free(i8* %mem)
+  ret void
+
+unreachable:
+  unreachable
+}
+
+define internal fastcc void @f.destroy(%f.Frame* %FramePtr) {
+entry.destroy:
+  %mem = bitcast %f.Frame* %FramePtr to i8*
+  call void @free(i8* %mem)
+  ret void
+}
+
+; In a pool, the state of a frame is found by comparing the frame pointer
+; with the frames after the first.
+; CHECK-LABEL: {{^}}g:
+; CHECK: JSR g.frame.alloc
+; CHECK: LDX #g.frames+8
+; CHECK: STA g.states,X
+; CHECK-LABEL: {{^}}g.resume:
+; CHECK: LDX #g.frames+8
+; CHECK: LDA g.states,X
+; CHECK: JMP ([[GJT:JTI[0-9_]+]],X)
+; CHECK: STA g.states,X
+; CHECK: JSR g.frame.free
+; CHECK: [[GJT]]:
+; CHECK-LABEL: {{^}}g.destroy:
+; CHECK: JSR g.frame.free
+; CHECK-LABEL: {{^}}g.frame.alloc:
+; CHECK-LABEL: {{^}}g.frame.free:
+
+; CHECK: .section .directpage
+; CHECK: f.state:
+; CHECK-NEXT: .byte 0
+; CHECK: .comm f.frame,8,
+; CHECK: f.frame.taken:
+; CHECK: .comm g.frames,16,
+; CHECK: g.states:
+; CHECK-NEXT: .zero 2
+; CHECK: .comm g.frames.taken,2,
+; CHECK: .globl f.frames.size
+; CHECK-NEXT: f.frames.size = 8
+; CHECK: .globl g.frames.size
+; CHECK-NEXT: g.frames.size = 16
+define i8* @g(i16 %n) #0 {
+entry:
+  %alloc = call i8* @malloc(i16 8)
+  %FramePtr = bitcast i8* %alloc to %g.Frame*
+  %resume.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 0
+  store void (%g.Frame*)* @g.resume, void (%g.Frame*)** %resume.addr
+  %destroy.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 1
+  store void (%g.Frame*)* @g.destroy, void (%g.Frame*)** %destroy.addr
+  %n.spill.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 4
+  store i16 %n, i16* %n.spill.addr
+  %index.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 3
+  store i3 0, i3* %index.addr
+  call void @print(i16 %n)
+  ret i8* %alloc
+}
+
+define internal fastcc void @g.resume(%g.Frame* %FramePtr) {
+entry.resume:
+  %n.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 4
+  %n = load i16, i16* %n.addr
+  %index.addr = getelementptr inbounds %g.Frame, %g.Frame* %FramePtr, i16 0, i32 3
+  %index = load i3, i3* %index.addr
+  switch i3 %index, label %unreachable [
+    i3 0, label %s0
+    i3 1, label %s1
+    i3 2, label %s2
+    i3 3, label %s3
+    i3 4, label %s4
+  ]
+
+s0:
+  %n1 = add i16 %n, 1
+  call void @print(i16 %n1)
+  store i3 1, i3* %index.addr
+  ret void
+
+s1:
+  %n2 = add i16 %n, 2
+  call void @print(i16 %n2)
+  store i3 2, i3* %index.addr
+  ret void
+
+s2:
+  %n3 = add i16 %n, 3
+  call void @print(i16 %n3)
+  store i3 3, i3* %index.addr
+  ret void
+
+s3:
+  %n4 = add i16 %n, 4
+  call void @print(i16 %n4)
+  store i3 4, i3* %index.addr
+  ret void
+
+s4:
+  %mem = bitcast %g.Frame* %FramePtr to i8*
+  call void @free(i8* %mem)
+  ret void
+
+unreachable:
+  unreachable
+}
+
+define internal fastcc void @g.destroy(%g.Frame* %FramePtr) {
+entry.destroy:
+  %mem = bitcast %g.Frame* %FramePtr to i8*
+  call void @free(i8* %mem)
+  ret void
+}
+
+attributes #0 = { "snes-coro-frames"="2" }
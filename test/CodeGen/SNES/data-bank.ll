@@ -0,0 +1,58 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; Calls to a function with the "snes-data-bank" attribute switch DB to its
+; bank, and back after the call.
+
+declare void @in81() #0
+declare void @in80() #1
+declare void @nobank()
+
+; The bank of the caller is not known, DB is saved on the stack. The saved
+; value stays there across calls in a row to the same bank.
+define void @unknown_twice() {
+; CHECK-LABEL: unknown_twice:
+; CHECK: PHB
+; CHECK-NEXT: PEA 33153
+; CHECK-NEXT: PLB
+; CHECK-NEXT: PLB
+; CHECK-NEXT: JSR in81
+; CHECK-NEXT: JSR in81
+; CHECK-NEXT: PLB
+  call void @in81()
+  call void @in81()
+  ret void
+}
+
+; The bank of the caller is known, it is set again after the calls.
+define void @known_twice() #1 {
+; CHECK-LABEL: known_twice:
+; CHECK-NOT: PHB
+; CHECK: PEA 33153
+; CHECK-NEXT: PLB
+; CHECK-NEXT: PLB
+; CHECK-NEXT: JSR in81
+; CHECK-NEXT: JSR in81
+; CHECK-NEXT: PEA 32896
+; CHECK-NEXT: PLB
+; CHECK-NEXT: PLB
+  call void @in81()
+  call void @in81()
+  ret void
+}
+
+; Calls within the bank of the caller, or to a function without one, do not
+; switch.
+define void @same_bank() #1 {
+; CHECK-LABEL: same_bank:
+; CHECK-NOT: PLB
+; CHECK: JSR in80
+; CHECK-NEXT: JSR nobank
+; CHECK-NOT: PLB
+; CHECK: RTS
+  call void @in80()
+  call void @nobank()
+  ret void
+}
+
+attributes #0 = { "snes-data-bank"="0x81" }
+attributes #1 = { "snes-data-bank"="0x80" }
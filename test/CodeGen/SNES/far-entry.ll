@@ -0,0 +1,54 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; Functions which can be called from another bank get a `JSR body; RTL` far
+; entry. Their bodies find the stack arguments past the return address of
+; the JSL too, so the calls which pass any always go through the far entry.
+
+declare void @ext1(i16)
+declare void @ext4(i16, i16, i16, i16)
+
+; CHECK-LABEL: sum4.far:
+; CHECK-NEXT: JSR sum4
+; CHECK-NEXT: RTL
+; CHECK-LABEL: sum4:
+define i16 @sum4(i16 %a, i16 %b, i16 %c, i16 %d) {
+  %ab = add i16 %a, %b
+  %abc = add i16 %ab, %c
+  %r = add i16 %abc, %d
+  ret i16 %r
+}
+
+; CHECK-NOT: near4.far:
+; CHECK-LABEL: near4:
+define internal i16 @near4(i16 %a, i16 %b, i16 %c, i16 %d) {
+  %r = add i16 %a, %d
+  ret i16 %r
+}
+
+define void @call_ext1() {
+; CHECK-LABEL: call_ext1:
+; CHECK: JSR ext1
+  call void @ext1(i16 1)
+  ret void
+}
+
+define void @call_ext4() {
+; CHECK-LABEL: call_ext4:
+; CHECK: JSL ext4.far
+  call void @ext4(i16 1, i16 2, i16 3, i16 4)
+  ret void
+}
+
+define i16 @call_sum4() {
+; CHECK-LABEL: call_sum4:
+; CHECK: JSL sum4.far
+  %r = call i16 @sum4(i16 1, i16 2, i16 3, i16 4)
+  ret i16 %r
+}
+
+define i16 @call_near4() {
+; CHECK-LABEL: call_near4:
+; CHECK: JSR near4
+  %r = call i16 @near4(i16 1, i16 2, i16 3, i16 4)
+  ret i16 %r
+}
@@ -0,0 +1,21 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; The operands go to WRMPYA and WRMPYB ($4202 and $4203) with byte stores,
+; a word store to WRMPYA would write WRMPYB too and start the multiply early.
+; The product is read from RDMPYL ($4216) as a word.
+
+declare i16 @llvm.snes.umul8(i8, i8)
+
+define i16 @umul8(i8 %a, i8 %b) {
+; CHECK-LABEL: umul8:
+; CHECK: SEP #32
+; CHECK-NOT: REP
+; CHECK: STA 16898
+; CHECK-NOT: REP
+; CHECK: STA 16899
+; CHECK: NOP
+; CHECK: REP #32
+; CHECK: LDA 16918
+  %r = call i16 @llvm.snes.umul8(i8 %a, i8 %b)
+  ret i16 %r
+}
@@ -0,0 +1,69 @@
+; RUN: llc < %s -march=snes -verify-machineinstrs | FileCheck %s
+
+; Constants are a single LDA, LDX or LDY #imm, and are loaded again after a
+; call rather than spilled. Logic, adds and compares with a constant take it
+; as an immediate operand.
+
+declare void @ext(i16)
+declare void @use(i16, i16)
+
+define i16 @ret_const() {
+; CHECK-LABEL: ret_const:
+; CHECK: LDA #1234
+; CHECK-NEXT: RTS
+  ret i16 1234
+}
+
+define i16 @logic(i16 %a) {
+; CHECK-LABEL: logic:
+; CHECK: AND #255
+; CHECK-NEXT: ORA #4096
+; CHECK-NEXT: EOR #3
+; CHECK-NEXT: RTS
+  %b = and i16 %a, 255
+  %c = or i16 %b, 4096
+  %d = xor i16 %c, 3
+  ret i16 %d
+}
+
+define i16 @add_const(i16 %a) {
+; CHECK-LABEL: add_const:
+; CHECK: CLC
+; CHECK-NEXT: ADC #300
+; CHECK-NEXT: RTS
+  %b = add i16 %a, 300
+  ret i16 %b
+}
+
+define void @cmp_const(i16 %a) {
+; CHECK-LABEL: cmp_const:
+; CHECK: CMP #100
+; CHECK-NEXT: BNE
+; CHECK: LDA #1
+; CHECK-NEXT: JSR ext
+  %c = icmp eq i16 %a, 100
+  br i1 %c, label %t, label %f
+t:
+  call void @ext(i16 1)
+  ret void
+f:
+  ret void
+}
+
+define void @remat() {
+; CHECK-LABEL: remat:
+; CHECK-NOT: Spill
+; CHECK: LDA #4660
+; CHECK-NEXT: JSR ext
+; CHECK-NEXT: LDA #4660
+; CHECK-NEXT: JSR ext
+; CHECK-NEXT: LDA #4660
+; CHECK-NEXT: LDX #4660
+; CHECK-NEXT: JSR use
+; CHECK-NOT: Reload
+; CHECK: RTS
+  call void @ext(i16 4660)
+  call void @ext(i16 4660)
+  call void @use(i16 4660, i16 4660)
+  ret void
+}
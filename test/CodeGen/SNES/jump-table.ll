@@ -0,0 +1,60 @@
+; RUN: llc < %s -march=snes -verify-machineinstrs | FileCheck %s
+
+; A dense switch is dispatched with `JMP (table,X)`, the case number doubled
+; with ASL A and moved to X as the offset of the entry. The table is kept in
+; the section of the function, since the entries are read from the program
+; bank.
+
+define i16 @dispatch(i16 %op, i16 %a) {
+; CHECK-LABEL: dispatch:
+; CHECK: CMP #5
+; CHECK-NEXT: BCS [[OTHER:LBB[0-9_]+]]
+; CHECK: ASL A
+; CHECK-NEXT: TAX
+; CHECK-NEXT: JMP ([[JT:JTI[0-9_]+]],X)
+; CHECK: [[C0:LBB[0-9_]+]]: ; %c0
+; CHECK: ADC #3
+; CHECK: [[OTHER]]: ; %other
+; CHECK: [[C1:LBB[0-9_]+]]: ; %c1
+; CHECK: [[C2:LBB[0-9_]+]]: ; %c2
+; CHECK: [[C3:LBB[0-9_]+]]: ; %c3
+; CHECK: [[C4:LBB[0-9_]+]]: ; %c4
+; CHECK-NOT: .section
+; CHECK: [[JT]]:
+; CHECK-NEXT: .short [[C0]]
+; CHECK-NEXT: .short [[C1]]
+; CHECK-NEXT: .short [[C2]]
+; CHECK-NEXT: .short [[C3]]
+; CHECK-NEXT: .short [[C4]]
+entry:
+  switch i16 %op, label %other [
+    i16 0, label %c0
+    i16 1, label %c1
+    i16 2, label %c2
+    i16 3, label %c3
+    i16 4, label %c4
+  ]
+
+c0:
+  %r0 = add i16 %a, 3
+  ret i16 %r0
+
+c1:
+  %r1 = sub i16 %a, 7
+  ret i16 %r1
+
+c2:
+  %r2 = xor i16 %a, 21
+  ret i16 %r2
+
+c3:
+  %r3 = and i16 %a, 255
+  ret i16 %r3
+
+c4:
+  %r4 = or i16 %a, 4096
+  ret i16 %r4
+
+other:
+  ret i16 0
+}
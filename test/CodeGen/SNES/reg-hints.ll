@@ -0,0 +1,33 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+
+; Values are hinted to the register their users need: an index to X, where
+; it is passed, and the sum to A. Neither goes through a transfer.
+
+@t = global [8 x i8] zeroinitializer
+
+; CHECK-LABEL: byte_index:
+; CHECK-NOT: TAX
+; CHECK-NOT: TXA
+; CHECK: CLC
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: ADC t,X
+; CHECK-NEXT: REP #32
+; CHECK-NEXT: RTS
+define i8 @byte_index(i8 %a, i16 %i) {
+  %p = getelementptr [8 x i8], [8 x i8]* @t, i16 0, i16 %i
+  %v = load i8, i8* %p
+  %r = add i8 %v, %a
+  ret i8 %r
+}
+
+; The arguments stay in A and X, only the copy of X into Y is a transfer.
+; CHECK-LABEL: pass_on:
+; CHECK-NOT: TAX
+; CHECK-NOT: TXA
+; CHECK: TXY
+; CHECK-NEXT: JSR g3
+declare void @g3(i16, i16, i16)
+define void @pass_on(i16 %a, i16 %b) {
+  call void @g3(i16 %a, i16 %b, i16 %b)
+  ret void
+}
@@ -0,0 +1,87 @@
+; RUN: llc < %s -march=snes | FileCheck %s
+; RUN: llc < %s -march=snes -snes-fastrom-entry-count=100 \
+; RUN:   | FileCheck %s --check-prefix=COUNT
+; RUN: llc < %s -march=snes -snes-profile-bank-placement=false \
+; RUN:   | FileCheck %s --check-prefix=OFF
+
+; Hot functions go to .text.fastrom, which the linker maps onto the banks
+; from $80 up, and cold ones to .text.slowrom. The section prefix
+; CodeGenPrepare gives from the profile summary comes first, then the cold
+; attribute, then the entry count when -snes-fastrom-entry-count is given.
+; The printer only names a section when it changes, so the functions
+; alternate between them.
+
+; OFF-NOT: .text.fastrom
+; OFF-NOT: .text.slowrom
+
+; CHECK: .section .text.fastrom,"ax",@progbits
+; CHECK-NEXT: .globl hot
+; COUNT: .section .text.fastrom,"ax",@progbits
+; COUNT-NEXT: .globl hot
+define void @hot() !section_prefix !0 {
+  ret void
+}
+
+; CHECK: .section .text.slowrom,"ax",@progbits
+; CHECK-NEXT: .globl unlikely
+; COUNT: .section .text.slowrom,"ax",@progbits
+; COUNT-NEXT: .globl unlikely
+define void @unlikely() !section_prefix !1 {
+  ret void
+}
+
+; CHECK: .text{{$}}
+; CHECK-NEXT: .globl plain
+; COUNT: .text{{$}}
+; COUNT-NEXT: .globl plain
+define void @plain() {
+  ret void
+}
+
+; CHECK: .section .text.slowrom,"ax",@progbits
+; CHECK-NEXT: .globl cold
+; COUNT: .section .text.slowrom,"ax",@progbits
+; COUNT-NEXT: .globl cold
+define void @cold() cold {
+  ret void
+}
+
+; The prefix wins over the attribute.
+; CHECK: .section .text.fastrom,"ax",@progbits
+; CHECK-NEXT: .globl hot_cold
+; COUNT: .section .text.fastrom,"ax",@progbits
+; COUNT-NEXT: .globl hot_cold
+define void @hot_cold() cold !section_prefix !0 {
+  ret void
+}
+
+; Without -snes-fastrom-entry-count the entry count says nothing.
+; CHECK: .text{{$}}
+; CHECK-NEXT: .globl seldom
+; COUNT: .section .text.slowrom,"ax",@progbits
+; COUNT-NEXT: .globl seldom
+define void @seldom() !prof !2 {
+  ret void
+}
+
+; The attribute wins over the entry count.
+; CHECK: .section .text.slowrom,"ax",@progbits
+; CHECK-NEXT: .globl cold_often
+; COUNT-NOT: .section
+; COUNT: .globl cold_often
+define void @cold_often() cold !prof !3 {
+  ret void
+}
+
+; CHECK: .text{{$}}
+; CHECK-NEXT: .globl often
+; COUNT: .section .text.fastrom,"ax",@progbits
+; COUNT-NEXT: .globl often
+define void @often() !prof !3 {
+  ret void
+}
+
+!0 = !{!"function_section_prefix", !".hot"}
+!1 = !{!"function_section_prefix", !".unlikely"}
+!2 = !{!"function_entry_count", i64 99}
+!3 = !{!"function_entry_count", i64 100}
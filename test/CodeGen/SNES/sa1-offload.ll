@@ -0,0 +1,46 @@
+; RUN: llc < %s -march=snes -mcpu=sa1 | FileCheck %s
+
+; @shared is called from both CPUs. The S-CPU keeps it, with the multiplier
+; at WRMPYA ($4202), and the SA-1 calls a copy of it which uses its own unit
+; at $2251 instead.
+
+declare i16 @llvm.snes.umul8(i8, i8)
+
+define i16 @shared(i8 %a, i8 %b) {
+; CHECK-LABEL: shared:
+; CHECK: STA 16898
+  %r = call i16 @llvm.snes.umul8(i8 %a, i8 %b)
+  ret i16 %r
+}
+
+define i16 @work(i8 %a) "snes-sa1" {
+; CHECK-LABEL: work:
+; CHECK: JSR shared.sa1
+  %r = call i16 @shared(i8 %a, i8 3)
+  ret i16 %r
+}
+
+define i16 @caller(i8 %a) {
+; CHECK-LABEL: caller:
+; CHECK: JSR work.sa1call
+; CHECK: JSR shared
+  %r = call i16 @work(i8 %a)
+  %s = call i16 @shared(i8 %a, i8 5)
+  %t = add i16 %r, %s
+  ret i16 %t
+}
+
+; CHECK-LABEL: shared.sa1:
+; CHECK-NOT: 16898
+; CHECK: STA 8785
+; CHECK-NOT: 16898
+; CHECK: RTS
+
+; The stub hands the SA-1 the long address of the far entry of @work.
+; CHECK-LABEL: work.sa1call:
+; CHECK: work.sa1addr
+; CHECK: __sa1_mailbox_fn
+; CHECK: JSR __sa1_call
+
+; CHECK: work.sa1addr:
+; CHECK-NEXT: .long work.far
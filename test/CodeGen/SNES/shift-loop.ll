@@ -0,0 +1,52 @@
+; RUN: llc < %s -march=snes -verify-machineinstrs | FileCheck %s
+
+; Shifts by a variable amount are loops which count down a word in X, the
+; count of a byte shift is zero extended first. Only the shift of a byte is
+; done with M set. The compare with zero is left out of the loop, DEX sets Z.
+
+define i8 @shl8_var(i8 %a, i8 %n) {
+; CHECK-LABEL: shl8_var:
+; CHECK: AND #255
+; CHECK-NEXT: TAX
+; CHECK: CPX #0
+; CHECK-NEXT: BEQ [[DONE:LBB[0-9_]+]]
+; CHECK: [[LOOP:LBB[0-9_]+]]:
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: ASL A
+; CHECK-NEXT: DEX
+; CHECK-NEXT: REP #32
+; CHECK-NEXT: BNE [[LOOP]]
+; CHECK: [[DONE]]:
+; CHECK-NEXT: RTS
+  %r = shl i8 %a, %n
+  ret i8 %r
+}
+
+define i8 @lshr8_var(i8 %a, i8 %n) {
+; CHECK-LABEL: lshr8_var:
+; CHECK: AND #255
+; CHECK-NEXT: TAX
+; CHECK: CPX #0
+; CHECK-NEXT: BEQ
+; CHECK: [[LOOP:LBB[0-9_]+]]:
+; CHECK-NEXT: SEP #32
+; CHECK-NEXT: LSR A
+; CHECK-NEXT: DEX
+; CHECK-NEXT: REP #32
+; CHECK-NEXT: BNE [[LOOP]]
+  %r = lshr i8 %a, %n
+  ret i8 %r
+}
+
+define i16 @shl16_var(i16 %a, i16 %n) {
+; CHECK-LABEL: shl16_var:
+; CHECK: CPX #0
+; CHECK-NEXT: BEQ
+; CHECK-NOT: SEP
+; CHECK: [[LOOP:LBB[0-9_]+]]:
+; CHECK-NEXT: ASL A
+; CHECK-NEXT: DEX
+; CHECK-NEXT: BNE [[LOOP]]
+  %r = shl i16 %a, %n
+  ret i16 %r
+}
@@ -0,0 +1,63 @@
+; RUN: llc < %s -march=snes -snes-stack-report=- -o /dev/null | FileCheck %s
+; RUN: not llc < %s -march=snes -snes-stack-budget=1000 -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=BUDGET
+
+; Recursion has no bound on its depth. A function which only calls itself,
+; or a cycle of calls nothing else reaches, is an entry point of its own.
+
+; CHECK: Stack usage of <stdin>, in bytes below the return address:
+; CHECK-NEXT: even frame {{ *[0-9]+}}, unbounded
+; CHECK-NEXT: fact frame {{ *[0-9]+}}, unbounded
+; CHECK-NEXT: odd frame {{ *[0-9]+}}, unbounded
+
+; CHECK: Entry points, with what is pushed to enter them:
+; CHECK-NEXT: even unbounded, 'even' is recursive
+; CHECK-NEXT: fact unbounded, 'fact' is recursive
+; CHECK-NOT: odd
+
+; CHECK: Worst case: unbounded, 'even' is recursive
+
+; BUDGET: LLVM ERROR: SNES: the stack depth has no bound, 'even' is recursive
+
+define i16 @fact(i16 %n) {
+entry:
+  %z = icmp eq i16 %n, 0
+  br i1 %z, label %done, label %rec
+
+rec:
+  %m = sub i16 %n, 1
+  %r = call i16 @fact(i16 %m)
+  %p = add i16 %r, %n
+  ret i16 %p
+
+done:
+  ret i16 1
+}
+
+define i16 @even(i16 %n) {
+entry:
+  %z = icmp eq i16 %n, 0
+  br i1 %z, label %done, label %rec
+
+rec:
+  %m = sub i16 %n, 1
+  %r = call i16 @odd(i16 %m)
+  ret i16 %r
+
+done:
+  ret i16 1
+}
+
+define i16 @odd(i16 %n) {
+entry:
+  %z = icmp eq i16 %n, 0
+  br i1 %z, label %done, label %rec
+
+rec:
+  %m = sub i16 %n, 1
+  %r = call i16 @even(i16 %m)
+  ret i16 %r
+
+done:
+  ret i16 0
+}
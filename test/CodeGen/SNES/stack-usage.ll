@@ -0,0 +1,66 @@
+; RUN: llc < %s -march=snes -snes-stack-report=- -o /dev/null | FileCheck %s
+; RUN: llc < %s -march=snes -snes-stack-budget=43 -o /dev/null
+; RUN: not llc < %s -march=snes -snes-stack-budget=42 -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=BUDGET
+
+; The deepest the stack gets from each entry point, and the static RAM by
+; section. A JSR pushes 2 bytes, a call from outside goes through the far
+; entry and pushes 5. An interrupt pushes 4, and the handlers are counted
+; on top of the deepest of the rest.
+
+; CHECK: Stack usage of <stdin>, in bytes below the return address:
+; CHECK-NEXT: leaf frame 0, depth 0
+; CHECK-NEXT: main frame 0, depth 26
+; CHECK-NEXT: middle frame 24, depth 24
+; CHECK-NEXT: nmi frame 6, depth 8
+
+; CHECK: Entry points, with what is pushed to enter them:
+; CHECK-NEXT: main 31
+; CHECK-NEXT: nmi 12 (interrupt)
+
+; CHECK: Worst case: 43 bytes
+
+; CHECK: Static RAM:
+; CHECK-NEXT: .bss 66
+; CHECK-NEXT: counter 2
+; CHECK-NEXT: buffer 64
+; CHECK-NEXT: .data 8
+; CHECK-NEXT: table 8
+; CHECK-NEXT: .directpage 2
+; CHECK-NEXT: fast 2
+
+; BUDGET: LLVM ERROR: SNES: the stack may take 43 bytes, more than the budget of 42
+
+@counter = global i16 0
+@table = global [4 x i16] [i16 1, i16 2, i16 3, i16 4]
+@buffer = global [64 x i8] zeroinitializer
+@fast = addrspace(2) global i16 0
+@message = constant [4 x i8] c"SNES"
+
+define internal void @leaf() {
+  store volatile i16 1, i16* @counter
+  ret void
+}
+
+define internal i16 @middle(i16 %a, i16 %b) {
+  %x = alloca [8 x i16]
+  %p = getelementptr [8 x i16], [8 x i16]* %x, i16 0, i16 %a
+  store volatile i16 %b, i16* %p
+  call void @leaf()
+  %v = load volatile i16, i16* %p
+  ret i16 %v
+}
+
+define void @main() {
+  %r = call i16 @middle(i16 1, i16 2)
+  store i16 %r, i16* @counter
+  call void @leaf()
+  ret void
+}
+
+define void @nmi() #0 {
+  call void @leaf()
+  ret void
+}
+
+attributes #0 = { "interrupt" }
@@ -0,0 +1,61 @@
+; RUN: llc < %s -march=snes -snes-static-frames | FileCheck %s
+
+; Only functions that cannot be entered twice, or while a frame the call
+; graph does not know about is live, get a static frame.
+
+; CHECK-LABEL: plain:
+; CHECK: __snes_static_frames
+define void @plain() {
+  %a = alloca i16
+  store volatile i16 1, i16* %a
+  ret void
+}
+
+; Called from the handler, which may interrupt main in the middle of it.
+; CHECK-LABEL: from_irq:
+; CHECK-NOT: __snes_static_frames
+; CHECK: RTS
+define void @from_irq() {
+  %a = alloca i16
+  store volatile i16 2, i16* %a
+  ret void
+}
+
+define void @irq() #0 {
+  call void @from_irq()
+  ret void
+}
+
+; Reached only through a function pointer. Its frame and the frames of what
+; it calls could overlap the frame of the function making the indirect call.
+; CHECK-LABEL: callback:
+; CHECK-NOT: __snes_static_frames
+; CHECK: RTS
+define void @callback() {
+  %a = alloca i16
+  store volatile i16 3, i16* %a
+  call void @from_callback()
+  ret void
+}
+
+; CHECK-LABEL: from_callback:
+; CHECK-NOT: __snes_static_frames
+; CHECK: RTS
+define void @from_callback() {
+  %a = alloca i16
+  store volatile i16 4, i16* %a
+  ret void
+}
+
+define void @main(void ()* %f) {
+  %a = alloca i16
+  store volatile i16 5, i16* %a
+  call void @plain()
+  call void @from_irq()
+  call void %f()
+  ret void
+}
+
+@fp = global void ()* @callback
+
+attributes #0 = { "interrupt" }
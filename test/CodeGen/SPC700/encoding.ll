@@ -0,0 +1,76 @@
+; RUN: llc < %s -march=spc700 -show-mc-encoding | FileCheck %s
+
+; The instructions the code generator emits and their encodings, from
+; selection to the MC layer.
+
+@g = global i8 0
+
+; CHECK-LABEL: add:
+; CHECK: mov $06, x ; encoding: [0xd8,0x06]
+; CHECK-NEXT: mov $07, a ; encoding: [0xc4,0x07]
+; CHECK-NEXT: clrc ; encoding: [0x60]
+; CHECK-NEXT: adc $07, $06 ; encoding: [0x89,0x06,0x07]
+; CHECK: mov a, $07 ; encoding: [0xe4,0x07]
+; CHECK: ret ; encoding: [0x6f]
+define i8 @add(i8 %a, i8 %b) {
+  %r = add i8 %a, %b
+  ret i8 %r
+}
+
+; CHECK-LABEL: addw:
+; CHECK: movw ya, $06 ; encoding: [0xba,0x06]
+; CHECK-NEXT: addw ya, $08 ; encoding: [0x7a,0x08]
+; CHECK-NEXT: ret ; encoding: [0x6f]
+define i16 @addw(i16 %a, i16 %b) {
+  %r = add i16 %a, %b
+  ret i16 %r
+}
+
+; CHECK-LABEL: mul:
+; CHECK: mul ya ; encoding: [0xcf]
+define i8 @mul(i8 %a, i8 %b) {
+  %r = mul i8 %a, %b
+  ret i8 %r
+}
+
+; CHECK-LABEL: store_global:
+; CHECK: mov !g, a ; encoding: [0xc5,A,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: g, kind: fixup_16
+define void @store_global(i8 %v) {
+  store i8 %v, i8* @g
+  ret void
+}
+
+; The I/O registers are in the direct page.
+; CHECK-LABEL: io:
+; CHECK: mov $f4, #1 ; encoding: [0x8f,0x01,0xf4]
+define void @io() {
+  store volatile i8 1, i8* inttoptr (i16 244 to i8*)
+  ret void
+}
+
+; CHECK-LABEL: call:
+; CHECK: mov x, #1 ; encoding: [0xcd,0x01]
+; CHECK-NEXT: call !add ; encoding: [0x3f,A,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: add, kind: fixup_16
+define i8 @call(i8 %a) {
+  %r = call i8 @add(i8 %a, i8 1)
+  ret i8 %r
+}
+
+; CHECK-LABEL: branch:
+; CHECK: cmp $07, $06 ; encoding: [0x69,0x06,0x07]
+; CHECK-NEXT: bne [[F:LBB[0-9_]+]] ; encoding: [0xd0,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: [[F]], kind: fixup_8_pcrel
+; CHECK: mov a, #1 ; encoding: [0xe8,0x01]
+; CHECK: [[F]]:
+; CHECK-NEXT: mov a, #2 ; encoding: [0xe8,0x02]
+define i8 @branch(i8 %a, i8 %b) {
+entry:
+  %c = icmp eq i8 %a, %b
+  br i1 %c, label %t, label %f
+t:
+  ret i8 1
+f:
+  ret i8 2
+}
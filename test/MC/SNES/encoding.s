@@ -0,0 +1,44 @@
+; RUN: llvm-mc -triple=snes -show-encoding < %s | FileCheck %s
+
+; The opcode comes first and the operand follows it, low byte first.
+
+; CHECK: STA 4660 ; encoding: [0x8d,0x34,0x12]
+	sta	0x1234
+; CHECK: JSL 1193046 ; encoding: [0x22,0x56,0x34,0x12]
+	jsl	0x123456
+; CHECK: ASL A ; encoding: [0x0a]
+	asl	a
+; CHECK: LDA t,X ; encoding: [0xbd,A,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: t, kind: fixup_16
+	lda	t,x
+; CHECK: JMP (t,X) ; encoding: [0x7c,A,A]
+	jmp	(t,x)
+; CHECK: MVP 1, 2 ; encoding: [0x44,0x02,0x01]
+	mvp	1,2
+; CHECK: BRA .Lback ; encoding: [0x80,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: .Lback, kind: fixup_8_pcrel
+.Lback:
+	bra	.Lback
+
+; The immediates are words until SEP sets M or X, and again once REP
+; clears it.
+
+; CHECK: LDA #5 ; encoding: [0xa9,0x05,0x00]
+	lda	#5
+; CHECK: SEP #48 ; encoding: [0xe2,0x30]
+	sep	#0x30
+; CHECK-NEXT: LDA #5 ; encoding: [0xa9,0x05]
+	lda	#5
+; CHECK-NEXT: CPX #5 ; encoding: [0xe0,0x05]
+	cpx	#5
+; CHECK-NEXT: REP #16 ; encoding: [0xc2,0x10]
+	rep	#0x10
+; CHECK-NEXT: AND #5 ; encoding: [0x29,0x05]
+	and	#5
+; CHECK-NEXT: LDY #5 ; encoding: [0xa0,0x05,0x00]
+	ldy	#5
+; CHECK-NEXT: REP #32 ; encoding: [0xc2,0x20]
+	rep	#0x20
+; CHECK-NEXT: ADC #t ; encoding: [0x69,A,A]
+; CHECK-NEXT: ; fixup A - offset: 1, value: t, kind: fixup_16
+	adc	#t
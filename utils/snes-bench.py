@@ -0,0 +1,195 @@
+#!/usr/bin/env python
+
+"""Tracks the code size and cycles of the SNES benchmarks.
+
+The benchmarks are the kernels in test/CodeGen/SNES/Bench. llc writes the size
+and the estimated cycles per call of each function with -snes-cost-report,
+and Inputs/baseline.txt next to them has the figures to compare against.
+
+  snes-bench.py check BASELINE REPORT...
+      Fails when a function of a report got bigger or slower than the
+      baseline, or is not in it. This is what the lit tests run.
+
+  snes-bench.py run --llc LLC [--update] [--record FILE] [KERNEL...]
+      Compiles the kernels, all of them by default, and prints each function
+      with the change from the baseline. --update writes the figures into the
+      baseline, and --record appends them to FILE with the current commit, to
+      follow the backend from commit to commit.
+"""
+
+from __future__ import print_function
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+BENCH_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir,
+                         'test', 'CodeGen', 'SNES', 'Bench')
+BASELINE = os.path.join(BENCH_DIR, 'Inputs', 'baseline.txt')
+
+REPORT_RE = re.compile(r'^\s+(\S+)\s+size\s+(\d+), cycles\s+(\d+)$')
+
+
+def read_report(path):
+  """Returns {function: (size, cycles)} from a -snes-cost-report file."""
+  costs = {}
+  with open(path) as f:
+    for line in f:
+      m = REPORT_RE.match(line.rstrip('\n'))
+      if m:
+        costs[m.group(1)] = (int(m.group(2)), int(m.group(3)))
+  return costs
+
+
+def read_baseline(path):
+  """Returns {function: (size, cycles)} from a baseline file."""
+  costs = {}
+  if not os.path.exists(path):
+    return costs
+  with open(path) as f:
+    for line in f:
+      fields = line.split('#', 1)[0].split()
+      if len(fields) == 3:
+        costs[fields[0]] = (int(fields[1]), int(fields[2]))
+  return costs
+
+
+def write_baseline(path, costs):
+  with open(path, 'w') as f:
+    f.write('# Code size and estimated cycles per call of the SNES benchmarks,\n'
+            '# written by utils/snes-bench.py run --update.\n'
+            '#\n'
+            '# %-38s %6s %8s\n' % ('function', 'size', 'cycles'))
+    for name in sorted(costs):
+      size, cycles = costs[name]
+      f.write('%-40s %6d %8d\n' % (name, size, cycles))
+
+
+def delta(new, old):
+  if old is None:
+    return 'new'
+  if new == old:
+    return '='
+  return '%+d (%+.1f%%)' % (new - old, 100.0 * (new - old) / max(old, 1))
+
+
+def is_worse(new, old, tolerance):
+  return new > old * (1 + tolerance / 100.0)
+
+
+def check(args):
+  baseline = read_baseline(args.baseline)
+  failed = False
+  for report in args.reports:
+    for name, (size, cycles) in sorted(read_report(report).items()):
+      if name not in baseline:
+        print('%s: no baseline, size %d, cycles %d, update the baseline' %
+              (name, size, cycles))
+        failed = True
+        continue
+      base_size, base_cycles = baseline[name]
+      regressed = False
+      if is_worse(size, base_size, args.tolerance):
+        print('%s: size regressed, %d bytes, baseline %d' %
+              (name, size, base_size))
+        regressed = True
+      if is_worse(cycles, base_cycles, args.tolerance):
+        print('%s: cycles regressed, %d, baseline %d' %
+              (name, cycles, base_cycles))
+        regressed = True
+      if regressed:
+        failed = True
+      elif size < base_size or cycles < base_cycles:
+        print('%s: improved to size %d, cycles %d, update the baseline' %
+              (name, size, cycles))
+  return 1 if failed else 0
+
+
+def compile_kernel(llc, kernel, extra_args):
+  fd, report = tempfile.mkstemp(suffix='.txt')
+  os.close(fd)
+  try:
+    with open(os.devnull, 'w') as null:
+      subprocess.check_call([llc, '-march=snes', '-snes-cost-report=' + report,
+                             '-o', os.devnull, kernel] + extra_args,
+                            stdout=null)
+    return read_report(report)
+  finally:
+    os.remove(report)
+
+
+def current_commit():
+  try:
+    return subprocess.check_output(
+        ['git', 'rev-parse', '--short', 'HEAD'],
+        cwd=os.path.dirname(os.path.abspath(__file__))).decode().strip()
+  except (OSError, subprocess.CalledProcessError):
+    return 'unknown'
+
+
+def run(args):
+  kernels = args.kernels or sorted(glob.glob(os.path.join(BENCH_DIR, '*.ll')))
+  baseline = read_baseline(args.baseline)
+
+  costs = {}
+  for kernel in kernels:
+    costs.update(compile_kernel(args.llc, kernel, args.llc_args))
+
+  print('%-32s %6s %-18s %8s %s' % ('function', 'size', '', 'cycles', ''))
+  for name in sorted(costs):
+    size, cycles = costs[name]
+    base_size, base_cycles = baseline.get(name, (None, None))
+    print('%-32s %6d %-18s %8d %s' % (name, size, delta(size, base_size),
+                                      cycles, delta(cycles, base_cycles)))
+
+  if args.record:
+    commit = current_commit()
+    with open(args.record, 'a') as f:
+      for name in sorted(costs):
+        f.write('%s %s %d %d\n' % ((commit, name) + costs[name]))
+
+  if args.update:
+    baseline.update(costs)
+    write_baseline(args.baseline, baseline)
+  return 0
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  subparsers = parser.add_subparsers(dest='command')
+
+  check_parser = subparsers.add_parser('check',
+                                       help='compare reports to a baseline')
+  check_parser.add_argument('baseline')
+  check_parser.add_argument('reports', nargs='+')
+  check_parser.add_argument('--tolerance', type=float, default=0,
+                            help='the growth allowed, in percent')
+
+  run_parser = subparsers.add_parser('run', help='compile the kernels')
+  run_parser.add_argument('--llc', default='llc', help='the llc to run')
+  run_parser.add_argument('--llc-args', default='',
+                          help='more options for llc, e.g. "-mcpu=sa1"')
+  run_parser.add_argument('--baseline', default=BASELINE)
+  run_parser.add_argument('--update', action='store_true',
+                          help='write the results into the baseline')
+  run_parser.add_argument('--record', metavar='FILE',
+                          help='append the results with the commit to FILE')
+  run_parser.add_argument('kernels', nargs='*')
+
+  args = parser.parse_args()
+  if args.command == 'check':
+    return check(args)
+  if args.command == 'run':
+    args.llc_args = args.llc_args.split()
+    return run(args)
+  parser.print_help()
+  return 1
+
+
+if __name__ == '__main__':
+  sys.exit(main())